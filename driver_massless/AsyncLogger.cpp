@@ -0,0 +1,193 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "AsyncLogger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+AsyncLogger::AsyncLogger(Sink sink) :
+    AsyncLogger(std::move(sink), Options(), Clock::now)
+{}
+
+AsyncLogger::AsyncLogger(Sink sink, Options options, ClockFunction clock) :
+    m_sink(std::move(sink)),
+    m_options(options),
+    m_clock(std::move(clock))
+{
+    std::size_t capacity = 2;
+    while (capacity < this->m_options.capacity)
+        capacity *= 2;
+    this->m_slots = std::make_unique<Slot[]>(capacity);
+    this->m_mask = capacity - 1;
+
+    // A slot is free for the writer at position i when its sequence is i, and holds a line for the reader when it is i + 1
+    for (std::size_t i = 0; i < capacity; ++i)
+        this->m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    for (auto& window : this->m_reportedWindows)
+        window = -1;
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    this->stop();
+}
+
+bool AsyncLogger::log(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool queued = this->logv(format, args);
+    va_end(args);
+    return queued;
+}
+
+bool AsyncLogger::logv(const char* format, va_list args)
+{
+    if (this->m_options.repeat_limit > 0 && !this->allowRepeat(format, this->getWindow())) {
+        this->m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Claim a slot, or drop the line if the reader has fallen a whole ring behind
+    std::size_t position = this->m_enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &this->m_slots[position & this->m_mask];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0) {
+            if (this->m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0) {
+            this->m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            position = this->m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Formatted here because arguments (usually c_str() of temporaries) don't outlive the call
+    std::vsnprintf(slot->text, m_lineSize, format, args);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+void AsyncLogger::start()
+{
+    std::lock_guard<std::mutex> lock(this->m_threadMutex);
+    if (this->m_running)
+        return;
+    this->m_running = true;
+    this->m_worker = std::thread(&AsyncLogger::run, this);
+}
+
+void AsyncLogger::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_threadMutex);
+        this->m_running = false;
+    }
+    this->m_wake.notify_all();
+    if (this->m_worker.joinable())
+        this->m_worker.join();
+    this->flush();
+}
+
+void AsyncLogger::flush()
+{
+    std::lock_guard<std::mutex> lock(this->m_flushMutex);
+
+    // Stops at the first slot still being written, it is picked up next time
+    while (true) {
+        Slot& slot = this->m_slots[this->m_dequeuePosition & this->m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != this->m_dequeuePosition + 1)
+            break;
+        this->m_sink(slot.text);
+        slot.sequence.store(this->m_dequeuePosition + this->m_mask + 1, std::memory_order_release);
+        ++this->m_dequeuePosition;
+        this->m_written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    char summary[m_lineSize];
+    uint64_t dropped = this->m_dropped.load(std::memory_order_relaxed);
+    if (dropped != this->m_reportedDropped) {
+        std::snprintf(summary, sizeof(summary), "[Warn] Dropped %llu log lines, the log queue was full.\n",
+            static_cast<unsigned long long>(dropped - this->m_reportedDropped));
+        this->m_reportedDropped = dropped;
+        this->m_sink(summary);
+    }
+
+    // At most one summary per format per window, so a format that keeps repeating is summarised once a window
+    int64_t window = this->getWindow();
+    for (std::size_t i = 0; i < m_repeatTableSize; ++i) {
+        RepeatCounter& counter = this->m_repeats[i];
+        const char* format = counter.format.load(std::memory_order_acquire);
+        if (format == nullptr || this->m_reportedWindows[i] == window || counter.suppressed.load(std::memory_order_relaxed) == 0)
+            continue;
+        this->m_reportedWindows[i] = window;
+        uint32_t suppressed = counter.suppressed.exchange(0, std::memory_order_relaxed);
+        std::string_view line(format);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.remove_suffix(1);
+        std::snprintf(summary, sizeof(summary), "[Warn] Suppressed %u repeats of: %.*s\n", suppressed, static_cast<int>(line.size()), line.data());
+        this->m_sink(summary);
+    }
+}
+
+AsyncLogger::Stats AsyncLogger::getStats() const
+{
+    Stats stats;
+    stats.written = this->m_written.load(std::memory_order_relaxed);
+    stats.dropped = this->m_dropped.load(std::memory_order_relaxed);
+    stats.suppressed = this->m_suppressed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool AsyncLogger::allowRepeat(const char* format, int64_t window)
+{
+    // Counted by format pointer, a few probes into a fixed table. Races between writers only make the limit approximate.
+    auto hash = static_cast<std::size_t>((reinterpret_cast<uintptr_t>(format) >> 3) * 0x9E3779B97F4A7C15ull >> 32);
+    for (std::size_t probe = 0; probe < 4; ++probe) {
+        RepeatCounter& counter = this->m_repeats[(hash + probe) % m_repeatTableSize];
+        const char* current = counter.format.load(std::memory_order_acquire);
+        if (current == nullptr && counter.format.compare_exchange_strong(current, format, std::memory_order_acq_rel))
+            current = format;
+        if (current != format)
+            continue;
+
+        if (counter.window.load(std::memory_order_relaxed) != window && counter.window.exchange(window, std::memory_order_relaxed) != window)
+            counter.count.store(0, std::memory_order_relaxed);
+        if (counter.count.fetch_add(1, std::memory_order_relaxed) < this->m_options.repeat_limit)
+            return true;
+        counter.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+int64_t AsyncLogger::getWindow() const
+{
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(this->m_clock().time_since_epoch());
+    return now.count() / std::max<int64_t>(this->m_options.repeat_window.count(), 1);
+}
+
+void AsyncLogger::run()
+{
+    std::unique_lock<std::mutex> lock(this->m_threadMutex);
+    while (this->m_running) {
+        this->m_wake.wait_for(lock, this->m_options.flush_interval, [this]() { return !this->m_running; });
+        lock.unlock();
+        this->flush();
+        lock.lock();
+    }
+}
@@ -0,0 +1,154 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// <summary>
+/// Logging backend that keeps the cost of a log line on the calling thread to formatting it into a queue. Lines go into a bounded lock free ring
+/// (any number of writers, one reader) and are passed to the sink by a background thread, so a slow sink (IVRDriverLog writes to a file) never
+/// holds up a frame. Lines that don't fit in the ring are dropped and counted, and a format that is logged too often in a window has its
+/// repeats suppressed, with a summary logged once the window is over.
+/// </summary>
+class AsyncLogger
+{
+public:
+    using Sink = std::function<void(const char*)>;
+    using Clock = std::chrono::steady_clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+
+    struct Options {
+        /// <summary>
+        /// Lines the ring holds, rounded up to a power of two
+        /// </summary>
+        std::size_t capacity = 256;
+
+        /// <summary>
+        /// Lines allowed from one format string per window before the rest are suppressed, 0 for no limit
+        /// </summary>
+        uint32_t repeat_limit = 50;
+        std::chrono::milliseconds repeat_window{ 1000 };
+
+        /// <summary>
+        /// How often the background thread passes queued lines to the sink
+        /// </summary>
+        std::chrono::milliseconds flush_interval{ 20 };
+    };
+
+    struct Stats {
+        uint64_t written = 0;
+        uint64_t dropped = 0;
+        uint64_t suppressed = 0;
+    };
+
+    /// <summary>
+    /// Longest line kept, longer lines are truncated
+    /// </summary>
+    static constexpr std::size_t m_lineSize = 1024;
+
+    /// <summary>
+    /// Formats of repeated lines tracked for rate limiting, formats beyond this are never limited
+    /// </summary>
+    static constexpr std::size_t m_repeatTableSize = 64;
+
+    explicit AsyncLogger(Sink sink);
+
+    AsyncLogger(Sink sink, Options options, ClockFunction clock);
+
+    /// <summary>
+    /// Stops the background thread, passing any queued lines to the sink first
+    /// </summary>
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    /// <summary>
+    /// Queues a line, from any thread. Never blocks or allocates.
+    /// </summary>
+    /// <param name="format">printf style format. It is also what repeats are counted by, so it should be a string literal.</param>
+    /// <returns>Whether the line was queued, rather than dropped or suppressed</returns>
+    bool log(const char* format, ...);
+    bool logv(const char* format, va_list args);
+
+    /// <summary>
+    /// Starts passing queued lines to the sink on a background thread
+    /// </summary>
+    void start();
+
+    /// <summary>
+    /// Passes any queued lines to the sink, then stops the background thread
+    /// </summary>
+    void stop();
+
+    /// <summary>
+    /// Passes queued lines, and summaries of dropped and suppressed lines, to the sink on the calling thread
+    /// </summary>
+    void flush();
+
+    Stats getStats() const;
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        char text[m_lineSize];
+    };
+
+    struct RepeatCounter {
+        std::atomic<const char*> format{ nullptr };
+        std::atomic<int64_t> window{ -1 };
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<uint32_t> suppressed{ 0 };
+    };
+
+    /// <summary>
+    /// Counts a line against its format's limit
+    /// </summary>
+    /// <returns>Whether the line should be logged</returns>
+    bool allowRepeat(const char* format, int64_t window);
+
+    int64_t getWindow() const;
+
+    void run();
+
+    Sink m_sink;
+    Options m_options;
+    ClockFunction m_clock;
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_enqueuePosition{ 0 };
+    alignas(64) std::size_t m_dequeuePosition = 0;
+
+    RepeatCounter m_repeats[m_repeatTableSize];
+
+    std::atomic<uint64_t> m_written{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+    std::atomic<uint64_t> m_suppressed{ 0 };
+    uint64_t m_reportedDropped = 0;
+    int64_t m_reportedWindows[m_repeatTableSize];
+
+    /// <summary>
+    /// Held by whichever thread is reading the ring, writers never take it
+    /// </summary>
+    std::mutex m_flushMutex;
+
+    std::mutex m_threadMutex;
+    std::condition_variable m_wake;
+    bool m_running = false;
+    std::thread m_worker;
+};
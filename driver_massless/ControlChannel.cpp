@@ -0,0 +1,81 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ControlChannel.hpp"
+
+ControlChannel::ControlChannel(RuntimeParameters parameters) :
+    m_parameters(parameters)
+{}
+
+RuntimeParameters ControlChannel::getParameters() const
+{
+    return this->m_parameters.load();
+}
+
+uint64_t ControlChannel::getParametersVersion() const
+{
+    return this->m_parameters.getVersion();
+}
+
+void ControlChannel::updateParameters(const std::function<void(RuntimeParameters&)>& update)
+{
+    // Only writers are serialised, readers never wait
+    std::lock_guard<std::mutex> lock(this->m_parametersWriteMutex);
+    RuntimeParameters parameters = this->m_parameters.load();
+    update(parameters);
+    this->m_parameters.store(parameters);
+}
+
+ControlTelemetry ControlChannel::getTelemetry() const
+{
+    return this->m_telemetry.load();
+}
+
+void ControlChannel::publishTelemetry(const ControlTelemetry& telemetry)
+{
+    this->m_telemetry.store(telemetry);
+}
+
+void ControlChannel::setHandlers(Handlers handlers)
+{
+    this->m_handlers = std::move(handlers);
+}
+
+const ControlChannel::Handlers& ControlChannel::getHandlers() const
+{
+    return this->m_handlers;
+}
+
+std::future<std::string> ControlChannel::post(std::function<std::string()> task)
+{
+    std::packaged_task<std::string()> packaged(std::move(task));
+    auto result = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> lock(this->m_tasksMutex);
+        this->m_tasks.push_back(std::move(packaged));
+        this->m_hasTasks = true;
+    }
+    return result;
+}
+
+std::size_t ControlChannel::runPending()
+{
+    if (!this->m_hasTasks.load(std::memory_order_acquire))
+        return 0;
+
+    std::deque<std::packaged_task<std::string()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(this->m_tasksMutex);
+        tasks.swap(this->m_tasks);
+        this->m_hasTasks = false;
+    }
+    for (auto& task : tasks)
+        task();
+    return tasks.size();
+}
@@ -0,0 +1,129 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <SeqlockValue.hpp>
+
+/// <summary>
+/// Parameters that can be changed while the driver is running (see ControlSession). The frame thread reads a snapshot of them once per frame.
+/// </summary>
+struct RuntimeParameters {
+    bool detailed_logging = false;
+    bool reference_fusion = false;
+
+    /// <summary>
+    /// See ReferenceFusion::Options
+    /// </summary>
+    float fusion_outlier_distance = 0.05f;
+    float fusion_jitter_smoothing = 0.1f;
+    uint32_t fusion_reenroll_frames = 90;
+};
+
+/// <summary>
+/// What the frame thread last did, for the control feed
+/// </summary>
+struct ControlTelemetry {
+    uint64_t frame = 0;
+    bool pen_added = false;
+    bool pose_valid = false;
+    int32_t tracking_result = 0;
+    double position[3] = { 0, 0, 0 };
+    double rotation[4] = { 1, 0, 0, 0 };
+    bool reference_locked = false;
+    double run_frame_mean_us = 0;
+
+    /// <summary>
+    /// Static strings, ie. PowerController::getModeName
+    /// </summary>
+    const char* power_mode = "";
+    const char* ownership = "";
+};
+
+/// <summary>
+/// State shared between the frame thread and the control server's thread. The frame thread never takes a lock here: parameters and telemetry
+/// are seqlocked, and posted tasks are only locked for when some are pending.
+/// </summary>
+class ControlChannel
+{
+public:
+    /// <summary>
+    /// Work the control server needs done on the frame thread, returning a JSON value
+    /// </summary>
+    struct Handlers {
+        /// <summary>
+        /// Runs a debug request (as PenController::DebugRequest) and returns its response
+        /// </summary>
+        std::function<std::string(std::string_view request)> capture;
+
+        /// <summary>
+        /// Drops the current tracking reference and searches again, for the given serial if there is one
+        /// </summary>
+        std::function<std::string(const std::optional<std::string>& serial)> select_reference;
+    };
+
+    explicit ControlChannel(RuntimeParameters parameters = RuntimeParameters());
+
+    /// <summary>
+    /// Gets the latest parameters (never blocks)
+    /// </summary>
+    RuntimeParameters getParameters() const;
+
+    /// <summary>
+    /// Gets the number of times the parameters have been changed
+    /// </summary>
+    uint64_t getParametersVersion() const;
+
+    /// <summary>
+    /// Changes the parameters, from any thread. Can wait for another change in progress, but never for a reader.
+    /// </summary>
+    void updateParameters(const std::function<void(RuntimeParameters&)>& update);
+
+    ControlTelemetry getTelemetry() const;
+
+    /// <summary>
+    /// Publishes what the frame thread did this frame (frame thread only)
+    /// </summary>
+    void publishTelemetry(const ControlTelemetry& telemetry);
+
+    void setHandlers(Handlers handlers);
+    const Handlers& getHandlers() const;
+
+    /// <summary>
+    /// Queues work for the frame thread
+    /// </summary>
+    /// <returns>The work's result, once the frame thread has run it</returns>
+    std::future<std::string> post(std::function<std::string()> task);
+
+    /// <summary>
+    /// Runs any posted work (frame thread only)
+    /// </summary>
+    /// <returns>Number of tasks run</returns>
+    std::size_t runPending();
+
+private:
+    SeqlockValue<RuntimeParameters> m_parameters;
+    std::mutex m_parametersWriteMutex;
+    SeqlockValue<ControlTelemetry> m_telemetry;
+
+    Handlers m_handlers;
+
+    std::mutex m_tasksMutex;
+    std::deque<std::packaged_task<std::string()>> m_tasks;
+    std::atomic<bool> m_hasTasks = false;
+};
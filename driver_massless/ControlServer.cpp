@@ -0,0 +1,364 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ControlServer.hpp"
+#include <ControlSession.hpp>
+#include <DriverLog.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+namespace {
+    // Caps how long the server sleeps, so a stalled session can't hold up shutdown for long even without a wake
+    constexpr std::chrono::milliseconds max_wait(50);
+
+    /// <summary>
+    /// Per connection state that doesn't depend on the transport
+    /// </summary>
+    struct Connection {
+        explicit Connection(std::shared_ptr<ControlChannel> channel) :
+            session(channel)
+        {}
+
+        ControlSession session;
+        std::string input;
+        std::string output;
+
+        /// <summary>
+        /// Handles any complete lines received, and queues whatever is ready to send
+        /// </summary>
+        /// <returns>Whether the connection is still usable</returns>
+        bool process()
+        {
+            std::vector<std::string> lines;
+            std::size_t start = 0;
+            for (std::size_t end; (end = this->input.find('\n', start)) != std::string::npos; start = end + 1) {
+                std::string_view line(this->input.data() + start, end - start);
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+                if (!line.empty())
+                    this->session.handleLine(line, lines);
+            }
+            this->input.erase(0, start);
+            if (this->input.size() > ControlServer::m_maxLineLength)
+                return false;
+
+            this->session.poll(lines);
+            for (const auto& line : lines) {
+                this->output += line;
+                this->output += '\n';
+            }
+            return this->output.size() <= ControlServer::m_maxPendingOutput;
+        }
+
+        std::chrono::milliseconds getWait() const
+        {
+            auto deadline = this->session.getNextDeadline();
+            if (!deadline.has_value())
+                return max_wait;
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+            return std::clamp(wait, std::chrono::milliseconds(0), max_wait);
+        }
+    };
+}
+
+std::unique_ptr<ControlServer> ControlServer::create(std::shared_ptr<ControlChannel> channel, const std::string& address)
+{
+    std::unique_ptr<ControlServer> server(new ControlServer(channel, address));
+#ifdef _WIN32
+    // The first instance is created here so a name clash is reported to the caller. The default security only lets the creator (and
+    // administrators) write to it.
+    HANDLE pipe = CreateNamedPipeA(address.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1, 64 * 1024, 64 * 1024, 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE)
+        return nullptr;
+    server->m_pipe = pipe;
+    server->m_stopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (server->m_stopEvent == nullptr)
+        return nullptr;
+#else
+    sockaddr_un socket_address = {};
+    socket_address.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(socket_address.sun_path))
+        return nullptr;
+    std::memcpy(socket_address.sun_path, address.c_str(), address.size() + 1);
+
+    server->m_listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (server->m_listener < 0)
+        return nullptr;
+
+    // A socket file left behind by a driver that crashed, as long as nothing is still listening on it
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        if (connect(probe, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) != 0 && errno == ECONNREFUSED)
+            unlink(address.c_str());
+        close(probe);
+    }
+
+    // Private to this user, set before listening so nobody else can connect in between
+    if (bind(server->m_listener, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) != 0) {
+        // Not ours to remove, ie. another driver instance is listening on it
+        close(server->m_listener);
+        server->m_listener = -1;
+        return nullptr;
+    }
+    if (chmod(address.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(server->m_listener, 4) != 0)
+        return nullptr;
+
+#ifdef __linux__
+    server->m_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#else
+    int wake[2];
+    if (pipe(wake) == 0) {
+        fcntl(wake[0], F_SETFL, O_NONBLOCK);
+        fcntl(wake[1], F_SETFL, O_NONBLOCK);
+        server->m_wake = wake[0];
+        server->m_wakeWrite = wake[1];
+    }
+#endif
+    if (server->m_wake < 0)
+        return nullptr;
+#endif
+
+    server->m_thread = std::thread([server = server.get()]() { server->run(); });
+    DRIVER_LOG_INFO(General, "Control server listening on %s\n", address.c_str());
+    return server;
+}
+
+ControlServer::ControlServer(std::shared_ptr<ControlChannel> channel, std::string address) :
+    m_channel(channel),
+    m_address(std::move(address))
+{}
+
+ControlServer::~ControlServer()
+{
+    this->stop();
+    if (this->m_thread.joinable())
+        this->m_thread.join();
+#ifdef _WIN32
+    if (this->m_pipe != nullptr)
+        CloseHandle(this->m_pipe);
+    if (this->m_stopEvent != nullptr)
+        CloseHandle(this->m_stopEvent);
+#else
+    if (this->m_listener >= 0) {
+        close(this->m_listener);
+        unlink(this->m_address.c_str());
+    }
+    if (this->m_wake >= 0)
+        close(this->m_wake);
+    if (this->m_wakeWrite >= 0)
+        close(this->m_wakeWrite);
+#endif
+}
+
+const std::string& ControlServer::getAddress() const
+{
+    return this->m_address;
+}
+
+uint64_t ControlServer::getConnectionCount() const
+{
+    return this->m_connections;
+}
+
+void ControlServer::stop()
+{
+    this->m_isRunning = false;
+#ifdef _WIN32
+    if (this->m_stopEvent != nullptr)
+        SetEvent(this->m_stopEvent);
+#else
+    uint64_t one = 1;
+    int wake = this->m_wakeWrite >= 0 ? this->m_wakeWrite : this->m_wake;
+    if (wake >= 0) {
+        [[maybe_unused]] auto ignored = write(wake, &one, this->m_wakeWrite >= 0 ? 1 : sizeof(one));
+    }
+#endif
+}
+
+#ifdef _WIN32
+std::string ControlServer::getDefaultAddress()
+{
+    return "\\\\.\\pipe\\MasslessPenControl";
+}
+
+void ControlServer::run()
+{
+    // One client at a time, which is all the tools need
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    OVERLAPPED write_overlapped = {};
+    write_overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    HANDLE pipe = this->m_pipe;
+
+    while (this->m_isRunning) {
+        ResetEvent(overlapped.hEvent);
+        if (!ConnectNamedPipe(pipe, &overlapped)) {
+            DWORD error = GetLastError();
+            if (error == ERROR_IO_PENDING) {
+                HANDLE waits[2] = { this->m_stopEvent, overlapped.hEvent };
+                if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+                    CancelIo(pipe);
+                    break;
+                }
+            }
+            else if (error != ERROR_PIPE_CONNECTED) {
+                break;
+            }
+        }
+        ++this->m_connections;
+
+        Connection connection(this->m_channel);
+        char buffer[4096];
+        bool reading = false;
+        while (this->m_isRunning) {
+            if (!reading) {
+                ResetEvent(overlapped.hEvent);
+                if (!ReadFile(pipe, buffer, sizeof(buffer), nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+                    break;
+                reading = true;
+            }
+
+            HANDLE waits[2] = { this->m_stopEvent, overlapped.hEvent };
+            DWORD waited = WaitForMultipleObjects(2, waits, FALSE, static_cast<DWORD>(connection.getWait().count()));
+            if (waited == WAIT_OBJECT_0)
+                break;
+            if (waited == WAIT_OBJECT_0 + 1) {
+                reading = false;
+                DWORD received = 0;
+                if (!GetOverlappedResult(pipe, &overlapped, &received, FALSE))
+                    break;
+                connection.input.append(buffer, received);
+            }
+            if (!connection.process())
+                break;
+
+            // Responses are small, so waiting for each write doesn't hold up reading for long
+            if (!connection.output.empty()) {
+                DWORD written = 0;
+                ResetEvent(write_overlapped.hEvent);
+                if (!WriteFile(pipe, connection.output.data(), static_cast<DWORD>(connection.output.size()), nullptr, &write_overlapped)
+                    && GetLastError() != ERROR_IO_PENDING)
+                    break;
+                if (!GetOverlappedResult(pipe, &write_overlapped, &written, TRUE))
+                    break;
+                connection.output.erase(0, written);
+            }
+        }
+        if (reading) {
+            CancelIo(pipe);
+            DWORD ignored;
+            GetOverlappedResult(pipe, &overlapped, &ignored, TRUE);
+        }
+        DisconnectNamedPipe(pipe);
+    }
+
+    CloseHandle(overlapped.hEvent);
+    CloseHandle(write_overlapped.hEvent);
+}
+#else
+std::string ControlServer::getDefaultAddress()
+{
+    if (const char* runtime_directory = std::getenv("XDG_RUNTIME_DIR"); runtime_directory != nullptr && runtime_directory[0] != '\0')
+        return std::string(runtime_directory) + "/massless_pen_control.sock";
+    return "/tmp/massless_pen_control_" + std::to_string(getuid()) + ".sock";
+}
+
+void ControlServer::run()
+{
+    struct Client {
+        int socket;
+        Connection connection;
+    };
+    std::vector<std::unique_ptr<Client>> clients;
+    std::vector<pollfd> fds;
+
+    while (this->m_isRunning) {
+        fds.clear();
+        fds.push_back({ this->m_listener, POLLIN, 0 });
+        fds.push_back({ this->m_wake, POLLIN, 0 });
+        auto wait = max_wait;
+        for (const auto& client : clients) {
+            fds.push_back({ client->socket, static_cast<short>(POLLIN | (client->connection.output.empty() ? 0 : POLLOUT)), 0 });
+            wait = std::min(wait, client->connection.getWait());
+        }
+
+        if (poll(fds.data(), fds.size(), static_cast<int>(wait.count())) < 0 && errno != EINTR)
+            break;
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            [[maybe_unused]] auto ignored = read(this->m_wake, &count, sizeof(count));
+        }
+        if (fds[0].revents & POLLIN) {
+            int socket;
+            while ((socket = accept(this->m_listener, nullptr, nullptr)) >= 0) {
+                fcntl(socket, F_SETFD, FD_CLOEXEC);
+                fcntl(socket, F_SETFL, O_NONBLOCK);
+                clients.push_back(std::make_unique<Client>(Client{ socket, Connection(this->m_channel) }));
+                ++this->m_connections;
+            }
+        }
+
+        // Only the clients that were polled, new ones get their turn next time round
+        std::size_t polled = fds.size() - 2;
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            Client& client = *clients[i];
+            short revents = i < polled ? fds[i + 2].revents : 0;
+            bool open = (revents & (POLLERR | POLLNVAL)) == 0;
+
+            if (open && (revents & (POLLIN | POLLHUP))) {
+                char buffer[4096];
+                ssize_t received;
+                while ((received = recv(client.socket, buffer, sizeof(buffer), 0)) > 0)
+                    client.connection.input.append(buffer, static_cast<std::size_t>(received));
+                open = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+            }
+            open = open && client.connection.process();
+
+            while (open && !client.connection.output.empty()) {
+                ssize_t sent = send(client.socket, client.connection.output.data(), client.connection.output.size(), MSG_NOSIGNAL);
+                if (sent < 0) {
+                    open = errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+                    break;
+                }
+                client.connection.output.erase(0, static_cast<std::size_t>(sent));
+            }
+
+            if (!open) {
+                close(client.socket);
+                clients[i].reset();
+            }
+        }
+        clients.erase(std::remove(clients.begin(), clients.end(), nullptr), clients.end());
+    }
+
+    for (const auto& client : clients)
+        close(client->socket);
+}
+#endif
@@ -0,0 +1,83 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <ControlChannel.hpp>
+
+/// <summary>
+/// Serves ControlSession's JSON lines protocol on a background thread, over a Unix domain socket (only accessible to the user running the
+/// driver), or on Windows a named pipe. Tools like socat can be used to talk to it by hand.
+/// </summary>
+class ControlServer
+{
+public:
+    /// <summary>
+    /// Upper bound on a request line, longer ones close the connection
+    /// </summary>
+    static constexpr std::size_t m_maxLineLength = 64 * 1024;
+
+    /// <summary>
+    /// Clients that fall this far behind reading responses and feed samples are disconnected
+    /// </summary>
+    static constexpr std::size_t m_maxPendingOutput = 1024 * 1024;
+
+    /// <summary>
+    /// Starts listening
+    /// </summary>
+    /// <returns>The server, or nullptr if the address couldn't be listened on</returns>
+    static std::unique_ptr<ControlServer> create(std::shared_ptr<ControlChannel> channel, const std::string& address = getDefaultAddress());
+
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    const std::string& getAddress() const;
+
+    /// <summary>
+    /// Gets the number of clients that have connected
+    /// </summary>
+    uint64_t getConnectionCount() const;
+
+    /// <summary>
+    /// Gets the socket path, or on Windows the pipe name
+    /// </summary>
+    static std::string getDefaultAddress();
+
+private:
+    ControlServer(std::shared_ptr<ControlChannel> channel, std::string address);
+
+    void run();
+    void stop();
+
+    std::shared_ptr<ControlChannel> m_channel;
+    std::string m_address;
+
+#ifdef _WIN32
+    void* m_pipe = nullptr;
+    void* m_stopEvent = nullptr;
+#else
+    int m_listener = -1;
+    int m_wake = -1;
+
+    /// <summary>
+    /// Write end of the wake pipe, where there is no eventfd
+    /// </summary>
+    int m_wakeWrite = -1;
+#endif
+
+    std::atomic<bool> m_isRunning = true;
+    std::atomic<uint64_t> m_connections = 0;
+    std::thread m_thread;
+};
@@ -0,0 +1,246 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ControlSession.hpp"
+
+#include <variant>
+
+using json = nlohmann::json;
+
+namespace {
+    /// <summary>
+    /// A runtime parameter and the values it accepts
+    /// </summary>
+    struct Parameter {
+        const char* name;
+        std::variant<bool RuntimeParameters::*, float RuntimeParameters::*, uint32_t RuntimeParameters::*> member;
+        double min = 0;
+        double max = 0;
+    };
+
+    const Parameter parameters[] = {
+        { "detailed_logging", &RuntimeParameters::detailed_logging },
+        { "reference_fusion", &RuntimeParameters::reference_fusion },
+        { "fusion_outlier_distance", &RuntimeParameters::fusion_outlier_distance, 0.001, 1.0 },
+        { "fusion_jitter_smoothing", &RuntimeParameters::fusion_jitter_smoothing, 0.001, 1.0 },
+        { "fusion_reenroll_frames", &RuntimeParameters::fusion_reenroll_frames, 1, 100000 },
+    };
+
+    const Parameter* findParameter(std::string_view name)
+    {
+        for (const auto& parameter : parameters) {
+            if (name == parameter.name)
+                return &parameter;
+        }
+        return nullptr;
+    }
+
+    json getValue(const RuntimeParameters& values, const Parameter& parameter)
+    {
+        return std::visit([&](auto member) { return json(values.*member); }, parameter.member);
+    }
+
+    /// <summary>
+    /// Sets a parameter from JSON, if it is the right type and in range
+    /// </summary>
+    bool setValue(RuntimeParameters& values, const Parameter& parameter, const json& value)
+    {
+        return std::visit([&](auto member) {
+            using T = std::remove_reference_t<decltype(values.*member)>;
+            if constexpr (std::is_same_v<T, bool>) {
+                if (!value.is_boolean())
+                    return false;
+                values.*member = value.get<bool>();
+            }
+            else {
+                if (!value.is_number() || (std::is_integral_v<T> && !value.is_number_integer()))
+                    return false;
+                double number = value.get<double>();
+                if (number < parameter.min || number > parameter.max)
+                    return false;
+                values.*member = static_cast<T>(number);
+            }
+            return true;
+        }, parameter.member);
+    }
+}
+
+ControlSession::ControlSession(std::shared_ptr<ControlChannel> channel) :
+    ControlSession(channel, []() { return std::chrono::steady_clock::now(); })
+{}
+
+ControlSession::ControlSession(std::shared_ptr<ControlChannel> channel, ClockFunction clock) :
+    m_channel(channel),
+    m_clock(clock)
+{}
+
+void ControlSession::handleLine(std::string_view line, std::vector<std::string>& output)
+{
+    json request = json::parse(line.begin(), line.end(), nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        output.push_back(this->fail(nullptr, "invalid_json"));
+        return;
+    }
+    json id = request.contains("id") ? request["id"] : json();
+    if (!request.contains("cmd") || !request["cmd"].is_string()) {
+        output.push_back(this->fail(id, "missing_cmd"));
+        return;
+    }
+    std::string command = request["cmd"].get<std::string>();
+
+    if (command == "get") {
+        RuntimeParameters values = this->m_channel->getParameters();
+        if (request.contains("name")) {
+            const Parameter* parameter = request["name"].is_string() ? findParameter(request["name"].get<std::string>()) : nullptr;
+            if (parameter == nullptr)
+                output.push_back(this->fail(id, "unknown_parameter"));
+            else
+                output.push_back(this->respond(id, { { "name", parameter->name }, { "value", getValue(values, *parameter) } }));
+        }
+        else {
+            json all = json::object();
+            for (const auto& parameter : parameters)
+                all[parameter.name] = getValue(values, parameter);
+            output.push_back(this->respond(id, { { "parameters", all } }));
+        }
+    }
+    else if (command == "set") {
+        const Parameter* parameter = request.contains("name") && request["name"].is_string() ? findParameter(request["name"].get<std::string>()) : nullptr;
+        if (parameter == nullptr) {
+            output.push_back(this->fail(id, "unknown_parameter"));
+            return;
+        }
+        bool valid = false;
+        json value;
+        this->m_channel->updateParameters([&](RuntimeParameters& values) {
+            valid = request.contains("value") && setValue(values, *parameter, request["value"]);
+            value = getValue(values, *parameter);
+        });
+        if (valid)
+            output.push_back(this->respond(id, { { "name", parameter->name }, { "value", value } }));
+        else
+            output.push_back(this->fail(id, "invalid_value"));
+    }
+    else if (command == "subscribe") {
+        double rate_hz = request.contains("rate_hz") && request["rate_hz"].is_number() ? request["rate_hz"].get<double>() : 10.0;
+        if (!(rate_hz > 0)) {
+            output.push_back(this->fail(id, "invalid_rate"));
+            return;
+        }
+        rate_hz = std::min(rate_hz, m_maxFeedRateHz);
+        this->m_feedInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate_hz));
+        this->m_nextFeed = this->m_clock();
+        output.push_back(this->respond(id, { { "rate_hz", rate_hz } }));
+    }
+    else if (command == "unsubscribe") {
+        this->m_feedInterval = std::nullopt;
+        output.push_back(this->respond(id, json::object()));
+    }
+    else if (command == "capture") {
+        const auto& capture = this->m_channel->getHandlers().capture;
+        if (!capture || !request.contains("request") || !request["request"].is_string()) {
+            output.push_back(this->fail(id, capture ? "missing_request" : "unavailable"));
+            return;
+        }
+        std::string debug_request = request["request"].get<std::string>();
+        this->m_pending.push_back({ id, "capture", this->m_channel->post([capture, debug_request]() { return capture(debug_request); }) });
+    }
+    else if (command == "select_reference") {
+        const auto& select_reference = this->m_channel->getHandlers().select_reference;
+        if (!select_reference) {
+            output.push_back(this->fail(id, "unavailable"));
+            return;
+        }
+        std::optional<std::string> serial;
+        if (request.contains("serial") && request["serial"].is_string())
+            serial = request["serial"].get<std::string>();
+        this->m_pending.push_back({ id, "reference", this->m_channel->post([select_reference, serial]() { return select_reference(serial); }) });
+    }
+    else {
+        output.push_back(this->fail(id, "unknown_cmd"));
+    }
+}
+
+void ControlSession::poll(std::vector<std::string>& output)
+{
+    // Frame thread work finishes in order, but check them all in case one was slow
+    for (auto it = this->m_pending.begin(); it != this->m_pending.end();) {
+        if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        std::string text = it->result.get();
+        json result = json::parse(text, nullptr, false);
+        output.push_back(this->respond(it->id, { { it->result_key, result.is_discarded() ? json(text) : result } }));
+        it = this->m_pending.erase(it);
+    }
+
+    if (!this->m_feedInterval.has_value())
+        return;
+    auto now = this->m_clock();
+    if (now < this->m_nextFeed)
+        return;
+    this->m_nextFeed += *this->m_feedInterval;
+    if (this->m_nextFeed < now)
+        this->m_nextFeed = now + *this->m_feedInterval;
+
+    // Only new frames, a stalled frame thread shows up as a gap in the feed
+    ControlTelemetry telemetry = this->m_channel->getTelemetry();
+    if (telemetry.frame == this->m_lastFeedFrame)
+        return;
+    this->m_lastFeedFrame = telemetry.frame;
+    json feed = {
+        { "frame", telemetry.frame },
+        { "pen_added", telemetry.pen_added },
+        { "pose_valid", telemetry.pose_valid },
+        { "tracking_result", telemetry.tracking_result },
+        { "position", { telemetry.position[0], telemetry.position[1], telemetry.position[2] } },
+        { "rotation", { telemetry.rotation[0], telemetry.rotation[1], telemetry.rotation[2], telemetry.rotation[3] } },
+        { "reference_locked", telemetry.reference_locked },
+        { "run_frame_mean_us", telemetry.run_frame_mean_us },
+        { "power_mode", telemetry.power_mode },
+        { "ownership", telemetry.ownership }
+    };
+    output.push_back(json({ { "feed", feed } }).dump());
+}
+
+std::optional<std::chrono::steady_clock::time_point> ControlSession::getNextDeadline() const
+{
+    // There is no notification when frame thread work finishes, so check again soon
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (!this->m_pending.empty())
+        deadline = this->m_clock() + std::chrono::milliseconds(5);
+    if (this->m_feedInterval.has_value() && (!deadline.has_value() || this->m_nextFeed < *deadline))
+        deadline = this->m_nextFeed;
+    return deadline;
+}
+
+std::vector<std::string> ControlSession::getParameterNames()
+{
+    std::vector<std::string> names;
+    for (const auto& parameter : parameters)
+        names.push_back(parameter.name);
+    return names;
+}
+
+std::string ControlSession::respond(const json& id, json response) const
+{
+    response["ok"] = true;
+    if (!id.is_null())
+        response["id"] = id;
+    return response.dump();
+}
+
+std::string ControlSession::fail(const json& id, const char* error) const
+{
+    json response = { { "ok", false }, { "error", error } };
+    if (!id.is_null())
+        response["id"] = id;
+    return response.dump();
+}
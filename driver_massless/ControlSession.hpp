@@ -0,0 +1,83 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <json.hpp>
+
+#include <ControlChannel.hpp>
+
+/// <summary>
+/// One client of the control server. Requests and responses are JSON objects, one per line:
+///   {"cmd":"get"} or {"cmd":"get","name":"reference_fusion"}              read runtime parameters
+///   {"cmd":"set","name":"fusion_outlier_distance","value":0.03}          change one, effective from the next frame
+///   {"cmd":"subscribe","rate_hz":30} / {"cmd":"unsubscribe"}              a feed of the pen pose and frame metrics
+///   {"cmd":"capture","request":"pose_history 32"}                         run a debug request on the frame thread
+///   {"cmd":"select_reference"} or {"cmd":"select_reference","serial":"x"} search for a tracking reference again
+/// Responses carry "ok" (and "error" when false), and echo any "id" in the request. Feed samples are {"feed":{...}}.
+/// Transport independent, see ControlServer.
+/// </summary>
+class ControlSession
+{
+public:
+    using ClockFunction = std::function<std::chrono::steady_clock::time_point()>;
+
+    static constexpr double m_maxFeedRateHz = 100.0;
+
+    explicit ControlSession(std::shared_ptr<ControlChannel> channel);
+    ControlSession(std::shared_ptr<ControlChannel> channel, ClockFunction clock);
+
+    /// <summary>
+    /// Handles one request, appending the response if it is ready now
+    /// </summary>
+    void handleLine(std::string_view line, std::vector<std::string>& output);
+
+    /// <summary>
+    /// Appends responses that have become ready since: finished frame thread work, and feed samples that are due
+    /// </summary>
+    void poll(std::vector<std::string>& output);
+
+    /// <summary>
+    /// Gets when poll next has something to do
+    /// </summary>
+    /// <returns>The time, or nullopt if only a new request can produce output</returns>
+    std::optional<std::chrono::steady_clock::time_point> getNextDeadline() const;
+
+    /// <summary>
+    /// Gets the names of the runtime parameters, in the order they are listed by get
+    /// </summary>
+    static std::vector<std::string> getParameterNames();
+
+private:
+    struct Pending {
+        nlohmann::json id;
+        std::string result_key;
+        std::future<std::string> result;
+    };
+
+    std::string respond(const nlohmann::json& id, nlohmann::json response) const;
+    std::string fail(const nlohmann::json& id, const char* error) const;
+
+    std::shared_ptr<ControlChannel> m_channel;
+    ClockFunction m_clock;
+
+    std::vector<Pending> m_pending;
+
+    std::optional<std::chrono::steady_clock::duration> m_feedInterval;
+    std::chrono::steady_clock::time_point m_nextFeed;
+    uint64_t m_lastFeedFrame = 0;
+};
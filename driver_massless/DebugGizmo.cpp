@@ -17,7 +17,7 @@ DebugGizmo::DebugGizmo(std::shared_ptr<SettingsManager> settings_manager, std::f
     this->m_currentGizmoPose = this->getNotTrackingOpenVRPose();
 }
 
-void DebugGizmo::update(std::vector<vr::VREvent_t> events)
+void DebugGizmo::update(EventSpan events)
 {
     if (this->m_deviceIndex != vr::k_unTrackedDeviceIndexInvalid)
     {
@@ -52,8 +52,17 @@ void* DebugGizmo::GetComponent(const char* pchComponentNameAndVersion)
 
 void DebugGizmo::DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize)
 {
-    if (unResponseBufferSize >= 1)
-        pchResponseBuffer[0] = 0;
+    DebugResponseWriter writer(pchResponseBuffer, unResponseBufferSize);
+    auto [command, argument] = DebugResponseWriter::splitRequest(pchRequest);
+    if (auto server_driver = ServerDriver::instance(); server_driver != nullptr) {
+        server_driver->handleDebugRequest(command, argument, writer);
+    }
+    else {
+        writer.beginObject();
+        writer.error("unknown_request");
+        writer.endObject();
+    }
+    writer.finish();
 }
 
 vr::DriverPose_t DebugGizmo::GetPose()
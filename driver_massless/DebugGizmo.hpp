@@ -25,7 +25,7 @@ public:
     /// Updates the internal state of this device.
     /// Will be called every time ServerDriver::RunFrame is called
     /// </summary>
-    virtual void update(std::vector<vr::VREvent_t> events) override;
+    virtual void update(EventSpan events) override;
 
     /// <summary>
     /// Activates this controller
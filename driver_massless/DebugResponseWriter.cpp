@@ -0,0 +1,273 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "DebugResponseWriter.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+DebugResponseWriter::DebugResponseWriter(char* buffer, uint32_t buffer_size) :
+    m_buffer(buffer),
+    m_capacity(buffer != nullptr && buffer_size > 0 ? buffer_size - 1 : 0)
+{
+    if (this->m_buffer != nullptr && buffer_size > 0)
+        this->m_buffer[0] = 0;
+}
+
+void DebugResponseWriter::beginObject()
+{
+    this->beforeValue();
+    this->put('{');
+    if (this->m_depth + 1 < m_maxDepth)
+        this->m_needsComma[++this->m_depth] = false;
+    else
+        ++this->m_untrackedDepth;
+}
+
+void DebugResponseWriter::endObject()
+{
+    if (this->m_untrackedDepth > 0)
+        --this->m_untrackedDepth;
+    else if (this->m_depth > 0)
+        --this->m_depth;
+    this->put('}');
+}
+
+void DebugResponseWriter::beginArray()
+{
+    this->beforeValue();
+    this->put('[');
+    if (this->m_depth + 1 < m_maxDepth)
+        this->m_needsComma[++this->m_depth] = false;
+    else
+        ++this->m_untrackedDepth;
+}
+
+void DebugResponseWriter::endArray()
+{
+    if (this->m_untrackedDepth > 0)
+        --this->m_untrackedDepth;
+    else if (this->m_depth > 0)
+        --this->m_depth;
+    this->put(']');
+}
+
+void DebugResponseWriter::key(std::string_view name)
+{
+    this->beforeValue();
+    this->put('"');
+    this->putEscaped(name);
+    this->put("\":");
+    this->m_afterKey = true;
+}
+
+void DebugResponseWriter::value(std::string_view string_value)
+{
+    this->beforeValue();
+    this->put('"');
+    this->putEscaped(string_value);
+    this->put('"');
+}
+
+void DebugResponseWriter::value(const char* string_value)
+{
+    if (string_value == nullptr) {
+        this->nullValue();
+        return;
+    }
+    this->value(std::string_view(string_value));
+}
+
+void DebugResponseWriter::value(bool bool_value)
+{
+    this->beforeValue();
+    this->put(bool_value ? "true" : "false");
+}
+
+void DebugResponseWriter::value(double number_value)
+{
+    // JSON has no representation for nan or inf
+    if (!std::isfinite(number_value)) {
+        this->nullValue();
+        return;
+    }
+    this->beforeValue();
+    char number[32];
+    int written = std::snprintf(number, sizeof(number), "%.6g", number_value);
+    if (written > 0)
+        this->put(std::string_view(number, static_cast<std::size_t>(written)));
+}
+
+void DebugResponseWriter::nullValue()
+{
+    this->beforeValue();
+    this->put("null");
+}
+
+void DebugResponseWriter::error(std::string_view message)
+{
+    this->field("error", message);
+}
+
+bool DebugResponseWriter::finish()
+{
+    if (this->m_buffer == nullptr || this->m_capacity == 0)
+        return this->m_length == 0;
+
+    if (!this->hasOverflowed()) {
+        this->m_buffer[this->m_length] = 0;
+        return true;
+    }
+
+    // Replace the truncated response with something a client can still parse
+    char overflow_response[64];
+    int written = std::snprintf(overflow_response, sizeof(overflow_response), "{\"error\":\"buffer_too_small\",\"required\":%zu}", this->m_length + 1);
+    if (written > 0 && static_cast<std::size_t>(written) <= this->m_capacity) {
+        std::memcpy(this->m_buffer, overflow_response, static_cast<std::size_t>(written) + 1);
+    }
+    else {
+        this->m_buffer[0] = 0;
+    }
+    return false;
+}
+
+bool DebugResponseWriter::hasOverflowed() const
+{
+    return this->m_length > this->m_capacity;
+}
+
+std::size_t DebugResponseWriter::requiredLength() const
+{
+    return this->m_length;
+}
+
+std::pair<std::string_view, std::string_view> DebugResponseWriter::splitRequest(const char* request)
+{
+    if (request == nullptr)
+        return { std::string_view(), std::string_view() };
+
+    constexpr std::string_view whitespace = " \t\r\n";
+    std::string_view remaining(request);
+
+    auto trim = [&](std::string_view text) {
+        std::size_t begin = text.find_first_not_of(whitespace);
+        if (begin == std::string_view::npos)
+            return std::string_view();
+        std::size_t end = text.find_last_not_of(whitespace);
+        return text.substr(begin, end - begin + 1);
+    };
+
+    remaining = trim(remaining);
+    std::size_t split = remaining.find_first_of(whitespace);
+    if (split == std::string_view::npos)
+        return { remaining, std::string_view() };
+    return { remaining.substr(0, split), trim(remaining.substr(split)) };
+}
+
+uint32_t DebugResponseWriter::parseUnsigned(std::string_view argument, uint32_t default_value)
+{
+    if (argument.empty())
+        return default_value;
+    uint64_t parsed = 0;
+    for (char character : argument) {
+        if (character < '0' || character > '9')
+            return default_value;
+        parsed = parsed * 10 + static_cast<uint64_t>(character - '0');
+        if (parsed > UINT32_MAX)
+            return UINT32_MAX;
+    }
+    return static_cast<uint32_t>(parsed);
+}
+
+std::optional<std::array<float, 3>> DebugResponseWriter::parseVector3(std::string_view argument)
+{
+    std::string terminated(argument);
+    std::array<float, 3> values;
+    const char* position = terminated.c_str();
+    for (float& value : values) {
+        char* end = nullptr;
+        value = std::strtof(position, &end);
+        if (end == position)
+            return std::nullopt;
+        position = end;
+    }
+    while (*position == ' ')
+        ++position;
+    if (*position != '\0')
+        return std::nullopt;
+    return values;
+}
+
+void DebugResponseWriter::put(char character)
+{
+    if (this->m_length < this->m_capacity)
+        this->m_buffer[this->m_length] = character;
+    ++this->m_length;
+}
+
+void DebugResponseWriter::put(std::string_view characters)
+{
+    for (char character : characters)
+        this->put(character);
+}
+
+void DebugResponseWriter::putEscaped(std::string_view characters)
+{
+    constexpr char hex_digits[] = "0123456789abcdef";
+    for (char character : characters) {
+        switch (character) {
+        case '"': this->put("\\\""); break;
+        case '\\': this->put("\\\\"); break;
+        case '\n': this->put("\\n"); break;
+        case '\r': this->put("\\r"); break;
+        case '\t': this->put("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(character) < 0x20) {
+                this->put("\\u00");
+                this->put(hex_digits[(character >> 4) & 0xF]);
+                this->put(hex_digits[character & 0xF]);
+            }
+            else {
+                this->put(character);
+            }
+        }
+    }
+}
+
+void DebugResponseWriter::beforeValue()
+{
+    if (this->m_afterKey) {
+        this->m_afterKey = false;
+        return;
+    }
+    if (this->m_needsComma[this->m_depth])
+        this->put(',');
+    this->m_needsComma[this->m_depth] = true;
+}
+
+void DebugResponseWriter::writeSigned(int64_t integral_value)
+{
+    this->beforeValue();
+    char number[24];
+    int written = std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(integral_value));
+    if (written > 0)
+        this->put(std::string_view(number, static_cast<std::size_t>(written)));
+}
+
+void DebugResponseWriter::writeUnsigned(uint64_t integral_value)
+{
+    this->beforeValue();
+    char number[24];
+    int written = std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(integral_value));
+    if (written > 0)
+        this->put(std::string_view(number, static_cast<std::size_t>(written)));
+}
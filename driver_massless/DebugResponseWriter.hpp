@@ -0,0 +1,151 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/// <summary>
+/// Writes compact JSON directly into a caller supplied buffer (ie. the OpenVR DebugRequest response buffer).
+/// No memory is allocated while writing, if the buffer is too small the response is replaced with an error object on finish().
+/// </summary>
+class DebugResponseWriter
+{
+public:
+    /// <summary>
+    /// Constructs a writer over the given buffer
+    /// </summary>
+    /// <param name="buffer">Buffer to write the response into, can be null if buffer_size is 0</param>
+    /// <param name="buffer_size">Size of the buffer in bytes, including the null terminator</param>
+    DebugResponseWriter(char* buffer, uint32_t buffer_size);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /// <summary>
+    /// Writes an object key, the next value written will be its value
+    /// </summary>
+    /// <param name="name">Key name</param>
+    void key(std::string_view name);
+
+    void value(std::string_view string_value);
+    void value(const char* string_value);
+    void value(bool bool_value);
+    void value(double number_value);
+    void nullValue();
+
+    /// <summary>
+    /// Writes any integral value (except bool, which has its own overload)
+    /// </summary>
+    template<typename T, typename std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    void value(T integral_value) {
+        if constexpr (std::is_signed_v<T>) {
+            this->writeSigned(static_cast<int64_t>(integral_value));
+        }
+        else {
+            this->writeUnsigned(static_cast<uint64_t>(integral_value));
+        }
+    }
+
+    /// <summary>
+    /// Writes a float as a double
+    /// </summary>
+    void value(float number_value) { this->value(static_cast<double>(number_value)); }
+
+    /// <summary>
+    /// Writes a key and value pair
+    /// </summary>
+    template<typename T>
+    void field(std::string_view name, const T& field_value) {
+        this->key(name);
+        this->value(field_value);
+    }
+
+    /// <summary>
+    /// Writes an error object field pair ie. "error":"message"
+    /// </summary>
+    /// <param name="message">Error message</param>
+    void error(std::string_view message);
+
+    /// <summary>
+    /// Null terminates the response. If the response did not fit, it is replaced with a small error object reporting the required size.
+    /// </summary>
+    /// <returns>True if the full response fit in the buffer</returns>
+    bool finish();
+
+    /// <summary>
+    /// Checks if any write so far has been truncated
+    /// </summary>
+    /// <returns>True if the buffer was too small</returns>
+    bool hasOverflowed() const;
+
+    /// <summary>
+    /// Gets the number of characters the full response needs (excluding the null terminator)
+    /// </summary>
+    /// <returns>Required number of characters</returns>
+    std::size_t requiredLength() const;
+
+    /// <summary>
+    /// Splits a debug request into its command and argument, ie. "pose_history 10" becomes {"pose_history", "10"}
+    /// </summary>
+    /// <param name="request">Null terminated request string, can be null</param>
+    /// <returns>Command and (possibly empty) argument string</returns>
+    static std::pair<std::string_view, std::string_view> splitRequest(const char* request);
+
+    /// <summary>
+    /// Parses an unsigned integer argument
+    /// </summary>
+    /// <param name="argument">Argument string</param>
+    /// <param name="default_value">Value returned when the argument is empty or not a number</param>
+    /// <returns>Parsed value, or default_value</returns>
+    static uint32_t parseUnsigned(std::string_view argument, uint32_t default_value);
+
+    /// <summary>
+    /// Parses three space separated numbers, ie. "0.01 -0.02 0.1"
+    /// </summary>
+    /// <param name="argument">Argument string</param>
+    /// <returns>Parsed values, or nullopt if there are not exactly three numbers</returns>
+    static std::optional<std::array<float, 3>> parseVector3(std::string_view argument);
+
+private:
+    void put(char character);
+    void put(std::string_view characters);
+    void putEscaped(std::string_view characters);
+    void beforeValue();
+    void writeSigned(int64_t integral_value);
+    void writeUnsigned(uint64_t integral_value);
+
+    /// <summary>
+    /// Maximum nesting depth of objects and arrays
+    /// </summary>
+    static constexpr std::size_t m_maxDepth = 16;
+
+    char* m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_length = 0;
+
+    /// <summary>
+    /// For each nesting level, true if a comma is needed before the next element
+    /// </summary>
+    std::array<bool, m_maxDepth> m_needsComma = { false };
+    std::size_t m_depth = 0;
+
+    /// <summary>
+    /// Nesting levels deeper than m_maxDepth, these share the comma state of the deepest tracked level
+    /// </summary>
+    std::size_t m_untrackedDepth = 0;
+    bool m_afterKey = false;
+};
@@ -0,0 +1,95 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "DeferredWriter.hpp"
+
+#include <algorithm>
+
+DeferredWriter::DeferredWriter(std::chrono::milliseconds delay) :
+    m_delay(delay)
+{
+    this->m_worker = std::thread(&DeferredWriter::run, this);
+}
+
+DeferredWriter::~DeferredWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_running = false;
+    }
+    this->m_wake.notify_all();
+    if (this->m_worker.joinable())
+        this->m_worker.join();
+}
+
+void DeferredWriter::schedule(std::function<void()> write)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        auto now = Clock::now();
+        if (!this->m_pending)
+            this->m_deadline = now + 4 * this->m_delay;
+        this->m_pending = std::move(write);
+        this->m_due = std::min(now + this->m_delay, this->m_deadline);
+        ++this->m_scheduled;
+    }
+    this->m_wake.notify_one();
+}
+
+void DeferredWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    if (!this->m_pending && !this->m_writing)
+        return;
+    this->m_flushRequested = true;
+    this->m_wake.notify_one();
+    this->m_idle.wait(lock, [this]() { return !this->m_pending && !this->m_writing; });
+}
+
+uint64_t DeferredWriter::getScheduledCount() const
+{
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    return this->m_scheduled;
+}
+
+uint64_t DeferredWriter::getWriteCount() const
+{
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    return this->m_writes;
+}
+
+void DeferredWriter::run()
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    while (true) {
+        if (!this->m_pending) {
+            if (!this->m_running)
+                break;
+            this->m_wake.wait(lock);
+            continue;
+        }
+
+        // Keep waiting while changes are still coming in, unless we are being flushed or stopped
+        if (this->m_running && !this->m_flushRequested && Clock::now() < this->m_due) {
+            this->m_wake.wait_until(lock, this->m_due);
+            continue;
+        }
+
+        std::function<void()> write = std::move(this->m_pending);
+        this->m_pending = nullptr;
+        this->m_flushRequested = false;
+        this->m_writing = true;
+        lock.unlock();
+        write();
+        lock.lock();
+        this->m_writing = false;
+        ++this->m_writes;
+        this->m_idle.notify_all();
+    }
+}
@@ -0,0 +1,80 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// <summary>
+/// Runs writes on a background thread so the frame thread never touches the filesystem. Scheduling replaces any write still pending, so a burst
+/// of changes is written once, with the latest state, after things have been quiet for the delay (or at most four delays after the first change).
+/// </summary>
+class DeferredWriter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// <summary>
+    /// Starts the writer thread
+    /// </summary>
+    /// <param name="delay">How long to wait for further changes before writing</param>
+    explicit DeferredWriter(std::chrono::milliseconds delay);
+
+    /// <summary>
+    /// Runs any pending write, then stops the writer thread
+    /// </summary>
+    ~DeferredWriter();
+
+    DeferredWriter(const DeferredWriter&) = delete;
+    DeferredWriter& operator=(const DeferredWriter&) = delete;
+
+    /// <summary>
+    /// Schedules a write, replacing the pending one if there is one. Never blocks on a write in progress.
+    /// </summary>
+    /// <param name="write">Function that does the write, called on the writer thread</param>
+    void schedule(std::function<void()> write);
+
+    /// <summary>
+    /// Runs the pending write now and waits for it to finish
+    /// </summary>
+    void flush();
+
+    /// <summary>
+    /// Number of writes scheduled
+    /// </summary>
+    uint64_t getScheduledCount() const;
+
+    /// <summary>
+    /// Number of writes run, lower than the scheduled count when bursts were coalesced
+    /// </summary>
+    uint64_t getWriteCount() const;
+
+private:
+    void run();
+
+    std::chrono::milliseconds m_delay;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::function<void()> m_pending;
+    Clock::time_point m_due;
+    Clock::time_point m_deadline;
+    bool m_flushRequested = false;
+    bool m_writing = false;
+    bool m_running = true;
+    uint64_t m_scheduled = 0;
+    uint64_t m_writes = 0;
+
+    std::thread m_worker;
+};
@@ -0,0 +1,62 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "DevicePoseSnapshot.hpp"
+#include <DriverAnalytics.hpp>
+
+#include <bitset>
+
+DevicePoseSnapshot::DevicePoseSnapshot()
+{
+    this->m_poses.fill(vr::TrackedDevicePose_t{});
+}
+
+void DevicePoseSnapshot::capture(vr::IVRServerDriverHost* serverdriver_host)
+{
+    serverdriver_host->GetRawTrackedDevicePoses(0, this->m_poses.data(), vr::k_unMaxTrackedDeviceCount);
+    this->m_convertedMask = 0;
+    ++this->m_captureCount;
+}
+
+const vr::TrackedDevicePose_t& DevicePoseSnapshot::getRawPose(vr::TrackedDeviceIndex_t device_index) const
+{
+    return this->m_poses[device_index];
+}
+
+bool DevicePoseSnapshot::isConnected(vr::TrackedDeviceIndex_t device_index) const
+{
+    return device_index < vr::k_unMaxTrackedDeviceCount && this->m_poses[device_index].bDeviceIsConnected;
+}
+
+std::optional<DevicePoseSnapshot::EigenPose> DevicePoseSnapshot::getPose(vr::TrackedDeviceIndex_t device_index) const
+{
+    if (device_index >= vr::k_unMaxTrackedDeviceCount)
+        return std::nullopt;
+
+    const vr::TrackedDevicePose_t& device_pose = this->m_poses[device_index];
+    if (!device_pose.bDeviceIsConnected || !device_pose.bPoseIsValid)
+        return std::nullopt;
+
+    uint64_t bit = uint64_t(1) << device_index;
+    if ((this->m_convertedMask & bit) == 0) {
+        this->m_converted[device_index] = DriverAnalytics::hmdMatrixtoEigenPose(device_pose.mDeviceToAbsoluteTracking);
+        this->m_convertedMask |= bit;
+    }
+    return this->m_converted[device_index];
+}
+
+uint64_t DevicePoseSnapshot::getCaptureCount() const
+{
+    return this->m_captureCount;
+}
+
+uint32_t DevicePoseSnapshot::getConversionCount() const
+{
+    return static_cast<uint32_t>(std::bitset<64>(this->m_convertedMask).count());
+}
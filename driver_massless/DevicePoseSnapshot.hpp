@@ -0,0 +1,81 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include <openvr_driver.h>
+#include <Eigen/eigen>
+
+/// <summary>
+/// The raw poses of every tracked device, captured once per frame and shared by everything that needs a device pose that frame.
+/// Poses are only converted to Eigen when they are asked for, and each conversion is cached until the next capture.
+/// </summary>
+class DevicePoseSnapshot
+{
+public:
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    DevicePoseSnapshot();
+
+    /// <summary>
+    /// Captures the raw poses of all tracked devices (one GetRawTrackedDevicePoses call), discarding any cached conversions
+    /// </summary>
+    /// <param name="serverdriver_host">IVRServerDriverHost pointer (usually vr::VRServerDriverHost())</param>
+    void capture(vr::IVRServerDriverHost* serverdriver_host);
+
+    /// <summary>
+    /// Gets the raw pose of a device as of the last capture
+    /// </summary>
+    /// <param name="device_index">device index, must be less than vr::k_unMaxTrackedDeviceCount</param>
+    /// <returns>Raw device pose</returns>
+    const vr::TrackedDevicePose_t& getRawPose(vr::TrackedDeviceIndex_t device_index) const;
+
+    /// <summary>
+    /// Was the device connected at the last capture?
+    /// </summary>
+    /// <param name="device_index">device index</param>
+    /// <returns>True if the index is in range and the device is connected</returns>
+    bool isConnected(vr::TrackedDeviceIndex_t device_index) const;
+
+    /// <summary>
+    /// Gets the pose of a connected device with a valid pose, converted to Eigen (same as DriverAnalytics::getDevicePose)
+    /// </summary>
+    /// <param name="device_index">device index</param>
+    /// <returns>Device pose, or nullopt if the device is not connected or its pose is invalid</returns>
+    std::optional<EigenPose> getPose(vr::TrackedDeviceIndex_t device_index) const;
+
+    /// <summary>
+    /// Gets the number of captures so far
+    /// </summary>
+    /// <returns>Capture counter</returns>
+    uint64_t getCaptureCount() const;
+
+    /// <summary>
+    /// Gets the number of matrix to Eigen conversions done since the last capture (for diagnostics)
+    /// </summary>
+    /// <returns>Number of conversions</returns>
+    uint32_t getConversionCount() const;
+
+private:
+    static_assert(vr::k_unMaxTrackedDeviceCount <= 64, "Converted poses are tracked with a 64 bit mask");
+
+    std::array<vr::TrackedDevicePose_t, vr::k_unMaxTrackedDeviceCount> m_poses;
+
+    /// <summary>
+    /// Lazily converted poses, valid where the matching bit of m_convertedMask is set
+    /// </summary>
+    mutable std::array<EigenPose, vr::k_unMaxTrackedDeviceCount> m_converted;
+    mutable uint64_t m_convertedMask = 0;
+
+    uint64_t m_captureCount = 0;
+};
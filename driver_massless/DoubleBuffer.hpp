@@ -0,0 +1,64 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <mutex>
+
+/// <summary>
+/// A value one thread writes and other threads read, for values too large or not trivially copyable enough for a SeqlockValue.
+/// The writer fills the back copy in place (reusing its allocations) and publishes it by swapping it with the front copy readers see.
+/// Publishing never waits: if a reader is using the front copy the publish is skipped, and the writer refills and publishes the back copy next time.
+/// </summary>
+template<typename T>
+class DoubleBuffer
+{
+public:
+    /// <summary>
+    /// Gets the copy the writer fills before publishing, every field must be written as it holds an older value. Writer only.
+    /// </summary>
+    T& getBack()
+    {
+        return this->m_buffers[1 - this->m_front];
+    }
+
+    /// <summary>
+    /// Makes the back copy the one readers see. Writer only.
+    /// </summary>
+    /// <returns>False if a reader was using the front copy, so nothing was published</returns>
+    bool publish()
+    {
+        std::unique_lock<std::mutex> lock(this->m_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return false;
+        this->m_front = 1 - this->m_front;
+        return true;
+    }
+
+    /// <summary>
+    /// Calls reader with the latest published copy, which is held for the duration of the call
+    /// </summary>
+    /// <returns>What reader returns</returns>
+    template<typename Reader>
+    decltype(auto) read(Reader&& reader) const
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        return reader(this->m_buffers[this->m_front]);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::array<T, 2> m_buffers;
+
+    /// <summary>
+    /// Index of the copy readers see, only changed by the writer while holding m_mutex
+    /// </summary>
+    std::size_t m_front = 0;
+};
@@ -10,36 +10,42 @@
 #include "DriverAnalytics.hpp"
 #include <iostream>
 #include <VRProcessEnumerator.hpp>
+#include <StringPattern.hpp>
+
+using SystemType = MasslessInterface::TrackingSystemType::SystemType;
 
-using SystemMatcher = std::pair<std::regex, MasslessInterface::TrackingSystemType>;
 std::optional<std::wstring> DriverAnalytics::getVRClientProcessName(unsigned long pid)
 {
     return VRProcessEnumerator::getVRClientProcessName(pid);
 }
 
-//These matchers are for matching the ModelNumber string (more of a name if you ask me)
-SystemMatcher vive_lighthouse_v1_matcher{ std::regex("HTC V2-XD/XE", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::VIVE_BASESTATION_V1 };
-SystemMatcher vive_lighthouse_v2_matcher{ std::regex("Valve SR Imp", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::VIVE_BASESTATION_V2 };
-SystemMatcher vive_tracker_v2_matcher{ std::regex("VIVE Tracker Pro MV", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER };
-SystemMatcher oculus_camera_matcher{ std::regex("Oculus Rift CV1 \\(Camera\\d+\\)", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::OCULUS_SENSOR };
-SystemMatcher oculus_rift_s_right_controller_matcher{ std::regex("Oculus Rift S \\((Right) Controller\\)", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT };
-SystemMatcher oculus_rift_s_left_controller_matcher{ std::regex("Oculus Rift S \\((Left) Controller\\)", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT };
-SystemMatcher oculus_quest_right_controller_matcher{ std::regex("Oculus Quest \\((Right) Controller\\)", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT };
-SystemMatcher oculus_quest_left_controller_matcher{ std::regex("Oculus Quest \\((Left) Controller\\)", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT };
+//These matchers are for matching the ModelNumber string (more of a name if you ask me), in priority order
+static constexpr StringPatternTable<SystemType, 8> model_number_matchers(std::array<std::pair<StringPattern, SystemType>, 8>{ {
+    { StringPattern::compile("VIVE Tracker Pro MV"), SystemType::VIVE_TRACKER },
+    { StringPattern::compile("HTC V2-XD/XE"), SystemType::VIVE_BASESTATION_V1 },
+    { StringPattern::compile("Valve SR Imp"), SystemType::VIVE_BASESTATION_V2 },
+    { StringPattern::compile("Oculus Rift CV1 \\(Camera\\d+\\)"), SystemType::OCULUS_SENSOR },
+    { StringPattern::compile("Oculus Rift S \\((Right) Controller\\)"), SystemType::OCULUS_RIFT_S_TOUCH_RIGHT },
+    { StringPattern::compile("Oculus Rift S \\((Left) Controller\\)"), SystemType::OCULUS_RIFT_S_TOUCH_LEFT },
+    { StringPattern::compile("Oculus Quest \\((Left) Controller\\)"), SystemType::OCULUS_RIFT_S_TOUCH_LEFT },
+    { StringPattern::compile("Oculus Quest \\((Right) Controller\\)"), SystemType::OCULUS_RIFT_S_TOUCH_RIGHT }
+} });
 
 //This matcher is for matching the rendermodelname string, which is a fallback, currently only in use for the Vive Tracker V1
-SystemMatcher vive_tracker_v1_matcher{ std::regex("\\{htc\\}vr_tracker_vive_1_0", std::regex_constants::ECMAScript | std::regex_constants::icase), MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER };
-
-std::vector<SystemMatcher> matchers = { vive_tracker_v2_matcher, vive_lighthouse_v1_matcher, vive_lighthouse_v2_matcher, oculus_camera_matcher, oculus_rift_s_right_controller_matcher, oculus_rift_s_left_controller_matcher, oculus_quest_left_controller_matcher, oculus_quest_right_controller_matcher};
+static constexpr StringPattern vive_tracker_v1_matcher = StringPattern::compile("\\{htc\\}vr_tracker_vive_1_0");
 
 std::optional<std::pair<vr::TrackedDeviceIndex_t, MasslessInterface::TrackingSystemType>> DriverAnalytics::findLikelyTrackingReferenceIndex(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties)
 {
-    vr::TrackedDevicePose_t tracked_device_poses[vr::k_unMaxTrackedDeviceCount];
-    serverdriver_host->GetRawTrackedDevicePoses(0, tracked_device_poses, vr::k_unMaxTrackedDeviceCount);
+    DevicePoseSnapshot poses;
+    poses.capture(serverdriver_host);
+    return findLikelyTrackingReferenceIndex(poses, properties);
+}
+
+std::optional<std::pair<vr::TrackedDeviceIndex_t, MasslessInterface::TrackingSystemType>> DriverAnalytics::findLikelyTrackingReferenceIndex(const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties)
+{
     for (vr::TrackedDeviceIndex_t device_index = vr::k_unTrackedDeviceIndex_Hmd; device_index < vr::k_unMaxTrackedDeviceCount; device_index++) {
-        const auto& device_pose = tracked_device_poses[device_index];
-        // Check if this device pose is valid and the device is connected
-        if (device_pose.bDeviceIsConnected) {
+        // Check if the device is connected
+        if (poses.isConnected(device_index)) {
             if (isTrackingReference(device_index, properties)) {
                 return { { device_index, getReferenceSystemType(device_index, properties) } };
             }
@@ -48,6 +54,18 @@ std::optional<std::pair<vr::TrackedDeviceIndex_t, MasslessInterface::TrackingSys
     return std::nullopt;
 }
 
+std::optional<MasslessInterface::TrackingSystemType> DriverAnalytics::matchModelNumber(std::string_view model_number)
+{
+    if (const SystemType* system_type = model_number_matchers.find(model_number))
+        return *system_type;
+    return std::nullopt;
+}
+
+bool DriverAnalytics::matchesViveTrackerV1RenderModel(std::string_view render_model)
+{
+    return vive_tracker_v1_matcher.search(render_model);
+}
+
 bool DriverAnalytics::isTrackingReference(vr::TrackedDeviceIndex_t device_index, vr::CVRPropertyHelpers* properties)
 {
     vr::PropertyContainerHandle_t device_props = properties->TrackedDeviceToPropertyContainer(device_index);
@@ -59,7 +77,7 @@ bool DriverAnalytics::isTrackingReference(vr::TrackedDeviceIndex_t device_index,
         std::string device_render_model = properties->GetStringProperty(device_props, vr::ETrackedDeviceProperty::Prop_RenderModelName_String, &error);
         if (error == vr::ETrackedPropertyError::TrackedProp_Success) {
             //DriverLog("[Info] Failed to get system type, falling back to device render model, which is %s.\n", device_render_model);
-            if (std::regex_search(device_render_model, vive_tracker_v1_matcher.first)) {
+            if (matchesViveTrackerV1RenderModel(device_render_model)) {
                 //DriverLog("[Info] Deciding if a device is a tracking reference or not, it's a Vive Tracker V1.\n");
                 //DriverLog("[Info] Found a Vive Tracker V1.");
                 return true;
@@ -67,7 +85,19 @@ bool DriverAnalytics::isTrackingReference(vr::TrackedDeviceIndex_t device_index,
         }
         return false;
     }
-    return !std::none_of(matchers.begin(), matchers.end(), [=](const auto& matcher) { return std::regex_search(device_model_number, matcher.first);});
+    return matchModelNumber(device_model_number).has_value();
+}
+
+bool DriverAnalytics::isStaticReference(const MasslessInterface::TrackingSystemType& type)
+{
+    switch (type.getSystemType()) {
+    case MasslessInterface::TrackingSystemType::SystemType::OCULUS_SENSOR:
+    case MasslessInterface::TrackingSystemType::SystemType::VIVE_BASESTATION_V1:
+    case MasslessInterface::TrackingSystemType::SystemType::VIVE_BASESTATION_V2:
+        return true;
+    default:
+        return false;
+    }
 }
 
 MasslessInterface::TrackingSystemType DriverAnalytics::getReferenceSystemType(vr::TrackedDeviceIndex_t device_index, vr::CVRPropertyHelpers* properties)
@@ -81,25 +111,24 @@ MasslessInterface::TrackingSystemType DriverAnalytics::getReferenceSystemType(vr
         std::string device_render_model = properties->GetStringProperty(device_props, vr::ETrackedDeviceProperty::Prop_RenderModelName_String, &error);
         if (error == vr::ETrackedPropertyError::TrackedProp_Success) {
             //DriverLog("[Info] Failed to get system type, falling back to device render model, which is %s.\n", device_render_model);
-            if (std::regex_search(device_render_model, vive_tracker_v1_matcher.first)) {
+            if (matchesViveTrackerV1RenderModel(device_render_model)) {
                 //DriverLog("[Info] Found a Vive Tracker V1.");
-                return vive_tracker_v1_matcher.second;
+                return SystemType::VIVE_TRACKER;
             }
         }
-        DriverLog("[Error] Found a device that didn't match any type with failure to read the model.\n");
+        DRIVER_LOG_ERROR(Reference, "Found a device that didn't match any type with failure to read the model.\n");
         return MasslessInterface::TrackingSystemType::SystemType::INVALID_SYSTEM;
     }
     //DriverLog("[Info] Finding system type where model number string is: %s.\n", device_model_number.c_str());
-    for (const auto& matcher : matchers) {
-        if (std::regex_search(device_model_number, matcher.first)) return matcher.second;
-    }
+    if (auto system_type = matchModelNumber(device_model_number); system_type.has_value())
+        return *system_type;
     //If it hasn't matched anything else yet, try a vive tracker V1
     std::string device_render_model = properties->GetStringProperty(device_props, vr::ETrackedDeviceProperty::Prop_RenderModelName_String, &error);
-    if (std::regex_search(device_render_model, vive_tracker_v1_matcher.first)) {
+    if (matchesViveTrackerV1RenderModel(device_render_model)) {
         //DriverLog("[Info] Found a Vive Tracker V1.");
-        return vive_tracker_v1_matcher.second;
+        return SystemType::VIVE_TRACKER;
     }
-    DriverLog("[Error] Found a device that didn't match any type.\n");
+    DRIVER_LOG_ERROR(Reference, "Found a device that didn't match any type.\n");
     return MasslessInterface::TrackingSystemType::SystemType::INVALID_SYSTEM;
 }
 
@@ -116,13 +145,14 @@ std::optional<std::string> DriverAnalytics::getDeviceSerial(vr::TrackedDeviceInd
 
 std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> DriverAnalytics::getDevicePose(vr::TrackedDeviceIndex_t device_index, vr::IVRServerDriverHost* serverdriver_host)
 {
-    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
-    serverdriver_host->GetRawTrackedDevicePoses(0, poses, vr::k_unMaxTrackedDeviceCount);
-    vr::TrackedDevicePose_t device_pose = poses[device_index];
-    if (device_pose.bDeviceIsConnected && device_pose.bPoseIsValid) {
-        return hmdMatrixtoEigenPose(device_pose.mDeviceToAbsoluteTracking);
-    }
-    return std::nullopt;
+    DevicePoseSnapshot poses;
+    poses.capture(serverdriver_host);
+    return getDevicePose(device_index, poses);
+}
+
+std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> DriverAnalytics::getDevicePose(vr::TrackedDeviceIndex_t device_index, const DevicePoseSnapshot& poses)
+{
+    return poses.getPose(device_index);
 }
 
 std::pair<Eigen::Quaternionf, Eigen::Vector3f> DriverAnalytics::hmdMatrixtoEigenPose(const vr::HmdMatrix34_t& mat) {
@@ -137,13 +167,17 @@ std::pair<Eigen::Quaternionf, Eigen::Vector3f> DriverAnalytics::hmdMatrixtoEigen
 std::optional<vr::TrackedDeviceIndex_t> DriverAnalytics::getDeviceIndex(std::string device_serial, vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties)
 {
     // Get all currently tracked devices
-    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
-    serverdriver_host->GetRawTrackedDevicePoses(0, poses, vr::k_unMaxTrackedDeviceCount);
+    DevicePoseSnapshot poses;
+    poses.capture(serverdriver_host);
+    return getDeviceIndex(device_serial, poses, properties);
+}
+
+std::optional<vr::TrackedDeviceIndex_t> DriverAnalytics::getDeviceIndex(const std::string& device_serial, const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties)
+{
     for (vr::TrackedDeviceIndex_t index = 0; index < vr::k_unMaxTrackedDeviceCount; index++) {
 
         // Check it is actually a connected and working device
-        vr::TrackedDevicePose_t device_pose = poses[index];
-        if (device_pose.bDeviceIsConnected) {
+        if (poses.isConnected(index)) {
 
             // Check the serial number
             auto serial = getDeviceSerial(index, properties);
@@ -157,11 +191,16 @@ std::optional<vr::TrackedDeviceIndex_t> DriverAnalytics::getDeviceIndex(std::str
 
 std::vector<vr::TrackedDeviceIndex_t> DriverAnalytics::firstPass(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties)
 {
-    vr::TrackedDevicePose_t tracked_device_poses[vr::k_unMaxTrackedDeviceCount];
-    serverdriver_host->GetRawTrackedDevicePoses(0, tracked_device_poses, vr::k_unMaxTrackedDeviceCount);
+    DevicePoseSnapshot poses;
+    poses.capture(serverdriver_host);
+    return firstPass(poses, properties);
+}
+
+std::vector<vr::TrackedDeviceIndex_t> DriverAnalytics::firstPass(const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties)
+{
     std::vector<vr::TrackedDeviceIndex_t> indices;
     for (vr::TrackedDeviceIndex_t idx = 0; idx < vr::k_unMaxTrackedDeviceCount; idx++) {
-        if (tracked_device_poses[idx].bDeviceIsConnected && isTrackingReference(idx, properties)) {
+        if (poses.isConnected(idx) && isTrackingReference(idx, properties)) {
             indices.push_back(idx);
         }
     }
@@ -231,3 +270,36 @@ std::optional<DriverAnalytics::TrackingReferencePack> DriverAnalytics::secondPas
 
     return DriverAnalytics::TrackingReferencePack(*tracking_reference_index, tracking_reference_serial, system_type, *global_pose, *pose_offset);
 }
+
+std::vector<vr::TrackedDeviceIndex_t> DriverAnalytics::firstPass(const TrackedDeviceDirectory& directory)
+{
+    return directory.getTrackingReferences();
+}
+
+std::optional<DriverAnalytics::TrackingReferencePack> DriverAnalytics::secondPass(vr::TrackedDeviceIndex_t tracking_reference_index, const TrackedDeviceDirectory& directory, const DevicePoseSnapshot& poses, std::shared_ptr<MasslessInterface::IPenSystem> pen_system)
+{
+    const TrackedDeviceDirectory::DeviceEntry* entry = directory.getEntry(tracking_reference_index);
+    if (entry == nullptr || !entry->classified)
+        return std::nullopt;
+
+    if (entry->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::INVALID_SYSTEM)
+        return std::nullopt;
+
+    auto pose_offset = pen_system->getMasslessTrackerPoseOffset(entry->type);
+    if (!pose_offset.has_value())
+        return std::nullopt;
+
+    auto global_pose = poses.getPose(tracking_reference_index);
+    if (!global_pose.has_value())
+        return std::nullopt;
+
+    return DriverAnalytics::TrackingReferencePack(tracking_reference_index, entry->serial, entry->type, *global_pose, *pose_offset);
+}
+
+std::optional<DriverAnalytics::TrackingReferencePack> DriverAnalytics::secondPass(const std::string& tracking_reference_serial, const TrackedDeviceDirectory& directory, const DevicePoseSnapshot& poses, std::shared_ptr<MasslessInterface::IPenSystem> pen_system)
+{
+    auto tracking_reference_index = directory.findIndex(tracking_reference_serial);
+    if (!tracking_reference_index.has_value())
+        return std::nullopt;
+    return secondPass(*tracking_reference_index, directory, poses, pen_system);
+}
@@ -9,7 +9,7 @@
 
 #pragma once
 
-#include <regex>
+#include <string_view>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -22,6 +22,8 @@
 #include <TrackingSystemType.hpp>
 #include <IPenSystem.hpp>
 #include <Pose.hpp>
+#include <TrackedDeviceDirectory.hpp>
+#include <DevicePoseSnapshot.hpp>
 
 class DriverAnalytics
 {
@@ -36,6 +38,14 @@ public:
     /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
     /// <returns>The index of the device, and the tracking system type of the device, or nullopt on failure to find a device</returns>
     static std::optional<std::pair<vr::TrackedDeviceIndex_t, MasslessInterface::TrackingSystemType>> findLikelyTrackingReferenceIndex(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties);
+
+    /// <summary>
+    /// Finds the first tracking reference connected in a pose snapshot
+    /// </summary>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
+    /// <returns>Device index and system type, or nullopt if no tracking reference is connected</returns>
+    static std::optional<std::pair<vr::TrackedDeviceIndex_t, MasslessInterface::TrackingSystemType>> findLikelyTrackingReferenceIndex(const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties);
    
     /// <summary>
     /// Checks if the device at the given tracked device index is a valid tracking reference
@@ -53,6 +63,13 @@ public:
     /// <returns>System type of the device, or INVALID_SYSTEM if it is not supported, an error occurred getting the properties, or is not a tracking reference</returns>
     static MasslessInterface::TrackingSystemType getReferenceSystemType(vr::TrackedDeviceIndex_t device_index, vr::CVRPropertyHelpers* properties);
 
+    /// <summary>
+    /// Checks if a tracking reference type is fixed in place (base stations and sensors), rather than carried around (trackers and controllers)
+    /// </summary>
+    /// <param name="type">Tracking system type</param>
+    /// <returns>True if references of this type should not move</returns>
+    static bool isStaticReference(const MasslessInterface::TrackingSystemType& type);
+
     /// <summary>
     /// Gets the serial of a tracked device
     /// </summary>
@@ -69,6 +86,14 @@ public:
     /// <returns>Device pose, or nullopt on error</returns>
     static std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> getDevicePose(vr::TrackedDeviceIndex_t device_index, vr::IVRServerDriverHost* serverdriver_host);
 
+    /// <summary>
+    /// Gets the pose of a tracked device from a pose snapshot
+    /// </summary>
+    /// <param name="device_index">device index</param>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <returns>Device pose, or nullopt on error</returns>
+    static std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> getDevicePose(vr::TrackedDeviceIndex_t device_index, const DevicePoseSnapshot& poses);
+
     /// <summary>
     /// Converts an OpenVR pose to an Eigen pair
     /// </summary>
@@ -76,6 +101,20 @@ public:
     /// <returns>Input pose converts to an Eigen pair</returns>
     static std::pair<Eigen::Quaternionf, Eigen::Vector3f> hmdMatrixtoEigenPose(const vr::HmdMatrix34_t& mat);
 
+    /// <summary>
+    /// Matches a device model number string against the known tracking reference models
+    /// </summary>
+    /// <param name="model_number">Prop_ModelNumber_String of the device</param>
+    /// <returns>System type of the matching tracking reference, or nullopt if it is not a known tracking reference</returns>
+    static std::optional<MasslessInterface::TrackingSystemType> matchModelNumber(std::string_view model_number);
+
+    /// <summary>
+    /// Checks if a device render model name is the Vive Tracker V1's (which has no model number)
+    /// </summary>
+    /// <param name="render_model">Prop_RenderModelName_String of the device</param>
+    /// <returns>True if the render model is the Vive Tracker V1's</returns>
+    static bool matchesViveTrackerV1RenderModel(std::string_view render_model);
+
     /// <summary>
     /// Gets the index of a tracked device based on its serial
     /// </summary>
@@ -85,6 +124,15 @@ public:
     /// <returns>index of the device, or nullopt on failure to find device</returns>
     static std::optional<vr::TrackedDeviceIndex_t> getDeviceIndex(std::string device_serial, vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties);
 
+    /// <summary>
+    /// Gets the index of a tracked device based on its serial, checking the devices connected in a pose snapshot
+    /// </summary>
+    /// <param name="device_serial">device serial</param>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
+    /// <returns>index of the device, or nullopt on failure to find device</returns>
+    static std::optional<vr::TrackedDeviceIndex_t> getDeviceIndex(const std::string& device_serial, const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties);
+
     /// <summary>
     /// First pass for finding the tracking reference. This pass finds all of the valid tracking references currently connected, and returns a list of them sorted by priority (0 = highest)
     /// </summary>
@@ -92,6 +140,21 @@ public:
     /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
     /// <returns>List of possible tracking references, sorted by priority (0 = highest)</returns>
     static std::vector<vr::TrackedDeviceIndex_t> firstPass(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties);
+
+    /// <summary>
+    /// First pass for finding the tracking reference, checking the devices connected in a pose snapshot
+    /// </summary>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
+    /// <returns>List of possible tracking references, sorted by priority (0 = highest)</returns>
+    static std::vector<vr::TrackedDeviceIndex_t> firstPass(const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties);
+
+    /// <summary>
+    /// First pass for finding the tracking reference, using the classifications cached in the device directory instead of reading device properties
+    /// </summary>
+    /// <param name="directory">Refreshed tracked device directory</param>
+    /// <returns>List of possible tracking references, sorted by priority (0 = highest)</returns>
+    static std::vector<vr::TrackedDeviceIndex_t> firstPass(const TrackedDeviceDirectory& directory);
     
     /// <summary>
     /// A set of info about a tracking reference
@@ -123,5 +186,23 @@ public:
     /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
     /// <returns>Filled TrackingReferencePack with all of the information set, or nullopt if any property cannot be loaded</returns>
     static std::optional<TrackingReferencePack> secondPass(std::string tracking_reference_serial, vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties, std::shared_ptr<MasslessInterface::IPenSystem> pen_system);
+
+    /// <summary>
+    /// Second pass for finding the tracking reference, using the type and serial cached in the device directory
+    /// </summary>
+    /// <param name="tracking_reference_index">device index</param>
+    /// <param name="directory">Refreshed tracked device directory</param>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <returns>Filled TrackingReferencePack with all of the information set, or nullopt if the device is not classified or the offset/pose cannot be loaded</returns>
+    static std::optional<TrackingReferencePack> secondPass(vr::TrackedDeviceIndex_t tracking_reference_index, const TrackedDeviceDirectory& directory, const DevicePoseSnapshot& poses, std::shared_ptr<MasslessInterface::IPenSystem> pen_system);
+
+    /// <summary>
+    /// Second pass for finding the tracking reference by serial, using the serial lookup of the device directory
+    /// </summary>
+    /// <param name="tracking_reference_serial">device serial</param>
+    /// <param name="directory">Refreshed tracked device directory</param>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <returns>Filled TrackingReferencePack with all of the information set, or nullopt if no connected device has the serial or the offset/pose cannot be loaded</returns>
+    static std::optional<TrackingReferencePack> secondPass(const std::string& tracking_reference_serial, const TrackedDeviceDirectory& directory, const DevicePoseSnapshot& poses, std::shared_ptr<MasslessInterface::IPenSystem> pen_system);
 };
 
@@ -9,35 +9,46 @@
 
 #include "DriverLog.hpp"
 
-#include <stdio.h>
+#include <atomic>
 #include <stdarg.h>
 
-static vr::IVRDriverLog* s_pLogFile = NULL;
+static std::atomic<vr::IVRDriverLog*> s_pLogFile = NULL;
+
+// Never destroyed while the driver is loaded, lines logged from other threads during cleanup are just never written
+static AsyncLogger& GetDriverLogger()
+{
+	static AsyncLogger logger([](const char* line) {
+		if (vr::IVRDriverLog* log_file = s_pLogFile.load())
+			log_file->Log(line);
+	});
+	return logger;
+}
 
 bool InitDriverLog(vr::IVRDriverLog* pDriverLog)
 {
 	if (s_pLogFile)
 		return false;
 	s_pLogFile = pDriverLog;
+	if (s_pLogFile)
+		GetDriverLogger().start();
 	return s_pLogFile != NULL;
 }
 
 void CleanupDriverLog()
 {
+	GetDriverLogger().stop();
 	s_pLogFile = NULL;
 }
 
-static void DriverLogVarArgs(const char* pMsgFormat, va_list args)
+AsyncLogger::Stats GetDriverLogStats()
 {
-	char buf[1024];
-#if defined( WIN32 )
-	vsprintf_s(buf, pMsgFormat, args);
-#else
-	vsnprintf(buf, sizeof(buf), pMsgFormat, args);
-#endif
+	return GetDriverLogger().getStats();
+}
 
+static void DriverLogVarArgs(const char* pMsgFormat, va_list args)
+{
 	if (s_pLogFile)
-		s_pLogFile->Log(buf);
+		GetDriverLogger().logv(pMsgFormat, args);
 }
 
 void DriverLog(const char* pMsgFormat, ...)
@@ -60,4 +71,4 @@ void DebugDriverLog(const char* pMsgFormat, ...)
 
 	va_end(args);
 #endif
-}
\ No newline at end of file
+}
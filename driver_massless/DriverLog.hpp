@@ -11,6 +11,38 @@
 #include <openvr_driver.h>
 #include <Eigen/Eigen>
 
+#include <AsyncLogger.hpp>
+#include <LogFilter.hpp>
+
+/// <summary>
+/// Lowest level compiled in (as a LogLevel value), log sites below it are removed entirely. Trace is only compiled into debug builds.
+/// </summary>
+#ifndef MASSLESS_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define MASSLESS_LOG_MIN_LEVEL 0
+#else
+#define MASSLESS_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+/// <summary>
+/// Logs a line in a category at a level, prefixed with both: DRIVER_LOG_INFO(Reference, "Locked on to [%s].\n", serial.c_str()).
+/// The format must be a string literal. The arguments are only evaluated when the line is logged.
+/// </summary>
+#define DRIVER_LOG(category, level, ...) \
+    do { \
+        if constexpr (static_cast<int>(LogLevel::level) >= MASSLESS_LOG_MIN_LEVEL) { \
+            if (LogFilter::isEnabled(LogCategory::category, LogLevel::level)) \
+                DriverLog("[" #level "] [" #category "] " __VA_ARGS__); \
+        } \
+    } while (false)
+
+#define DRIVER_LOG_TRACE(category, ...) DRIVER_LOG(category, Trace, __VA_ARGS__)
+#define DRIVER_LOG_DEBUG(category, ...) DRIVER_LOG(category, Debug, __VA_ARGS__)
+#define DRIVER_LOG_INFO(category, ...) DRIVER_LOG(category, Info, __VA_ARGS__)
+#define DRIVER_LOG_WARN(category, ...) DRIVER_LOG(category, Warn, __VA_ARGS__)
+#define DRIVER_LOG_ERROR(category, ...) DRIVER_LOG(category, Error, __VA_ARGS__)
+
 const auto tr_to_str = [](Eigen::Translation3f translation) {
     std::stringstream s;
     s << translation.x() << ",\t" << translation.y() << ",\t" << translation.z();
@@ -23,7 +55,20 @@ const auto qu_to_str = [](Eigen::Quaternionf quat) {
     return s.str();
 };
 
+/// <summary>
+/// Logs to the SteamVR log. Lines are queued and written by a background thread (see AsyncLogger), so this can be called from any thread,
+/// including the frame thread, without waiting on the log file.
+/// </summary>
 void DriverLog(const char* pchFormat, ...);
 void DebugDriverLog(const char* pchFormat, ...);
 bool InitDriverLog(vr::IVRDriverLog* pDriverLog);
-void CleanupDriverLog();
\ No newline at end of file
+
+/// <summary>
+/// Writes any queued lines and stops the log thread
+/// </summary>
+void CleanupDriverLog();
+
+/// <summary>
+/// Counts of lines written, dropped because the queue was full, and suppressed as repeats
+/// </summary>
+AsyncLogger::Stats GetDriverLogStats();
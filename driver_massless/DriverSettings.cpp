@@ -14,5 +14,13 @@ const std::map<DriverSettings::Setting, DriverSettings::SettingKey> DriverSettin
     { ForcedTrackingRefSerial, "forced_tracking_reference_serial" },
     { Handedness, "pen_handedness"},
     { AttachGizmo, "attach_gizmo"},
-    { EnableDetailedLogging, "enable_detailed_logging"}
+    { EnableDetailedLogging, "enable_detailed_logging"},
+    { EnableReferenceFusion, "enable_reference_fusion"},
+    { EnableOffsetRefinement, "enable_offset_refinement"},
+    { IntegrationKeys, "integration_keys"},
+    { EnablePoseStream, "enable_pose_stream"},
+    { EnableControlSocket, "enable_control_socket"},
+    { ApplicationProfiles, "application_profiles"},
+    { LogLevels, "log_levels"},
+    { PoseTraceFile, "pose_trace_file"}
 });
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include <optional>
 #include <variant>
 #include <type_traits>
+#include <vector>
 
 // https://stackoverflow.com/questions/52303316/get-index-by-type-in-stdvariant
 /// <summary>
@@ -62,12 +63,16 @@ public:
     /// <summary>
     /// Constructs a DriverSettings instance with default values set
     /// </summary>
-    /// <returns>DriverSettings struct with Handedness, AttachGizmo, and EnableDetailedLogging set</returns>
+    /// <returns>DriverSettings struct with Handedness, AttachGizmo, EnableDetailedLogging, EnableReferenceFusion, EnableOffsetRefinement, EnablePoseStream, and EnableControlSocket set</returns>
     static DriverSettings make_default() {
         DriverSettings settings;
         settings.setValue<std::string>(Handedness, "right");
         settings.setValue<bool>(AttachGizmo, false);
         settings.setValue<bool>(EnableDetailedLogging, false);
+        settings.setValue<bool>(EnableReferenceFusion, false);
+        settings.setValue<bool>(EnableOffsetRefinement, false);
+        settings.setValue<bool>(EnablePoseStream, false);
+        settings.setValue<bool>(EnableControlSocket, false);
         return settings;
     }
 
@@ -79,7 +84,15 @@ public:
         ForcedTrackingRefSerial,
         Handedness,
         AttachGizmo,
-        EnableDetailedLogging
+        EnableDetailedLogging,
+        EnableReferenceFusion,
+        EnableOffsetRefinement,
+        IntegrationKeys,
+        EnablePoseStream,
+        EnableControlSocket,
+        ApplicationProfiles,
+        LogLevels,
+        PoseTraceFile
     };
 
     /// <summary>
@@ -128,6 +141,18 @@ public:
         this->m_values.erase(key);
     }
 
+    /// <summary>
+    /// Gets a pointer to the stored value of a setting, without copying it
+    /// </summary>
+    /// <param name="key">The setting key</param>
+    /// <returns>Pointer to the stored variant, or nullptr if the value isn't stored</returns>
+    const SettingValue* findValue(Setting key) const {
+        auto it = this->m_values.find(key);
+        if (it == this->m_values.end())
+            return nullptr;
+        return &it->second;
+    }
+
     /// <summary>
     /// Checks if the value of a key is not invalid_setting_t
     /// Will return true if the value is not set
@@ -192,6 +217,22 @@ public:
         return m_keys;
     }
 
+    /// <summary>
+    /// Gets the settings whose values differ from another instance's, including ones only set in one of them
+    /// </summary>
+    /// <param name="other">Settings to compare against</param>
+    /// <returns>The differing settings, in enum order</returns>
+    std::vector<Setting> getChangedKeys(const DriverSettings& other) const {
+        std::vector<Setting> changed;
+        for (const auto& key : m_keys) {
+            const SettingValue* value = this->findValue(key.first);
+            const SettingValue* other_value = other.findValue(key.first);
+            if ((value == nullptr) != (other_value == nullptr) || (value != nullptr && !(*value == *other_value)))
+                changed.push_back(key.first);
+        }
+        return changed;
+    }
+
 private:
     /// <summary>
     /// Storage for converstions between enum to string
@@ -16,9 +16,8 @@ FileSettingsLoader::FileSettingsLoader(std::filesystem::path config_path)
     nlohmann::json default_json = this->toJson(DriverSettings::make_default());
     try {
         // Try to make file if it doesnt exist with default settings
-        if (!std::filesystem::exists(config_path)) {
-            std::ofstream config_file_stream(config_path);
-            config_file_stream << default_json.dump(4, ' ', true);
+        if (!std::filesystem::exists(config_path) && !SettingsUtilities::replaceFile(config_path, default_json.dump(4, ' ', true))) {
+            throw DriverSettingsException(0, "Failed to create the config file at: " + config_path.string());
         }
     }
     catch (const std::system_error& e) {
@@ -31,7 +30,7 @@ FileSettingsLoader::FileSettingsLoader(std::filesystem::path config_path)
     // Delay opening ofstream until destructor
     this->m_isRealFilestream = true;
     this->m_filePath = config_path;
-    DriverLog("Loading settings from file: %s \n", this->m_filePath.string().c_str());
+    DRIVER_LOG_INFO(Settings, "Loading settings from file: %s \n", this->m_filePath.string().c_str());
 }
 
 
@@ -63,6 +62,8 @@ DriverSettings FileSettingsLoader::readSettings()
 
     DriverSettings settings = this->fromJson(input_json);
 
+    // Writing back what was just read would not change anything
+    this->m_lastWrittenHash = std::hash<std::string>{}(this->toJson(settings).dump(4, ' ', true));
     return settings;
 }
 
@@ -70,16 +71,20 @@ void FileSettingsLoader::writeSettings(DriverSettings settings)
 {
 
     try {
-        if (this->m_isRealFilestream) {
-            this->m_outStream = std::make_unique<std::ofstream>(this->m_filePath, std::fstream::trunc);
-        }
-        this->m_outStream->seekp(0);
         std::string json_string = this->toJson(settings).dump(4, ' ', true);
-        (*this->m_outStream) << json_string;
+        std::size_t json_hash = std::hash<std::string>{}(json_string);
+        if (this->m_lastWrittenHash == json_hash)
+            return;
 
         if (this->m_isRealFilestream) {
-            this->m_outStream.reset();
+            if (!SettingsUtilities::replaceFile(this->m_filePath, json_string))
+                return;
+        }
+        else {
+            this->m_outStream->seekp(0);
+            (*this->m_outStream) << json_string;
         }
+        this->m_lastWrittenHash = json_hash;
     }
     catch (const std::exception&) {/* Failed to write settings */ }
 }
@@ -107,9 +112,18 @@ DriverSettings FileSettingsLoader::fromJson(nlohmann::json input_json) const {
 
     load_setting(DriverSettings::AttachGizmo, [](json j) -> bool {return j.is_boolean(); }, [](json j) -> DriverSettings::SettingValue { return j.get<bool>(); });
     load_setting(DriverSettings::EnableDetailedLogging, [](json j) -> bool {return j.is_boolean(); }, [](json j) -> DriverSettings::SettingValue {return j.get<bool>(); });
+    load_setting(DriverSettings::EnableReferenceFusion, [](json j) -> bool {return j.is_boolean(); }, [](json j) -> DriverSettings::SettingValue {return j.get<bool>(); });
+    load_setting(DriverSettings::EnableOffsetRefinement, [](json j) -> bool {return j.is_boolean(); }, [](json j) -> DriverSettings::SettingValue {return j.get<bool>(); });
     load_setting(DriverSettings::Handedness, [](json j) -> bool {return j.is_string(); }, [](json j) -> DriverSettings::SettingValue {return j.get<std::string>(); });
     load_setting(DriverSettings::AutoTrackingRefSerial, [](json j) -> bool {return j.is_string(); }, [](json j) -> DriverSettings::SettingValue {return j.get<std::string>(); });
     load_setting(DriverSettings::ForcedTrackingRefSerial, [](json j) -> bool {return j.is_string(); }, [](json j) -> DriverSettings::SettingValue {return j.get<std::string>(); });
+    // An object of application names to keys, kept as its JSON text (see IntegrationKeyTable::parse)
+    load_setting(DriverSettings::IntegrationKeys, [](json j) -> bool {return j.is_object(); }, [](json j) -> DriverSettings::SettingValue {return j.dump(); });
+    load_setting(DriverSettings::EnablePoseStream, [](json j) -> bool {return j.is_boolean(); }, [](json j) -> DriverSettings::SettingValue {return j.get<bool>(); });
+    load_setting(DriverSettings::EnableControlSocket, [](json j) -> bool {return j.is_boolean(); }, [](json j) -> DriverSettings::SettingValue {return j.get<bool>(); });
+    load_setting(DriverSettings::ApplicationProfiles, [](json j) -> bool {return j.is_object(); }, [](json j) -> DriverSettings::SettingValue {return j.dump(); });
+    load_setting(DriverSettings::LogLevels, [](json j) -> bool {return j.is_object(); }, [](json j) -> DriverSettings::SettingValue {return j.dump(); });
+    load_setting(DriverSettings::PoseTraceFile, [](json j) -> bool {return j.is_string(); }, [](json j) -> DriverSettings::SettingValue {return j.get<std::string>(); });
 
     return settings;
 }
@@ -124,6 +138,18 @@ nlohmann::json FileSettingsLoader::toJson(DriverSettings settings) const
     if (settings.isValid(DriverSettings::EnableDetailedLogging) && settings.getValue<bool>(DriverSettings::EnableDetailedLogging).has_value()) {
         json[DriverSettings::getKeyString(DriverSettings::EnableDetailedLogging)] = *settings.getValue<bool>(DriverSettings::EnableDetailedLogging);
     }
+    if (settings.isValid(DriverSettings::EnableReferenceFusion) && settings.getValue<bool>(DriverSettings::EnableReferenceFusion).has_value()) {
+        json[DriverSettings::getKeyString(DriverSettings::EnableReferenceFusion)] = *settings.getValue<bool>(DriverSettings::EnableReferenceFusion);
+    }
+    if (settings.isValid(DriverSettings::EnableOffsetRefinement) && settings.getValue<bool>(DriverSettings::EnableOffsetRefinement).has_value()) {
+        json[DriverSettings::getKeyString(DriverSettings::EnableOffsetRefinement)] = *settings.getValue<bool>(DriverSettings::EnableOffsetRefinement);
+    }
+    if (settings.isValid(DriverSettings::EnablePoseStream) && settings.getValue<bool>(DriverSettings::EnablePoseStream).has_value()) {
+        json[DriverSettings::getKeyString(DriverSettings::EnablePoseStream)] = *settings.getValue<bool>(DriverSettings::EnablePoseStream);
+    }
+    if (settings.isValid(DriverSettings::EnableControlSocket) && settings.getValue<bool>(DriverSettings::EnableControlSocket).has_value()) {
+        json[DriverSettings::getKeyString(DriverSettings::EnableControlSocket)] = *settings.getValue<bool>(DriverSettings::EnableControlSocket);
+    }
     if (settings.isValid(DriverSettings::Handedness) && settings.getValue<std::string>(DriverSettings::Handedness).has_value()) {
         json[DriverSettings::getKeyString(DriverSettings::Handedness)] = *settings.getValue<std::string>(DriverSettings::Handedness);
     }
@@ -133,6 +159,24 @@ nlohmann::json FileSettingsLoader::toJson(DriverSettings settings) const
     if (settings.isValid(DriverSettings::ForcedTrackingRefSerial) && settings.getValue<std::string>(DriverSettings::ForcedTrackingRefSerial).has_value()) {
         json[DriverSettings::getKeyString(DriverSettings::ForcedTrackingRefSerial)] = *settings.getValue<std::string>(DriverSettings::ForcedTrackingRefSerial);
     }
+    if (settings.isValid(DriverSettings::IntegrationKeys) && settings.getValue<std::string>(DriverSettings::IntegrationKeys).has_value()) {
+        auto integration_keys = nlohmann::json::parse(*settings.getValue<std::string>(DriverSettings::IntegrationKeys), nullptr, false);
+        if (integration_keys.is_object())
+            json[DriverSettings::getKeyString(DriverSettings::IntegrationKeys)] = integration_keys;
+    }
+    if (settings.isValid(DriverSettings::ApplicationProfiles) && settings.getValue<std::string>(DriverSettings::ApplicationProfiles).has_value()) {
+        auto application_profiles = nlohmann::json::parse(*settings.getValue<std::string>(DriverSettings::ApplicationProfiles), nullptr, false);
+        if (application_profiles.is_object())
+            json[DriverSettings::getKeyString(DriverSettings::ApplicationProfiles)] = application_profiles;
+    }
+    if (settings.isValid(DriverSettings::LogLevels) && settings.getValue<std::string>(DriverSettings::LogLevels).has_value()) {
+        auto log_levels = nlohmann::json::parse(*settings.getValue<std::string>(DriverSettings::LogLevels), nullptr, false);
+        if (log_levels.is_object())
+            json[DriverSettings::getKeyString(DriverSettings::LogLevels)] = log_levels;
+    }
+    if (settings.isValid(DriverSettings::PoseTraceFile) && settings.getValue<std::string>(DriverSettings::PoseTraceFile).has_value()) {
+        json[DriverSettings::getKeyString(DriverSettings::PoseTraceFile)] = *settings.getValue<std::string>(DriverSettings::PoseTraceFile);
+    }
 
     return json;
 }
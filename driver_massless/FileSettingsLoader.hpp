@@ -12,6 +12,7 @@
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <optional>
 
 #include <json.hpp>
 
@@ -65,10 +66,15 @@ private:
     
     /// <summary>
     /// Stored settings output stream.
-    /// If this is a filestream this will be null until ~FileSettingsLoader is called.
+    /// If this is a filestream this will be null, the file is replaced with SettingsUtilities::replaceFile instead.
     /// </summary>
     std::unique_ptr<std::ostream> m_outStream;
 
+    /// <summary>
+    /// Hash of the JSON last read or written, so writing unchanged settings can be skipped
+    /// </summary>
+    std::optional<std::size_t> m_lastWrittenHash;
+
     /// <summary>
     /// True if this is acting on a real filestream
     /// </summary>
@@ -0,0 +1,288 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <cwctype>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(std::filesystem::path path, std::function<void()> on_change) :
+    FileWatcher(path, on_change, Options())
+{}
+
+FileWatcher::FileWatcher(std::filesystem::path path, std::function<void()> on_change, Options options) :
+    m_path(path),
+    m_onChange(on_change),
+    m_options(options)
+{
+    if (!this->m_options.force_polling)
+        this->openNotifications();
+    this->m_lastStamp = this->readStamp();
+    this->m_thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    this->stop();
+    if (this->m_thread.joinable())
+        this->m_thread.join();
+    this->closeNotifications();
+}
+
+const char* FileWatcher::getBackendName() const
+{
+    if (this->m_isPolling)
+        return "polling";
+#ifdef _WIN32
+    return "read_directory_changes";
+#else
+    return "inotify";
+#endif
+}
+
+uint64_t FileWatcher::getChangeCount() const
+{
+    return this->m_changeCount;
+}
+
+void FileWatcher::run()
+{
+    while (this->m_isRunning) {
+        if (!this->waitForChange(this->m_options.poll_interval))
+            continue;
+
+        // Wait for the writer to finish
+        while (this->m_isRunning && this->waitForChange(this->m_options.debounce)) {}
+        if (!this->m_isRunning)
+            break;
+
+        ++this->m_changeCount;
+        this->m_onChange();
+    }
+}
+
+bool FileWatcher::waitForChange(std::chrono::milliseconds timeout)
+{
+    if (this->m_isPolling)
+        return this->poll(timeout);
+    return this->waitForNotification(timeout);
+}
+
+bool FileWatcher::poll(std::chrono::milliseconds timeout)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->m_mutex);
+        if (this->m_wakeCondition.wait_for(lock, timeout, [this]() { return !this->m_isRunning; }))
+            return false;
+    }
+    auto stamp = this->readStamp();
+    if (stamp == this->m_lastStamp)
+        return false;
+    this->m_lastStamp = stamp;
+    return true;
+}
+
+std::optional<FileWatcher::FileStamp> FileWatcher::readStamp() const
+{
+    std::error_code error;
+    FileStamp stamp;
+    stamp.write_time = std::filesystem::last_write_time(this->m_path, error);
+    if (error)
+        return std::nullopt;
+    stamp.size = std::filesystem::file_size(this->m_path, error);
+    if (error)
+        return std::nullopt;
+    return stamp;
+}
+
+#ifdef _WIN32
+void FileWatcher::openNotifications()
+{
+    std::filesystem::path directory = this->m_path.parent_path().empty() ? std::filesystem::path(".") : this->m_path.parent_path();
+    HANDLE handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    this->m_directory = handle;
+    this->m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    this->m_overlapped = std::make_unique<OVERLAPPED>();
+    this->m_overlapped->hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    this->m_isPolling = this->m_stopEvent == nullptr || this->m_overlapped->hEvent == nullptr;
+}
+
+void FileWatcher::closeNotifications()
+{
+    if (this->m_directory != nullptr) {
+        if (this->m_isReading) {
+            CancelIo(this->m_directory);
+            DWORD ignored;
+            GetOverlappedResult(this->m_directory, this->m_overlapped.get(), &ignored, TRUE);
+        }
+        CloseHandle(this->m_directory);
+    }
+    if (this->m_overlapped != nullptr && this->m_overlapped->hEvent != nullptr)
+        CloseHandle(this->m_overlapped->hEvent);
+    if (this->m_stopEvent != nullptr)
+        CloseHandle(this->m_stopEvent);
+}
+
+void FileWatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_isRunning = false;
+    }
+    this->m_wakeCondition.notify_all();
+    if (this->m_stopEvent != nullptr)
+        SetEvent(this->m_stopEvent);
+}
+
+bool FileWatcher::waitForNotification(std::chrono::milliseconds timeout)
+{
+    std::wstring name = this->m_path.filename().wstring();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (this->m_isRunning) {
+        if (!this->m_isReading) {
+            ResetEvent(this->m_overlapped->hEvent);
+            if (!ReadDirectoryChangesW(this->m_directory, this->m_changes, sizeof(this->m_changes), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, this->m_overlapped.get(), nullptr)) {
+                this->m_isPolling = true;
+                return true;
+            }
+            this->m_isReading = true;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        HANDLE waits[2] = { this->m_stopEvent, this->m_overlapped->hEvent };
+        if (WaitForMultipleObjects(2, waits, FALSE, static_cast<DWORD>(std::max<int64_t>(remaining.count(), 0))) != WAIT_OBJECT_0 + 1)
+            return false;
+
+        this->m_isReading = false;
+        DWORD received = 0;
+        if (!GetOverlappedResult(this->m_directory, this->m_overlapped.get(), &received, FALSE))
+            return false;
+
+        // Overflowed, so anything could have changed
+        if (received == 0)
+            return true;
+
+        for (DWORD offset = 0;;) {
+            const auto* change = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(this->m_changes + offset);
+            std::wstring_view changed(change->FileName, change->FileNameLength / sizeof(WCHAR));
+            if (changed.size() == name.size() && std::equal(changed.begin(), changed.end(), name.begin(),
+                [](wchar_t a, wchar_t b) { return std::towlower(a) == std::towlower(b); }))
+                return true;
+            if (change->NextEntryOffset == 0)
+                break;
+            offset += change->NextEntryOffset;
+        }
+    }
+    return false;
+}
+#elif defined(__linux__)
+void FileWatcher::openNotifications()
+{
+    std::filesystem::path directory = this->m_path.parent_path().empty() ? std::filesystem::path(".") : this->m_path.parent_path();
+    int notifications = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifications < 0)
+        return;
+    int wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake < 0 || inotify_add_watch(notifications, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(notifications);
+        if (wake >= 0)
+            close(wake);
+        return;
+    }
+    this->m_notifications = notifications;
+    this->m_wake = wake;
+    this->m_isPolling = false;
+}
+
+void FileWatcher::closeNotifications()
+{
+    if (this->m_notifications >= 0)
+        close(this->m_notifications);
+    if (this->m_wake >= 0)
+        close(this->m_wake);
+}
+
+void FileWatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_isRunning = false;
+    }
+    this->m_wakeCondition.notify_all();
+    if (this->m_wake >= 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto ignored = write(this->m_wake, &one, sizeof(one));
+    }
+}
+
+bool FileWatcher::waitForNotification(std::chrono::milliseconds timeout)
+{
+    std::string name = this->m_path.filename().string();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (this->m_isRunning) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        pollfd fds[2] = { { this->m_notifications, POLLIN, 0 }, { this->m_wake, POLLIN, 0 } };
+        if (::poll(fds, 2, static_cast<int>(std::max<int64_t>(remaining.count(), 0))) <= 0 || (fds[1].revents & POLLIN))
+            return false;
+
+        // Other files in the directory (including the temporary file a replacement is written to) are ignored
+        bool changed = false;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(this->m_notifications, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && name == event->name))
+                    changed = true;
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed)
+            return true;
+    }
+    return false;
+}
+#else
+void FileWatcher::openNotifications()
+{
+}
+
+void FileWatcher::closeNotifications()
+{
+}
+
+void FileWatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_isRunning = false;
+    }
+    this->m_wakeCondition.notify_all();
+}
+
+bool FileWatcher::waitForNotification(std::chrono::milliseconds timeout)
+{
+    return this->poll(timeout);
+}
+#endif
@@ -0,0 +1,123 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#ifdef _WIN32
+struct _OVERLAPPED;
+#endif
+
+/// <summary>
+/// Calls back on a background thread when a file is written or replaced. Watches the file's directory, so replacing the file by renaming
+/// another over it (ie. SettingsUtilities::replaceFile, or most editors) is seen too. Uses inotify on Linux and ReadDirectoryChangesW on
+/// Windows, falling back to polling the file's size and modification time where neither is available.
+/// </summary>
+class FileWatcher
+{
+public:
+    struct Options {
+        /// <summary>
+        /// How long the file has to be left alone before the callback, so a save made of several writes is reported once
+        /// </summary>
+        std::chrono::milliseconds debounce = std::chrono::milliseconds(100);
+
+        /// <summary>
+        /// How often the file is checked when polling
+        /// </summary>
+        std::chrono::milliseconds poll_interval = std::chrono::milliseconds(1000);
+
+        /// <summary>
+        /// Poll even where change notifications are available
+        /// </summary>
+        bool force_polling = false;
+    };
+
+    /// <summary>
+    /// Starts watching
+    /// </summary>
+    /// <param name="path">File to watch, its directory must exist</param>
+    /// <param name="on_change">Called on the watcher's thread after the file has changed</param>
+    FileWatcher(std::filesystem::path path, std::function<void()> on_change);
+    FileWatcher(std::filesystem::path path, std::function<void()> on_change, Options options);
+
+    /// <summary>
+    /// Stops watching, waiting for a callback in progress to return
+    /// </summary>
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// <summary>
+    /// Gets how changes are found: "inotify", "read_directory_changes" or "polling"
+    /// </summary>
+    const char* getBackendName() const;
+
+    /// <summary>
+    /// Gets the number of times the callback has been called
+    /// </summary>
+    uint64_t getChangeCount() const;
+
+private:
+    /// <summary>
+    /// Opens the platform's change notifications, leaving the watcher polling if they aren't available
+    /// </summary>
+    void openNotifications();
+    void closeNotifications();
+
+    /// <summary>
+    /// Waits for the file to change, or to be stopped
+    /// </summary>
+    /// <returns>True if the file changed within the timeout</returns>
+    bool waitForChange(std::chrono::milliseconds timeout);
+    bool waitForNotification(std::chrono::milliseconds timeout);
+    bool poll(std::chrono::milliseconds timeout);
+
+    void run();
+    void stop();
+
+    struct FileStamp {
+        std::filesystem::file_time_type write_time;
+        std::uintmax_t size = 0;
+        bool operator==(const FileStamp& other) const { return this->write_time == other.write_time && this->size == other.size; }
+    };
+    std::optional<FileStamp> readStamp() const;
+
+    std::filesystem::path m_path;
+    std::function<void()> m_onChange;
+    Options m_options;
+    bool m_isPolling = true;
+
+#ifdef _WIN32
+    void* m_directory = nullptr;
+    void* m_stopEvent = nullptr;
+    std::unique_ptr<_OVERLAPPED> m_overlapped;
+    alignas(8) char m_changes[16 * 1024];
+    bool m_isReading = false;
+#else
+    int m_notifications = -1;
+    int m_wake = -1;
+#endif
+
+    std::optional<FileStamp> m_lastStamp;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<bool> m_isRunning = true;
+    std::atomic<uint64_t> m_changeCount = 0;
+    std::thread m_thread;
+};
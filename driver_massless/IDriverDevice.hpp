@@ -9,7 +9,9 @@
 
 #pragma once
 #include <openvr_driver.h>
+#include <DriverSettings.hpp>
 #include <IUpdatable.hpp>
+#include <Span.hpp>
 
 /// <summary>
 /// Interface for devices this driver exposes
@@ -17,5 +19,12 @@
 class IDriverDevice : public vr::ITrackedDeviceServerDriver, public IUpdatable {
 public:
     virtual vr::TrackedDeviceIndex_t getIndex() = 0;
+
+    /// <summary>
+    /// Called on the frame thread after the settings file has been reloaded
+    /// </summary>
+    /// <param name="changed">Settings whose values changed</param>
+    virtual void onSettingsChanged(Span<const DriverSettings::Setting> changed) {}
+
     virtual ~IDriverDevice() = default;
 };
\ No newline at end of file
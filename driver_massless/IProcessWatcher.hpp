@@ -0,0 +1,96 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <TimingStats.hpp>
+
+/// <summary>
+/// Reports processes starting and exiting, either from operating system notifications or by diffing process snapshots
+/// </summary>
+class IProcessWatcher
+{
+public:
+    /// <summary>
+    /// A process starting or exiting
+    /// </summary>
+    struct Event {
+        enum class Type {
+            Started,
+            Exited,
+
+            /// <summary>
+            /// Events were lost, so the process list was read again. The Started events after this one are every process running now,
+            /// anything not among them has exited.
+            /// </summary>
+            Rescanned
+        };
+
+        Type type;
+        unsigned long pid;
+
+        /// <summary>
+        /// Executable name of a started process, empty otherwise
+        /// </summary>
+        std::string name;
+    };
+
+    /// <summary>
+    /// Cost and latency of watching, for diagnostics
+    /// </summary>
+    struct Metrics {
+        /// <summary>
+        /// Time spent scanning for changes (a snapshot diff, or draining notifications)
+        /// </summary>
+        TimingStats scans;
+
+        /// <summary>
+        /// Time from a process starting or exiting to it being reported, where the backend can tell
+        /// </summary>
+        TimingStats detection_latency;
+
+        uint64_t started = 0;
+        uint64_t exited = 0;
+
+        /// <summary>
+        /// Times events were lost and the process list read again
+        /// </summary>
+        uint64_t rescans = 0;
+    };
+
+    virtual ~IProcessWatcher() = default;
+
+    /// <summary>
+    /// Waits for processes to start or exit. The first call reports every running process as started, without waiting.
+    /// </summary>
+    /// <param name="timeout">Longest time to wait. Snapshot watchers wait this long then scan, notification watchers return as soon as there are events.</param>
+    /// <returns>Events since the last call, possibly none</returns>
+    virtual std::vector<Event> waitForEvents(std::chrono::milliseconds timeout) = 0;
+
+    /// <summary>
+    /// Makes a waitForEvents in progress (or the next one) return early, from any thread
+    /// </summary>
+    virtual void interrupt() = 0;
+
+    /// <summary>
+    /// Whether processes are reported as they start and exit, rather than found by scanning
+    /// </summary>
+    virtual bool isEventDriven() const = 0;
+
+    /// <summary>
+    /// Gets the name of the backend, for logging
+    /// </summary>
+    virtual const char* getBackendName() const = 0;
+
+    virtual Metrics getMetrics() const = 0;
+};
@@ -8,8 +8,13 @@
  */
 
 #pragma once
-#include <vector>
 #include <openvr_driver.h>
+#include <Span.hpp>
+
+/// <summary>
+/// Non-owning view of the events polled this frame, only valid for the duration of the update call
+/// </summary>
+using EventSpan = Span<const vr::VREvent_t>;
 
 /// <summary>
 /// Interface for devices that will be updated every frame
@@ -19,7 +24,8 @@ public:
     /// <summary>
     /// Called to update the state of this device.
     /// </summary>
-    virtual void update(std::vector<vr::VREvent_t> events) = 0;
+    /// <param name="events">Events polled by the ServerDriver this frame</param>
+    virtual void update(EventSpan events) = 0;
 
     virtual ~IUpdatable() = default;
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "IntegrationKeyTable.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <json.hpp>
+
+IntegrationKeyTable::IntegrationKeyTable(const std::vector<Entry>& entries)
+{
+    for (const auto& entry : entries) {
+        std::string pattern = toLower(entry.pattern);
+        switch (classify(pattern)) {
+        case MatchKind::Exact:
+            this->m_exact.emplace(pattern, entry.key);
+            break;
+        case MatchKind::Prefix:
+            pattern.pop_back();
+            this->m_prefixLengths.insert(pattern.size());
+            this->m_prefixes.emplace(pattern, entry.key);
+            break;
+        case MatchKind::Glob:
+            this->m_globs.emplace_back(pattern, entry.key);
+            break;
+        }
+        ++this->m_size;
+    }
+}
+
+IntegrationKeyTable::ParseResult IntegrationKeyTable::parse(std::string_view json_text)
+{
+    ParseResult result;
+    nlohmann::json input_json;
+    try {
+        input_json = nlohmann::json::parse(json_text.begin(), json_text.end());
+    }
+    catch (const std::exception& e) {
+        result.errors.emplace_back(e.what());
+        return result;
+    }
+    if (!input_json.is_object()) {
+        result.errors.emplace_back("integration_keys must be an object of application names to keys");
+        return result;
+    }
+
+    for (const auto& [pattern, value] : input_json.items()) {
+        if (pattern.empty()) {
+            result.errors.emplace_back("Empty application name");
+            continue;
+        }
+        if (!value.is_string()) {
+            result.errors.emplace_back("Key for \"" + pattern + "\" is not a string");
+            continue;
+        }
+        try {
+            result.entries.push_back({ pattern, SettingsUtilities::parseIntegrationKey(value.get<std::string>()) });
+        }
+        catch (const std::invalid_argument& e) {
+            result.errors.emplace_back("Key for \"" + pattern + "\" is invalid: " + e.what());
+        }
+    }
+    return result;
+}
+
+IntegrationKeyTable::MatchKind IntegrationKeyTable::classify(std::string_view pattern)
+{
+    std::size_t wildcard = pattern.find_first_of("*?");
+    if (wildcard == std::string_view::npos)
+        return MatchKind::Exact;
+    if (wildcard == pattern.size() - 1 && pattern.back() == '*')
+        return MatchKind::Prefix;
+    return MatchKind::Glob;
+}
+
+bool IntegrationKeyTable::globMatch(std::string_view pattern, std::string_view input)
+{
+    auto lower = [](char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; };
+
+    // Greedy with a single backtrack point, linear for patterns without repeated stars
+    std::size_t p = 0, i = 0;
+    std::size_t star = std::string_view::npos, star_input = 0;
+    while (i < input.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || lower(pattern[p]) == lower(input[i]))) {
+            ++p;
+            ++i;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_input = i;
+        }
+        else if (star != std::string_view::npos) {
+            p = star + 1;
+            i = ++star_input;
+        }
+        else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+
+std::optional<IntegrationKeyTable::Key> IntegrationKeyTable::find(std::string_view exe_name)
+{
+    std::string lower_name = toLower(exe_name);
+    if (auto cached = this->m_cache.find(lower_name); cached != this->m_cache.end())
+        return cached->second;
+
+    auto key = this->match(lower_name);
+    if (this->m_cache.size() >= m_maxCached)
+        this->m_cache.clear();
+    this->m_cache.emplace(std::move(lower_name), key);
+    return key;
+}
+
+std::size_t IntegrationKeyTable::size() const
+{
+    return this->m_size;
+}
+
+std::size_t IntegrationKeyTable::getCacheSize() const
+{
+    return this->m_cache.size();
+}
+
+std::optional<IntegrationKeyTable::Key> IntegrationKeyTable::match(const std::string& lower_name) const
+{
+    if (auto exact = this->m_exact.find(lower_name); exact != this->m_exact.end())
+        return exact->second;
+
+    // Longest prefix first
+    for (std::size_t length : this->m_prefixLengths) {
+        if (length > lower_name.size())
+            continue;
+        if (auto prefix = this->m_prefixes.find(lower_name.substr(0, length)); prefix != this->m_prefixes.end())
+            return prefix->second;
+    }
+
+    for (const auto& [pattern, key] : this->m_globs) {
+        if (globMatch(pattern, lower_name))
+            return key;
+    }
+
+    return SettingsUtilities::getIntegrationKeyForApp(lower_name);
+}
+
+std::string IntegrationKeyTable::toLower(std::string_view value)
+{
+    std::string lower(value);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; });
+    return lower;
+}
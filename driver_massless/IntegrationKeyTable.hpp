@@ -0,0 +1,131 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SettingsUtilities.hpp>
+
+/// <summary>
+/// Maps application executable names to integration keys, from user entries in the integration_keys setting, falling back to the built in keys
+/// (SettingsUtilities::getIntegrationKeyForApp). Entries are compiled once when the table is built: exact names into a hash map, prefixes ("Name*")
+/// into a hash map per prefix length, and anything else with wildcards into a list of globs. All matching is case-insensitive (ASCII). The result
+/// for each executable name is cached, so looking up an application seen before is a single hash lookup.
+/// </summary>
+class IntegrationKeyTable
+{
+public:
+    using Key = std::array<uint8_t, SettingsUtilities::m_integrationKeyLen>;
+
+    /// <summary>
+    /// How an entry's pattern is matched
+    /// </summary>
+    enum class MatchKind {
+        /// <summary>
+        /// No wildcards, the whole name must match
+        /// </summary>
+        Exact,
+
+        /// <summary>
+        /// A single trailing *, the name must start with the rest
+        /// </summary>
+        Prefix,
+
+        /// <summary>
+        /// * matches any run of characters and ? any one character
+        /// </summary>
+        Glob
+    };
+
+    /// <summary>
+    /// A user entry, a pattern and the key for the applications it matches
+    /// </summary>
+    struct Entry {
+        std::string pattern;
+        Key key;
+    };
+
+    /// <summary>
+    /// Entries parsed from the integration_keys setting, and errors for the ones that could not be parsed
+    /// </summary>
+    struct ParseResult {
+        std::vector<Entry> entries;
+        std::vector<std::string> errors;
+    };
+
+    /// <summary>
+    /// Most executable names cached, the cache is cleared when it fills
+    /// </summary>
+    static constexpr std::size_t m_maxCached = 64;
+
+    /// <summary>
+    /// A table with only the built in keys
+    /// </summary>
+    IntegrationKeyTable() = default;
+
+    /// <summary>
+    /// Compiles a table from user entries. Exact names take priority over prefixes (longest first), then globs, then the built in keys.
+    /// </summary>
+    explicit IntegrationKeyTable(const std::vector<Entry>& entries);
+
+    /// <summary>
+    /// Parses the integration_keys setting, a JSON object of patterns to keys (32 hex digits, dashes allowed)
+    /// </summary>
+    /// <param name="json_text">The setting value</param>
+    static ParseResult parse(std::string_view json_text);
+
+    /// <summary>
+    /// Gets how a pattern would be matched
+    /// </summary>
+    static MatchKind classify(std::string_view pattern);
+
+    /// <summary>
+    /// Case-insensitive glob match of the whole input
+    /// </summary>
+    static bool globMatch(std::string_view pattern, std::string_view input);
+
+    /// <summary>
+    /// Finds the integration key for an application, caching the result
+    /// </summary>
+    /// <param name="exe_name">Name of the exe file</param>
+    /// <returns>The key, or nullopt if neither a user entry nor a built in key matches</returns>
+    std::optional<Key> find(std::string_view exe_name);
+
+    /// <summary>
+    /// Number of user entries compiled into the table
+    /// </summary>
+    std::size_t size() const;
+
+    /// <summary>
+    /// Number of executable names currently cached
+    /// </summary>
+    std::size_t getCacheSize() const;
+
+private:
+    std::optional<Key> match(const std::string& lower_name) const;
+
+    static std::string toLower(std::string_view value);
+
+    std::unordered_map<std::string, Key> m_exact;
+    std::unordered_map<std::string, Key> m_prefixes;
+    std::set<std::size_t, std::greater<std::size_t>> m_prefixLengths;
+    std::vector<std::pair<std::string, Key>> m_globs;
+    std::size_t m_size = 0;
+
+    std::unordered_map<std::string, std::optional<Key>> m_cache;
+};
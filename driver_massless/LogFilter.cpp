@@ -0,0 +1,84 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "LogFilter.hpp"
+
+#include <json.hpp>
+
+namespace {
+    constexpr std::array<const char*, 6> level_names = { "trace", "debug", "info", "warn", "error", "off" };
+    constexpr std::array<const char*, LogFilter::m_categoryCount> category_names = { "general", "pose", "gesture", "reference", "backend", "settings" };
+}
+
+void LogFilter::setLevel(LogCategory category, LogLevel minimum)
+{
+    uint64_t category_bits = getCategoryMask(category, LogLevel::Trace);
+    uint64_t enabled_bits = getCategoryMask(category, minimum);
+    uint64_t mask = m_mask.load(std::memory_order_relaxed);
+    while (!m_mask.compare_exchange_weak(mask, (mask & ~category_bits) | enabled_bits, std::memory_order_relaxed)) {}
+}
+
+LogLevel LogFilter::getLevel(LogCategory category)
+{
+    for (unsigned level = 0; level < static_cast<unsigned>(LogLevel::Off); ++level) {
+        if (isEnabled(category, static_cast<LogLevel>(level)))
+            return static_cast<LogLevel>(level);
+    }
+    return LogLevel::Off;
+}
+
+const char* LogFilter::getLevelName(LogLevel level)
+{
+    return level_names.at(static_cast<std::size_t>(level));
+}
+
+const char* LogFilter::getCategoryName(LogCategory category)
+{
+    return category_names.at(static_cast<std::size_t>(category));
+}
+
+std::optional<LogLevel> LogFilter::parseLevel(std::string_view name)
+{
+    for (std::size_t i = 0; i < level_names.size(); ++i) {
+        if (name == level_names[i])
+            return static_cast<LogLevel>(i);
+    }
+    return std::nullopt;
+}
+
+std::optional<LogCategory> LogFilter::parseCategory(std::string_view name)
+{
+    for (std::size_t i = 0; i < category_names.size(); ++i) {
+        if (name == category_names[i])
+            return static_cast<LogCategory>(i);
+    }
+    return std::nullopt;
+}
+
+LogFilter::ParseResult LogFilter::parse(std::string_view json_text)
+{
+    ParseResult result;
+    nlohmann::json input_json = nlohmann::json::parse(json_text.begin(), json_text.end(), nullptr, false);
+    if (input_json.is_discarded() || !input_json.is_object()) {
+        result.errors.emplace_back("log_levels must be an object of categories to levels");
+        return result;
+    }
+
+    for (const auto& [name, value] : input_json.items()) {
+        auto category = parseCategory(name);
+        auto level = value.is_string() ? parseLevel(value.get<std::string>()) : std::nullopt;
+        if (!category.has_value())
+            result.errors.emplace_back("Unknown log category \"" + name + "\"");
+        else if (!level.has_value())
+            result.errors.emplace_back("Log level for \"" + name + "\" must be one of trace, debug, info, warn, error or off");
+        else
+            result.levels.emplace_back(*category, *level);
+    }
+    return result;
+}
@@ -0,0 +1,115 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// How important a log line is, lines below a category's level are not logged
+/// </summary>
+enum class LogLevel : uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+/// <summary>
+/// What a log line is about, each has its own level
+/// </summary>
+enum class LogCategory : uint8_t {
+    General,
+    Pose,
+    Gesture,
+    Reference,
+    Backend,
+    Settings,
+    Count
+};
+
+/// <summary>
+/// Which categories log at which levels, changed at runtime from the settings and runtime parameters. Every (category, level) pair is one bit of a
+/// single atomic mask, so the check a log site does before evaluating any of its arguments is one relaxed load, a shift and a test.
+/// </summary>
+class LogFilter
+{
+public:
+    static constexpr std::size_t m_categoryCount = static_cast<std::size_t>(LogCategory::Count);
+
+    /// <summary>
+    /// The level every category starts at
+    /// </summary>
+    static constexpr LogLevel m_defaultLevel = LogLevel::Info;
+
+    /// <summary>
+    /// Levels from the log_levels setting, categories it doesn't name are left out
+    /// </summary>
+    struct ParseResult {
+        std::vector<std::pair<LogCategory, LogLevel>> levels;
+        std::vector<std::string> errors;
+    };
+
+    static bool isEnabled(LogCategory category, LogLevel level)
+    {
+        return (m_mask.load(std::memory_order_relaxed) >> getBit(category, level)) & 1;
+    }
+
+    /// <summary>
+    /// Sets the lowest level a category logs at, from any thread
+    /// </summary>
+    static void setLevel(LogCategory category, LogLevel minimum);
+
+    static LogLevel getLevel(LogCategory category);
+
+    static const char* getLevelName(LogLevel level);
+    static const char* getCategoryName(LogCategory category);
+    static std::optional<LogLevel> parseLevel(std::string_view name);
+    static std::optional<LogCategory> parseCategory(std::string_view name);
+
+    /// <summary>
+    /// Parses the log_levels setting, a JSON object of category names to level names
+    /// </summary>
+    static ParseResult parse(std::string_view json_text);
+
+private:
+    static constexpr unsigned getBit(LogCategory category, LogLevel level)
+    {
+        return static_cast<unsigned>(category) * 8 + static_cast<unsigned>(level);
+    }
+
+    static constexpr uint64_t getCategoryMask(LogCategory category, LogLevel minimum)
+    {
+        uint64_t mask = 0;
+        for (unsigned level = static_cast<unsigned>(minimum); level < static_cast<unsigned>(LogLevel::Off); ++level)
+            mask |= uint64_t(1) << getBit(category, static_cast<LogLevel>(level));
+        return mask;
+    }
+
+    static constexpr uint64_t getDefaultMask()
+    {
+        uint64_t mask = 0;
+        for (std::size_t category = 0; category < m_categoryCount; ++category)
+            mask |= getCategoryMask(static_cast<LogCategory>(category), m_defaultLevel);
+        return mask;
+    }
+
+    static std::atomic<uint64_t> m_mask;
+};
+
+// Defined after the class so the default mask is a constant, set before any code runs
+inline std::atomic<uint64_t> LogFilter::m_mask{ LogFilter::getDefaultMask() };
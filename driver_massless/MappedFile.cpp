@@ -0,0 +1,107 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+std::unique_ptr<MappedFile> MappedFile::create(const std::filesystem::path& path, std::size_t size)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    HANDLE mapping = nullptr;
+    void* data = nullptr;
+    if (SetFilePointerEx(file, end, nullptr, FILE_BEGIN) && SetEndOfFile(file)) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (mapping != nullptr)
+            data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    }
+    if (data == nullptr) {
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        DeleteFileW(path.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> mapped(new MappedFile());
+    mapped->m_data = data;
+    mapped->m_size = size;
+    mapped->m_file = file;
+    mapped->m_mapping = mapping;
+    return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(this->m_data);
+    CloseHandle(this->m_mapping);
+    CloseHandle(this->m_file);
+}
+
+void MappedFile::flush()
+{
+    FlushViewOfFile(this->m_data, this->m_size);
+}
+#else
+std::unique_ptr<MappedFile> MappedFile::create(const std::filesystem::path& path, std::size_t size)
+{
+    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    // Allocated rather than sparse, so the disk can't fill up part way through
+    void* data = MAP_FAILED;
+    if (posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0)
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        unlink(path.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> mapped(new MappedFile());
+    mapped->m_data = data;
+    mapped->m_size = size;
+    return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(this->m_data, this->m_size);
+}
+
+void MappedFile::flush()
+{
+    msync(this->m_data, this->m_size, MS_ASYNC);
+}
+#endif
+
+void* MappedFile::data()
+{
+    return this->m_data;
+}
+
+std::size_t MappedFile::size() const
+{
+    return this->m_size;
+}
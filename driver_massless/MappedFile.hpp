@@ -0,0 +1,55 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+/// <summary>
+/// A file of a fixed size mapped into memory read/write, for writing large files without a system call per write.
+/// The file is allocated on disk up front so running out of space shows up at create() rather than as a fault while writing.
+/// </summary>
+class MappedFile
+{
+public:
+    /// <summary>
+    /// Creates (or replaces) a zero filled file and maps it
+    /// </summary>
+    /// <param name="path">Path of the file</param>
+    /// <param name="size">Size in bytes</param>
+    /// <returns>The file, or nullptr if it could not be created, allocated or mapped</returns>
+    static std::unique_ptr<MappedFile> create(const std::filesystem::path& path, std::size_t size);
+
+    /// <summary>
+    /// Unmaps the file, leaving the OS to finish writing it back
+    /// </summary>
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// <summary>
+    /// Starts writing changed pages back to the file, without waiting for them
+    /// </summary>
+    void flush();
+
+    void* data();
+    std::size_t size() const;
+
+private:
+    MappedFile() = default;
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
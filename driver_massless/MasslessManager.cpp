@@ -9,64 +9,135 @@
 
 #include "MasslessManager.hpp"
 
-MasslessManager::MasslessManager(std::shared_ptr<MasslessInterface::IPenSystem> pen_system):
-    m_penSystem(pen_system)
+MasslessManager::MasslessManager(std::shared_ptr<MasslessInterface::IPenSystem> pen_system) :
+    MasslessManager(pen_system, ProcessWatch::createPlatformWatcher())
+{}
+
+MasslessManager::MasslessManager(std::shared_ptr<MasslessInterface::IPenSystem> pen_system, std::unique_ptr<IProcessWatcher> process_watcher) :
+    m_penSystem(pen_system),
+    m_studioWatch(std::make_unique<ProcessWatch>(m_masslessStudioMatcher, std::move(process_watcher)))
 {
-    this->m_masslessStudioCheckThread = std::thread(
-        [&isRunning = this->m_isMasslessStudioRunning, 
-        &wasRunning = this->m_wasMasslessStudioRunning, 
-        &shouldRun = this->m_shouldRunStudioCheckThread, 
-        &masslessStudioMatcher = this->m_masslessStudioMatcher,
-        &penSystem = this->m_penSystem,
-        &penSystemLock = this->m_penSystemLock,
-        &penSystemRunning = this->m_penSystemRunning
-        ]() {
-        std::unique_lock my_lock(penSystemLock, std::defer_lock);
-            while (shouldRun) {
-                isRunning = VRProcessEnumerator::isProcessRunning(masslessStudioMatcher);
-                // If we have changed state since last time we checked
-                if (wasRunning != isRunning) {
-                    if (isRunning) {
-                        // Lock access, stop the system if it was started
-                        my_lock.lock();
-                        if (penSystem->isSystemRunning()) {
-                            penSystemRunning = true;
-                            auto res = penSystem->stopSystem();
-                            if (res.has_value())
-                                DriverLog("[Error] Unable to stop backend for Massless Studio. Threw error code [%d].\n", res.value());
-                        }
-                    }
-                    else {
-                        // Restart the system if it was previously started, unlock access
-                        if (penSystemRunning) {
-                            penSystemRunning = false;
-                            auto res = penSystem->startSystem();
-                            if (res.has_value())
-                                DriverLog("[Error] Unable to restart backend after Massless Studio closed. Threw error code [%d].\n", res.value());
-                        }
-                        my_lock.unlock();
-                    }
-                    bool wRunning = isRunning;
-                    wasRunning = wRunning;
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    DRIVER_LOG_INFO(Backend, "Watching for Massless Studio with the %s process watcher.\n", this->m_studioWatch->getWatcher().getBackendName());
+
+    this->m_masslessStudioCheckThread = std::thread([this]() {
+        while (this->m_shouldRunStudioCheckThread) {
+            // Returns as soon as a process starts or exits where the platform reports them, otherwise scans once per interval
+            this->m_isMasslessStudioRunning = this->m_studioWatch->update(std::chrono::milliseconds(this->m_pollIntervalMs.load()));
+            // If we have changed state since last time we checked
+            if (this->m_wasMasslessStudioRunning != this->m_isMasslessStudioRunning) {
+                if (this->m_isMasslessStudioRunning)
+                    this->releaseToStudio();
+                else
+                    this->reclaimFromStudio();
+                bool is_running = this->m_isMasslessStudioRunning;
+                this->m_wasMasslessStudioRunning = is_running;
             }
         }
-    );
+    });
 }
 
 MasslessManager::~MasslessManager()
 {
     this->m_shouldRunStudioCheckThread = false;
+    this->m_studioWatch->interrupt();
     if(this->m_masslessStudioCheckThread.joinable())
         this->m_masslessStudioCheckThread.join();
 }
 
 MasslessManager::SystemLock MasslessManager::getPenSystem()
 {
-    // Try and get access to the pen system
-    std::unique_lock<std::recursive_mutex> lock(this->m_penSystemLock, std::try_to_lock);
-    if (!lock.owns_lock())
-        return SystemLock{ std::move(lock), std::nullopt };
-    return SystemLock{ std::move(lock), this->m_penSystem };
+    SystemLock out{ std::unique_lock<std::recursive_mutex>(this->m_penSystemLock, std::defer_lock), std::nullopt, this->m_ownership.load() };
+    if (out.ownership != Ownership::Driver)
+        return out;
+
+    // Try and get access to the pen system. A handoff may have begun since the ownership was read, in which case give the lock straight back.
+    if (out.lock.try_lock()) {
+        out.ownership = this->m_ownership.load();
+        if (out.ownership == Ownership::Driver)
+            out.pen_system = this->m_penSystem;
+        else
+            out.lock.unlock();
+    }
+    return out;
+}
+
+MasslessManager::Ownership MasslessManager::getOwnership() const
+{
+    return this->m_ownership.load();
+}
+
+uint64_t MasslessManager::getHandoffCount() const
+{
+    return this->m_handoffs.load();
+}
+
+const char* MasslessManager::getOwnershipName(Ownership ownership)
+{
+    switch (ownership) {
+    case Ownership::Driver:
+        return "driver";
+    case Ownership::ReleasingToStudio:
+        return "releasing_to_studio";
+    case Ownership::Studio:
+        return "studio";
+    case Ownership::ReclaimingFromStudio:
+        return "reclaiming_from_studio";
+    }
+    return "unknown";
+}
+
+void MasslessManager::releaseToStudio()
+{
+    this->m_ownership = Ownership::ReleasingToStudio;
+    {
+        // Waits for the frame in progress at most, the frame thread won't take the lock again once ownership has changed
+        std::lock_guard<std::recursive_mutex> lock(this->m_penSystemLock);
+        if (this->m_penSystem->isSystemRunning()) {
+            this->m_penSystemRunning = true;
+            auto res = this->m_penSystem->stopSystem();
+            if (res.has_value())
+                DRIVER_LOG_ERROR(Backend, "Unable to stop backend for Massless Studio. Threw error code [%d].\n", res.value());
+        }
+    }
+    this->m_ownership = Ownership::Studio;
+    ++this->m_handoffs;
+    DRIVER_LOG_INFO(Backend, "Massless Studio is running, the pen is suspended until it closes.\n");
+}
+
+void MasslessManager::reclaimFromStudio()
+{
+    this->m_ownership = Ownership::ReclaimingFromStudio;
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->m_penSystemLock);
+        if (this->m_penSystemRunning) {
+            this->m_penSystemRunning = false;
+            auto res = this->m_penSystem->startSystem();
+            if (res.has_value())
+                DRIVER_LOG_ERROR(Backend, "Unable to restart backend after Massless Studio closed. Threw error code [%d].\n", res.value());
+        }
+    }
+    this->m_ownership = Ownership::Driver;
+    DRIVER_LOG_INFO(Backend, "Massless Studio has closed, the pen is resumed.\n");
+}
+
+void MasslessManager::setPollInterval(std::chrono::milliseconds interval)
+{
+    // Wake the watcher so a shorter interval applies now
+    if (this->m_pollIntervalMs.exchange(interval.count()) != interval.count())
+        this->m_studioWatch->interrupt();
+}
+
+std::chrono::milliseconds MasslessManager::getPollInterval() const
+{
+    return std::chrono::milliseconds(this->m_pollIntervalMs.load());
+}
+
+IProcessWatcher::Metrics MasslessManager::getProcessWatcherMetrics() const
+{
+    return this->m_studioWatch->getWatcher().getMetrics();
+}
+
+const char* MasslessManager::getProcessWatcherName() const
+{
+    return this->m_studioWatch->getWatcher().getBackendName();
 }
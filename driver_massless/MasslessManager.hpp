@@ -13,11 +13,13 @@
 #include <optional>
 #include <thread>
 #include <atomic>
-#include <regex>
+#include <chrono>
 #include <mutex>
 
 #include <IPenSystem.hpp>
-#include <VRProcessEnumerator.hpp>
+#include <IProcessWatcher.hpp>
+#include <ProcessWatch.hpp>
+#include <StringPattern.hpp>
 #include <DriverLog.hpp>
 
 /// <summary>
@@ -27,12 +29,33 @@ class MasslessManager
 {
 public:
 
+    /// <summary>
+    /// Who has the pen system. Only the Massless Studio check thread moves between these, in order, and the frame thread only gets the pen
+    /// system while the driver owns it.
+    /// </summary>
+    enum class Ownership {
+        Driver,
+        ReleasingToStudio,
+        Studio,
+        ReclaimingFromStudio
+    };
+
     struct SystemLock {
         std::unique_lock<std::recursive_mutex> lock;
         std::optional<std::shared_ptr<MasslessInterface::IPenSystem>> pen_system;
+
+        /// <summary>
+        /// Owner when the lock was taken, so callers can tell Massless Studio having the pen from the lock being briefly contended
+        /// </summary>
+        Ownership ownership = Ownership::Driver;
     };
 
     MasslessManager(std::shared_ptr<MasslessInterface::IPenSystem> pen_system);
+
+    /// <summary>
+    /// Watches for Massless Studio with the given process watcher, rather than the platform's
+    /// </summary>
+    MasslessManager(std::shared_ptr<MasslessInterface::IPenSystem> pen_system, std::unique_ptr<IProcessWatcher> process_watcher);
     ~MasslessManager();
 
     /// <summary>
@@ -42,22 +65,78 @@ public:
     /// <returns>SystemLock with locked lock and valid pen_system, or unlocked lock with nullopt pen_system</returns>
     SystemLock getPenSystem();
 
+    /// <summary>
+    /// Gets who has the pen system right now (non-blocking)
+    /// </summary>
+    Ownership getOwnership() const;
+
+    /// <summary>
+    /// Gets the number of times the pen system has been handed to Massless Studio and back
+    /// </summary>
+    uint64_t getHandoffCount() const;
+
+    static const char* getOwnershipName(Ownership ownership);
+
+    /// <summary>
+    /// Sets how often the Massless Studio check runs, waking the check thread so a shorter interval applies immediately.
+    /// Event driven process watchers report Massless Studio starting as it happens whatever the interval.
+    /// </summary>
+    /// <param name="interval">Time between checks</param>
+    void setPollInterval(std::chrono::milliseconds interval);
+
+    /// <summary>
+    /// Gets how often the Massless Studio check runs
+    /// </summary>
+    std::chrono::milliseconds getPollInterval() const;
+
+    /// <summary>
+    /// Gets the cost and latency of watching for Massless Studio
+    /// </summary>
+    IProcessWatcher::Metrics getProcessWatcherMetrics() const;
+
+    /// <summary>
+    /// Gets the name of the process watcher backend in use
+    /// </summary>
+    const char* getProcessWatcherName() const;
+
 private:
 
+    /// <summary>
+    /// Stops the pen system for Massless Studio, once the frame thread has finished with it
+    /// </summary>
+    void releaseToStudio();
+
+    /// <summary>
+    /// Restarts the pen system after Massless Studio has closed, if we stopped it
+    /// </summary>
+    void reclaimFromStudio();
+
     std::shared_ptr<MasslessInterface::IPenSystem> m_penSystem;
 
     /// <summary>
     /// Recusive mutex so PenController, ServerDriver etc. all on the same thread can 
     /// lock it at the same time, but our internal thread cant lock it until they give 
-    /// up access, and vice versa.
+    /// up access, and vice versa. The check thread only holds it while stopping or restarting the pen system.
     /// </summary>
     std::recursive_mutex m_penSystemLock;
 
-    std::regex m_masslessStudioMatcher{ "^(Massless)*\\s*Studio", std::regex_constants::ECMAScript | std::regex_constants::icase };
+    /// <summary>
+    /// Published before the check thread takes the lock, so the frame thread stops trying to take it as soon as a handoff begins
+    /// </summary>
+    std::atomic<Ownership> m_ownership = Ownership::Driver;
+    std::atomic<uint64_t> m_handoffs = 0;
+
+    static constexpr StringPattern m_masslessStudioMatcher = StringPattern::compile("^(Massless)*\\s*Studio");
+    std::unique_ptr<ProcessWatch> m_studioWatch;
     std::thread m_masslessStudioCheckThread;
     std::atomic<bool> m_isMasslessStudioRunning = false;
     std::atomic<bool> m_wasMasslessStudioRunning = false;
     std::atomic<bool> m_shouldRunStudioCheckThread = true;
     std::atomic<bool> m_penSystemRunning = false;
+
+    /// <summary>
+    /// Time between Massless Studio checks, backed off while the driver is idle
+    /// </summary>
+    std::atomic<std::chrono::milliseconds::rep> m_pollIntervalMs = 100;
 };
 
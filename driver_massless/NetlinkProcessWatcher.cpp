@@ -0,0 +1,215 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#ifdef __linux__
+#include "NetlinkProcessWatcher.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    // How long to wait for the kernel to acknowledge the subscription. In a network namespace other than the initial one the socket can be
+    // created but no events (including the acknowledgement) are ever delivered.
+    constexpr int subscribe_timeout_ms = 200;
+
+    bool sendListen(int socket, bool listen)
+    {
+        alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+        auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+        header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+        header->nlmsg_type = NLMSG_DONE;
+        header->nlmsg_pid = 0;
+
+        auto* message = reinterpret_cast<cn_msg*>(NLMSG_DATA(header));
+        message->id.idx = CN_IDX_PROC;
+        message->id.val = CN_VAL_PROC;
+        message->len = sizeof(proc_cn_mcast_op);
+        auto op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+        std::memcpy(message->data, &op, sizeof(op));
+
+        return send(socket, header, header->nlmsg_len, 0) == static_cast<ssize_t>(header->nlmsg_len);
+    }
+
+    uint64_t monotonicNanoseconds()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    }
+}
+
+std::unique_ptr<NetlinkProcessWatcher> NetlinkProcessWatcher::create()
+{
+    int socket = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (socket < 0)
+        return nullptr;
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    int wake = -1;
+    if (bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || !sendListen(socket, true)
+        || (wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) {
+        close(socket);
+        return nullptr;
+    }
+
+    // Wait for the acknowledgement, a PROC_EVENT_NONE
+    std::unique_ptr<NetlinkProcessWatcher> watcher(new NetlinkProcessWatcher(socket, wake));
+    pollfd readable = { socket, POLLIN, 0 };
+    if (poll(&readable, 1, subscribe_timeout_ms) <= 0)
+        return nullptr;
+    return watcher;
+}
+
+NetlinkProcessWatcher::NetlinkProcessWatcher(int socket, int wake) :
+    m_socket(socket),
+    m_wake(wake),
+    m_source(SnapshotProcessWatcher::makePlatformSource())
+{}
+
+NetlinkProcessWatcher::~NetlinkProcessWatcher()
+{
+    sendListen(this->m_socket, false);
+    close(this->m_socket);
+    close(this->m_wake);
+}
+
+std::vector<IProcessWatcher::Event> NetlinkProcessWatcher::waitForEvents(std::chrono::milliseconds timeout)
+{
+    std::vector<Event> events;
+
+    // Processes that started before we subscribed
+    if (!this->m_hasListed) {
+        auto start = std::chrono::steady_clock::now();
+        std::size_t listed = this->list(events);
+        this->m_hasListed = true;
+        {
+            std::lock_guard<std::mutex> lock(this->m_mutex);
+            this->m_metrics.scans.record(std::chrono::steady_clock::now() - start);
+            this->m_metrics.started += listed;
+        }
+        this->drain(events);
+        return events;
+    }
+
+    pollfd fds[2] = { { this->m_socket, POLLIN, 0 }, { this->m_wake, POLLIN, 0 } };
+    if (poll(fds, 2, static_cast<int>(timeout.count())) <= 0)
+        return events;
+    if (fds[1].revents & POLLIN) {
+        uint64_t count;
+        [[maybe_unused]] auto ignored = read(this->m_wake, &count, sizeof(count));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    this->drain(events);
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    this->m_metrics.scans.record(std::chrono::steady_clock::now() - start);
+    return events;
+}
+
+void NetlinkProcessWatcher::interrupt()
+{
+    uint64_t one = 1;
+    [[maybe_unused]] auto ignored = write(this->m_wake, &one, sizeof(one));
+}
+
+bool NetlinkProcessWatcher::isEventDriven() const
+{
+    return true;
+}
+
+const char* NetlinkProcessWatcher::getBackendName() const
+{
+    return "netlink";
+}
+
+IProcessWatcher::Metrics NetlinkProcessWatcher::getMetrics() const
+{
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    return this->m_metrics;
+}
+
+std::size_t NetlinkProcessWatcher::list(std::vector<Event>& events)
+{
+    std::size_t listed = 0;
+    std::vector<unsigned long> pids;
+    if (this->m_source.list_pids(pids)) {
+        for (unsigned long pid : pids) {
+            if (auto name = this->m_source.get_name(pid); name.has_value()) {
+                events.push_back({ Event::Type::Started, pid, std::move(*name) });
+                ++listed;
+            }
+        }
+    }
+    return listed;
+}
+
+void NetlinkProcessWatcher::drain(std::vector<Event>& events)
+{
+    alignas(nlmsghdr) char buffer[4096];
+    while (true) {
+        ssize_t received = recv(this->m_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received < 0 && errno == ENOBUFS) {
+            // The socket overflowed (ie. a burst of forks) and events were dropped. Messages queued after the overflow are still read
+            // after this, and applying them on top of the fresh list is harmless.
+            events.push_back({ Event::Type::Rescanned, 0, std::string() });
+            std::size_t listed = this->list(events);
+            std::lock_guard<std::mutex> lock(this->m_mutex);
+            ++this->m_metrics.rescans;
+            this->m_metrics.started += listed;
+            continue;
+        }
+        if (received <= 0)
+            return;
+        int length = static_cast<int>(received);
+
+        uint64_t now = monotonicNanoseconds();
+        for (auto* header = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP)
+                continue;
+            const auto* message = reinterpret_cast<const cn_msg*>(NLMSG_DATA(header));
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC)
+                continue;
+            const auto* event = reinterpret_cast<const proc_event*>(message->data);
+
+            // Only whole processes, not threads. A fork runs the parent's executable until it execs, so the name is only known at exec.
+            std::optional<Event> reported;
+            if (event->what == proc_event::PROC_EVENT_EXEC) {
+                unsigned long pid = static_cast<unsigned long>(event->event_data.exec.process_tgid);
+                if (auto name = this->m_source.get_name(pid); name.has_value())
+                    reported = Event{ Event::Type::Started, pid, std::move(*name) };
+            }
+            else if (event->what == proc_event::PROC_EVENT_EXIT && event->event_data.exit.process_pid == event->event_data.exit.process_tgid) {
+                reported = Event{ Event::Type::Exited, static_cast<unsigned long>(event->event_data.exit.process_tgid), std::string() };
+            }
+            if (!reported.has_value())
+                continue;
+
+            std::lock_guard<std::mutex> lock(this->m_mutex);
+            if (now > event->timestamp_ns)
+                this->m_metrics.detection_latency.record(std::chrono::nanoseconds(now - event->timestamp_ns));
+            if (reported->type == Event::Type::Started)
+                ++this->m_metrics.started;
+            else
+                ++this->m_metrics.exited;
+            events.push_back(std::move(*reported));
+        }
+    }
+}
+#endif
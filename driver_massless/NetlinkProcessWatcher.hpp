@@ -0,0 +1,68 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include <IProcessWatcher.hpp>
+#include <SnapshotProcessWatcher.hpp>
+
+/// <summary>
+/// Linux process watcher using the kernel's process events connector (netlink), so starts and exits are reported as they happen with no scanning.
+/// Subscribing needs CAP_NET_ADMIN, so create() returns nullptr where that isn't available and the caller should fall back to scanning.
+/// Only built on Linux.
+/// </summary>
+class NetlinkProcessWatcher : public IProcessWatcher
+{
+public:
+    /// <summary>
+    /// Subscribes to process events
+    /// </summary>
+    /// <returns>The watcher, or nullptr if process events are not available</returns>
+    static std::unique_ptr<NetlinkProcessWatcher> create();
+
+    ~NetlinkProcessWatcher();
+
+    NetlinkProcessWatcher(const NetlinkProcessWatcher&) = delete;
+    NetlinkProcessWatcher& operator=(const NetlinkProcessWatcher&) = delete;
+
+    std::vector<Event> waitForEvents(std::chrono::milliseconds timeout) override;
+    void interrupt() override;
+    bool isEventDriven() const override;
+    const char* getBackendName() const override;
+    Metrics getMetrics() const override;
+
+private:
+    NetlinkProcessWatcher(int socket, int wake);
+
+    /// <summary>
+    /// Reports every running process as started
+    /// </summary>
+    /// <returns>Number of processes reported</returns>
+    std::size_t list(std::vector<Event>& events);
+
+    /// <summary>
+    /// Reads every queued message without blocking. If the socket overflowed, the processes are listed again after a Rescanned event.
+    /// </summary>
+    void drain(std::vector<Event>& events);
+
+    int m_socket;
+    int m_wake;
+
+    /// <summary>
+    /// Lists the processes already running on the first call, and names processes as they exec
+    /// </summary>
+    SnapshotProcessWatcher::Source m_source;
+    bool m_hasListed = false;
+
+    mutable std::mutex m_mutex;
+    Metrics m_metrics;
+};
@@ -0,0 +1,244 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "OffsetRefiner.hpp"
+#include <DriverLog.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+void OffsetRefiner::Accumulator::add(const Eigen::Vector3f& source, const Eigen::Vector3f& target)
+{
+    Eigen::Vector3d s = source.cast<double>();
+    Eigen::Vector3d t = target.cast<double>();
+    ++this->m_count;
+    this->m_sumSource += s;
+    this->m_sumTarget += t;
+    this->m_sumSourceSource += s * s.transpose();
+    this->m_sumSourceTarget += s * t.transpose();
+    this->m_sumTargetNorm += t.squaredNorm();
+}
+
+void OffsetRefiner::Accumulator::clear()
+{
+    *this = Accumulator();
+}
+
+std::size_t OffsetRefiner::Accumulator::size() const
+{
+    return this->m_count;
+}
+
+std::optional<OffsetRefiner::Solution> OffsetRefiner::Accumulator::solve(const Options& options) const
+{
+    if (this->m_count < std::max<std::size_t>(options.min_observations, 3))
+        return std::nullopt;
+
+    double n = static_cast<double>(this->m_count);
+    Eigen::Vector3d source_mean = this->m_sumSource / n;
+    Eigen::Vector3d target_mean = this->m_sumTarget / n;
+    Eigen::Matrix3d source_scatter = this->m_sumSourceSource - n * source_mean * source_mean.transpose();
+    Eigen::Matrix3d cross = this->m_sumSourceTarget - n * source_mean * target_mean.transpose();
+
+    // Points along a line leave the rotation about that line free
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> spread(source_scatter / n);
+    double min_spread = static_cast<double>(options.min_spread);
+    if (spread.eigenvalues()(1) < min_spread * min_spread)
+        return std::nullopt;
+
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(cross, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    double reflection = (svd.matrixV() * svd.matrixU().transpose()).determinant() < 0 ? -1.0 : 1.0;
+    Eigen::Vector3d signs(1.0, 1.0, reflection);
+    Eigen::Matrix3d rotation = svd.matrixV() * signs.asDiagonal() * svd.matrixU().transpose();
+    Eigen::Vector3d translation = target_mean - rotation * source_mean;
+
+    // Sum of squared errors, straight from the sums
+    double source_energy = source_scatter.trace();
+    double target_energy = this->m_sumTargetNorm - n * target_mean.squaredNorm();
+    double error = source_energy + target_energy - 2.0 * svd.singularValues().dot(signs);
+
+    Solution solution;
+    solution.offset = { Eigen::Quaterniond(rotation).cast<float>().normalized(), translation.cast<float>() };
+    solution.residual = static_cast<float>(std::sqrt(std::max(error, 0.0) / n));
+    return solution;
+}
+
+OffsetRefiner::OffsetRefiner() :
+    OffsetRefiner(Options(), Clock::now)
+{}
+
+OffsetRefiner::OffsetRefiner(Options options, ClockFunction clock) :
+    m_options(options),
+    m_clock(clock),
+    m_applied(toEigen(MasslessInterface::Pose())),
+    m_backendPose(m_applied)
+{
+    this->m_pending.reserve(this->m_options.max_pending);
+    this->m_worker = std::thread(&OffsetRefiner::run, this);
+}
+
+OffsetRefiner::~OffsetRefiner()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_running = false;
+    }
+    this->m_wake.notify_all();
+    if (this->m_worker.joinable())
+        this->m_worker.join();
+}
+
+void OffsetRefiner::reset(const DriverAnalytics::TrackingReferencePack& reference)
+{
+    if (reference.device_serial == this->m_deviceSerial && reference.type.getSystemType() == this->m_type.getSystemType() && this->m_backendOffset == reference.pose_offset)
+        return;
+
+    this->m_deviceSerial = reference.device_serial;
+    this->m_type = reference.type;
+    this->m_backendOffset = reference.pose_offset;
+    this->m_applied = toEigen(reference.pose_offset);
+    this->m_lastUpdate = this->m_clock();
+
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    ++this->m_generation;
+    this->m_pending.clear();
+    this->m_solution = std::nullopt;
+    this->m_metrics = Metrics();
+    this->m_publishedMetrics.store(this->m_metrics);
+    this->m_backendPose = this->m_applied;
+    this->m_observationType = reference.type.getSystemType();
+}
+
+void OffsetRefiner::addObservation(const Eigen::Vector3f& pen_position, const Eigen::Vector3f& reference_point)
+{
+    constexpr float pi = 3.1415926f;
+
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+
+        // The offset maps Massless space to the reference's frame with the Massless axes flip applied (see ReferenceFusion::makeCompositeTransform)
+        float flip_angle = this->m_observationType == MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER ? pi / 2.0f : pi;
+        Eigen::Vector3f target = Eigen::AngleAxisf(-flip_angle, Eigen::Vector3f::UnitX()) * reference_point;
+        if (this->m_pending.size() >= this->m_options.max_pending) {
+            ++this->m_metrics.dropped;
+            this->m_publishedMetrics.store(this->m_metrics);
+            return;
+        }
+        ++this->m_metrics.observations;
+        this->m_publishedMetrics.store(this->m_metrics);
+        this->m_pending.emplace_back(pen_position, target);
+    }
+    this->m_wake.notify_one();
+}
+
+MasslessInterface::Pose OffsetRefiner::update()
+{
+    auto now = this->m_clock();
+    float elapsed = std::max(std::chrono::duration<float>(now - this->m_lastUpdate).count(), 0.0f);
+    this->m_lastUpdate = now;
+
+    // Never wait on the worker, last frame's target is fine
+    std::unique_lock<std::mutex> lock(this->m_mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return toPose(this->m_applied);
+    EigenPose target = this->m_solution.value_or(this->m_backendPose);
+    lock.unlock();
+
+    Eigen::Vector3f delta = target.second - this->m_applied.second;
+    float max_step = this->m_options.max_translation_rate * elapsed;
+    if (delta.norm() > max_step)
+        delta *= max_step / delta.norm();
+    this->m_applied.second += delta;
+
+    float angle = this->m_applied.first.angularDistance(target.first);
+    float max_angle = this->m_options.max_rotation_rate * elapsed;
+    if (angle > 0)
+        this->m_applied.first = this->m_applied.first.slerp(std::min(1.0f, max_angle / angle), target.first).normalized();
+
+    return toPose(this->m_applied);
+}
+
+const std::string& OffsetRefiner::getDeviceSerial() const
+{
+    return this->m_deviceSerial;
+}
+
+OffsetRefiner::Metrics OffsetRefiner::getMetrics() const
+{
+    return this->m_publishedMetrics.load();
+}
+
+OffsetRefiner::EigenPose OffsetRefiner::toEigen(const MasslessInterface::Pose& offset)
+{
+    return { Eigen::Quaternionf(offset.m_qr, offset.m_qx, offset.m_qy, offset.m_qz).normalized(), Eigen::Vector3f(offset.m_x, offset.m_y, offset.m_z) };
+}
+
+MasslessInterface::Pose OffsetRefiner::toPose(const EigenPose& offset)
+{
+    const auto& [rotation, translation] = offset;
+    return MasslessInterface::Pose(translation.x(), translation.y(), translation.z(), rotation.w(), rotation.x(), rotation.y(), rotation.z());
+}
+
+void OffsetRefiner::run()
+{
+    Accumulator accumulator;
+    std::vector<std::pair<Eigen::Vector3f, Eigen::Vector3f>> batch;
+    batch.reserve(this->m_options.max_pending);
+
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    uint64_t generation = this->m_generation;
+    while (this->m_running) {
+        // Sleeping the whole interval even when woken early is what bounds the solve rate
+        this->m_wake.wait_for(lock, this->m_options.solve_interval, [this]() { return !this->m_running; });
+        if (!this->m_running)
+            break;
+        if (generation != this->m_generation) {
+            accumulator.clear();
+            generation = this->m_generation;
+        }
+        if (this->m_pending.empty())
+            continue;
+
+        batch.swap(this->m_pending);
+        EigenPose backend = this->m_backendPose;
+        lock.unlock();
+
+        for (const auto& [source, target] : batch)
+            accumulator.add(source, target);
+        batch.clear();
+        auto solution = accumulator.solve(this->m_options);
+
+        lock.lock();
+        // Reset while we were solving, these observations were for the old reference
+        if (generation != this->m_generation || !solution.has_value())
+            continue;
+
+        ++this->m_metrics.solves;
+        this->m_metrics.residual = solution->residual;
+        this->m_metrics.correction_distance = (solution->offset.second - backend.second).norm();
+        this->m_metrics.correction_angle = solution->offset.first.angularDistance(backend.first);
+        bool rejected = solution->residual > this->m_options.max_residual
+            || this->m_metrics.correction_distance > this->m_options.max_correction_distance
+            || this->m_metrics.correction_angle > this->m_options.max_correction_angle;
+        if (rejected)
+            ++this->m_metrics.rejected;
+        else
+            this->m_solution = solution->offset;
+        this->m_publishedMetrics.store(this->m_metrics);
+        float correction_distance = this->m_metrics.correction_distance;
+
+        // Logged without the lock, the frame thread tries it every frame
+        lock.unlock();
+        if (rejected)
+            DRIVER_LOG_INFO(Reference, "Offset refinement rejected a solution (error %.1fmm, correction %.1fmm).\n", solution->residual * 1000.0f, correction_distance * 1000.0f);
+        else
+            DRIVER_LOG_INFO(Reference, "Offset refinement updated from %zu observations (error %.1fmm, correction %.1fmm).\n", accumulator.size(), solution->residual * 1000.0f, correction_distance * 1000.0f);
+        lock.lock();
+    }
+}
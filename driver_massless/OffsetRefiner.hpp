@@ -0,0 +1,199 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Eigen/eigen>
+
+#include <DriverAnalytics.hpp>
+#include <Pose.hpp>
+#include <SeqlockValue.hpp>
+#include <TrackingSystemType.hpp>
+
+/// <summary>
+/// Refines the Massless Tracker offset reported by the backend from co-observations: the pen tip (in Massless space) placed on points whose position
+/// is known in the tracking reference's own frame, ie. marked points on a Rift S controller or Vive Tracker. The best fit offset is found with an
+/// incremental least squares solve (running sums, so each solve is constant time however many observations there are) on a worker thread that wakes
+/// at most once per solve_interval. The frame thread only queues observations and eases the applied offset toward the latest solution.
+/// </summary>
+class OffsetRefiner
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    /// <summary>
+    /// Solve and smoothing limits
+    /// </summary>
+    struct Options {
+        /// <summary>
+        /// Fewest observations before solving
+        /// </summary>
+        std::size_t min_observations = 4;
+
+        /// <summary>
+        /// Observations must spread at least this far (metres, standard deviation) in two directions, or the rotation is not constrained
+        /// </summary>
+        float min_spread = 0.01f;
+
+        /// <summary>
+        /// Largest RMS error (metres) of a solution that is applied
+        /// </summary>
+        float max_residual = 0.005f;
+
+        /// <summary>
+        /// Largest difference from the backend's offset that is applied, anything further is more likely bad observations than calibration error
+        /// </summary>
+        float max_correction_distance = 0.05f;
+        float max_correction_angle = 0.17f;
+
+        /// <summary>
+        /// How fast the applied offset moves toward the solution, so corrections don't jump the pen
+        /// </summary>
+        float max_translation_rate = 0.01f;
+        float max_rotation_rate = 0.05f;
+
+        /// <summary>
+        /// Minimum time between solves, bounds the worker's CPU use
+        /// </summary>
+        std::chrono::milliseconds solve_interval{ 250 };
+
+        /// <summary>
+        /// Observations queued between solves, any more are dropped
+        /// </summary>
+        std::size_t max_pending = 64;
+    };
+
+    /// <summary>
+    /// Refinement state, for diagnostics
+    /// </summary>
+    struct Metrics {
+        uint64_t observations = 0;
+        uint64_t dropped = 0;
+        uint64_t solves = 0;
+        uint64_t rejected = 0;
+        float residual = 0;
+        float correction_distance = 0;
+        float correction_angle = 0;
+    };
+
+    /// <summary>
+    /// A best fit offset
+    /// </summary>
+    struct Solution {
+        EigenPose offset;
+        float residual;
+    };
+
+    /// <summary>
+    /// Running sums of the observation pairs, from which the best fit rigid transform (Kabsch) and its error can be found without keeping the pairs
+    /// </summary>
+    class Accumulator {
+    public:
+        void add(const Eigen::Vector3f& source, const Eigen::Vector3f& target);
+        void clear();
+        std::size_t size() const;
+
+        /// <summary>
+        /// Finds the rigid transform that best maps the sources on to the targets
+        /// </summary>
+        /// <returns>The transform and its RMS error, or nullopt if there are too few observations or they are too close to a line</returns>
+        std::optional<Solution> solve(const Options& options) const;
+
+    private:
+        std::size_t m_count = 0;
+        Eigen::Vector3d m_sumSource = Eigen::Vector3d::Zero();
+        Eigen::Vector3d m_sumTarget = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d m_sumSourceSource = Eigen::Matrix3d::Zero();
+        Eigen::Matrix3d m_sumSourceTarget = Eigen::Matrix3d::Zero();
+        double m_sumTargetNorm = 0;
+    };
+
+    OffsetRefiner();
+    OffsetRefiner(Options options, ClockFunction clock);
+    ~OffsetRefiner();
+
+    OffsetRefiner(const OffsetRefiner&) = delete;
+    OffsetRefiner& operator=(const OffsetRefiner&) = delete;
+
+    /// <summary>
+    /// Starts refining the offset of a tracking reference. Observations are kept if it is the same device with the same backend offset as before.
+    /// </summary>
+    void reset(const DriverAnalytics::TrackingReferencePack& reference);
+
+    /// <summary>
+    /// Queues a co-observation for the worker, can be called from any thread
+    /// </summary>
+    /// <param name="pen_position">Pen tip position in Massless space</param>
+    /// <param name="reference_point">Where the tip is in the tracking reference's frame (SteamVR axes, metres)</param>
+    void addObservation(const Eigen::Vector3f& pen_position, const Eigen::Vector3f& reference_point);
+
+    /// <summary>
+    /// Eases the applied offset toward the latest accepted solution, call once per frame
+    /// </summary>
+    /// <returns>The offset to use this frame, the backend's offset until a solution has been accepted</returns>
+    MasslessInterface::Pose update();
+
+    /// <summary>
+    /// Gets the serial of the reference being refined, empty before the first reset
+    /// </summary>
+    const std::string& getDeviceSerial() const;
+
+    /// <summary>
+    /// Gets the latest metrics without waiting on the worker, so it can be called every frame
+    /// </summary>
+    Metrics getMetrics() const;
+
+    /// <summary>
+    /// Converts between the offset as reported by the Massless API and a rotation/translation
+    /// </summary>
+    static EigenPose toEigen(const MasslessInterface::Pose& offset);
+    static MasslessInterface::Pose toPose(const EigenPose& offset);
+
+private:
+    void run();
+
+    Options m_options;
+    ClockFunction m_clock;
+
+    // Frame thread only
+    std::string m_deviceSerial;
+    MasslessInterface::TrackingSystemType m_type;
+    MasslessInterface::Pose m_backendOffset;
+    EigenPose m_applied;
+    Clock::time_point m_lastUpdate;
+
+    // Shared with the worker, guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<std::pair<Eigen::Vector3f, Eigen::Vector3f>> m_pending;
+    uint64_t m_generation = 0;
+    std::optional<EigenPose> m_solution;
+    Metrics m_metrics;
+    EigenPose m_backendPose;
+    MasslessInterface::TrackingSystemType::SystemType m_observationType = MasslessInterface::TrackingSystemType::SystemType::INVALID_SYSTEM;
+
+    // Copy of m_metrics for getMetrics, stored whenever it changes (while holding m_mutex, so stores never overlap)
+    SeqlockValue<Metrics> m_publishedMetrics;
+
+    std::atomic<bool> m_running = true;
+    std::thread m_worker;
+};
@@ -11,6 +11,31 @@
 #include <DriverLog.hpp>
 #include <iostream>
 
+namespace {
+    // Debug requests answered by the pen itself rather than forwarded to the server driver
+    constexpr std::array<const char*, 3> pen_debug_commands = { "stats", "pose_history", "queues" };
+
+    void tracePose(float (&position)[3], float (&rotation)[4], const vr::DriverPose_t& pose)
+    {
+        for (int i = 0; i < 3; ++i)
+            position[i] = static_cast<float>(pose.vecPosition[i]);
+        rotation[0] = static_cast<float>(pose.qRotation.w);
+        rotation[1] = static_cast<float>(pose.qRotation.x);
+        rotation[2] = static_cast<float>(pose.qRotation.y);
+        rotation[3] = static_cast<float>(pose.qRotation.z);
+    }
+
+    void tracePose(float (&position)[3], float (&rotation)[4], const std::pair<Eigen::Quaternionf, Eigen::Vector3f>& pose)
+    {
+        for (int i = 0; i < 3; ++i)
+            position[i] = pose.second[i];
+        rotation[0] = pose.first.w();
+        rotation[1] = pose.first.x();
+        rotation[2] = pose.first.y();
+        rotation[3] = pose.first.z();
+    }
+}
+
 PenController::PenController(std::shared_ptr<SettingsManager> settings_manager, std::shared_ptr<MasslessManager> massless_manager):
     m_settingsManager(settings_manager),
     m_masslessManager(massless_manager),
@@ -31,13 +56,13 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             auto pen_system = massless_manager->getPenSystem();
             float swipe_velocity = std::static_pointer_cast<Massless::Events::TouchPadSwipeEvent>(event_stack.at(3).m_eventStruct.value())->Velocity;
             if (swipe_velocity > 0) {
-                DriverLog("Firing swipe forwards event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing swipe forwards event\n");
                 driver_input->UpdateBooleanComponent(this->m_compSwipeForwards, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
             }
             else {
-                DriverLog("Firing swipe backwards event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing swipe backwards event\n");
                 driver_input->UpdateBooleanComponent(this->m_compSwipeBackwards, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -63,7 +88,7 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             uint8_t tap_position_2 = std::static_pointer_cast<Massless::Events::TouchPadPressedEvent>(event_stack.at(3).m_eventStruct.value())->PositionPressed;
             auto pen_system = massless_manager->getPenSystem();
             if (tap_position_1 < m_touchpadSplitLocation && tap_position_2 < m_touchpadSplitLocation) {
-                DriverLog("Firing front double held down event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing front double held down event\n");
                 driver_input->UpdateBooleanComponent(this->m_compDoubleFront, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -71,7 +96,7 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
                 return false;
             }
             else if (tap_position_1 > m_touchpadSplitLocation && tap_position_2 > m_touchpadSplitLocation) {
-                DriverLog("Firing rear double held down event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing rear double held down event\n");
                 driver_input->UpdateBooleanComponent(this->m_compDoubleRear, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -95,7 +120,7 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             EventType::TouchPadReleased
         },
         [&, this](std::vector<MasslessInterface::PenEvent> event_stack, vr::IVRDriverInput* driver_input, std::shared_ptr<MasslessManager> massless_manager) {
-            DriverLog("Firing double held up event\n");
+            DRIVER_LOG_DEBUG(Gesture, "Firing double held up event\n");
             //TODO: If we add the haptics on down and up, doesn't this need an up vibration?
             this->m_unpressAllFrameTimeout = this->m_unpressAllMaxTimeout;
             return true;
@@ -114,13 +139,13 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             auto pen_system = massless_manager->getPenSystem();
             uint8_t tap_position = std::static_pointer_cast<Massless::Events::TouchPadPressedEvent>(event_stack.at(0).m_eventStruct.value())->PositionPressed;
             if (tap_position < m_touchpadSplitLocation) {
-                DriverLog("Firing front single held down event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing front single held down event\n");
                 driver_input->UpdateBooleanComponent(this->m_compSingleFront, true, 0); 
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
             }
             else {
-                DriverLog("Firing rear single held down event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing rear single held down event\n");
                 driver_input->UpdateBooleanComponent(this->m_compSingleRear, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -140,7 +165,7 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             EventType::TouchPadReleased
         },
         [&, this](std::vector<MasslessInterface::PenEvent> event_stack, vr::IVRDriverInput* driver_input, std::shared_ptr<MasslessManager> massless_manager) {
-            DriverLog("Firing single held up event\n");
+            DRIVER_LOG_DEBUG(Gesture, "Firing single held up event\n");
             this->m_unpressAllFrameTimeout = this->m_unpressAllMaxTimeout;
             return true;
         }
@@ -162,7 +187,7 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             uint8_t tap_position_2 = std::static_pointer_cast<Massless::Events::TouchPadPressedEvent>(event_stack.at(3).m_eventStruct.value())->PositionPressed;
             auto pen_system = massless_manager->getPenSystem();
             if (tap_position_1 < m_touchpadSplitLocation && tap_position_2 < m_touchpadSplitLocation) {
-                DriverLog("Firing front double tap event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing front double tap event\n");
                 driver_input->UpdateBooleanComponent(this->m_compDoubleFront, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -170,7 +195,7 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
                 return true;
             }
             else if (tap_position_1 > m_touchpadSplitLocation && tap_position_2 > m_touchpadSplitLocation) {
-                DriverLog("Firing rear double tap event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing rear double tap event\n");
                 driver_input->UpdateBooleanComponent(this->m_compDoubleRear, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -193,13 +218,13 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             auto pen_system = massless_manager->getPenSystem();
             uint8_t tap_position = std::static_pointer_cast<Massless::Events::TouchPadPressedEvent>(event_stack.at(0).m_eventStruct.value())->PositionPressed;
             if (tap_position < m_touchpadSplitLocation) {
-                DriverLog("Firing front single tap event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing front single tap event\n");
                 driver_input->UpdateBooleanComponent(this->m_compSingleFront, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
             }
             else {
-                DriverLog("Firing rear single tap event\n");
+                DRIVER_LOG_DEBUG(Gesture, "Firing rear single tap event\n");
                 driver_input->UpdateBooleanComponent(this->m_compSingleRear, true, 0);
                 /*if (pen_system.pen_system.has_value())
                     pen_system.pen_system.value()->sendVibration(this->m_tapVibrationDuration);*/
@@ -208,25 +233,60 @@ PenController::PenController(std::shared_ptr<SettingsManager> settings_manager,
             return true;
         }
         });
+    this->publishDebugState();
+}
+
+void PenController::update(EventSpan events)
+{
+    this->updatePen(events);
+    this->publishDebugState();
 }
 
-void PenController::update(std::vector<vr::VREvent_t> events)
+void PenController::updatePen(EventSpan events)
 {
     if (this->m_deviceIndex != vr::k_unTrackedDeviceIndexInvalid)
     {
+        ScopedTimer update_timer(this->m_updateTiming);
+        ++this->m_debugCounters.updates;
+
         // Ensure the pen is always highest priority
         vr::VRProperties()->SetInt32Property(this->m_propertiesHandle, vr::Prop_ControllerHandSelectionPriority_Int32, INT32_MAX);
         
         // Log notifications
-        if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false))
+        if (LogFilter::isEnabled(LogCategory::Backend, LogLevel::Debug))
             this->logNotifications();
 
         // Process OpenVR events
         this->processOpenVREvents(events);
 
+        // Inputs held when Massless Studio takes the pen would otherwise stay held until it closes
+        auto ownership = this->m_masslessManager->getOwnership();
+        bool ownership_changed = ownership != this->m_lastOwnership;
+        this->m_lastOwnership = ownership;
+        if (ownership_changed && ownership != MasslessManager::Ownership::Driver)
+            this->releaseInputs(vr::VRDriverInput());
+
         // Process Massless events
         this->processMasslessEvents(vr::VRDriverInput());
+
+        // Pen input is activity, as is tracking (which ServerDriver checks before us). Otherwise the pose can't have changed, so while idle it is
+        // only re-sent once per work interval, or straight away when the pen is suspended or resumed.
+        PowerController& power = ServerDriver::instance()->getPowerController();
+        if (this->m_debugCounters.last_frame_massless_events > 0)
+            power.onPenActivity();
+        if (!ownership_changed && power.getMode() != PowerController::Mode::Active && !power.isWorkDue()) {
+            ++this->m_debugCounters.idle_skips;
+            return;
+        }
         
+        // The application's profile, which stays the same for the whole update even if ServerDriver switches it
+        const PenProfile& profile = ServerDriver::instance()->getActiveProfile();
+        bool is_tracking = false;
+
+        // Each stage of a tracked pose, when tracing is on
+        PoseTraceRecorder* pose_trace = ServerDriver::instance()->getPoseTrace();
+        PoseTrace::Record trace_record = {};
+
         auto pen_system_lock = this->m_masslessManager->getPenSystem();
         if (pen_system_lock.pen_system.has_value()) {
             auto pen_system = pen_system_lock.pen_system.value();
@@ -244,18 +304,71 @@ void PenController::update(std::vector<vr::VREvent_t> events)
             else if (auto ref_pose = ServerDriver::instance()->getTrackingReference(); ref_pose.has_value())
             {
                 MasslessInterface::Pose pen_pose = pen_system->getCurrentPose();
-                this->m_currentPenPose = this->makeOpenVRPose(pen_pose, ref_pose->pose_offset, ref_pose->global_pose, ref_pose->type);
+
+                // Moving references are evaluated at the instant the pen sample was captured, rather than at RunFrame time
+                if (auto aligned_pose = ServerDriver::instance()->getTrackingReferencePoseAt(pen_pose.m_timestamp); aligned_pose.has_value())
+                    ref_pose->global_pose = *aligned_pose;
+
+                if (auto fused_pose = ServerDriver::instance()->getFusedPenPose(pen_pose); fused_pose.has_value()) {
+                    this->m_currentPenPose = this->makeOpenVRPose(*fused_pose);
+                    trace_record.flags |= PoseTrace::Fused;
+                }
+                else {
+                    this->m_currentPenPose = this->makeOpenVRPose(pen_pose, ref_pose->pose_offset, ref_pose->global_pose, ref_pose->type);
+                }
+                if (pose_trace != nullptr) {
+                    trace_record.sample_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(pen_pose.m_timestamp.time_since_epoch()).count();
+                    float raw_position[3] = { pen_pose.m_x, pen_pose.m_y, pen_pose.m_z };
+                    std::copy(std::begin(raw_position), std::end(raw_position), trace_record.raw_position);
+                    float raw_rotation[4] = { pen_pose.m_qr, pen_pose.m_qx, pen_pose.m_qy, pen_pose.m_qz };
+                    std::copy(std::begin(raw_rotation), std::end(raw_rotation), trace_record.raw_rotation);
+                    tracePose(trace_record.reference_position, trace_record.reference_rotation, ref_pose->global_pose);
+                    tracePose(trace_record.transformed_position, trace_record.transformed_rotation, this->m_currentPenPose);
+                }
+                this->m_poseFilter.configure(profile.smoothing, profile.prediction_ms);
+                this->m_poseFilter.apply(this->m_currentPenPose, pen_pose.m_timestamp);
+                if (pose_trace != nullptr)
+                    tracePose(trace_record.filtered_position, trace_record.filtered_rotation, this->m_currentPenPose);
+                is_tracking = true;
+                ServerDriver::instance()->onValidPenPose();
             }
             // Otherwise we are just waiting to find a tracking reference pose (ie. calibrating in-progress)
             else {
                 this->m_currentPenPose = this->makeCalibratingOpenVRPose();
             }
         }
+        // Massless Studio has the pen, or is being handed it
+        else if (pen_system_lock.ownership != MasslessManager::Ownership::Driver) {
+            this->m_currentPenPose = this->makeSuspendedOpenVRPose();
+        }
         // Otherwise we cannot access backend, so we are disconnected
         else {
+            ++this->m_debugCounters.backend_unavailable;
             this->m_currentPenPose = this->makeDisconnectedOpenVRPose();
         }
+        if (!is_tracking)
+            this->m_poseFilter.reset();
+
+        // Applications that can't use every frame's pose can ask for fewer, changes of tracking state are always sent
+        auto now = std::chrono::steady_clock::now();
+        if (is_tracking && this->m_wasTracking && profile.max_pose_rate_hz > 0.0f
+            && now - this->m_lastPoseUpdate < std::chrono::duration<float>(1.0f / profile.max_pose_rate_hz)) {
+            ++this->m_debugCounters.rate_limited_poses;
+            if (pose_trace != nullptr) {
+                trace_record.flags |= PoseTrace::RateLimited;
+                pose_trace->record(trace_record);
+            }
+            return;
+        }
+        this->m_lastPoseUpdate = now;
+        this->m_wasTracking = is_tracking;
+
+        this->recordPose(this->m_currentPenPose);
         this->updatePenPose(this->m_currentPenPose);
+        if (is_tracking && pose_trace != nullptr) {
+            trace_record.submit_ns = PoseTraceRecorder::nowNanoseconds();
+            pose_trace->record(trace_record);
+        }
     }
 }
 
@@ -274,6 +387,7 @@ void PenController::logNotifications() {
     // Show receieved notifications
     while (true) {
         if (auto notification = pen_system->popNotification(); notification != std::nullopt) {
+            ++this->m_debugCounters.notifications;
             std::string notificationType;
             switch (notification->m_notificationType) {
             case MasslessInterface::PenNotification::WARNING:
@@ -288,10 +402,10 @@ void PenController::logNotifications() {
                 break;
             }
             if (notification->m_notificationCode.has_value()) {
-                DriverLog("[Notification] [%s] %x \"%s\"\n", notificationType.c_str(), notification->m_notificationCode.value(), notification->m_notificationMessage.c_str());
+                DRIVER_LOG_DEBUG(Backend, "Notification [%s] %x \"%s\"\n", notificationType.c_str(), notification->m_notificationCode.value(), notification->m_notificationMessage.c_str());
             }
             else {
-                DriverLog("[Notification] [%s] \"%s\"\n", notificationType.c_str(), notification->m_notificationMessage.c_str());
+                DRIVER_LOG_DEBUG(Backend, "Notification [%s] \"%s\"\n", notificationType.c_str(), notification->m_notificationMessage.c_str());
             }
         }
         else {
@@ -302,6 +416,7 @@ void PenController::logNotifications() {
 
 void PenController::processMasslessEvents(vr::IVRDriverInput* driver_input)
 {
+    this->m_debugCounters.last_frame_massless_events = 0;
     auto pen_system_lock = this->m_masslessManager->getPenSystem();
     if (!pen_system_lock.pen_system.has_value())
         return;
@@ -309,12 +424,7 @@ void PenController::processMasslessEvents(vr::IVRDriverInput* driver_input)
 
     if (this->m_unpressAllFrameTimeout == 0) {
         this->m_unpressAllFrameTimeout = this->m_unpressAllStopTimeout;
-        driver_input->UpdateBooleanComponent(this->m_compSingleFront, false, 0);
-        driver_input->UpdateBooleanComponent(this->m_compDoubleFront, false, 0);
-        driver_input->UpdateBooleanComponent(this->m_compSingleRear, false, 0);
-        driver_input->UpdateBooleanComponent(this->m_compDoubleRear, false, 0);
-        driver_input->UpdateBooleanComponent(this->m_compSwipeForwards, false, 0);
-        driver_input->UpdateBooleanComponent(this->m_compSwipeBackwards, false, 0);
+        this->releaseGestureInputs(driver_input);
         //pen_system->sendVibration(this->m_tapVibrationDuration);
     }
     else if (this->m_unpressAllFrameTimeout > 0) {
@@ -338,23 +448,25 @@ void PenController::processMasslessEvents(vr::IVRDriverInput* driver_input)
 
     while (true) {
         if (auto event = pen_system->popEvent(); event != std::nullopt) {
+            ++this->m_debugCounters.massless_events;
+            ++this->m_debugCounters.last_frame_massless_events;
             switch (event->m_eventType) {
                 case Massless::Events::EventType::PenBattery:
                 {
                     const Massless::Events::PenBatteryEvent* battery_event = static_cast<Massless::Events::PenBatteryEvent*>(event->m_eventStruct->get());
-                    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false)) {
+                    if (this->isDetailedLogging()) {
                         if (battery_event->Charging) {
-                            DriverLog("[Event] Pen battery is charging\n");
+                            DRIVER_LOG_DEBUG(Backend, "Pen battery is charging\n");
                             vr::VRProperties()->SetBoolProperty(this->m_propertiesHandle, vr::Prop_DeviceIsCharging_Bool, true);
                         }
                         else {
-                            DriverLog("[Event] Pen battery is not charging\n");
+                            DRIVER_LOG_DEBUG(Backend, "Pen battery is not charging\n");
                             if (battery_event->Low) {
-                                DriverLog("[Event] Pen battery is low\n");
+                                DRIVER_LOG_DEBUG(Backend, "Pen battery is low\n");
                                 vr::VRProperties()->SetFloatProperty(this->m_propertiesHandle, vr::Prop_DeviceBatteryPercentage_Float, 0.1f);
                             }
                             else if (battery_event->Critical) {
-                                DriverLog("[Event] Pen battery is critical\n");
+                                DRIVER_LOG_DEBUG(Backend, "Pen battery is critical\n");
                                 vr::VRProperties()->SetFloatProperty(this->m_propertiesHandle, vr::Prop_DeviceBatteryPercentage_Float, 0.05f);
                             }
                             else {
@@ -365,8 +477,7 @@ void PenController::processMasslessEvents(vr::IVRDriverInput* driver_input)
 
                     }
                     else if (battery_event->Critical) {
-                        if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false))
-                            DriverLog("[Event] Pen battery is critical\n");
+                        DRIVER_LOG_DEBUG(Backend, "Pen battery is critical\n");
                         vr::VRProperties()->SetFloatProperty(this->m_propertiesHandle, vr::Prop_DeviceBatteryPercentage_Float, 0.05f);
                     }
                     else {
@@ -377,8 +488,7 @@ void PenController::processMasslessEvents(vr::IVRDriverInput* driver_input)
                 case Massless::Events::EventType::Error:
                 {
                     const Massless::Events::ErrorEvent* error_event = static_cast<Massless::Events::ErrorEvent*>(event->m_eventStruct->get());
-                    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false))
-                        DriverLog("[Event] [Error] Error code received %u\n", error_event->ErrorNumber);
+                    DRIVER_LOG_DEBUG(Backend, "Pen error code received %u\n", error_event->ErrorNumber);
                 } break;
 
 
@@ -400,19 +510,24 @@ void PenController::processMasslessEvents(vr::IVRDriverInput* driver_input)
     }
 }
 
-void PenController::processOpenVREvents(std::vector<vr::VREvent_t> events) {
+void PenController::processOpenVREvents(EventSpan events) {
+
+    this->m_debugCounters.openvr_events += events.size();
+    this->m_debugCounters.last_frame_openvr_events = events.size();
 
     auto pen_system_lock = this->m_masslessManager->getPenSystem();
     if (!pen_system_lock.pen_system.has_value())
         return;
     auto pen_system = pen_system_lock.pen_system.value();
 
-    for(auto event : events)
+    for(const auto& event : events)
     {
         // Process haptics
         if (event.eventType == vr::VREvent_Input_HapticVibration) {
             if (event.data.hapticVibration.componentHandle == this->m_compHaptic) {
-                pen_system->sendVibration(static_cast<uint16_t>(event.data.hapticVibration.fDurationSeconds * 1000.0f));
+                ++this->m_debugCounters.haptic_events;
+                float duration_ms = event.data.hapticVibration.fDurationSeconds * 1000.0f * ServerDriver::instance()->getActiveProfile().haptic_scale;
+                pen_system->sendVibration(static_cast<uint16_t>(std::clamp(duration_ms, 0.0f, static_cast<float>(UINT16_MAX))));
                 break;
             }
         }
@@ -473,14 +588,32 @@ vr::EVRInitError PenController::Activate(vr::TrackedDeviceIndex_t index, vr::IVR
     // driver_properties->SetBoolProperty(this->m_propertiesHandle, vr::Prop_Firmware_UpdateAvailable_Bool, true);
     // driver_properties->SetBoolProperty(this->m_propertiesHandle, vr::Prop_Firmware_ManualUpdate_Bool, true);
     // driver_properties->SetStringProperty(this->m_propertiesHandle, vr::Prop_Firmware_ManualUpdateURL_String, "https://massless.io/");
+    this->setRoleHint(driver_properties);
+
+    return vr::EVRInitError::VRInitError_None;
+}
+
+void PenController::setRoleHint(vr::CVRPropertyHelpers* driver_properties)
+{
     if (Handedness(this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::Handedness).value()) == Handedness::LEFT) {
         driver_properties->SetInt32Property(this->m_propertiesHandle, vr::Prop_ControllerRoleHint_Int32, vr::ETrackedControllerRole::TrackedControllerRole_LeftHand);
     }
     else if (Handedness(this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::Handedness).value()) == Handedness::RIGHT) {
         driver_properties->SetInt32Property(this->m_propertiesHandle, vr::Prop_ControllerRoleHint_Int32, vr::ETrackedControllerRole::TrackedControllerRole_RightHand);
     }
+}
 
-    return vr::EVRInitError::VRInitError_None;
+void PenController::onSettingsChanged(Span<const DriverSettings::Setting> changed)
+{
+    if (this->m_deviceIndex == vr::k_unTrackedDeviceIndexInvalid)
+        return;
+
+    // SteamVR only rereads the role hint when told the role has changed
+    if (std::find(changed.begin(), changed.end(), DriverSettings::Handedness) != changed.end()) {
+        this->setRoleHint(vr::VRProperties());
+        vr::VRServerDriverHost()->VendorSpecificEvent(this->m_deviceIndex, vr::VREvent_TrackedDeviceRoleChanged, {}, 0);
+        DRIVER_LOG_INFO(Settings, "Pen handedness changed to %s.\n", this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::Handedness).value_or("").c_str());
+    }
 }
 
 void PenController::Deactivate()
@@ -493,6 +626,8 @@ void PenController::Deactivate()
 
 void PenController::EnterStandby()
 {
+    // Stays in standby until the pen is used again, or SteamVR wakes the driver
+    ServerDriver::instance()->getPowerController().enterStandby();
 }
 
 void* PenController::GetComponent(const char* pchComponentNameAndVersion)
@@ -502,8 +637,48 @@ void* PenController::GetComponent(const char* pchComponentNameAndVersion)
 
 void PenController::DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize)
 {
-	if (unResponseBufferSize >= 1)
-		pchResponseBuffer[0] = 0;
+    DebugResponseWriter writer(pchResponseBuffer, unResponseBufferSize);
+    auto [command, argument] = DebugResponseWriter::splitRequest(pchRequest);
+
+    if (command == "stats") {
+        this->m_debugState.read([&](const DebugState& state) { this->writeStats(state, writer); });
+    }
+    else if (command == "pose_history") {
+        uint32_t count = DebugResponseWriter::parseUnsigned(argument, m_poseHistorySize);
+        this->m_debugState.read([&](const DebugState& state) { this->writePoseHistory(state, writer, count); });
+    }
+    else if (command == "queues") {
+        this->m_debugState.read([&](const DebugState& state) { this->writeQueues(state, writer); });
+    }
+    else if (command == "timings") {
+        writer.beginObject();
+        writer.key("pen");
+        this->m_debugState.read([&](const DebugState& state) { this->writeTimings(state, writer); });
+        if (auto server_driver = ServerDriver::instance(); server_driver != nullptr) {
+            writer.key("server_driver");
+            server_driver->writeTimings(writer);
+        }
+        writer.endObject();
+    }
+    else if (auto server_driver = ServerDriver::instance(); server_driver != nullptr) {
+        server_driver->handleDebugRequest(command, argument, writer, pen_debug_commands);
+    }
+    else {
+        writer.beginObject();
+        writer.error("unknown_request");
+        writer.endObject();
+    }
+    writer.finish();
+}
+
+bool PenController::isDetailedLogging() const
+{
+    // The driver's copy can be changed at runtime through the control socket
+    if (auto server_driver = ServerDriver::instance(); server_driver != nullptr) {
+        if (auto parameters = server_driver->getRuntimeParameters(); parameters.has_value())
+            return parameters->detailed_logging;
+    }
+    return this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false);
 }
 
 vr::DriverPose_t PenController::GetPose()
@@ -590,6 +765,30 @@ vr::DriverPose_t PenController::makeOpenVRPose(const MasslessInterface::Pose& pe
 	return out_pose;
 }
 
+vr::DriverPose_t PenController::makeOpenVRPose(const std::pair<Eigen::Quaternionf, Eigen::Vector3f>& pen_steamvr_pose)
+{
+    vr::DriverPose_t out_pose = { 0 };
+
+    // Set up some default values that should be in every pose
+    out_pose.deviceIsConnected = true;
+    out_pose.poseIsValid = true;
+    out_pose.result = vr::ETrackingResult::TrackingResult_Running_OK;
+    out_pose.willDriftInYaw = false;
+    out_pose.shouldApplyHeadModel = false;
+    out_pose.qDriverFromHeadRotation.w = out_pose.qWorldFromDriverRotation.w = 1.0;
+
+    out_pose.qRotation.w = pen_steamvr_pose.first.w();
+    out_pose.qRotation.x = pen_steamvr_pose.first.x();
+    out_pose.qRotation.y = pen_steamvr_pose.first.y();
+    out_pose.qRotation.z = pen_steamvr_pose.first.z();
+
+    out_pose.vecPosition[0] = pen_steamvr_pose.second.x();
+    out_pose.vecPosition[1] = pen_steamvr_pose.second.y();
+    out_pose.vecPosition[2] = pen_steamvr_pose.second.z();
+
+    return out_pose;
+}
+
 vr::DriverPose_t PenController::makeNotTrackingOpenVRPose()
 {
     vr::DriverPose_t out_pose = { 0 };
@@ -614,6 +813,18 @@ vr::DriverPose_t PenController::makeCalibratingOpenVRPose()
     return out_pose;
 }
 
+vr::DriverPose_t PenController::makeSuspendedOpenVRPose()
+{
+    vr::DriverPose_t out_pose = { 0 };
+    out_pose.deviceIsConnected = true;
+    out_pose.poseIsValid = false;
+    out_pose.result = vr::TrackingResult_Running_OutOfRange;
+    out_pose.willDriftInYaw = false;
+    out_pose.shouldApplyHeadModel = false;
+
+    return out_pose;
+}
+
 vr::DriverPose_t PenController::makeDisconnectedOpenVRPose()
 {
     vr::DriverPose_t out_pose = { 0 };
@@ -626,6 +837,25 @@ vr::DriverPose_t PenController::makeDisconnectedOpenVRPose()
     return out_pose;
 }
 
+void PenController::releaseGestureInputs(vr::IVRDriverInput* driver_input)
+{
+    driver_input->UpdateBooleanComponent(this->m_compSingleFront, false, 0);
+    driver_input->UpdateBooleanComponent(this->m_compDoubleFront, false, 0);
+    driver_input->UpdateBooleanComponent(this->m_compSingleRear, false, 0);
+    driver_input->UpdateBooleanComponent(this->m_compDoubleRear, false, 0);
+    driver_input->UpdateBooleanComponent(this->m_compSwipeForwards, false, 0);
+    driver_input->UpdateBooleanComponent(this->m_compSwipeBackwards, false, 0);
+}
+
+void PenController::releaseInputs(vr::IVRDriverInput* driver_input)
+{
+    this->m_unpressAllFrameTimeout = this->m_unpressAllStopTimeout;
+    this->m_eventStack.clear();
+    this->releaseGestureInputs(driver_input);
+    driver_input->UpdateBooleanComponent(this->m_compFastFront, false, 0);
+    driver_input->UpdateBooleanComponent(this->m_compFastRear, false, 0);
+}
+
 void PenController::onGestureEvent(const MasslessInterface::PenEvent& event, vr::IVRDriverInput* driver_input)
 {
     m_eventStack.push_back(event);
@@ -646,3 +876,122 @@ vr::TrackedDeviceIndex_t PenController::getIndex()
     return this->m_deviceIndex;
 }
 
+void PenController::recordPose(const vr::DriverPose_t& pose)
+{
+    if (pose.poseIsValid)
+        ++this->m_debugCounters.valid_poses;
+    else if (!pose.deviceIsConnected)
+        ++this->m_debugCounters.disconnected_poses;
+    else if (pose.result == vr::TrackingResult_Running_OutOfRange)
+        ++this->m_debugCounters.suspended_poses;
+    else if (pose.result == vr::TrackingResult_Calibrating_InProgress)
+        ++this->m_debugCounters.calibrating_poses;
+    else
+        ++this->m_debugCounters.not_tracking_poses;
+
+    PoseSample& sample = this->m_poseHistory[this->m_poseHistoryWritten % m_poseHistorySize];
+    sample.time_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->m_timeCreated).count();
+    sample.result = pose.result;
+    sample.valid = pose.poseIsValid;
+    sample.x = static_cast<float>(pose.vecPosition[0]);
+    sample.y = static_cast<float>(pose.vecPosition[1]);
+    sample.z = static_cast<float>(pose.vecPosition[2]);
+    ++this->m_poseHistoryWritten;
+}
+
+void PenController::publishDebugState()
+{
+    DebugState& state = this->m_debugState.getBack();
+    state.counters = this->m_debugCounters;
+    state.pose_history = this->m_poseHistory;
+    state.pose_history_written = this->m_poseHistoryWritten;
+    state.pose_valid = this->m_currentPenPose.poseIsValid;
+    state.tracking_result = this->m_currentPenPose.result;
+    if (auto server_driver = ServerDriver::instance(); server_driver != nullptr)
+        state.profile = server_driver->getActiveProfile().name;
+    state.gesture_stack = this->m_eventStack.size();
+    state.gesture_handlers = this->m_gestureHandlers.size();
+    state.unpress_timeout = this->m_unpressAllFrameTimeout;
+    state.update_timing = this->m_updateTiming;
+
+    // Skipped if a request is being answered, the next update publishes instead
+    this->m_debugState.publish();
+}
+
+void PenController::writeStats(const DebugState& state, DebugResponseWriter& writer) const
+{
+    writer.beginObject();
+    writer.field("updates", state.counters.updates);
+    writer.key("poses");
+    writer.beginObject();
+    writer.field("valid", state.counters.valid_poses);
+    writer.field("not_tracking", state.counters.not_tracking_poses);
+    writer.field("calibrating", state.counters.calibrating_poses);
+    writer.field("disconnected", state.counters.disconnected_poses);
+    writer.field("suspended", state.counters.suspended_poses);
+    writer.endObject();
+    writer.field("ownership", MasslessManager::getOwnershipName(this->m_masslessManager->getOwnership()));
+    writer.field("studio_handoffs", this->m_masslessManager->getHandoffCount());
+    writer.field("backend_unavailable", state.counters.backend_unavailable);
+    writer.field("idle_skips", state.counters.idle_skips);
+    writer.field("rate_limited_poses", state.counters.rate_limited_poses);
+    if (!state.profile.empty())
+        writer.field("profile", state.profile);
+    writer.field("openvr_events", state.counters.openvr_events);
+    writer.field("massless_events", state.counters.massless_events);
+    writer.field("notifications", state.counters.notifications);
+    writer.field("haptic_events", state.counters.haptic_events);
+    writer.field("pose_valid", state.pose_valid);
+    writer.field("tracking_result", static_cast<int32_t>(state.tracking_result));
+    writer.endObject();
+}
+
+void PenController::writePoseHistory(const DebugState& state, DebugResponseWriter& writer, uint32_t count) const
+{
+    uint64_t stored = std::min<uint64_t>(state.pose_history_written, m_poseHistorySize);
+    uint64_t to_write = std::min<uint64_t>(stored, count);
+
+    writer.beginObject();
+    writer.field("capacity", m_poseHistorySize);
+    writer.key("poses");
+    writer.beginArray();
+    // Oldest first
+    for (uint64_t i = state.pose_history_written - to_write; i < state.pose_history_written; ++i) {
+        const PoseSample& sample = state.pose_history[i % m_poseHistorySize];
+        writer.beginObject();
+        writer.field("t", sample.time_s);
+        writer.field("valid", sample.valid);
+        writer.field("result", static_cast<int32_t>(sample.result));
+        writer.key("pos");
+        writer.beginArray();
+        writer.value(sample.x);
+        writer.value(sample.y);
+        writer.value(sample.z);
+        writer.endArray();
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+void PenController::writeQueues(const DebugState& state, DebugResponseWriter& writer) const
+{
+    writer.beginObject();
+    writer.field("gesture_stack", state.gesture_stack);
+    writer.field("gesture_handlers", state.gesture_handlers);
+    writer.field("unpress_timeout", state.unpress_timeout);
+    writer.field("last_frame_openvr_events", state.counters.last_frame_openvr_events);
+    writer.field("last_frame_massless_events", state.counters.last_frame_massless_events);
+    writer.endObject();
+}
+
+void PenController::writeTimings(const DebugState& state, DebugResponseWriter& writer) const
+{
+    writer.beginObject();
+    writer.field("update_last_us", state.update_timing.last_us);
+    writer.field("update_mean_us", state.update_timing.meanMicroseconds());
+    writer.field("update_max_us", state.update_timing.max_us);
+    writer.field("update_count", state.update_timing.count);
+    writer.endObject();
+}
+
@@ -8,6 +8,7 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <string>
@@ -22,6 +23,10 @@
 #include <IDriverDevice.hpp>
 #include <MasslessManager.hpp>
 #include <GestureHandler.hpp>
+#include <DebugResponseWriter.hpp>
+#include <TimingStats.hpp>
+#include <PoseFilter.hpp>
+#include <DoubleBuffer.hpp>
 
 /// <summary>
 /// OpenVR Massless Pen controller interface
@@ -40,7 +45,7 @@ public:
     /// Updates the internal state of this device.
     /// Will be called every time ServerDriver::RunFrame is called
     /// </summary>
-	virtual void update(std::vector<vr::VREvent_t> events) override;
+	virtual void update(EventSpan events) override;
 
     /// <summary>
     /// Activates this controller
@@ -78,7 +83,10 @@ public:
 	virtual void* GetComponent(const char* pchComponentNameAndVersion) override;
 
     /// <summary>
-    /// Handles a debug request
+    /// Handles a debug request, the response is written as compact JSON.
+    /// Supported requests are "stats", "pose_history [N]", "queues" and "timings",
+    /// anything else is forwarded to ServerDriver::handleDebugRequest. Safe to call from any thread, responses are written from the state
+    /// published at the end of the last update.
     /// </summary>
     /// <param name="pchRequest">Request type</param>
     /// <param name="pchResponseBuffer">Response buffer</param>
@@ -91,6 +99,11 @@ public:
     /// <returns>Device Pose</returns>
 	virtual vr::DriverPose_t GetPose() override;
 
+    /// <summary>
+    /// Updates the role hint when the handedness changes
+    /// </summary>
+    virtual void onSettingsChanged(Span<const DriverSettings::Setting> changed) override;
+
     /// <summary>
     /// Logs currently waiting notifications from the Massless Pen System
     /// </summary>
@@ -104,7 +117,7 @@ public:
     /// <summary>
     /// Processes events from the OpenVR Server
     /// </summary>
-    void processOpenVREvents(std::vector<vr::VREvent_t> events);
+    void processOpenVREvents(EventSpan events);
         
     /// <summary>
     /// Updates the ServerDriver host with the new pen pose
@@ -132,8 +145,6 @@ public:
     vr::VRInputComponentHandle_t m_compFastFront = vr::k_ulInvalidInputComponentHandle;
     vr::VRInputComponentHandle_t m_compFastRear = vr::k_ulInvalidInputComponentHandle;
 
-private:
-    
     /// <summary>
     /// Converts a Massless Pen Pose to an OpenVR Pose
     /// This conversion is based off of the pen's pose, the massless tracker's pose, and the native openvr base tracker's pose 
@@ -145,6 +156,25 @@ private:
     /// <returns>Converted Driver Pose</returns>
     static vr::DriverPose_t makeOpenVRPose(const MasslessInterface::Pose& pen_pose, const MasslessInterface::Pose& tracking_ref_offset, const std::pair<Eigen::Quaternionf, Eigen::Vector3f>& tracking_reference_pose, const MasslessInterface::TrackingSystemType& tracking_ref_type);
 
+    /// <summary>
+    /// Makes an OpenVR Pose from a pen pose that is already in SteamVR space (ie. from ReferenceFusion)
+    /// </summary>
+    /// <param name="pen_steamvr_pose">Pose of the pen in SteamVR global space</param>
+    /// <returns>Driver Pose</returns>
+    static vr::DriverPose_t makeOpenVRPose(const std::pair<Eigen::Quaternionf, Eigen::Vector3f>& pen_steamvr_pose);
+
+private:
+    
+    /// <summary>
+    /// Is enable_detailed_logging on? Follows the driver's runtime parameters once it has them.
+    /// </summary>
+    bool isDetailedLogging() const;
+
+    /// <summary>
+    /// Sets the controller role hint from the handedness setting
+    /// </summary>
+    void setRoleHint(vr::CVRPropertyHelpers* driver_properties);
+
     /// <summary>
     /// Returns a DriverPose_t that marks this devices pose as connected but not tracking.
     /// </summary>
@@ -163,6 +193,22 @@ private:
     /// <returns></returns>
     static vr::DriverPose_t makeDisconnectedOpenVRPose();
 
+    /// <summary>
+    /// Returns a DriverPose_t that marks this devices pose as connected but suspended (ie. Massless Studio is using the pen).
+    /// </summary>
+    /// <returns></returns>
+    static vr::DriverPose_t makeSuspendedOpenVRPose();
+
+    /// <summary>
+    /// Unpresses the tap and swipe inputs
+    /// </summary>
+    void releaseGestureInputs(vr::IVRDriverInput* driver_input);
+
+    /// <summary>
+    /// Unpresses every input and forgets any gesture in progress
+    /// </summary>
+    void releaseInputs(vr::IVRDriverInput* driver_input);
+
     /// <summary>
     /// Called when a new gesture event is triggered
     /// </summary>
@@ -173,6 +219,118 @@ private:
     // Inherited via IDriverDevice
     virtual vr::TrackedDeviceIndex_t getIndex();
 
+    /// <summary>
+    /// Updates the debug counters and pose history with the pose sent this frame
+    /// </summary>
+    /// <param name="pose">Pose sent to OpenVR</param>
+    void recordPose(const vr::DriverPose_t& pose);
+
+    /// <summary>
+    /// Updates the pen's inputs and pose, the part of update that is timed
+    /// </summary>
+    void updatePen(EventSpan events);
+
+    /// <summary>
+    /// Counters reported by the "stats" debug request
+    /// </summary>
+    struct DebugCounters {
+        uint64_t updates = 0;
+        uint64_t valid_poses = 0;
+        uint64_t not_tracking_poses = 0;
+        uint64_t calibrating_poses = 0;
+        uint64_t disconnected_poses = 0;
+        uint64_t suspended_poses = 0;
+        uint64_t backend_unavailable = 0;
+        uint64_t idle_skips = 0;
+        uint64_t rate_limited_poses = 0;
+        uint64_t openvr_events = 0;
+        uint64_t massless_events = 0;
+        uint64_t notifications = 0;
+        uint64_t haptic_events = 0;
+        std::size_t last_frame_openvr_events = 0;
+        std::size_t last_frame_massless_events = 0;
+    };
+
+    /// <summary>
+    /// Pose sample stored in the pose history ring
+    /// </summary>
+    struct PoseSample {
+        double time_s = 0.0;
+        vr::ETrackingResult result = vr::TrackingResult_Uninitialized;
+        bool valid = false;
+        float x = 0.0f, y = 0.0f, z = 0.0f;
+    };
+
+    /// <summary>
+    /// Number of poses kept for the "pose_history" debug request
+    /// </summary>
+    static constexpr std::size_t m_poseHistorySize = 64;
+
+    /// <summary>
+    /// What the debug requests report on. vrserver makes debug requests from its own thread, so they are answered from this copy of the
+    /// pen's state rather than the state itself.
+    /// </summary>
+    struct DebugState {
+        DebugCounters counters;
+        std::array<PoseSample, m_poseHistorySize> pose_history;
+        uint64_t pose_history_written = 0;
+        bool pose_valid = false;
+        vr::ETrackingResult tracking_result = vr::TrackingResult_Uninitialized;
+        std::string profile;
+        std::size_t gesture_stack = 0;
+        std::size_t gesture_handlers = 0;
+        int unpress_timeout = 0;
+        TimingStats update_timing;
+    };
+
+    /// <summary>
+    /// Copies the state the debug requests report on into m_debugState and publishes it, at the end of construction and of each update
+    /// </summary>
+    void publishDebugState();
+
+    void writeStats(const DebugState& state, DebugResponseWriter& writer) const;
+    void writePoseHistory(const DebugState& state, DebugResponseWriter& writer, uint32_t count) const;
+    void writeQueues(const DebugState& state, DebugResponseWriter& writer) const;
+    void writeTimings(const DebugState& state, DebugResponseWriter& writer) const;
+
+    /// <summary>
+    /// State for debug requests, written by the frame thread and read by whichever thread makes the request
+    /// </summary>
+    DoubleBuffer<DebugState> m_debugState;
+
+    /// <summary>
+    /// Fixed size ring of the most recent poses sent to OpenVR
+    /// </summary>
+    std::array<PoseSample, m_poseHistorySize> m_poseHistory;
+
+    /// <summary>
+    /// Total number of poses written to m_poseHistory
+    /// </summary>
+    uint64_t m_poseHistoryWritten = 0;
+
+    DebugCounters m_debugCounters;
+
+    /// <summary>
+    /// Duration of each call to update
+    /// </summary>
+    TimingStats m_updateTiming;
+
+    /// <summary>
+    /// Time the controller was constructed, pose history times are relative to this
+    /// </summary>
+    std::chrono::steady_clock::time_point m_timeCreated = std::chrono::steady_clock::now();
+
+    /// <summary>
+    /// Smoothing and prediction from the application's profile
+    /// </summary>
+    PoseFilter m_poseFilter;
+
+    /// <summary>
+    /// When the last pose was sent to SteamVR and whether it was tracking, for the profile's pose rate limit
+    /// </summary>
+    std::chrono::steady_clock::time_point m_lastPoseUpdate;
+    bool m_wasTracking = false;
+
     /// <summary>
     /// OpenVR device index
     /// </summary>
@@ -203,6 +361,11 @@ private:
     /// </summary>
     vr::DriverPose_t m_currentPenPose;
 
+    /// <summary>
+    /// Owner of the pen system last frame, to react to Massless Studio taking or giving back the pen
+    /// </summary>
+    MasslessManager::Ownership m_lastOwnership = MasslessManager::Ownership::Driver;
+
     /// <summary>
     /// Supplied driver settings struct
     /// </summary>
@@ -0,0 +1,128 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PenProfileTable.hpp"
+#include <IntegrationKeyTable.hpp>
+
+#include <algorithm>
+
+#include <json.hpp>
+
+namespace {
+    /// <summary>
+    /// A profile field and the values it accepts
+    /// </summary>
+    struct Field {
+        const char* name;
+        float PenProfile::* member;
+        float min;
+        float max;
+    };
+
+    const Field fields[] = {
+        { "smoothing", &PenProfile::smoothing, 0.0f, 0.95f },
+        { "prediction_ms", &PenProfile::prediction_ms, 0.0f, 50.0f },
+        { "haptic_scale", &PenProfile::haptic_scale, 0.0f, 4.0f },
+        { "max_pose_rate_hz", &PenProfile::max_pose_rate_hz, 0.0f, 1000.0f },
+    };
+
+    int getPriority(const std::string& pattern)
+    {
+        switch (IntegrationKeyTable::classify(pattern)) {
+        case IntegrationKeyTable::MatchKind::Exact:
+            return 0;
+        case IntegrationKeyTable::MatchKind::Prefix:
+            return 1;
+        default:
+            return 2;
+        }
+    }
+}
+
+PenProfileTable::PenProfileTable() :
+    m_default(std::make_shared<const PenProfile>())
+{}
+
+PenProfileTable::PenProfileTable(const std::vector<Entry>& entries) :
+    PenProfileTable()
+{
+    for (const auto& entry : entries)
+        this->m_profiles.emplace_back(entry.pattern, std::make_shared<const PenProfile>(entry.profile));
+
+    // Applications change rarely and there are only a handful of profiles, so a scan in priority order is plenty
+    std::stable_sort(this->m_profiles.begin(), this->m_profiles.end(), [](const auto& a, const auto& b) {
+        int a_priority = getPriority(a.first);
+        int b_priority = getPriority(b.first);
+        if (a_priority != b_priority)
+            return a_priority < b_priority;
+        return a_priority == 1 && a.first.size() > b.first.size();
+    });
+}
+
+PenProfileTable::ParseResult PenProfileTable::parse(std::string_view json_text)
+{
+    ParseResult result;
+    nlohmann::json input_json = nlohmann::json::parse(json_text.begin(), json_text.end(), nullptr, false);
+    if (input_json.is_discarded() || !input_json.is_object()) {
+        result.errors.emplace_back("application_profiles must be an object of application names to profiles");
+        return result;
+    }
+
+    for (const auto& [pattern, value] : input_json.items()) {
+        if (pattern.empty()) {
+            result.errors.emplace_back("Empty application name");
+            continue;
+        }
+        if (!value.is_object()) {
+            result.errors.emplace_back("Profile for \"" + pattern + "\" is not an object");
+            continue;
+        }
+
+        Entry entry{ pattern, PenProfile() };
+        entry.profile.name = pattern;
+        bool valid = true;
+        for (const auto& [name, field_value] : value.items()) {
+            auto field = std::find_if(std::begin(fields), std::end(fields), [&name = name](const Field& f) { return name == f.name; });
+            if (field == std::end(fields)) {
+                result.errors.emplace_back("Profile for \"" + pattern + "\" has unknown field \"" + name + "\"");
+                valid = false;
+            }
+            else if (!field_value.is_number() || field_value.get<float>() < field->min || field_value.get<float>() > field->max) {
+                result.errors.emplace_back("Profile for \"" + pattern + "\" has " + name + " out of range [" + std::to_string(field->min) + ", "
+                    + std::to_string(field->max) + "]");
+                valid = false;
+            }
+            else {
+                entry.profile.*field->member = field_value.get<float>();
+            }
+        }
+        if (valid)
+            result.entries.push_back(std::move(entry));
+    }
+    return result;
+}
+
+std::shared_ptr<const PenProfile> PenProfileTable::find(std::string_view exe_name) const
+{
+    for (const auto& [pattern, profile] : this->m_profiles) {
+        if (IntegrationKeyTable::globMatch(pattern, exe_name))
+            return profile;
+    }
+    return this->m_default;
+}
+
+std::shared_ptr<const PenProfile> PenProfileTable::getDefault() const
+{
+    return this->m_default;
+}
+
+std::size_t PenProfileTable::size() const
+{
+    return this->m_profiles.size();
+}
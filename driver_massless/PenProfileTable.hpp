@@ -0,0 +1,102 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Per application tuning of the pen, an immutable block that is swapped as a whole when the scene application changes
+/// </summary>
+struct PenProfile {
+    /// <summary>
+    /// Name of the profile, the pattern it was defined for or "default"
+    /// </summary>
+    std::string name = "default";
+
+    /// <summary>
+    /// Pose smoothing, 0 (off) to 0.95 (see PoseFilter)
+    /// </summary>
+    float smoothing = 0.0f;
+
+    /// <summary>
+    /// How far ahead to extrapolate the pose from its velocity (milliseconds, 0 to 50)
+    /// </summary>
+    float prediction_ms = 0.0f;
+
+    /// <summary>
+    /// Multiplies the duration of haptic pulses the application asks for (0 to 4)
+    /// </summary>
+    float haptic_scale = 1.0f;
+
+    /// <summary>
+    /// Most poses per second pushed to SteamVR while tracking, 0 for every frame
+    /// </summary>
+    float max_pose_rate_hz = 0.0f;
+};
+
+/// <summary>
+/// Profiles by application, compiled from the application_profiles setting. Patterns are matched like integration keys (see IntegrationKeyTable):
+/// exact names first, then prefixes longest first, then globs, ignoring case. Applications with no profile get the default one.
+/// </summary>
+class PenProfileTable
+{
+public:
+    /// <summary>
+    /// A profile and the applications it is for
+    /// </summary>
+    struct Entry {
+        std::string pattern;
+        PenProfile profile;
+    };
+
+    /// <summary>
+    /// Entries parsed from the application_profiles setting, and errors for the ones that could not be parsed
+    /// </summary>
+    struct ParseResult {
+        std::vector<Entry> entries;
+        std::vector<std::string> errors;
+    };
+
+    /// <summary>
+    /// A table with only the default profile
+    /// </summary>
+    PenProfileTable();
+
+    explicit PenProfileTable(const std::vector<Entry>& entries);
+
+    /// <summary>
+    /// Parses the application_profiles setting, a JSON object of patterns to objects of profile fields. Missing fields take the default.
+    /// </summary>
+    /// <param name="json_text">The setting value</param>
+    static ParseResult parse(std::string_view json_text);
+
+    /// <summary>
+    /// Finds the profile for an application
+    /// </summary>
+    /// <param name="exe_name">Name of the exe file</param>
+    /// <returns>The application's profile, or the default one</returns>
+    std::shared_ptr<const PenProfile> find(std::string_view exe_name) const;
+
+    std::shared_ptr<const PenProfile> getDefault() const;
+
+    /// <summary>
+    /// Number of profiles compiled into the table, not counting the default
+    /// </summary>
+    std::size_t size() const;
+
+private:
+    /// <summary>
+    /// In match priority order
+    /// </summary>
+    std::vector<std::pair<std::string, std::shared_ptr<const PenProfile>>> m_profiles;
+    std::shared_ptr<const PenProfile> m_default;
+};
@@ -0,0 +1,76 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PoseFilter.hpp"
+
+void PoseFilter::configure(float smoothing, float prediction_ms)
+{
+    this->m_smoothing = smoothing;
+    this->m_predictionSeconds = prediction_ms / 1000.0f;
+}
+
+void PoseFilter::apply(vr::DriverPose_t& pose, std::chrono::system_clock::time_point timestamp)
+{
+    if (!this->isEnabled()) {
+        this->m_hasPrevious = false;
+        return;
+    }
+
+    Eigen::Vector3d position(pose.vecPosition[0], pose.vecPosition[1], pose.vecPosition[2]);
+    Eigen::Quaterniond rotation(pose.qRotation.w, pose.qRotation.x, pose.qRotation.y, pose.qRotation.z);
+
+    double dt = std::chrono::duration<double>(timestamp - this->m_previousTime).count();
+    if (!this->m_hasPrevious || dt <= 0.0 || dt > std::chrono::duration<double>(m_maxGap).count()) {
+        // The same sample again is passed through as it was filtered last time, anything else restarts the filter
+        if (this->m_hasPrevious && dt == 0.0) {
+            position = this->m_position;
+            rotation = this->m_rotation;
+        }
+        else {
+            this->m_hasPrevious = true;
+            this->m_previousTime = timestamp;
+            this->m_position = position;
+            this->m_rotation = rotation;
+            this->m_velocity.setZero();
+        }
+    }
+    else {
+        double alpha = 1.0 - this->m_smoothing;
+        Eigen::Vector3d filtered_position = this->m_position + alpha * (position - this->m_position);
+        Eigen::Vector3d velocity = (filtered_position - this->m_position) / dt;
+        this->m_velocity += alpha * (velocity - this->m_velocity);
+
+        this->m_previousTime = timestamp;
+        this->m_position = filtered_position;
+        this->m_rotation = this->m_rotation.slerp(alpha, rotation).normalized();
+        position = this->m_position;
+        rotation = this->m_rotation;
+    }
+
+    // Extrapolated here rather than by reporting vecVelocity, so SteamVR's own prediction (to photons) isn't applied on top of the profile's horizon
+    if (this->m_predictionSeconds > 0.0f)
+        position += this->m_velocity * this->m_predictionSeconds;
+
+    for (int i = 0; i < 3; ++i)
+        pose.vecPosition[i] = position[i];
+    pose.qRotation.w = rotation.w();
+    pose.qRotation.x = rotation.x();
+    pose.qRotation.y = rotation.y();
+    pose.qRotation.z = rotation.z();
+}
+
+void PoseFilter::reset()
+{
+    this->m_hasPrevious = false;
+}
+
+bool PoseFilter::isEnabled() const
+{
+    return this->m_smoothing > 0.0f || this->m_predictionSeconds > 0.0f;
+}
@@ -0,0 +1,58 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <chrono>
+
+#include <Eigen/Eigen>
+#include <openvr_driver.h>
+
+/// <summary>
+/// Smooths a stream of valid poses and extrapolates them ahead from their velocity, as set by the active application's profile (see PenProfile).
+/// With no smoothing and no prediction poses pass through untouched.
+/// </summary>
+class PoseFilter
+{
+public:
+    /// <summary>
+    /// Gaps longer than this between samples restart the filter rather than smoothing across them
+    /// </summary>
+    static constexpr std::chrono::milliseconds m_maxGap{ 250 };
+
+    /// <summary>
+    /// Sets how the next poses are filtered
+    /// </summary>
+    /// <param name="smoothing">0 for none, towards 1 for more (the weight given to the previous filtered pose)</param>
+    /// <param name="prediction_ms">How far ahead to extrapolate, 0 for none</param>
+    void configure(float smoothing, float prediction_ms);
+
+    /// <summary>
+    /// Filters a valid pose in place
+    /// </summary>
+    /// <param name="pose">Pose to filter</param>
+    /// <param name="timestamp">When the pose was sampled</param>
+    void apply(vr::DriverPose_t& pose, std::chrono::system_clock::time_point timestamp);
+
+    /// <summary>
+    /// Forgets the previous poses, for when tracking is lost
+    /// </summary>
+    void reset();
+
+    bool isEnabled() const;
+
+private:
+    float m_smoothing = 0.0f;
+    float m_predictionSeconds = 0.0f;
+
+    bool m_hasPrevious = false;
+    std::chrono::system_clock::time_point m_previousTime;
+    Eigen::Vector3d m_position;
+    Eigen::Quaterniond m_rotation;
+    Eigen::Vector3d m_velocity;
+};
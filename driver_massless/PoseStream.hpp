@@ -0,0 +1,104 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/// <summary>
+/// Layout of the shared memory pose stream, shared by PoseStreamWriter and PoseStreamReader (and any other reader).
+///
+/// A header followed by a ring of slots. Writers claim the next record index from the header, and each slot is a seqlock: its sequence is
+/// 2 * index + 1 while record index is being written, and 2 * index + 2 once it is complete. Readers copy a slot and accept it only if the
+/// sequence was the completed value for the index they wanted both before and after copying, so they never block the writer or each other and
+/// need only read access.
+/// </summary>
+namespace PoseStream {
+    constexpr uint32_t magic = 0x5053504D; // "MPSP"
+    constexpr uint32_t version = 1;
+    constexpr const char* default_name = "MasslessPenPoseStream";
+    constexpr uint32_t default_capacity = 4096;
+
+    enum class RecordType : uint32_t {
+        Pose = 1,
+        State = 2,
+        Event = 3
+    };
+
+    /// <summary>
+    /// One pen sample, state or event. Only the fields for the record's type are set.
+    /// </summary>
+    struct Record {
+        RecordType type;
+
+        /// <summary>
+        /// Massless::Events::EventType of an event
+        /// </summary>
+        uint32_t event_type;
+
+        /// <summary>
+        /// When the sample was received, in nanoseconds since the Unix epoch
+        /// </summary>
+        int64_t timestamp_ns;
+
+        /// <summary>
+        /// Pen position (metres) and orientation (qr, qx, qy, qz) in the Massless tracker's space, position error and gyro readings
+        /// </summary>
+        float position[3];
+        float rotation[4];
+        float position_error[3];
+        float gyro[3];
+
+        float surface_proximity;
+        uint8_t capsense_value;
+        uint8_t surface_found;
+        uint8_t is_tapped;
+        uint8_t reserved;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        Record record;
+    };
+
+    struct alignas(64) Header {
+        /// <summary>
+        /// Set last by the writer, so a reader seeing the magic also sees the rest of the header
+        /// </summary>
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t slot_size;
+
+        /// <summary>
+        /// Number of records claimed by writers. Record i is in slot i % capacity.
+        /// </summary>
+        alignas(64) std::atomic<uint64_t> write_index;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Record>, "Records are copied in and out of shared memory");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "Atomics in shared memory must be lock free");
+
+    constexpr std::size_t regionSize(uint32_t capacity)
+    {
+        return sizeof(Header) + sizeof(Slot) * capacity;
+    }
+
+    inline Slot* slots(Header* header)
+    {
+        return reinterpret_cast<Slot*>(header + 1);
+    }
+
+    inline const Slot* slots(const Header* header)
+    {
+        return reinterpret_cast<const Slot*>(header + 1);
+    }
+}
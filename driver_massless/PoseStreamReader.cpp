@@ -0,0 +1,96 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PoseStreamReader.hpp"
+
+#include <cstring>
+
+std::unique_ptr<PoseStreamReader> PoseStreamReader::open(const std::string& name)
+{
+    auto region = SharedMemoryRegion::open(name);
+    if (region == nullptr || region->size() < sizeof(PoseStream::Header))
+        return nullptr;
+
+    const auto* header = static_cast<const PoseStream::Header*>(region->data());
+    if (header->magic.load(std::memory_order_acquire) != PoseStream::magic || header->version != PoseStream::version
+        || header->slot_size != sizeof(PoseStream::Slot) || header->capacity == 0 || region->size() < PoseStream::regionSize(header->capacity))
+        return nullptr;
+    return std::unique_ptr<PoseStreamReader>(new PoseStreamReader(std::move(region)));
+}
+
+PoseStreamReader::PoseStreamReader(std::unique_ptr<SharedMemoryRegion> region) :
+    m_region(std::move(region))
+{
+    this->m_header = static_cast<const PoseStream::Header*>(this->m_region->data());
+    this->m_slots = PoseStream::slots(this->m_header);
+    this->m_capacity = this->m_header->capacity;
+    this->m_next = this->m_header->write_index.load(std::memory_order_acquire);
+}
+
+std::size_t PoseStreamReader::read(std::vector<PoseStream::Record>& records, std::size_t max_records)
+{
+    uint64_t written = this->m_header->write_index.load(std::memory_order_acquire);
+
+    // Everything older than one lap of the ring has been overwritten
+    if (written - this->m_next > this->m_capacity) {
+        this->m_dropped += written - this->m_capacity - this->m_next;
+        this->m_next = written - this->m_capacity;
+    }
+
+    std::size_t count = 0;
+    PoseStream::Record record;
+    while (this->m_next < written && count < max_records) {
+        uint64_t sequence = this->m_slots[this->m_next % this->m_capacity].sequence.load(std::memory_order_acquire);
+        // Claimed but still being written, it will be there next time
+        if (sequence < 2 * this->m_next + 2)
+            break;
+        if (this->tryCopy(this->m_next, record)) {
+            records.push_back(record);
+            ++count;
+        }
+        else {
+            ++this->m_dropped;
+        }
+        ++this->m_next;
+    }
+    return count;
+}
+
+std::optional<PoseStream::Record> PoseStreamReader::readLatest() const
+{
+    uint64_t written = this->m_header->write_index.load(std::memory_order_acquire);
+    PoseStream::Record record;
+    // The newest claimed records may still be being written, so look back for the newest complete one
+    for (uint64_t index = written; index > 0 && written - index < this->m_capacity; --index) {
+        if (this->tryCopy(index - 1, record))
+            return record;
+    }
+    return std::nullopt;
+}
+
+uint64_t PoseStreamReader::getDroppedCount() const
+{
+    return this->m_dropped;
+}
+
+uint32_t PoseStreamReader::getCapacity() const
+{
+    return this->m_capacity;
+}
+
+bool PoseStreamReader::tryCopy(uint64_t index, PoseStream::Record& record) const
+{
+    const PoseStream::Slot& slot = this->m_slots[index % this->m_capacity];
+    uint64_t expected = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected)
+        return false;
+    std::memcpy(&record, &slot.record, sizeof(record));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
@@ -0,0 +1,73 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <PoseStream.hpp>
+#include <SharedMemoryRegion.hpp>
+
+/// <summary>
+/// Reads the shared memory pose stream published by the driver (see PoseStream.hpp). Needs only read access to the stream, and any number of
+/// readers can follow it at once without affecting the driver or each other. Has no dependencies on the rest of the driver, for use by tools.
+/// </summary>
+class PoseStreamReader
+{
+public:
+    /// <summary>
+    /// Opens the stream, positioned after the newest record
+    /// </summary>
+    /// <returns>The reader, or nullptr if there is no stream with that name or it is not a version this reader understands</returns>
+    static std::unique_ptr<PoseStreamReader> open(const std::string& name);
+
+    /// <summary>
+    /// Appends the records published since the last read, oldest first. Records that were overwritten before they could be read are skipped
+    /// and counted as dropped.
+    /// </summary>
+    /// <param name="records">Records are appended to this</param>
+    /// <param name="max_records">Most records to read</param>
+    /// <returns>Number of records read</returns>
+    std::size_t read(std::vector<PoseStream::Record>& records, std::size_t max_records);
+
+    /// <summary>
+    /// Gets the newest complete record, without moving the position read from
+    /// </summary>
+    std::optional<PoseStream::Record> readLatest() const;
+
+    /// <summary>
+    /// Gets the number of records this reader missed because it fell more than the stream's capacity behind
+    /// </summary>
+    uint64_t getDroppedCount() const;
+
+    uint32_t getCapacity() const;
+
+private:
+    PoseStreamReader(std::unique_ptr<SharedMemoryRegion> region);
+
+    /// <summary>
+    /// Copies record index out of its slot
+    /// </summary>
+    /// <returns>Whether the copy is record index, complete and unchanged while copying</returns>
+    bool tryCopy(uint64_t index, PoseStream::Record& record) const;
+
+    std::unique_ptr<SharedMemoryRegion> m_region;
+    const PoseStream::Header* m_header;
+    const PoseStream::Slot* m_slots;
+    uint32_t m_capacity;
+
+    /// <summary>
+    /// Index of the next record to read
+    /// </summary>
+    uint64_t m_next;
+    uint64_t m_dropped = 0;
+};
@@ -0,0 +1,109 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PoseStreamWriter.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+std::unique_ptr<PoseStreamWriter> PoseStreamWriter::create(const std::string& name, uint32_t capacity)
+{
+    if (capacity == 0)
+        return nullptr;
+    auto region = SharedMemoryRegion::create(name, PoseStream::regionSize(capacity));
+    if (region == nullptr)
+        return nullptr;
+    return std::unique_ptr<PoseStreamWriter>(new PoseStreamWriter(std::move(region), capacity));
+}
+
+PoseStreamWriter::PoseStreamWriter(std::unique_ptr<SharedMemoryRegion> region, uint32_t capacity) :
+    m_region(std::move(region)),
+    m_capacity(capacity)
+{
+    // The region is zero filled, which is a valid empty stream apart from the header fields
+    this->m_header = new (this->m_region->data()) PoseStream::Header();
+    this->m_slots = PoseStream::slots(this->m_header);
+    for (uint32_t i = 0; i < capacity; ++i)
+        new (&this->m_slots[i]) PoseStream::Slot();
+    this->m_header->version = PoseStream::version;
+    this->m_header->capacity = capacity;
+    this->m_header->slot_size = sizeof(PoseStream::Slot);
+    this->m_header->write_index.store(0, std::memory_order_relaxed);
+    this->m_header->magic.store(PoseStream::magic, std::memory_order_release);
+}
+
+void PoseStreamWriter::publishPose(const MasslessInterface::Pose& pose)
+{
+    PoseStream::Record record = {};
+    record.type = PoseStream::RecordType::Pose;
+    record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(pose.m_timestamp.time_since_epoch()).count();
+    record.position[0] = pose.m_x;
+    record.position[1] = pose.m_y;
+    record.position[2] = pose.m_z;
+    record.rotation[0] = pose.m_qr;
+    record.rotation[1] = pose.m_qx;
+    record.rotation[2] = pose.m_qy;
+    record.rotation[3] = pose.m_qz;
+    record.position_error[0] = pose.m_ex;
+    record.position_error[1] = pose.m_ey;
+    record.position_error[2] = pose.m_ez;
+    record.gyro[0] = pose.m_gx;
+    record.gyro[1] = pose.m_gy;
+    record.gyro[2] = pose.m_gz;
+    this->publish(record);
+}
+
+void PoseStreamWriter::publishState(const MasslessInterface::PenState& state)
+{
+    PoseStream::Record record = {};
+    record.type = PoseStream::RecordType::State;
+    record.timestamp_ns = nowNanoseconds();
+    record.surface_proximity = state.m_surfaceProximity;
+    record.capsense_value = state.m_capsenseValue;
+    record.surface_found = state.m_surfaceFound ? 1 : 0;
+    record.is_tapped = state.m_isTapped ? 1 : 0;
+    this->publish(record);
+}
+
+void PoseStreamWriter::publishEvent(uint16_t event_type)
+{
+    PoseStream::Record record = {};
+    record.type = PoseStream::RecordType::Event;
+    record.event_type = event_type;
+    record.timestamp_ns = nowNanoseconds();
+    this->publish(record);
+}
+
+void PoseStreamWriter::publish(const PoseStream::Record& record)
+{
+    uint64_t index = this->m_header->write_index.fetch_add(1, std::memory_order_relaxed);
+    PoseStream::Slot& slot = this->m_slots[index % this->m_capacity];
+
+    // Odd while writing, so a reader copying the slot at the same time throws its copy away
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.record, &record, sizeof(record));
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+uint64_t PoseStreamWriter::getPublishedCount() const
+{
+    return this->m_header->write_index.load(std::memory_order_relaxed);
+}
+
+uint32_t PoseStreamWriter::getCapacity() const
+{
+    return this->m_capacity;
+}
+
+int64_t PoseStreamWriter::nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,56 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <Pose.hpp>
+#include <PenState.hpp>
+#include <PoseStream.hpp>
+#include <SharedMemoryRegion.hpp>
+
+/// <summary>
+/// Publishes pen samples, states and events into the shared memory pose stream (see PoseStream.hpp) for other local processes to read.
+/// Publishing never blocks or allocates, and is safe from the backend's callback threads at the same time.
+/// </summary>
+class PoseStreamWriter
+{
+public:
+    /// <summary>
+    /// Creates the shared memory region and an empty stream in it
+    /// </summary>
+    /// <param name="name">Name readers open the stream with</param>
+    /// <param name="capacity">Number of records kept, readers further behind than this lose records</param>
+    /// <returns>The writer, or nullptr if the region could not be created</returns>
+    static std::unique_ptr<PoseStreamWriter> create(const std::string& name, uint32_t capacity);
+
+    void publishPose(const MasslessInterface::Pose& pose);
+    void publishState(const MasslessInterface::PenState& state);
+    void publishEvent(uint16_t event_type);
+    void publish(const PoseStream::Record& record);
+
+    /// <summary>
+    /// Gets the number of records published
+    /// </summary>
+    uint64_t getPublishedCount() const;
+
+    uint32_t getCapacity() const;
+
+private:
+    PoseStreamWriter(std::unique_ptr<SharedMemoryRegion> region, uint32_t capacity);
+
+    static int64_t nowNanoseconds();
+
+    std::unique_ptr<SharedMemoryRegion> m_region;
+    PoseStream::Header* m_header;
+    PoseStream::Slot* m_slots;
+    uint32_t m_capacity;
+};
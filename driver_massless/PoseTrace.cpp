@@ -0,0 +1,56 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PoseTrace.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+std::optional<PoseTrace::Contents> PoseTrace::read(const std::filesystem::path& path, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "Unable to open " + path.string();
+        return std::nullopt;
+    }
+
+    // The header is read as bytes, it holds an atomic that can't be copied
+    unsigned char header_bytes[sizeof(Header)];
+    if (!file.read(reinterpret_cast<char*>(header_bytes), sizeof(header_bytes))) {
+        error = "File is too short to be a pose trace";
+        return std::nullopt;
+    }
+    uint32_t file_magic, file_version, record_size;
+    uint64_t capacity, record_count;
+    int64_t start_ns;
+    std::memcpy(&file_magic, header_bytes + offsetof(Header, magic), sizeof(file_magic));
+    std::memcpy(&file_version, header_bytes + offsetof(Header, version), sizeof(file_version));
+    std::memcpy(&record_size, header_bytes + offsetof(Header, record_size), sizeof(record_size));
+    std::memcpy(&capacity, header_bytes + offsetof(Header, capacity), sizeof(capacity));
+    std::memcpy(&start_ns, header_bytes + offsetof(Header, start_ns), sizeof(start_ns));
+    std::memcpy(&record_count, header_bytes + offsetof(Header, record_count), sizeof(record_count));
+    if (file_magic != magic) {
+        error = "Not a pose trace";
+        return std::nullopt;
+    }
+    if (file_version != version || record_size != sizeof(Record)) {
+        error = "Unsupported pose trace version " + std::to_string(file_version);
+        return std::nullopt;
+    }
+
+    Contents contents;
+    contents.capacity = capacity;
+    contents.start_ns = start_ns;
+    contents.records.resize(static_cast<std::size_t>(std::min(record_count, capacity)));
+    file.read(reinterpret_cast<char*>(contents.records.data()), contents.records.size() * sizeof(Record));
+    contents.records.resize(static_cast<std::size_t>(file.gcount()) / sizeof(Record));
+    return contents;
+}
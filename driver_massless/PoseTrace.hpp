@@ -0,0 +1,128 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// Layout of a pose trace file, written by PoseTraceRecorder and read by PoseTrace::read and the pose_trace tool.
+///
+/// A header followed by fixed size records, preallocated for the capacity and filled in order. Only the first record_count records are
+/// complete, the rest of the file is zeros. Everything is little endian, as written by the platforms the driver runs on.
+/// </summary>
+namespace PoseTrace {
+    constexpr uint32_t magic = 0x52544D50; // "PMTR"
+    constexpr uint32_t version = 1;
+
+    /// <summary>
+    /// Ten minutes at 1 kHz
+    /// </summary>
+    constexpr uint64_t default_capacity = 600000;
+
+    enum RecordFlags : uint32_t {
+        /// <summary>
+        /// The pose came from reference fusion rather than a single tracking reference
+        /// </summary>
+        Fused = 1 << 0,
+
+        /// <summary>
+        /// The pose was held back by the profile's pose rate limit, submit_ns is 0
+        /// </summary>
+        RateLimited = 1 << 1
+    };
+
+    /// <summary>
+    /// One valid pen pose at each stage of the pipeline
+    /// </summary>
+    struct Record {
+        /// <summary>
+        /// When the SDK sampled the pose, and when it was submitted to SteamVR, in nanoseconds since the Unix epoch
+        /// </summary>
+        int64_t sample_ns;
+        int64_t submit_ns;
+
+        /// <summary>
+        /// Pose from the SDK, in the Massless tracker's space. Positions are metres, rotations (w, x, y, z).
+        /// </summary>
+        float raw_position[3];
+        float raw_rotation[4];
+
+        /// <summary>
+        /// Pose of the tracking reference in SteamVR's space
+        /// </summary>
+        float reference_position[3];
+        float reference_rotation[4];
+
+        /// <summary>
+        /// Pen pose transformed into SteamVR's space, before filtering
+        /// </summary>
+        float transformed_position[3];
+        float transformed_rotation[4];
+
+        /// <summary>
+        /// Pen pose after the profile's smoothing and prediction, as submitted
+        /// </summary>
+        float filtered_position[3];
+        float filtered_rotation[4];
+
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    struct alignas(64) Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t reserved;
+        uint64_t capacity;
+
+        /// <summary>
+        /// When recording started, in nanoseconds since the Unix epoch
+        /// </summary>
+        int64_t start_ns;
+
+        /// <summary>
+        /// Records written so far, stored after the records themselves
+        /// </summary>
+        std::atomic<uint64_t> record_count;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Record>, "Records are copied straight into the file");
+    static_assert(sizeof(Record) == 136, "The record layout is part of the file format");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The record count is updated in place in the mapped file");
+
+    constexpr std::size_t fileSize(uint64_t capacity)
+    {
+        return sizeof(Header) + sizeof(Record) * static_cast<std::size_t>(capacity);
+    }
+
+    /// <summary>
+    /// A trace read back from a file
+    /// </summary>
+    struct Contents {
+        uint64_t capacity = 0;
+        int64_t start_ns = 0;
+        std::vector<Record> records;
+    };
+
+    /// <summary>
+    /// Reads the complete records of a trace file, which can still be being recorded
+    /// </summary>
+    /// <param name="path">Trace file</param>
+    /// <param name="error">Set to why the file could not be read</param>
+    /// <returns>The trace, or nullopt if the file could not be read or is not a trace</returns>
+    std::optional<Contents> read(const std::filesystem::path& path, std::string& error);
+}
@@ -0,0 +1,121 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PoseTraceRecorder.hpp"
+
+#include <new>
+
+std::unique_ptr<PoseTraceRecorder> PoseTraceRecorder::create(const std::filesystem::path& path)
+{
+    return create(path, Options());
+}
+
+std::unique_ptr<PoseTraceRecorder> PoseTraceRecorder::create(const std::filesystem::path& path, Options options)
+{
+    if (options.capacity == 0)
+        return nullptr;
+    auto file = MappedFile::create(path, PoseTrace::fileSize(options.capacity));
+    if (file == nullptr)
+        return nullptr;
+    return std::unique_ptr<PoseTraceRecorder>(new PoseTraceRecorder(path, std::move(file), options));
+}
+
+PoseTraceRecorder::PoseTraceRecorder(const std::filesystem::path& path, std::unique_ptr<MappedFile> file, Options options) :
+    m_path(path),
+    m_file(std::move(file)),
+    m_options(options),
+    m_queue(options.queue_size)
+{
+    // The file is zero filled, only the header needs setting
+    this->m_header = new (this->m_file->data()) PoseTrace::Header();
+    this->m_records = reinterpret_cast<PoseTrace::Record*>(this->m_header + 1);
+    this->m_header->magic = PoseTrace::magic;
+    this->m_header->version = PoseTrace::version;
+    this->m_header->record_size = sizeof(PoseTrace::Record);
+    this->m_header->capacity = options.capacity;
+    this->m_header->start_ns = nowNanoseconds();
+    this->m_header->record_count.store(0, std::memory_order_release);
+
+    this->m_worker = std::thread(&PoseTraceRecorder::run, this);
+}
+
+PoseTraceRecorder::~PoseTraceRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_running = false;
+    }
+    this->m_wake.notify_all();
+    this->m_worker.join();
+    this->drain();
+    this->m_file->flush();
+}
+
+void PoseTraceRecorder::record(const PoseTrace::Record& record)
+{
+    if (!this->m_queue.tryPush(record))
+        this->m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+const std::filesystem::path& PoseTraceRecorder::getPath() const
+{
+    return this->m_path;
+}
+
+uint64_t PoseTraceRecorder::getRecordedCount() const
+{
+    return this->m_recorded.load(std::memory_order_relaxed);
+}
+
+uint64_t PoseTraceRecorder::getDroppedCount() const
+{
+    return this->m_dropped.load(std::memory_order_relaxed);
+}
+
+int64_t PoseTraceRecorder::nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void PoseTraceRecorder::run()
+{
+    auto last_flush = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    while (this->m_running) {
+        this->m_wake.wait_for(lock, this->m_options.drain_interval, [this]() { return !this->m_running; });
+        lock.unlock();
+        this->drain();
+
+        // Hand written pages to the OS now and then, rather than all at the end
+        if (auto now = std::chrono::steady_clock::now(); now - last_flush > std::chrono::seconds(1)) {
+            this->m_file->flush();
+            last_flush = now;
+        }
+        lock.lock();
+    }
+}
+
+void PoseTraceRecorder::drain()
+{
+    uint64_t recorded = this->m_recorded.load(std::memory_order_relaxed);
+    uint64_t start = recorded;
+    while (auto record = this->m_queue.tryPop()) {
+        if (recorded == this->m_options.capacity) {
+            this->m_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        this->m_records[recorded++] = *record;
+    }
+    if (recorded == start)
+        return;
+
+    // Readers of a trace still being recorded only see whole records
+    this->m_header->record_count.store(recorded, std::memory_order_release);
+    this->m_recorded.store(recorded, std::memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <MappedFile.hpp>
+#include <PoseTrace.hpp>
+#include <SpscQueue.hpp>
+
+/// <summary>
+/// Records pose trace records (see PoseTrace.hpp) to a preallocated, memory mapped file. The frame thread only copies each record into a
+/// queue in memory; a background thread moves them into the file, so page faults and write back never land on a frame. Records that don't
+/// fit in the queue, or arrive once the file is full, are counted and dropped.
+/// </summary>
+class PoseTraceRecorder
+{
+public:
+    struct Options {
+        /// <summary>
+        /// Records the file has room for
+        /// </summary>
+        uint64_t capacity = PoseTrace::default_capacity;
+
+        /// <summary>
+        /// Records the queue holds between drains
+        /// </summary>
+        std::size_t queue_size = 4096;
+
+        std::chrono::milliseconds drain_interval{ 10 };
+    };
+
+    /// <summary>
+    /// Creates the trace file and starts recording
+    /// </summary>
+    /// <returns>The recorder, or nullptr if the file could not be created</returns>
+    static std::unique_ptr<PoseTraceRecorder> create(const std::filesystem::path& path);
+    static std::unique_ptr<PoseTraceRecorder> create(const std::filesystem::path& path, Options options);
+
+    /// <summary>
+    /// Writes the queued records to the file and stops recording
+    /// </summary>
+    ~PoseTraceRecorder();
+
+    PoseTraceRecorder(const PoseTraceRecorder&) = delete;
+    PoseTraceRecorder& operator=(const PoseTraceRecorder&) = delete;
+
+    /// <summary>
+    /// Queues a record, from one thread at a time. Never blocks.
+    /// </summary>
+    void record(const PoseTrace::Record& record);
+
+    const std::filesystem::path& getPath() const;
+
+    /// <summary>
+    /// Records written to the file
+    /// </summary>
+    uint64_t getRecordedCount() const;
+
+    /// <summary>
+    /// Records dropped because the queue or the file was full
+    /// </summary>
+    uint64_t getDroppedCount() const;
+
+    static int64_t nowNanoseconds();
+
+private:
+    PoseTraceRecorder(const std::filesystem::path& path, std::unique_ptr<MappedFile> file, Options options);
+
+    void run();
+
+    /// <summary>
+    /// Moves queued records into the file, on the recorder thread
+    /// </summary>
+    void drain();
+
+    std::filesystem::path m_path;
+    std::unique_ptr<MappedFile> m_file;
+    Options m_options;
+    PoseTrace::Header* m_header;
+    PoseTrace::Record* m_records;
+
+    SpscQueue<PoseTrace::Record> m_queue;
+    std::atomic<uint64_t> m_recorded{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_running = true;
+    std::thread m_worker;
+};
@@ -0,0 +1,142 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PoseTraceSwitcher.hpp"
+#include <DriverLog.hpp>
+
+PoseTraceSwitcher::PoseTraceSwitcher() :
+    PoseTraceSwitcher([](const std::filesystem::path& path) { return PoseTraceRecorder::create(path); })
+{}
+
+PoseTraceSwitcher::PoseTraceSwitcher(Factory factory) :
+    m_factory(std::move(factory))
+{
+    this->m_worker = std::thread(&PoseTraceSwitcher::run, this);
+}
+
+PoseTraceSwitcher::~PoseTraceSwitcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_running = false;
+    }
+    this->m_wake.notify_all();
+    if (this->m_worker.joinable())
+        this->m_worker.join();
+
+    this->closeRetired();
+    delete this->m_ready.exchange(nullptr);
+    this->m_current.reset();
+}
+
+void PoseTraceSwitcher::request(std::optional<std::filesystem::path> path)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_request = std::move(path);
+        this->m_hasRequest = true;
+    }
+    this->m_wake.notify_one();
+}
+
+PoseTraceRecorder* PoseTraceSwitcher::update()
+{
+    if (this->m_ready.load(std::memory_order_relaxed) == nullptr)
+        return this->m_current.get();
+
+    Handoff* handoff = this->m_ready.exchange(nullptr, std::memory_order_acq_rel);
+    if (handoff != nullptr) {
+        std::swap(handoff->recorder, this->m_current);
+
+        // Hand the replaced recorder back, the worker only ever takes the whole stack so this can only retry once per take
+        handoff->next = this->m_retired.load(std::memory_order_relaxed);
+        while (!this->m_retired.compare_exchange_weak(handoff->next, handoff, std::memory_order_release, std::memory_order_relaxed)) {}
+        this->m_wake.notify_one();
+    }
+    return this->m_current.get();
+}
+
+PoseTraceRecorder* PoseTraceSwitcher::get() const
+{
+    return this->m_current.get();
+}
+
+void PoseTraceSwitcher::run()
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    while (this->m_running) {
+        this->m_wake.wait_for(lock, m_pollInterval, [this]() {
+            return !this->m_running || (this->m_hasRequest && !this->m_stopping) || this->m_retired.load(std::memory_order_relaxed) != nullptr;
+        });
+        if (!this->m_running)
+            break;
+
+        lock.unlock();
+        this->closeRetired();
+        lock.lock();
+        if (!this->m_hasRequest)
+            continue;
+
+        // The trace in use is stopped and closed before the next is opened, it may be to the same file
+        if (this->m_live > 0) {
+            if (!this->m_stopping) {
+                this->m_stopping = true;
+                lock.unlock();
+                this->publish(nullptr);
+                lock.lock();
+            }
+            continue;
+        }
+        this->m_stopping = false;
+
+        std::optional<std::filesystem::path> path = std::move(this->m_request);
+        this->m_request.reset();
+        this->m_hasRequest = false;
+        if (!path.has_value())
+            continue;
+
+        lock.unlock();
+        auto recorder = this->m_factory(*path);
+        if (recorder != nullptr) {
+            DRIVER_LOG_INFO(Pose, "Recording a pose trace to %s.\n", path->u8string().c_str());
+            this->publish(std::move(recorder));
+        }
+        else {
+            DRIVER_LOG_WARN(Pose, "Unable to create the pose trace file %s.\n", path->u8string().c_str());
+        }
+        lock.lock();
+    }
+}
+
+void PoseTraceSwitcher::publish(std::unique_ptr<PoseTraceRecorder> recorder)
+{
+    bool live = recorder != nullptr;
+    Handoff* handoff = new Handoff{ std::move(recorder) };
+
+    // Replaces one the frame thread hasn't picked up yet, which can be closed here
+    if (Handoff* stale = this->m_ready.exchange(handoff, std::memory_order_acq_rel); stale != nullptr) {
+        if (stale->recorder != nullptr)
+            --this->m_live;
+        delete stale;
+    }
+    if (live)
+        ++this->m_live;
+}
+
+void PoseTraceSwitcher::closeRetired()
+{
+    Handoff* handoff = this->m_retired.exchange(nullptr, std::memory_order_acquire);
+    while (handoff != nullptr) {
+        Handoff* next = handoff->next;
+        if (handoff->recorder != nullptr)
+            --this->m_live;
+        delete handoff;
+        handoff = next;
+    }
+}
@@ -0,0 +1,117 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <PoseTraceRecorder.hpp>
+
+/// <summary>
+/// Opens and closes pose traces on a background thread, since opening one preallocates its whole file and closing one waits for the last records
+/// to be written. The frame thread asks for a trace to be started or stopped, and picks up the new recorder once it is ready through an atomic
+/// pointer, handing the one it replaces back the same way to be closed. Only the latest request matters, and a trace is always closed before
+/// the next is opened, so the same file can be traced to again.
+/// </summary>
+class PoseTraceSwitcher
+{
+public:
+    using Factory = std::function<std::unique_ptr<PoseTraceRecorder>(const std::filesystem::path&)>;
+
+    /// <summary>
+    /// Opens traces with PoseTraceRecorder::create
+    /// </summary>
+    PoseTraceSwitcher();
+
+    /// <param name="factory">Opens a trace, called on the worker thread, returning nullptr on failure</param>
+    explicit PoseTraceSwitcher(Factory factory);
+
+    /// <summary>
+    /// Stops the worker and closes every trace, including the one in use. Call once the frame thread no longer uses get's result.
+    /// </summary>
+    ~PoseTraceSwitcher();
+
+    PoseTraceSwitcher(const PoseTraceSwitcher&) = delete;
+    PoseTraceSwitcher& operator=(const PoseTraceSwitcher&) = delete;
+
+    /// <summary>
+    /// Asks for a trace to the file to be started in place of the current one, or for tracing to stop. Never waits on the filesystem.
+    /// </summary>
+    /// <param name="path">Trace file, nullopt to stop tracing</param>
+    void request(std::optional<std::filesystem::path> path);
+
+    /// <summary>
+    /// Swaps in the latest opened trace, if there is one (frame thread only). Only an atomic load when there is none.
+    /// </summary>
+    /// <returns>The recorder to record to, nullptr when not tracing</returns>
+    PoseTraceRecorder* update();
+
+    /// <summary>
+    /// Gets the recorder swapped in by the last update (frame thread only)
+    /// </summary>
+    PoseTraceRecorder* get() const;
+
+private:
+    /// <summary>
+    /// A recorder passed between the threads, nullptr to stop tracing
+    /// </summary>
+    struct Handoff {
+        std::unique_ptr<PoseTraceRecorder> recorder;
+        Handoff* next = nullptr;
+    };
+
+    void run();
+
+    // Worker thread only
+    void publish(std::unique_ptr<PoseTraceRecorder> recorder);
+    void closeRetired();
+
+    Factory m_factory;
+
+    /// <summary>
+    /// The recorder in use (frame thread only)
+    /// </summary>
+    std::unique_ptr<PoseTraceRecorder> m_current;
+
+    /// <summary>
+    /// Opened by the worker, waiting to be swapped in by the frame thread
+    /// </summary>
+    std::atomic<Handoff*> m_ready{ nullptr };
+
+    /// <summary>
+    /// Replaced by the frame thread, waiting to be closed by the worker (a stack, only pushed by the frame thread)
+    /// </summary>
+    std::atomic<Handoff*> m_retired{ nullptr };
+
+    /// <summary>
+    /// Recorders published by the worker and not yet handed back (worker thread only)
+    /// </summary>
+    std::size_t m_live = 0;
+    bool m_stopping = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<std::filesystem::path> m_request;
+    bool m_hasRequest = false;
+    bool m_running = true;
+
+    /// <summary>
+    /// How often the worker checks for recorders to close, in case the frame thread's wake up was missed
+    /// </summary>
+    static constexpr std::chrono::milliseconds m_pollInterval{ 50 };
+
+    std::thread m_worker;
+};
@@ -0,0 +1,147 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "PowerController.hpp"
+#include <DriverLog.hpp>
+
+double PowerController::ModeStats::cpuPercent() const
+{
+    double time_us = std::chrono::duration<double, std::micro>(this->time).count();
+    return time_us <= 0.0 ? 0.0 : 100.0 * this->frames.total_us / time_us;
+}
+
+PowerController::PowerController() :
+    PowerController(Options(), Clock::now)
+{}
+
+PowerController::PowerController(Options options, ClockFunction clock) :
+    m_options(options),
+    m_clock(clock)
+{
+    auto now = this->m_clock();
+    this->m_lastActivity = now;
+    this->m_lastWork = now;
+    this->m_lastUpdate = now;
+    this->m_stats[static_cast<std::size_t>(Mode::Active)].entered = 1;
+}
+
+PowerController::Mode PowerController::update()
+{
+    auto now = this->m_clock();
+    this->accumulateTime(now);
+
+    if (this->m_mode == Mode::Active && now - this->m_lastActivity >= this->m_options.idle_timeout)
+        this->setMode(Mode::Idle, now);
+
+    if (this->m_mode == Mode::Active) {
+        this->m_workDue = true;
+    }
+    else {
+        auto interval = this->m_mode == Mode::Idle ? this->m_options.idle_work_interval : this->m_options.standby_work_interval;
+        this->m_workDue = now - this->m_lastWork >= interval;
+    }
+    if (this->m_workDue)
+        this->m_lastWork = now;
+
+    return this->m_mode;
+}
+
+void PowerController::onPenActivity()
+{
+    auto now = this->m_clock();
+    this->m_lastActivity = now;
+    if (this->m_mode != Mode::Active) {
+        this->accumulateTime(now);
+        this->setMode(Mode::Active, now);
+        this->m_workDue = true;
+        this->m_lastWork = now;
+    }
+}
+
+void PowerController::enterStandby()
+{
+    auto now = this->m_clock();
+    this->accumulateTime(now);
+    this->setMode(Mode::Standby, now);
+}
+
+void PowerController::leaveStandby()
+{
+    if (this->m_mode != Mode::Standby)
+        return;
+
+    // Only Active if the pen was in use recently, otherwise wait for it in Idle
+    auto now = this->m_clock();
+    this->accumulateTime(now);
+    this->setMode(now - this->m_lastActivity < this->m_options.idle_timeout ? Mode::Active : Mode::Idle, now);
+}
+
+PowerController::Mode PowerController::getMode() const
+{
+    return this->m_mode;
+}
+
+bool PowerController::isWorkDue() const
+{
+    return this->m_workDue;
+}
+
+std::chrono::milliseconds PowerController::getPollInterval() const
+{
+    switch (this->m_mode) {
+    case Mode::Idle:
+        return this->m_options.idle_poll_interval;
+    case Mode::Standby:
+        return this->m_options.standby_poll_interval;
+    default:
+        return this->m_options.active_poll_interval;
+    }
+}
+
+TimingStats& PowerController::getFrameTiming(Mode mode)
+{
+    return this->m_stats[static_cast<std::size_t>(mode)].frames;
+}
+
+const PowerController::ModeStats& PowerController::getStats(Mode mode) const
+{
+    return this->m_stats[static_cast<std::size_t>(mode)];
+}
+
+const char* PowerController::getModeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::Active:
+        return "active";
+    case Mode::Idle:
+        return "idle";
+    case Mode::Standby:
+        return "standby";
+    }
+    return "unknown";
+}
+
+void PowerController::setMode(Mode mode, Clock::time_point now)
+{
+    if (mode == this->m_mode)
+        return;
+    DRIVER_LOG_INFO(General, "Power mode changed from %s to %s.\n", getModeName(this->m_mode), getModeName(mode));
+    this->m_mode = mode;
+    ++this->m_stats[static_cast<std::size_t>(mode)].entered;
+
+    // Deferred work runs on the first frame of a new mode
+    this->m_lastWork = now - this->m_options.standby_work_interval - this->m_options.idle_work_interval;
+}
+
+void PowerController::accumulateTime(Clock::time_point now)
+{
+    if (now > this->m_lastUpdate)
+        this->m_stats[static_cast<std::size_t>(this->m_mode)].time += now - this->m_lastUpdate;
+    this->m_lastUpdate = now;
+}
@@ -0,0 +1,140 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include <TimingStats.hpp>
+
+/// <summary>
+/// Decides how much work the driver does each frame. While the pen is in use the driver is Active and does everything every frame. Once the pen has
+/// not been tracking for a while it goes Idle, and SteamVR can put it in Standby. In both of those, per frame work that only matters while the pen is
+/// in use (tracking reference discovery, posting an unchanged pose) runs at most once per work interval, and polling threads back off. Any pen
+/// activity makes it Active again straight away.
+/// </summary>
+class PowerController
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+
+    enum class Mode {
+        Active,
+        Idle,
+        Standby
+    };
+
+    static constexpr std::size_t m_modeCount = 3;
+
+    /// <summary>
+    /// Timeouts and intervals
+    /// </summary>
+    struct Options {
+        /// <summary>
+        /// How long without pen activity before going Idle
+        /// </summary>
+        std::chrono::milliseconds idle_timeout{ 2000 };
+
+        /// <summary>
+        /// How often deferred work runs while Idle or in Standby
+        /// </summary>
+        std::chrono::milliseconds idle_work_interval{ 250 };
+        std::chrono::milliseconds standby_work_interval{ 1000 };
+
+        /// <summary>
+        /// How often polling threads (ie. the Massless Studio check) should poll in each mode
+        /// </summary>
+        std::chrono::milliseconds active_poll_interval{ 100 };
+        std::chrono::milliseconds idle_poll_interval{ 500 };
+        std::chrono::milliseconds standby_poll_interval{ 2000 };
+    };
+
+    /// <summary>
+    /// Where the frame time went in one mode
+    /// </summary>
+    struct ModeStats {
+        /// <summary>
+        /// RunFrame durations while in this mode
+        /// </summary>
+        TimingStats frames;
+
+        /// <summary>
+        /// Wall time spent in this mode
+        /// </summary>
+        Clock::duration time{ 0 };
+
+        /// <summary>
+        /// Number of times this mode was entered
+        /// </summary>
+        uint64_t entered = 0;
+
+        /// <summary>
+        /// Share of one core the frame thread used while in this mode, in percent
+        /// </summary>
+        double cpuPercent() const;
+    };
+
+    PowerController();
+    PowerController(Options options, ClockFunction clock);
+
+    /// <summary>
+    /// Advances to this frame, going Idle if the pen has been inactive for the idle timeout. Call once at the start of each frame.
+    /// </summary>
+    /// <returns>The mode for this frame</returns>
+    Mode update();
+
+    /// <summary>
+    /// Marks the pen as in use (tracking, or sending input), going Active immediately
+    /// </summary>
+    void onPenActivity();
+
+    /// <summary>
+    /// SteamVR has asked the driver to save power, or has woken it again
+    /// </summary>
+    void enterStandby();
+    void leaveStandby();
+
+    Mode getMode() const;
+
+    /// <summary>
+    /// Whether deferrable work should run this frame: every frame while Active, otherwise once per work interval
+    /// </summary>
+    bool isWorkDue() const;
+
+    /// <summary>
+    /// Gets how often polling threads should poll in the current mode
+    /// </summary>
+    std::chrono::milliseconds getPollInterval() const;
+
+    /// <summary>
+    /// Gets the frame timing of a mode, to record a frame into
+    /// </summary>
+    TimingStats& getFrameTiming(Mode mode);
+
+    const ModeStats& getStats(Mode mode) const;
+
+    static const char* getModeName(Mode mode);
+
+private:
+    void setMode(Mode mode, Clock::time_point now);
+    void accumulateTime(Clock::time_point now);
+
+    Options m_options;
+    ClockFunction m_clock;
+
+    Mode m_mode = Mode::Active;
+    bool m_workDue = true;
+    Clock::time_point m_lastActivity;
+    Clock::time_point m_lastWork;
+    Clock::time_point m_lastUpdate;
+    std::array<ModeStats, m_modeCount> m_stats;
+};
@@ -0,0 +1,125 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ProcessNameResolver.hpp"
+#include <VRProcessEnumerator.hpp>
+
+std::size_t ProcessNameResolver::CacheKeyHash::operator()(const CacheKey& key) const
+{
+    return std::hash<uint64_t>()(key.second) ^ (std::hash<unsigned long>()(key.first) << 1);
+}
+
+ProcessNameResolver::ProcessNameResolver() :
+    ProcessNameResolver(16, VRProcessEnumerator::getVRClientProcessName, VRProcessEnumerator::getProcessStartTime)
+{}
+
+ProcessNameResolver::ProcessNameResolver(std::size_t capacity, LookupFunction lookup, StartTimeFunction start_time) :
+    m_capacity(capacity),
+    m_lookup(lookup),
+    m_startTime(start_time)
+{
+    this->m_worker = std::thread(&ProcessNameResolver::run, this);
+}
+
+ProcessNameResolver::~ProcessNameResolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_running = false;
+    }
+    this->m_wake.notify_all();
+    if (this->m_worker.joinable())
+        this->m_worker.join();
+}
+
+void ProcessNameResolver::request(unsigned long pid)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_pending = pid;
+        this->m_result = std::nullopt;
+        ++this->m_generation;
+    }
+    this->m_wake.notify_one();
+}
+
+std::optional<ProcessNameResolver::Result> ProcessNameResolver::takeResult()
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || !this->m_result.has_value())
+        return std::nullopt;
+    auto result = std::move(this->m_result);
+    this->m_result = std::nullopt;
+    return result;
+}
+
+uint64_t ProcessNameResolver::getLookupCount() const
+{
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    return this->m_lookups;
+}
+
+std::optional<std::wstring> ProcessNameResolver::findCached(const CacheKey& key)
+{
+    auto found = this->m_cacheIndex.find(key);
+    if (found == this->m_cacheIndex.end())
+        return std::nullopt;
+    this->m_cache.splice(this->m_cache.begin(), this->m_cache, found->second);
+    return found->second->second;
+}
+
+void ProcessNameResolver::addCached(const CacheKey& key, const std::wstring& name)
+{
+    if (this->m_capacity == 0)
+        return;
+    if (this->m_cache.size() >= this->m_capacity) {
+        this->m_cacheIndex.erase(this->m_cache.back().first);
+        this->m_cache.pop_back();
+    }
+    this->m_cache.emplace_front(key, name);
+    this->m_cacheIndex[key] = this->m_cache.begin();
+}
+
+void ProcessNameResolver::run()
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    while (true) {
+        this->m_wake.wait(lock, [this]() { return !this->m_running || this->m_pending.has_value(); });
+        if (!this->m_running)
+            break;
+
+        unsigned long pid = *this->m_pending;
+        this->m_pending = std::nullopt;
+        uint64_t generation = this->m_generation;
+        lock.unlock();
+
+        // A PID can be reused once its process exits, the start time tells the new process apart
+        Result result{ pid, std::nullopt, false };
+        auto start_time = this->m_startTime(pid);
+        if (start_time.has_value()) {
+            result.name = this->findCached({ pid, *start_time });
+            result.cached = result.name.has_value();
+        }
+        bool looked_up = false;
+        if (!result.cached) {
+            result.name = this->m_lookup(pid);
+            looked_up = true;
+            // Don't cache misses, the process may not have loaded vrclient yet
+            if (start_time.has_value() && result.name.has_value())
+                this->addCached({ pid, *start_time }, *result.name);
+        }
+
+        lock.lock();
+        if (looked_up)
+            ++this->m_lookups;
+        // Superseded while we were looking it up
+        if (generation == this->m_generation)
+            this->m_result = std::move(result);
+    }
+}
@@ -0,0 +1,110 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+/// <summary>
+/// Looks up the executable name of a VR client process on a background thread, since finding it means enumerating every process and its modules.
+/// Names are cached by PID and process start time, so a PID reused by a new process is looked up again. Only the latest request matters: a request
+/// replaces any that have not been looked up yet, and a result is dropped if another request came in while it was being looked up.
+/// </summary>
+class ProcessNameResolver
+{
+public:
+    using LookupFunction = std::function<std::optional<std::wstring>(unsigned long)>;
+    using StartTimeFunction = std::function<std::optional<uint64_t>(unsigned long)>;
+
+    /// <summary>
+    /// A resolved request
+    /// </summary>
+    struct Result {
+        unsigned long pid;
+
+        /// <summary>
+        /// The executable name, nullopt if the process could not be found
+        /// </summary>
+        std::optional<std::wstring> name;
+
+        /// <summary>
+        /// Whether the name came from the cache rather than a lookup
+        /// </summary>
+        bool cached;
+    };
+
+    /// <summary>
+    /// Resolves names with the VRProcessEnumerator
+    /// </summary>
+    ProcessNameResolver();
+
+    /// <param name="capacity">Most names to keep cached, least recently used are dropped first</param>
+    /// <param name="lookup">Finds the name of a process, called on the worker thread</param>
+    /// <param name="start_time">Gets when a process started, nullopt if it can't be told (then the name is not cached)</param>
+    ProcessNameResolver(std::size_t capacity, LookupFunction lookup, StartTimeFunction start_time);
+
+    ~ProcessNameResolver();
+
+    ProcessNameResolver(const ProcessNameResolver&) = delete;
+    ProcessNameResolver& operator=(const ProcessNameResolver&) = delete;
+
+    /// <summary>
+    /// Asks for the name of a process, never blocks
+    /// </summary>
+    void request(unsigned long pid);
+
+    /// <summary>
+    /// Takes the result of the latest request, if it is ready, never blocks
+    /// </summary>
+    std::optional<Result> takeResult();
+
+    /// <summary>
+    /// Number of lookups done, ie. requests that missed the cache
+    /// </summary>
+    uint64_t getLookupCount() const;
+
+private:
+    void run();
+
+    using CacheKey = std::pair<unsigned long, uint64_t>;
+    struct CacheKeyHash {
+        std::size_t operator()(const CacheKey& key) const;
+    };
+    using CacheList = std::list<std::pair<CacheKey, std::wstring>>;
+
+    // Worker thread only
+    std::optional<std::wstring> findCached(const CacheKey& key);
+    void addCached(const CacheKey& key, const std::wstring& name);
+
+    std::size_t m_capacity;
+    LookupFunction m_lookup;
+    StartTimeFunction m_startTime;
+
+    CacheList m_cache;
+    std::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash> m_cacheIndex;
+
+    // Shared with the worker, guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<unsigned long> m_pending;
+    std::optional<Result> m_result;
+    uint64_t m_generation = 0;
+    uint64_t m_lookups = 0;
+    bool m_running = true;
+
+    std::thread m_worker;
+};
@@ -0,0 +1,70 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ProcessWatch.hpp"
+#include <SnapshotProcessWatcher.hpp>
+#include <DriverLog.hpp>
+
+#ifdef __linux__
+#include <NetlinkProcessWatcher.hpp>
+#endif
+
+ProcessWatch::ProcessWatch(StringPattern matcher) :
+    ProcessWatch(matcher, createPlatformWatcher())
+{}
+
+ProcessWatch::ProcessWatch(StringPattern matcher, std::unique_ptr<IProcessWatcher> watcher) :
+    m_matcher(matcher),
+    m_watcher(std::move(watcher))
+{}
+
+bool ProcessWatch::update(std::chrono::milliseconds timeout)
+{
+    for (const auto& event : this->m_watcher->waitForEvents(timeout)) {
+        if (event.type == IProcessWatcher::Event::Type::Rescanned) {
+            // Rebuilt from the Started events that follow, so processes whose exit was lost are dropped
+            this->m_matching.clear();
+        }
+        else if (event.type == IProcessWatcher::Event::Type::Started) {
+            if (this->m_matcher.search(event.name))
+                this->m_matching.insert(event.pid);
+            else
+                this->m_matching.erase(event.pid);  // Reused PID, or exec'd into something else
+        }
+        else {
+            this->m_matching.erase(event.pid);
+        }
+    }
+    return this->isRunning();
+}
+
+void ProcessWatch::interrupt()
+{
+    this->m_watcher->interrupt();
+}
+
+bool ProcessWatch::isRunning() const
+{
+    return !this->m_matching.empty();
+}
+
+const IProcessWatcher& ProcessWatch::getWatcher() const
+{
+    return *this->m_watcher;
+}
+
+std::unique_ptr<IProcessWatcher> ProcessWatch::createPlatformWatcher()
+{
+#ifdef __linux__
+    if (auto watcher = NetlinkProcessWatcher::create(); watcher != nullptr)
+        return watcher;
+#endif
+    auto watcher = std::make_unique<SnapshotProcessWatcher>();
+    return watcher;
+}
@@ -0,0 +1,56 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <chrono>
+#include <memory>
+#include <unordered_set>
+
+#include <IProcessWatcher.hpp>
+#include <StringPattern.hpp>
+
+/// <summary>
+/// Keeps track of whether any process whose executable name matches a pattern is running, from a process watcher's start and exit events.
+/// Names are only matched when a process starts, and the matches are only rebuilt from scratch when the watcher reports it lost events.
+/// </summary>
+class ProcessWatch
+{
+public:
+    /// <summary>
+    /// Watches with the best watcher for the platform
+    /// </summary>
+    explicit ProcessWatch(StringPattern matcher);
+
+    ProcessWatch(StringPattern matcher, std::unique_ptr<IProcessWatcher> watcher);
+
+    /// <summary>
+    /// Waits for processes to start or exit (see IProcessWatcher::waitForEvents)
+    /// </summary>
+    /// <returns>Whether a matching process is running</returns>
+    bool update(std::chrono::milliseconds timeout);
+
+    /// <summary>
+    /// Makes an update in progress return early, from any thread
+    /// </summary>
+    void interrupt();
+
+    bool isRunning() const;
+
+    const IProcessWatcher& getWatcher() const;
+
+    /// <summary>
+    /// Creates the best watcher available: process event notifications where the platform allows it, otherwise snapshot diffing
+    /// </summary>
+    static std::unique_ptr<IProcessWatcher> createPlatformWatcher();
+
+private:
+    StringPattern m_matcher;
+    std::unique_ptr<IProcessWatcher> m_watcher;
+    std::unordered_set<unsigned long> m_matching;
+};
@@ -0,0 +1,128 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ReferenceCandidateScorer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ReferenceCandidateScorer::ReferenceCandidateScorer(Options options) :
+    m_options(options)
+{}
+
+void ReferenceCandidateScorer::update(const std::optional<Eigen::Vector3f>& pen_position, Span<const Candidate> candidates)
+{
+    this->m_hasSamples = this->m_hasSamples || !candidates.empty();
+    for (const Candidate& candidate : candidates) {
+        if (candidate.index >= vr::k_unMaxTrackedDeviceCount)
+            continue;
+        this->addSample(this->m_slots[candidate.index], candidate, pen_position);
+    }
+}
+
+std::optional<ReferenceCandidateScorer::Score> ReferenceCandidateScorer::getScore(vr::TrackedDeviceIndex_t index) const
+{
+    if (index >= vr::k_unMaxTrackedDeviceCount)
+        return std::nullopt;
+    return this->m_slots[index].score;
+}
+
+bool ReferenceCandidateScorer::isReady(Span<const vr::TrackedDeviceIndex_t> indices) const
+{
+    return std::all_of(indices.begin(), indices.end(), [this](vr::TrackedDeviceIndex_t index) { return this->getScore(index).has_value(); });
+}
+
+void ReferenceCandidateScorer::rank(Span<const vr::TrackedDeviceIndex_t> indices, std::vector<vr::TrackedDeviceIndex_t>& ranked) const
+{
+    ranked.assign(indices.begin(), indices.end());
+    std::stable_sort(ranked.begin(), ranked.end(), [this](vr::TrackedDeviceIndex_t a, vr::TrackedDeviceIndex_t b) {
+        auto score_a = this->getScore(a);
+        auto score_b = this->getScore(b);
+        return (score_a.has_value() ? score_a->score : -1.0f) > (score_b.has_value() ? score_b->score : -1.0f);
+    });
+}
+
+void ReferenceCandidateScorer::clear()
+{
+    // Called every frame while locked, so only pay for the reset once
+    if (!this->m_hasSamples)
+        return;
+    this->m_slots.fill(Slot());
+    this->m_hasSamples = false;
+}
+
+void ReferenceCandidateScorer::addSample(Slot& slot, const Candidate& candidate, const std::optional<Eigen::Vector3f>& pen_position)
+{
+    Accumulator& acc = slot.accumulator;
+    ++acc.samples;
+
+    if (candidate.pose.has_value()) {
+        ++acc.valid;
+        const Eigen::Vector3f& position = candidate.pose->second;
+
+        // Welford update of the position mean and variance
+        Eigen::Vector3d sample = position.cast<double>();
+        Eigen::Vector3d delta = sample - acc.position_mean;
+        acc.position_mean += delta / static_cast<double>(acc.valid);
+        acc.position_m2 += delta.cwiseProduct(sample - acc.position_mean);
+
+        // Speeds are frame to frame distances, so need a previous valid sample of both
+        if (candidate.correlate && pen_position.has_value() && acc.last_position.has_value() && acc.last_pen_position.has_value()) {
+            double x = (position - *acc.last_position).norm();
+            double y = (*pen_position - *acc.last_pen_position).norm();
+            ++acc.pairs;
+            double delta_x = x - acc.speed_mean_x;
+            acc.speed_mean_x += delta_x / acc.pairs;
+            double delta_y = y - acc.speed_mean_y;
+            acc.speed_mean_y += delta_y / acc.pairs;
+            acc.speed_m2_x += delta_x * (x - acc.speed_mean_x);
+            acc.speed_m2_y += delta_y * (y - acc.speed_mean_y);
+            acc.speed_c_xy += delta_x * (y - acc.speed_mean_y);
+        }
+        acc.last_position = position;
+    }
+    else {
+        acc.last_position = std::nullopt;
+    }
+    acc.last_pen_position = pen_position;
+
+    if (acc.samples >= this->m_options.window) {
+        slot.score = this->finishWindow(acc, candidate.correlate);
+
+        // Keep the last positions, so the first speed of the next window isn't lost
+        Accumulator next;
+        next.last_position = acc.last_position;
+        next.last_pen_position = acc.last_pen_position;
+        acc = next;
+    }
+}
+
+ReferenceCandidateScorer::Score ReferenceCandidateScorer::finishWindow(const Accumulator& acc, bool correlate) const
+{
+    Score score;
+    score.samples = acc.samples;
+    score.validity_rate = static_cast<float>(acc.valid) / static_cast<float>(acc.samples);
+    if (acc.valid > 1)
+        score.jitter = static_cast<float>(acc.position_m2.sum() / (acc.valid - 1));
+
+    if (correlate) {
+        if (acc.pairs > 1) {
+            double variance_x = acc.speed_m2_x / (acc.pairs - 1);
+            double variance_y = acc.speed_m2_y / (acc.pairs - 1);
+            if (variance_x > this->m_options.min_speed_variance && variance_y > this->m_options.min_speed_variance)
+                score.correlation = static_cast<float>(acc.speed_c_xy / std::sqrt(acc.speed_m2_x * acc.speed_m2_y));
+        }
+        float motion_factor = score.correlation.has_value() ? std::max(0.0f, *score.correlation) : this->m_options.unknown_correlation_factor;
+        score.score = score.validity_rate * motion_factor;
+    }
+    else {
+        score.score = score.validity_rate / (1.0f + static_cast<float>(score.jitter / this->m_options.jitter_scale));
+    }
+    return score;
+}
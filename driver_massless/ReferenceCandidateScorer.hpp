@@ -0,0 +1,167 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <Eigen/eigen>
+#include <openvr_driver.h>
+
+#include <Span.hpp>
+
+/// <summary>
+/// Ranks tracking reference candidates by watching them for a short window.
+/// Every candidate gets one sample per frame, scored on how often its pose was valid and, for static references, how much the pose jittered.
+/// Controllers (Rift S/Quest) are expected to move, so they are scored on the correlation between their speed and the pen's speed instead,
+/// as the controller the Massless tracker is mounted on moves with the pen's reported pose.
+/// All statistics are streaming (Welford), so each sample is constant time and nothing is stored per frame. Scores come from the last completed window.
+/// </summary>
+class ReferenceCandidateScorer
+{
+public:
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    /// <summary>
+    /// Tuning parameters
+    /// </summary>
+    struct Options {
+        /// <summary>
+        /// Samples per scoring window
+        /// </summary>
+        uint32_t window = 45;
+
+        /// <summary>
+        /// Position variance (meters squared) at which a static reference's stability score halves
+        /// </summary>
+        double jitter_scale = 1e-6;
+
+        /// <summary>
+        /// Minimum pen and controller speed variance for a correlation to be meaningful, below this the pen wasn't moving
+        /// </summary>
+        double min_speed_variance = 1e-10;
+
+        /// <summary>
+        /// Score factor for a controller when no correlation could be measured
+        /// </summary>
+        float unknown_correlation_factor = 0.5f;
+    };
+
+    /// <summary>
+    /// A candidate sampled this frame
+    /// </summary>
+    struct Candidate {
+        vr::TrackedDeviceIndex_t index;
+
+        /// <summary>
+        /// Pose this frame, nullopt if invalid
+        /// </summary>
+        std::optional<EigenPose> pose;
+
+        /// <summary>
+        /// Score on motion correlation with the pen rather than stability (ie. controllers)
+        /// </summary>
+        bool correlate;
+    };
+
+    /// <summary>
+    /// Result of a completed window
+    /// </summary>
+    struct Score {
+        uint32_t samples = 0;
+        float validity_rate = 0;
+
+        /// <summary>
+        /// Sum of the per axis position variances (meters squared)
+        /// </summary>
+        float jitter = 0;
+
+        /// <summary>
+        /// Pearson correlation of controller speed with pen speed, only for correlated candidates with enough motion
+        /// </summary>
+        std::optional<float> correlation;
+
+        /// <summary>
+        /// Overall score, 0 (unusable) to 1 (perfect)
+        /// </summary>
+        float score = 0;
+    };
+
+    ReferenceCandidateScorer() = default;
+    explicit ReferenceCandidateScorer(Options options);
+
+    /// <summary>
+    /// Adds one sample for every candidate
+    /// </summary>
+    /// <param name="pen_position">Pen position in the Massless tracker space this frame, nullopt if the pen isn't tracking</param>
+    /// <param name="candidates">Candidates sampled this frame</param>
+    void update(const std::optional<Eigen::Vector3f>& pen_position, Span<const Candidate> candidates);
+
+    /// <summary>
+    /// Gets the score of the last completed window for a device
+    /// </summary>
+    /// <returns>Score, or nullopt if no window has completed since the last clear</returns>
+    std::optional<Score> getScore(vr::TrackedDeviceIndex_t index) const;
+
+    /// <summary>
+    /// Has every device in the list completed a window?
+    /// </summary>
+    bool isReady(Span<const vr::TrackedDeviceIndex_t> indices) const;
+
+    /// <summary>
+    /// Sorts devices by score, best first. Devices with equal scores (or no score) keep their order, so the given priority breaks ties.
+    /// </summary>
+    /// <param name="indices">Devices sorted by priority</param>
+    /// <param name="ranked">Output, reused to avoid allocating</param>
+    void rank(Span<const vr::TrackedDeviceIndex_t> indices, std::vector<vr::TrackedDeviceIndex_t>& ranked) const;
+
+    /// <summary>
+    /// Discards all samples and scores
+    /// </summary>
+    void clear();
+
+private:
+    /// <summary>
+    /// Running statistics for the window in progress
+    /// </summary>
+    struct Accumulator {
+        uint32_t samples = 0;
+        uint32_t valid = 0;
+
+        // Welford mean and sum of squared differences of position
+        Eigen::Vector3d position_mean = Eigen::Vector3d::Zero();
+        Eigen::Vector3d position_m2 = Eigen::Vector3d::Zero();
+
+        // Welford co-moment of controller speed (x) and pen speed (y)
+        uint32_t pairs = 0;
+        double speed_mean_x = 0;
+        double speed_mean_y = 0;
+        double speed_m2_x = 0;
+        double speed_m2_y = 0;
+        double speed_c_xy = 0;
+
+        std::optional<Eigen::Vector3f> last_position;
+        std::optional<Eigen::Vector3f> last_pen_position;
+    };
+
+    struct Slot {
+        Accumulator accumulator;
+        std::optional<Score> score;
+    };
+
+    void addSample(Slot& slot, const Candidate& candidate, const std::optional<Eigen::Vector3f>& pen_position);
+    Score finishWindow(const Accumulator& accumulator, bool correlate) const;
+
+    Options m_options;
+    std::array<Slot, vr::k_unMaxTrackedDeviceCount> m_slots;
+    bool m_hasSamples = false;
+};
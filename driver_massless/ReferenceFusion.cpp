@@ -0,0 +1,259 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ReferenceFusion.hpp"
+#include <DriverLog.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    bool isSamePose(const ReferenceFusion::EigenPose& a, const ReferenceFusion::EigenPose& b) {
+        return a.first.coeffs() == b.first.coeffs() && a.second == b.second;
+    }
+
+    bool isSameOffset(const MasslessInterface::Pose& a, const MasslessInterface::Pose& b) {
+        return a.m_x == b.m_x && a.m_y == b.m_y && a.m_z == b.m_z
+            && a.m_qr == b.m_qr && a.m_qx == b.m_qx && a.m_qy == b.m_qy && a.m_qz == b.m_qz;
+    }
+
+    // Sign aligned, weighted sum of quaternions. Good enough for the small spread between references that pass the outlier check.
+    void accumulateRotation(Eigen::Vector4f& sum, const Eigen::Quaternionf& rotation, float weight) {
+        Eigen::Vector4f coeffs = rotation.coeffs();
+        if (sum.dot(coeffs) < 0)
+            coeffs = -coeffs;
+        sum += weight * coeffs;
+    }
+
+    Eigen::Quaternionf normalisedRotation(const Eigen::Vector4f& sum) {
+        Eigen::Quaternionf rotation;
+        rotation.coeffs() = sum;
+        return rotation.normalized();
+    }
+}
+
+ReferenceFusion::ReferenceFusion(Options options) :
+    m_options(options)
+{}
+
+ReferenceFusion::CompositeTransform ReferenceFusion::makeCompositeTransform(const DriverAnalytics::TrackingReferencePack& reference)
+{
+    constexpr float pi = 3.1415926f;
+
+    // See PenController::makeOpenVRPose. Rotating about the reference's x axis in SteamVR space is the same as rotating about x in the reference's
+    // own space, so the whole chain collapses to reference pose * coordinate flip * tracker offset.
+    float flip_angle = reference.type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER ? pi / 2.0f : pi;
+    Eigen::Quaternionf reference_to_tracker = reference.global_pose.first * Eigen::Quaternionf(Eigen::AngleAxisf(flip_angle, Eigen::Vector3f::UnitX()));
+
+    const MasslessInterface::Pose& offset = reference.pose_offset;
+    CompositeTransform composite;
+    composite.rotation = reference_to_tracker * Eigen::Quaternionf(offset.m_qr, offset.m_qx, offset.m_qy, offset.m_qz);
+    composite.translation = reference_to_tracker * Eigen::Vector3f(offset.m_x, offset.m_y, offset.m_z) + reference.global_pose.second;
+    return composite;
+}
+
+bool ReferenceFusion::isFusable(const MasslessInterface::TrackingSystemType& type)
+{
+    return DriverAnalytics::isStaticReference(type);
+}
+
+ReferenceFusion::EigenPose ReferenceFusion::applyCompositeTransform(const CompositeTransform& composite, const MasslessInterface::Pose& pen_pose)
+{
+    constexpr float pi = 3.1415926f;
+
+    // Massless pen axes to SteamVR controller axes (Rotation #2 in PenController::makeOpenVRPose, applied in the pen's own frame)
+    static const Eigen::Quaternionf pen_to_controller = Eigen::Quaternionf(Eigen::AngleAxisf(-pi / 2, Eigen::Vector3f::UnitZ())) * Eigen::Quaternionf(Eigen::AngleAxisf(pi / 2, Eigen::Vector3f::UnitX()));
+
+    Eigen::Quaternionf rotation = composite.rotation * Eigen::Quaternionf(pen_pose.m_qr, pen_pose.m_qx, pen_pose.m_qy, pen_pose.m_qz) * pen_to_controller;
+    Eigen::Vector3f translation = composite.rotation * Eigen::Vector3f(pen_pose.m_x, pen_pose.m_y, pen_pose.m_z) + composite.translation;
+    return { rotation, translation };
+}
+
+void ReferenceFusion::update(const DriverAnalytics::TrackingReferencePack& primary, Span<const Reference> secondaries)
+{
+    // A different primary invalidates every enrolment
+    if (this->m_slotCount > 0 && this->m_slots[0].device_serial != primary.device_serial)
+        this->clear();
+
+    for (std::size_t i = 0; i < this->m_slotCount; ++i)
+        this->m_slots[i].seen = false;
+
+    Slot& primary_slot = this->m_slots[0];
+    if (this->m_slotCount == 0 || !isSameOffset(this->m_primaryOffset, primary.pose_offset)) {
+        this->m_slotCount = std::max<std::size_t>(this->m_slotCount, 1);
+        primary_slot.device_serial = primary.device_serial;
+        this->m_primaryOffset = primary.pose_offset;
+        this->enroll(primary_slot, primary.global_pose, makeCompositeTransform(primary));
+    }
+    primary_slot.index = primary.index;
+    this->updateSlot(primary_slot, primary.global_pose);
+
+    // New references are enrolled against the fused pose of the ones we already trust
+    std::optional<CompositeTransform> fused = this->fuseComposites();
+    for (const Reference& reference : secondaries) {
+        if (reference.device_serial == primary.device_serial)
+            continue;
+        auto end = this->m_slots.begin() + this->m_slotCount;
+        auto slot = std::find_if(this->m_slots.begin() + 1, end, [&](const Slot& s) { return s.device_serial == reference.device_serial; });
+        if (slot == end) {
+            if (this->m_slotCount == m_maxReferences)
+                continue;
+            slot = end;
+            ++this->m_slotCount;
+            slot->device_serial = reference.device_serial;
+            this->enroll(*slot, reference.global_pose, fused.value_or(primary_slot.composite));
+            DRIVER_LOG_INFO(Reference, "Reference fusion: enrolled tracking reference with serial [%s].\n", reference.device_serial.c_str());
+        }
+        else if (slot->rejected_frames >= this->m_options.reenroll_frames && fused.has_value()) {
+            // Disagreed for long enough that it has been moved rather than bumped
+            this->enroll(*slot, reference.global_pose, *fused);
+            DRIVER_LOG_INFO(Reference, "Reference fusion: re-enrolled tracking reference with serial [%s].\n", reference.device_serial.c_str());
+        }
+        slot->index = reference.index;
+        this->updateSlot(*slot, reference.global_pose);
+    }
+
+    // Drop secondaries that are no longer visible, keeping the primary first
+    auto end = std::remove_if(this->m_slots.begin() + 1, this->m_slots.begin() + this->m_slotCount, [](const Slot& s) { return !s.seen; });
+    this->m_slotCount = static_cast<std::size_t>(end - this->m_slots.begin());
+}
+
+std::optional<ReferenceFusion::EigenPose> ReferenceFusion::fuse(const MasslessInterface::Pose& pen_pose)
+{
+    if (this->m_slotCount == 0)
+        return std::nullopt;
+
+    for (std::size_t i = 0; i < this->m_slotCount; ++i)
+        this->m_candidates[i] = applyCompositeTransform(this->m_slots[i].composite, pen_pose);
+
+    if (this->m_slotCount == 1) {
+        this->m_slots[0].weight = 1;
+        this->m_slots[0].rejected = false;
+        this->m_slots[0].rejected_frames = 0;
+        return this->m_candidates[0];
+    }
+
+    // The medoid is the candidate closest to all the others, ties (ie. two references) go to the stiller reference
+    std::size_t medoid = 0;
+    float best_distance = std::numeric_limits<float>::max();
+    for (std::size_t i = 0; i < this->m_slotCount; ++i) {
+        float distance = 0;
+        for (std::size_t j = 0; j < this->m_slotCount; ++j)
+            distance += (this->m_candidates[i].second - this->m_candidates[j].second).norm();
+        if (distance < best_distance || (distance == best_distance && this->m_slots[i].jitter < this->m_slots[medoid].jitter)) {
+            best_distance = distance;
+            medoid = i;
+        }
+    }
+
+    float total_weight = 0;
+    for (std::size_t i = 0; i < this->m_slotCount; ++i) {
+        Slot& slot = this->m_slots[i];
+        slot.rejected = (this->m_candidates[i].second - this->m_candidates[medoid].second).norm() > this->m_options.outlier_distance;
+        if (slot.rejected) {
+            ++slot.rejected_frames;
+            slot.weight = 0;
+            continue;
+        }
+        slot.rejected_frames = 0;
+        slot.weight = 1.0f / (slot.jitter + this->m_options.jitter_floor);
+        total_weight += slot.weight;
+    }
+
+    // The medoid is never rejected, so there is always some weight
+    Eigen::Vector4f rotation = Eigen::Vector4f::Zero();
+    Eigen::Vector3f translation = Eigen::Vector3f::Zero();
+    for (std::size_t i = 0; i < this->m_slotCount; ++i) {
+        Slot& slot = this->m_slots[i];
+        if (slot.rejected)
+            continue;
+        slot.weight /= total_weight;
+        accumulateRotation(rotation, this->m_candidates[i].first, slot.weight);
+        translation += slot.weight * this->m_candidates[i].second;
+    }
+    return EigenPose(normalisedRotation(rotation), translation);
+}
+
+void ReferenceFusion::clear()
+{
+    this->m_slotCount = 0;
+}
+
+Span<const ReferenceFusion::Slot> ReferenceFusion::getSlots() const
+{
+    return Span<const Slot>(this->m_slots.data(), this->m_slotCount);
+}
+
+uint64_t ReferenceFusion::getCompositeUpdateCount() const
+{
+    return this->m_compositeUpdates;
+}
+
+void ReferenceFusion::setOptions(Options options)
+{
+    this->m_options = options;
+}
+
+const ReferenceFusion::Options& ReferenceFusion::getOptions() const
+{
+    return this->m_options;
+}
+
+void ReferenceFusion::updateSlot(Slot& slot, const EigenPose& global_pose)
+{
+    slot.seen = true;
+    float movement = 0;
+    if (!isSamePose(slot.global_pose, global_pose)) {
+        movement = (global_pose.second - slot.global_pose.second).squaredNorm();
+        float angle = slot.global_pose.first.angularDistance(global_pose.first);
+        movement += angle * angle;
+
+        slot.global_pose = global_pose;
+        slot.composite.rotation = global_pose.first * slot.offset.first;
+        slot.composite.translation = global_pose.first * slot.offset.second + global_pose.second;
+        ++this->m_compositeUpdates;
+    }
+    slot.jitter += this->m_options.jitter_smoothing * (movement - slot.jitter);
+}
+
+void ReferenceFusion::enroll(Slot& slot, const EigenPose& global_pose, const CompositeTransform& composite)
+{
+    Eigen::Quaternionf inverse_rotation = global_pose.first.conjugate();
+    slot.offset.first = inverse_rotation * composite.rotation;
+    slot.offset.second = inverse_rotation * (composite.translation - global_pose.second);
+    slot.global_pose = global_pose;
+    slot.composite = composite;
+    slot.jitter = 0;
+    slot.weight = 0;
+    slot.rejected = false;
+    slot.rejected_frames = 0;
+    ++this->m_compositeUpdates;
+}
+
+std::optional<ReferenceFusion::CompositeTransform> ReferenceFusion::fuseComposites() const
+{
+    Eigen::Vector4f rotation = Eigen::Vector4f::Zero();
+    Eigen::Vector3f translation = Eigen::Vector3f::Zero();
+    float total_weight = 0;
+    for (std::size_t i = 0; i < this->m_slotCount; ++i) {
+        const Slot& slot = this->m_slots[i];
+        if (slot.rejected || slot.weight <= 0)
+            continue;
+        accumulateRotation(rotation, slot.composite.rotation, slot.weight);
+        translation += slot.weight * slot.composite.translation;
+        total_weight += slot.weight;
+    }
+    if (total_weight <= 0)
+        return std::nullopt;
+
+    CompositeTransform composite;
+    composite.rotation = normalisedRotation(rotation);
+    composite.translation = translation / total_weight;
+    return composite;
+}
@@ -0,0 +1,179 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <Eigen/eigen>
+#include <openvr_driver.h>
+
+#include <DriverAnalytics.hpp>
+#include <MasslessInterface.hpp>
+#include <Span.hpp>
+
+/// <summary>
+/// Fuses the pen pose seen through several static tracking references (base stations), so a bump or noise on one of them doesn't move the pen.
+/// The Massless API only gives the tracker offset from the primary (locked) reference, so every other reference is enrolled with its offset to the
+/// Massless tracker derived from the primary when it is first seen. Each frame the pen pose is computed from every reference, references that
+/// disagree with the medoid by more than the outlier distance are rejected, and the rest are averaged weighted by how still each reference has been.
+/// Each reference's composite transform (reference pose * offset) is cached and only rebuilt when that reference's pose changes, and at most
+/// m_maxReferences are tracked, so the per-frame cost is bounded.
+/// </summary>
+class ReferenceFusion
+{
+public:
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    /// <summary>
+    /// Maximum number of references fused, including the primary
+    /// </summary>
+    static constexpr std::size_t m_maxReferences = 4;
+
+    /// <summary>
+    /// Pose of the Massless tracker in SteamVR space, including the change of coordinate system, so the pen pose is just this applied to the Massless pose
+    /// </summary>
+    struct CompositeTransform {
+        Eigen::Quaternionf rotation = Eigen::Quaternionf::Identity();
+        Eigen::Vector3f translation = Eigen::Vector3f::Zero();
+    };
+
+    /// <summary>
+    /// A secondary reference visible this frame
+    /// </summary>
+    struct Reference {
+        vr::TrackedDeviceIndex_t index;
+        std::string device_serial;
+        EigenPose global_pose;
+    };
+
+    /// <summary>
+    /// Tuning parameters
+    /// </summary>
+    struct Options {
+        /// <summary>
+        /// Pen positions further than this (meters) from the medoid are rejected
+        /// </summary>
+        float outlier_distance = 0.05f;
+
+        /// <summary>
+        /// Smoothing factor of the moving average of each reference's frame to frame movement
+        /// </summary>
+        float jitter_smoothing = 0.1f;
+
+        /// <summary>
+        /// Added to the jitter before weighting, so perfectly still references don't get infinite weight (meters squared)
+        /// </summary>
+        float jitter_floor = 1e-6f;
+
+        /// <summary>
+        /// Number of consecutive frames a reference has to be rejected for before it is re-enrolled against the fused pose (ie. it was moved)
+        /// </summary>
+        uint32_t reenroll_frames = 90;
+    };
+
+    /// <summary>
+    /// Per reference fusion state
+    /// </summary>
+    struct Slot {
+        vr::TrackedDeviceIndex_t index = vr::k_unTrackedDeviceIndexInvalid;
+        std::string device_serial;
+
+        /// <summary>
+        /// Pose of the Massless tracker relative to this reference
+        /// </summary>
+        EigenPose offset;
+
+        /// <summary>
+        /// Reference pose the composite was built from
+        /// </summary>
+        EigenPose global_pose;
+        CompositeTransform composite;
+
+        /// <summary>
+        /// Moving average of squared frame to frame movement
+        /// </summary>
+        float jitter = 0;
+        float weight = 0;
+        bool rejected = false;
+        uint32_t rejected_frames = 0;
+        bool seen = false;
+    };
+
+    ReferenceFusion() = default;
+    explicit ReferenceFusion(Options options);
+
+    /// <summary>
+    /// Builds the composite transform for a tracking reference pack, same maths as PenController::makeOpenVRPose
+    /// </summary>
+    static CompositeTransform makeCompositeTransform(const DriverAnalytics::TrackingReferencePack& reference);
+
+    /// <summary>
+    /// Can references of this type be fused? Only static references (base stations and sensors) can, as enrolment assumes they don't move.
+    /// </summary>
+    static bool isFusable(const MasslessInterface::TrackingSystemType& type);
+
+    /// <summary>
+    /// Transforms a Massless pen pose into SteamVR space
+    /// </summary>
+    static EigenPose applyCompositeTransform(const CompositeTransform& composite, const MasslessInterface::Pose& pen_pose);
+
+    /// <summary>
+    /// Updates the references for this frame. Secondary references not in the list are dropped, new ones are enrolled while there is room.
+    /// </summary>
+    /// <param name="primary">Locked tracking reference</param>
+    /// <param name="secondaries">Other visible references of the same type</param>
+    void update(const DriverAnalytics::TrackingReferencePack& primary, Span<const Reference> secondaries);
+
+    /// <summary>
+    /// Computes the fused pen pose
+    /// </summary>
+    /// <returns>Fused pose in SteamVR space, or nullopt if update hasn't been called since the last clear</returns>
+    std::optional<EigenPose> fuse(const MasslessInterface::Pose& pen_pose);
+
+    /// <summary>
+    /// Drops every reference (ie. when the tracking reference is lost)
+    /// </summary>
+    void clear();
+
+    /// <summary>
+    /// Gets the tracked references, the primary first
+    /// </summary>
+    Span<const Slot> getSlots() const;
+
+    /// <summary>
+    /// Gets the number of composite transforms rebuilt since construction
+    /// </summary>
+    uint64_t getCompositeUpdateCount() const;
+
+    /// <summary>
+    /// Changes the tuning, effective from the next update. Enrolled references are kept.
+    /// </summary>
+    void setOptions(Options options);
+    const Options& getOptions() const;
+
+private:
+    void updateSlot(Slot& slot, const EigenPose& global_pose);
+    void enroll(Slot& slot, const EigenPose& global_pose, const CompositeTransform& composite);
+    std::optional<CompositeTransform> fuseComposites() const;
+
+    Options m_options;
+    std::array<Slot, m_maxReferences> m_slots;
+    std::size_t m_slotCount = 0;
+    std::array<EigenPose, m_maxReferences> m_candidates;
+
+    /// <summary>
+    /// Massless offset the primary's slot was built from, the primary is re-enrolled when this changes
+    /// </summary>
+    MasslessInterface::Pose m_primaryOffset;
+    uint64_t m_compositeUpdates = 0;
+};
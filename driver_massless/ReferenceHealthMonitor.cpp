@@ -0,0 +1,118 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ReferenceHealthMonitor.hpp"
+#include <DriverLog.hpp>
+
+ReferenceHealthMonitor::ReferenceHealthMonitor() :
+    ReferenceHealthMonitor(Options(), Clock::now)
+{}
+
+ReferenceHealthMonitor::ReferenceHealthMonitor(Options options, ClockFunction clock) :
+    m_options(options),
+    m_clock(clock)
+{}
+
+void ReferenceHealthMonitor::reset(const EigenPose& pose)
+{
+    this->m_anchor = pose;
+    this->m_holding = false;
+    this->m_historyCount = 0;
+    this->m_historyNext = 0;
+    this->accept(pose);
+}
+
+ReferenceHealthMonitor::Verdict ReferenceHealthMonitor::observe(const EigenPose& pose)
+{
+    if (!this->m_holding) {
+        if (this->isJump(this->m_lastGood, pose)) {
+            ++this->m_metrics.discontinuities;
+            ++this->m_metrics.held;
+            DRIVER_LOG_INFO(Reference, "Tracking reference pose jumped, holding the last good pose.\n");
+            this->m_holding = true;
+            this->m_holdStart = this->m_settleStart = this->m_clock();
+            this->m_settleCandidate = pose;
+            return Verdict::Hold;
+        }
+
+        this->accept(pose);
+
+        // Slow drift doesn't trip the jump check, so compare the recent average with where the reference was at lock
+        Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+        for (std::size_t i = 0; i < this->m_historyCount; ++i)
+            mean += this->m_history[i];
+        mean /= static_cast<float>(this->m_historyCount);
+        if (this->m_historyCount == m_historySize
+            && ((mean - this->m_anchor.second).norm() > this->m_options.drift_distance || pose.first.angularDistance(this->m_anchor.first) > this->m_options.drift_angle)) {
+            ++this->m_metrics.drifts;
+            ++this->m_metrics.moves;
+            DRIVER_LOG_INFO(Reference, "Tracking reference has drifted from where it was locked.\n");
+            return Verdict::Moved;
+        }
+
+        ++this->m_metrics.accepted;
+        return Verdict::Accept;
+    }
+
+    // Came back, so it was just a glitch
+    if (!this->isJump(this->m_lastGood, pose)) {
+        ++this->m_metrics.transients;
+        ++this->m_metrics.accepted;
+        DRIVER_LOG_INFO(Reference, "Tracking reference pose returned after a transient.\n");
+        this->m_holding = false;
+        this->accept(pose);
+        return Verdict::Accept;
+    }
+
+    // Still somewhere else, restart the settle timer whenever the new pose moves around
+    auto now = this->m_clock();
+    if (this->isJump(this->m_settleCandidate, pose)) {
+        this->m_settleCandidate = pose;
+        this->m_settleStart = now;
+    }
+    if (now - this->m_settleStart >= this->m_options.settle_period || now - this->m_holdStart >= this->m_options.hold_timeout) {
+        ++this->m_metrics.moves;
+        DRIVER_LOG_INFO(Reference, "Tracking reference has moved.\n");
+        this->m_holding = false;
+        return Verdict::Moved;
+    }
+
+    ++this->m_metrics.held;
+    return Verdict::Hold;
+}
+
+const ReferenceHealthMonitor::EigenPose& ReferenceHealthMonitor::getLastGoodPose() const
+{
+    return this->m_lastGood;
+}
+
+bool ReferenceHealthMonitor::isHolding() const
+{
+    return this->m_holding;
+}
+
+const ReferenceHealthMonitor::Metrics& ReferenceHealthMonitor::getMetrics() const
+{
+    return this->m_metrics;
+}
+
+bool ReferenceHealthMonitor::isJump(const EigenPose& from, const EigenPose& to) const
+{
+    return (to.second - from.second).norm() > this->m_options.jump_distance
+        || to.first.angularDistance(from.first) > this->m_options.jump_angle;
+}
+
+void ReferenceHealthMonitor::accept(const EigenPose& pose)
+{
+    this->m_lastGood = pose;
+    this->m_history[this->m_historyNext] = pose.second;
+    this->m_historyNext = (this->m_historyNext + 1) % m_historySize;
+    if (this->m_historyCount < m_historySize)
+        ++this->m_historyCount;
+}
@@ -0,0 +1,149 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include <Eigen/eigen>
+
+/// <summary>
+/// Plausibility check for the locked tracking reference's pose, so a bumped base station or a glitching tracker doesn't drag the pen with it.
+///     Tracking    -> Holding      when the pose jumps from the last good pose (discontinuity), the last good pose is held
+///     Holding     -> Tracking     when the pose comes back to the last good pose (transient)
+///     Holding     -> Moved        when the pose settles at the new position for the settle period, or keeps jumping for the hold timeout
+///     Tracking    -> Moved        when the average of the recent poses drifts away from the pose at lock
+/// Moved is reported once, ServerDriver then searches for the reference again. Timers are wall time from an injectable clock.
+/// </summary>
+class ReferenceHealthMonitor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    enum class Verdict {
+        /// <summary>
+        /// Pose is good, use it
+        /// </summary>
+        Accept,
+
+        /// <summary>
+        /// Pose is suspect, keep using getLastGoodPose()
+        /// </summary>
+        Hold,
+
+        /// <summary>
+        /// The reference has really moved, search for it again
+        /// </summary>
+        Moved
+    };
+
+    /// <summary>
+    /// Thresholds and timers
+    /// </summary>
+    struct Options {
+        /// <summary>
+        /// Frame to frame movement (meters) that counts as a discontinuity
+        /// </summary>
+        float jump_distance = 0.01f;
+
+        /// <summary>
+        /// Frame to frame rotation (radians) that counts as a discontinuity
+        /// </summary>
+        float jump_angle = 0.02f;
+
+        /// <summary>
+        /// Distance (meters) the recent average can drift from the pose at lock before the reference counts as moved
+        /// </summary>
+        float drift_distance = 0.02f;
+
+        /// <summary>
+        /// Rotation (radians) the recent poses can drift from the pose at lock before the reference counts as moved
+        /// </summary>
+        float drift_angle = 0.035f;
+
+        /// <summary>
+        /// How long a new pose has to stay put after a discontinuity to count as moved
+        /// </summary>
+        std::chrono::milliseconds settle_period{ 1000 };
+
+        /// <summary>
+        /// How long to hold the last good pose while the reference keeps jumping around
+        /// </summary>
+        std::chrono::milliseconds hold_timeout{ 3000 };
+    };
+
+    /// <summary>
+    /// Event counts since construction
+    /// </summary>
+    struct Metrics {
+        uint64_t accepted = 0;
+        uint64_t held = 0;
+        uint64_t discontinuities = 0;
+        uint64_t transients = 0;
+        uint64_t drifts = 0;
+        uint64_t moves = 0;
+    };
+
+    /// <summary>
+    /// Number of accepted poses averaged for drift detection
+    /// </summary>
+    static constexpr std::size_t m_historySize = 16;
+
+    ReferenceHealthMonitor();
+    ReferenceHealthMonitor(Options options, ClockFunction clock);
+
+    /// <summary>
+    /// Starts monitoring a newly locked reference, its current pose becomes the anchor for drift detection
+    /// </summary>
+    void reset(const EigenPose& pose);
+
+    /// <summary>
+    /// Checks this frame's reference pose
+    /// </summary>
+    /// <returns>Whether to use the pose, hold the last good one, or search again</returns>
+    Verdict observe(const EigenPose& pose);
+
+    /// <summary>
+    /// Gets the last pose that was accepted
+    /// </summary>
+    const EigenPose& getLastGoodPose() const;
+
+    /// <summary>
+    /// Is the last good pose currently being held?
+    /// </summary>
+    bool isHolding() const;
+
+    const Metrics& getMetrics() const;
+
+private:
+    bool isJump(const EigenPose& from, const EigenPose& to) const;
+    void accept(const EigenPose& pose);
+
+    Options m_options;
+    ClockFunction m_clock;
+    Metrics m_metrics;
+
+    EigenPose m_anchor;
+    EigenPose m_lastGood;
+
+    // Ring of recent accepted positions
+    std::array<Eigen::Vector3f, m_historySize> m_history;
+    std::size_t m_historyCount = 0;
+    std::size_t m_historyNext = 0;
+
+    bool m_holding = false;
+    EigenPose m_settleCandidate;
+    Clock::time_point m_holdStart;
+    Clock::time_point m_settleStart;
+};
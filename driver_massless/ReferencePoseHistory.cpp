@@ -0,0 +1,87 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "ReferencePoseHistory.hpp"
+
+#include <algorithm>
+
+ReferencePoseHistory::ReferencePoseHistory(Options options) :
+    m_options(options)
+{}
+
+void ReferencePoseHistory::push(Clock::time_point time, const EigenPose& pose)
+{
+    if (this->m_count > 0 && time <= this->fromNewest(0).time)
+        return;
+    this->m_samples[this->m_next] = Sample{ time, pose };
+    this->m_next = (this->m_next + 1) % m_capacity;
+    if (this->m_count < m_capacity)
+        ++this->m_count;
+}
+
+std::optional<ReferencePoseHistory::EigenPose> ReferencePoseHistory::sample(Clock::time_point time)
+{
+    if (this->m_count == 0)
+        return std::nullopt;
+
+    const Sample& newest = this->fromNewest(0);
+    if (time < newest.time - this->m_options.max_lookback) {
+        ++this->m_metrics.out_of_range;
+        return std::nullopt;
+    }
+
+    // Pen sample is newer than the reference, predict forward from the last two samples
+    if (time >= newest.time) {
+        ++this->m_metrics.extrapolated;
+        if (this->m_count == 1)
+            return newest.pose;
+        const Sample& previous = this->fromNewest(1);
+        auto ahead = std::min<Clock::duration>(time - newest.time, this->m_options.max_extrapolation);
+        float t = 1.0f + std::chrono::duration<float>(ahead).count() / std::chrono::duration<float>(newest.time - previous.time).count();
+        return interpolate(previous.pose, newest.pose, t);
+    }
+
+    // Walk back from the newest, the pen sample is usually only a frame or two old
+    ++this->m_metrics.interpolated;
+    for (std::size_t age = 1; age < this->m_count; ++age) {
+        const Sample& older = this->fromNewest(age);
+        if (older.time <= time) {
+            const Sample& newer = this->fromNewest(age - 1);
+            float t = std::chrono::duration<float>(time - older.time).count() / std::chrono::duration<float>(newer.time - older.time).count();
+            return interpolate(older.pose, newer.pose, t);
+        }
+    }
+    return this->fromNewest(this->m_count - 1).pose;
+}
+
+ReferencePoseHistory::EigenPose ReferencePoseHistory::interpolate(const EigenPose& from, const EigenPose& to, float t)
+{
+    return { from.first.slerp(t, to.first).normalized(), from.second + t * (to.second - from.second) };
+}
+
+void ReferencePoseHistory::clear()
+{
+    this->m_count = 0;
+    this->m_next = 0;
+}
+
+std::size_t ReferencePoseHistory::size() const
+{
+    return this->m_count;
+}
+
+const ReferencePoseHistory::Metrics& ReferencePoseHistory::getMetrics() const
+{
+    return this->m_metrics;
+}
+
+const ReferencePoseHistory::Sample& ReferencePoseHistory::fromNewest(std::size_t age) const
+{
+    return this->m_samples[(this->m_next + m_capacity - 1 - age) % m_capacity];
+}
@@ -0,0 +1,99 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include <Eigen/eigen>
+
+/// <summary>
+/// Short history of a moving tracking reference's pose (Vive Tracker, Rift S/Quest controller), so the reference can be evaluated at the instant the
+/// pen sample was captured rather than at RunFrame time. Poses between samples are interpolated (lerp/slerp), and poses slightly after the newest sample are
+/// extrapolated from the last two. Timestamps use the system clock, the same as MasslessInterface::Pose::m_timestamp.
+/// </summary>
+class ReferencePoseHistory
+{
+public:
+    using Clock = std::chrono::system_clock;
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    /// <summary>
+    /// Number of samples kept, about a third of a second at 90Hz
+    /// </summary>
+    static constexpr std::size_t m_capacity = 32;
+
+    /// <summary>
+    /// Limits on how far from the newest sample a pose can be evaluated
+    /// </summary>
+    struct Options {
+        /// <summary>
+        /// Oldest time before the newest sample that can be evaluated, anything older is treated as a clock mismatch and not aligned
+        /// </summary>
+        std::chrono::milliseconds max_lookback{ 100 };
+
+        /// <summary>
+        /// Furthest time after the newest sample to extrapolate to, anything later is clamped
+        /// </summary>
+        std::chrono::milliseconds max_extrapolation{ 20 };
+    };
+
+    /// <summary>
+    /// How samples were served, for diagnostics
+    /// </summary>
+    struct Metrics {
+        uint64_t interpolated = 0;
+        uint64_t extrapolated = 0;
+        uint64_t out_of_range = 0;
+    };
+
+    ReferencePoseHistory() = default;
+    explicit ReferencePoseHistory(Options options);
+
+    /// <summary>
+    /// Adds a reference pose. Samples that are not newer than the last one are ignored.
+    /// </summary>
+    void push(Clock::time_point time, const EigenPose& pose);
+
+    /// <summary>
+    /// Evaluates the reference pose at a time
+    /// </summary>
+    /// <param name="time">Time to evaluate at (ie. the pen sample's timestamp)</param>
+    /// <returns>Interpolated or extrapolated pose, or nullopt if there are no samples or the time is further back than max_lookback</returns>
+    std::optional<EigenPose> sample(Clock::time_point time);
+
+    /// <summary>
+    /// Interpolates between two poses, t outside of [0, 1] extrapolates
+    /// </summary>
+    static EigenPose interpolate(const EigenPose& from, const EigenPose& to, float t);
+
+    void clear();
+    std::size_t size() const;
+    const Metrics& getMetrics() const;
+
+private:
+    struct Sample {
+        Clock::time_point time;
+        EigenPose pose;
+    };
+
+    /// <summary>
+    /// Gets a sample by age, 0 is the newest
+    /// </summary>
+    const Sample& fromNewest(std::size_t age) const;
+
+    Options m_options;
+    Metrics m_metrics;
+    std::array<Sample, m_capacity> m_samples;
+    std::size_t m_count = 0;
+    std::size_t m_next = 0;
+};
@@ -0,0 +1,90 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/// <summary>
+/// A value shared between threads where reads must never block: one thread (or callers serialising their stores) stores, any number load.
+/// A load copies the value and retries if a store happened while it was copying, so a reader always gets a whole value, and a store never waits.
+/// The value is held as atomic words so the copy is not a data race.
+/// </summary>
+template<typename T>
+class SeqlockValue
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Values are copied a word at a time");
+
+public:
+    SeqlockValue(const T& value = T())
+    {
+        this->write(value);
+    }
+
+    /// <summary>
+    /// Replaces the value. Stores must not overlap each other.
+    /// </summary>
+    void store(const T& value)
+    {
+        uint64_t sequence = this->m_sequence.load(std::memory_order_relaxed);
+        this->m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        this->write(value);
+        this->m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Gets the latest whole value stored
+    /// </summary>
+    T load() const
+    {
+        std::array<uint64_t, m_wordCount> words;
+        while (true) {
+            uint64_t before = this->m_sequence.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                for (std::size_t i = 0; i < m_wordCount; ++i)
+                    words[i] = this->m_words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (this->m_sequence.load(std::memory_order_relaxed) == before)
+                    break;
+            }
+        }
+        // Through bytes, T can have member initialisers (so is not trivially default constructible) and GCC warns on a memcpy straight into it
+        std::array<unsigned char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), words.data(), sizeof(T));
+        T value{};
+        std::memcpy(reinterpret_cast<unsigned char*>(&value), bytes.data(), sizeof(T));
+        return value;
+    }
+
+    /// <summary>
+    /// Gets the number of stores, so a reader can tell cheaply whether the value has changed
+    /// </summary>
+    uint64_t getVersion() const
+    {
+        return this->m_sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    void write(const T& value)
+    {
+        std::array<uint64_t, m_wordCount> words = {};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < m_wordCount; ++i)
+            this->m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t m_wordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> m_sequence = 0;
+    std::array<std::atomic<uint64_t>, m_wordCount> m_words;
+};
@@ -26,9 +26,8 @@ EVRInitError ServerDriver::Init(IVRDriverContext* driver_context)
 		return init_error;
 	}
 
-    // Set start time point
-    this->m_timeDriverStart = std::chrono::system_clock::now();
-    
+    this->m_initTime = std::chrono::steady_clock::now();
+
     // Init driver log
     InitDriverLog(vr::VRDriverLog());
     DriverLog("==========================================================================\n");
@@ -44,7 +43,7 @@ EVRInitError ServerDriver::Init(IVRDriverContext* driver_context)
         config_path = SettingsUtilities::getMasslessConfigPath();
     }
     catch (const DriverSettingsException & e) {
-        DriverLog("[Error] Unable to load config file path due to [%d]: %s\n", e.code().value(), e.what());
+        DRIVER_LOG_ERROR(Settings, "Unable to load config file path due to [%d]: %s\n", e.code().value(), e.what());
         return EVRInitError::VRInitError_Init_NoConfigPath;
     }
 
@@ -52,7 +51,7 @@ EVRInitError ServerDriver::Init(IVRDriverContext* driver_context)
         m_settingsManager = std::make_shared<SettingsManager>(std::make_unique<FileSettingsLoader>(config_path));
     }
     catch (const DriverSettingsException& e) {
-        DriverLog("[Error] Unable to load config due to [%d]: %s\n", e.code().value(), e.what());
+        DRIVER_LOG_ERROR(Settings, "Unable to load config due to [%d]: %s\n", e.code().value(), e.what());
         return EVRInitError::VRInitError_Init_SettingsInitFailed;
     }
 
@@ -60,135 +59,15 @@ EVRInitError ServerDriver::Init(IVRDriverContext* driver_context)
         const auto& settingsKeys = DriverSettings::getKeys();
         for (auto it = settingsKeys.begin(); it != settingsKeys.end(); ++it) {
             if (!m_settingsManager->getSettings().isValid(it->first)) {
-                DriverLog("[Error] Setting [%s] is invalid\n", DriverSettings::getKeyString(it->first).c_str());
+                DRIVER_LOG_ERROR(Settings, "Setting [%s] is invalid\n", DriverSettings::getKeyString(it->first).c_str());
             }
         }
         return EVRInitError::VRInitError_Init_SettingsInitFailed;
     }
 
     // Attach gizmo if requested
-    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::AttachGizmo).value_or(false)) {
-        // Setup update function for tracking reference pose gizmo
-        auto tracking_ref_gizmo_update_fn = [](DebugGizmo* thiz) {
-            vr::DriverPose_t out_pose = { 0 };
-            if (auto ref_pose = ServerDriver::instance()->getTrackingReference(); ref_pose.has_value()) {
-
-                // Set up some default values that should be in every pose
-                out_pose.deviceIsConnected = true;
-                out_pose.poseIsValid = true;
-                out_pose.result = vr::ETrackingResult::TrackingResult_Running_OK;
-                out_pose.willDriftInYaw = false;
-                out_pose.shouldApplyHeadModel = false;
-                out_pose.qDriverFromHeadRotation.w = out_pose.qWorldFromDriverRotation.w = out_pose.qRotation.w = 1.0;
-
-
-                // Tracking reference pose in steamvr space
-                const Eigen::Quaternionf& tracking_ref_steamvr_space_rotation = ref_pose->global_pose.first;
-                const Eigen::Vector3f& tracking_ref_steamvr_space_translation = ref_pose->global_pose.second;
-
-                out_pose.qRotation.w = tracking_ref_steamvr_space_rotation.w();
-                out_pose.qRotation.x = tracking_ref_steamvr_space_rotation.x();
-                out_pose.qRotation.y = tracking_ref_steamvr_space_rotation.y();
-                out_pose.qRotation.z = tracking_ref_steamvr_space_rotation.z();
-
-                out_pose.vecPosition[0] = tracking_ref_steamvr_space_translation.x();
-                out_pose.vecPosition[1] = tracking_ref_steamvr_space_translation.y();
-                out_pose.vecPosition[2] = tracking_ref_steamvr_space_translation.z();
-            }
-
-            thiz->m_currentGizmoPose = out_pose;
-            vr::VRServerDriverHost()->TrackedDevicePoseUpdated(thiz->m_deviceIndex, thiz->m_currentGizmoPose, sizeof(vr::DriverPose_t));
-        };
-
-        this->tryAddDevice(std::make_unique<DebugGizmo>(this->m_settingsManager, tracking_ref_gizmo_update_fn), "tracking_ref_gizmo", vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference);
-    
-        // Setup update function for massless tracker pose gizmo (Copied straight out of PenController::makeOpenVRPose with a pen pose of (0,0,0)(1,0,0,0))
-        auto massless_tracker_gizmo_update_fn = [](DebugGizmo* thiz) {
-            vr::DriverPose_t out_pose = { 0 };
-            if (auto ref_pose = ServerDriver::instance()->getTrackingReference(); ref_pose.has_value()) {
-                // Set up some default values that should be in every pose
-                out_pose.deviceIsConnected = true;
-                out_pose.poseIsValid = true;
-                out_pose.result = vr::ETrackingResult::TrackingResult_Running_OK;
-                out_pose.willDriftInYaw = false;
-                out_pose.shouldApplyHeadModel = false;
-                out_pose.qDriverFromHeadRotation.w = out_pose.qWorldFromDriverRotation.w = out_pose.qRotation.w = 1.0;
-
-                /*
-                    Things to note here:
-                    1. The massless tracking space is defined as (looking toward the trackers) X left, Y down, Z toward you, Steamvr is defined as
-                       X right, Y up, Z toward you. When looking toward a lighthouse (and perhaps a rift camera also), X is left, Y is up, and z is away from you.
-                       (This is probably because the lighthouse model was made with z- pointing out the front of the glass, and it being spun to face you).
-                       To make these coordinate systems workable, we need to flip the massless coordinate system around the x axis by 180 degrees, so that now the massless
-                       tracker orientation is oriented with X left, Y up, and Z facing away from us (same orientation as the lighthouse)
-                    2. The pen is defined as X out of the tip, Z up, Y right (looking down the tip), steamvr defines its controllers orientations
-                       as Z- out of the tip, Y up, and X to the left (looking down the controller).
-                    3. The Massless API reports the offset (translation, and rotation to the described system above) from the tracking reference, to the Massless tracker's coord system.
-                       This is reported as a transformation in the Massless Tracker's frame of reference, to the origin point of the reference system. We then need to rotate this to
-                       match the orientation of the reference system.
-                    To account for these, we need to apply the transformations as shown below
-                */
-                constexpr float pi = 3.1415926f;
-
-                // Tracking reference pose in steamvr space
-                Eigen::Quaternionf tracking_ref_steamvr_space_rotation = ref_pose->global_pose.first;
-                const Eigen::Vector3f& tracking_ref_steamvr_space_translation = ref_pose->global_pose.second;
-
-                // Massless tracker pose (offset) from tracking reference.
-                const MasslessInterface::Pose& tracker_pose = ref_pose->pose_offset;
-
-                // Rotation #1
-                Eigen::Vector3f tracker_local_x_axis = tracking_ref_steamvr_space_rotation * Eigen::Vector3f(1, 0, 0);
-                Eigen::Quaternionf tracker_coordinate_to_steamvr_coordinate;
-                if (ref_pose->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER) {
-                    tracker_coordinate_to_steamvr_coordinate = Eigen::AngleAxisf(pi / 2.0f, tracker_local_x_axis);
-                }
-                else {
-                    tracker_coordinate_to_steamvr_coordinate = Eigen::AngleAxisf(pi, tracker_local_x_axis);
-                }
-                //
-
-                Eigen::Quaternionf tracker_ms_space_rotation = Eigen::Quaternion(tracker_pose.m_qr, tracker_pose.m_qx, tracker_pose.m_qy, tracker_pose.m_qz);
-                Eigen::Vector3f tracker_ms_space_translation = Eigen::Vector3f(tracker_pose.m_x, tracker_pose.m_y, tracker_pose.m_z);
-
-                //Eigen::Vector3f tracker_steamvr_space_translation = tracking_ref_steamvr_space_rotation * tracker_ms_space_translation;
-                //Eigen::Quaternionf tracker_steamvr_space_rotation = tracking_ref_steamvr_space_rotation * tracker_ms_space_rotation;
-
-                // Rotate the massless pen into the tracker's frame in the massless coordinate system, also translate it to the tracking reference's system.
-                Eigen::Vector3f pen_ms_space_translation = tracker_ms_space_rotation * Eigen::Vector3f(0, 0, 0) + tracker_ms_space_translation;
-                Eigen::Quaternionf pen_ms_space_rotation = tracker_ms_space_rotation * Eigen::Quaternionf(1, 0, 0, 0);
-
-                Eigen::Vector3f pen_steamvr_space_translation = tracking_ref_steamvr_space_rotation * pen_ms_space_translation;
-                Eigen::Quaternionf pen_steamvr_space_rotation = tracking_ref_steamvr_space_rotation * pen_ms_space_rotation;
-
-                // Rotation #2
-                Eigen::Vector3f local_x_axis = pen_steamvr_space_rotation * Eigen::Vector3f(1, 0, 0);
-                Eigen::Vector3f local_z_axis = pen_steamvr_space_rotation * Eigen::Vector3f(0, 0, 1);
-                pen_steamvr_space_rotation = tracker_coordinate_to_steamvr_coordinate * Eigen::AngleAxisf(-pi / 2, local_z_axis) * Eigen::AngleAxisf(pi / 2, local_x_axis) * pen_steamvr_space_rotation;
-                pen_steamvr_space_translation = tracker_coordinate_to_steamvr_coordinate * pen_steamvr_space_translation;
-                //
-                pen_steamvr_space_translation += tracking_ref_steamvr_space_translation;
-
-                out_pose.qRotation.w = pen_steamvr_space_rotation.w();
-                out_pose.qRotation.x = pen_steamvr_space_rotation.x();
-                out_pose.qRotation.y = pen_steamvr_space_rotation.y();
-                out_pose.qRotation.z = pen_steamvr_space_rotation.z();
-
-                out_pose.vecPosition[0] = pen_steamvr_space_translation.x();
-                out_pose.vecPosition[1] = pen_steamvr_space_translation.y();
-                out_pose.vecPosition[2] = pen_steamvr_space_translation.z();
-
-            }
-
-            thiz->m_currentGizmoPose = out_pose;
-            vr::VRServerDriverHost()->TrackedDevicePoseUpdated(thiz->m_deviceIndex, thiz->m_currentGizmoPose, sizeof(vr::DriverPose_t));
-        };
-    
-        this->tryAddDevice(std::make_unique<DebugGizmo>(this->m_settingsManager, massless_tracker_gizmo_update_fn), "massless_tracker_gizmo", vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference);
-
-    
-    
-    }
+    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::AttachGizmo).value_or(false))
+        this->addGizmos();
 
     // Check if we have either the forced_tracking_reference or the auto_tracking_reference set
     if (this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::ForcedTrackingRefSerial).has_value()) {
@@ -196,22 +75,82 @@ EVRInitError ServerDriver::Init(IVRDriverContext* driver_context)
         this->m_doLookForever = true;
         this->m_doRetryOnConnect = false;
         this->m_doRetryOnDisconnect = false;
-        DriverLog("[Info] Force attaching to tracking reference with serial [%s]\n", (*this->m_trackingReferenceSerialHint).c_str());
+        DRIVER_LOG_INFO(Reference, "Force attaching to tracking reference with serial [%s]\n", (*this->m_trackingReferenceSerialHint).c_str());
     }else if (this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::AutoTrackingRefSerial).has_value()) {
         this->m_trackingReferenceSerialHint = this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value();
         this->m_doLookForever = false;
         this->m_doRetryOnConnect = true;
         this->m_doRetryOnDisconnect = true;
-        DriverLog("[Info] Auto attaching to tracking reference with serial [%s]\n", (*this->m_trackingReferenceSerialHint).c_str());
+        DRIVER_LOG_INFO(Reference, "Auto attaching to tracking reference with serial [%s]\n", (*this->m_trackingReferenceSerialHint).c_str());
     }
 
-    DriverLog("[Info] Success!\n");
+    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableOffsetRefinement).value_or(false)) {
+        this->m_offsetRefiner = std::make_unique<OffsetRefiner>();
+        DRIVER_LOG_INFO(Reference, "Tracking reference offset refinement enabled.\n");
+    }
+
+    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnablePoseStream).value_or(false)) {
+        this->m_poseStream = PoseStreamWriter::create(PoseStream::default_name, PoseStream::default_capacity);
+        if (this->m_poseStream != nullptr)
+            DRIVER_LOG_INFO(Pose, "Publishing pen samples to shared memory [%s].\n", PoseStream::default_name);
+        else
+            DRIVER_LOG_WARN(Pose, "Unable to create shared memory [%s] for the pose stream.\n", PoseStream::default_name);
+    }
+
+    // Parameters that can be changed while running start from the settings file, changes are not written back to it
+    RuntimeParameters runtime_parameters;
+    runtime_parameters.detailed_logging = this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false);
+    runtime_parameters.reference_fusion = this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableReferenceFusion).value_or(false);
+    this->m_controlChannel = std::make_shared<ControlChannel>(runtime_parameters);
+    this->m_frameParametersVersion = this->m_controlChannel->getParametersVersion();
+    this->m_frameParameters = runtime_parameters;
+    this->m_controlChannel->setHandlers({
+        [this](std::string_view request) { return this->captureDebugRequest(request); },
+        [this](const std::optional<std::string>& serial) { return this->selectTrackingReference(serial); }
+    });
+    if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableControlSocket).value_or(false)) {
+        this->m_controlServer = ControlServer::create(this->m_controlChannel);
+        if (this->m_controlServer == nullptr)
+            DRIVER_LOG_WARN(General, "Unable to listen on the control socket [%s].\n", ControlServer::getDefaultAddress().c_str());
+    }
+
+    this->loadIntegrationKeys();
+    this->loadProfiles();
+    this->applyLogLevels();
+    this->m_poseTraces = std::make_unique<PoseTraceSwitcher>();
+    this->updatePoseTrace();
+
+    // Reload the settings when the file is edited, read and validated off the frame thread
+    this->m_settingsWatcher = std::make_unique<FileWatcher>(config_path,
+        [settings_manager = this->m_settingsManager, loader = std::make_shared<FileSettingsLoader>(config_path)]() { settings_manager->prepareReload(*loader); });
+    DRIVER_LOG_INFO(Settings, "Watching the settings file for changes (%s).\n", this->m_settingsWatcher->getBackendName());
+
+    // Load the last locked reference, it is only useful if it is the one we are about to look for
+    this->m_warmStartPath = WarmStartCache::getCachePath(config_path);
+    this->m_warmStart = WarmStartCache::load(this->m_warmStartPath);
+    if (this->m_warmStart.has_value() && this->m_trackingReferenceSerialHint != this->m_warmStart->device_serial)
+        this->m_warmStart = std::nullopt;
+    if (this->m_warmStart.has_value())
+        DRIVER_LOG_INFO(Reference, "Loaded warm start cache for tracking reference of type %s with serial [%s]\n", this->m_warmStart->type.getStringValue().c_str(), this->m_warmStart->device_serial.c_str());
+
+    DRIVER_LOG_INFO(General, "Success!\n");
     this->m_initSuccess = true;
+    this->publishDebugState();
 	return EVRInitError::VRInitError_None;
 }
 
 void ServerDriver::Cleanup()
 {
+    // Stop taking requests before the devices they would run against go away
+    this->m_controlServer.reset();
+    this->m_settingsWatcher.reset();
+    this->m_poseTraces.reset();
+
+    // Don't leave writes pending until the instance is destroyed at unload
+    if (this->m_settingsManager != nullptr)
+        this->m_settingsManager->flush();
+    this->m_warmStartWriter.flush();
+    CleanupDriverLog();
 }
 
 const char* const* ServerDriver::GetInterfaceVersions()
@@ -224,11 +163,22 @@ void ServerDriver::RunFrame()
     if (!this->m_initSuccess)
         return;
 
-    if (m_TrackingReferenceSearchCountdown > 0)--m_TrackingReferenceSearchCountdown;
+    ScopedTimer run_frame_timer(this->m_runFrameTiming);
+    auto power_mode = this->m_powerController.update();
+    ScopedTimer power_mode_timer(this->m_powerController.getFrameTiming(power_mode));
+    if (auto changed = this->m_settingsManager->applyReload(); !changed.empty())
+        this->onSettingsChanged(changed);
+    this->updateRuntimeParameters();
+    if (this->m_poseTraces != nullptr)
+        this->m_poseTraces->update();
 
     auto events = this->processEvents(vr::VRServerDriverHost(), vr::VRProperties());
+    this->m_poseSnapshot.capture(vr::VRServerDriverHost());
+    this->m_deviceDirectory.processEvents(events);
+    this->m_deviceDirectory.refresh(this->m_poseSnapshot, vr::VRProperties());
 
     // Get exclusive access to the pen system for this frame
+    this->m_penPosition = std::nullopt;
     auto pen_system_lock = this->m_masslessManager->getPenSystem();
     if (pen_system_lock.pen_system.has_value()) {
 
@@ -239,25 +189,33 @@ void ServerDriver::RunFrame()
         if (!hasSetupBackend) {
 
             auto driver_version = DriverVersion::m_driverVersion.to_string();
-            DriverLog("[Info] Massless Pen SteamVR Driver version v%s\n", driver_version.c_str());
-            DriverLog("[Info] Massless Pen DLL version v%s\n", pen_system->getDllVersionString().c_str());
+            DRIVER_LOG_INFO(Backend, "Massless Pen SteamVR Driver version v%s\n", driver_version.c_str());
+            DRIVER_LOG_INFO(Backend, "Massless Pen DLL version v%s\n", pen_system->getDllVersionString().c_str());
             if (DriverVersion::m_dllVersion != DriverVersion::asSemVer<uint64_t>(pen_system->getDllVersion())) {
-                DriverLog("[Warn] Massless dll version this driver was built against (%s) is different to the currently linked dll version (%s)\n", DriverVersion::m_dllVersion.to_string().c_str(), pen_system->getDllVersionString().c_str());
+                DRIVER_LOG_WARN(Backend, "Massless dll version this driver was built against (%s) is different to the currently linked dll version (%s)\n", DriverVersion::m_dllVersion.to_string().c_str(), pen_system->getDllVersionString().c_str());
+            }
+
+            // Published straight from the backend's callbacks, so readers get every sample rather than one per frame
+            if (this->m_poseStream != nullptr) {
+                std::shared_ptr<PoseStreamWriter> pose_stream = this->m_poseStream;
+                pen_system->setPoseCallback([pose_stream](MasslessInterface::Pose pose) { pose_stream->publishPose(pose); });
+                pen_system->setStateCallback([pose_stream](MasslessInterface::PenState state) { pose_stream->publishState(state); });
+                pen_system->setEventCallback([pose_stream](MasslessInterface::PenEvent event) { pose_stream->publishEvent(event.m_eventType); });
             }
 
             pen_system->setIntegrationKey(SettingsUtilities::getDefaultIntegrationKey());
             auto start_result = pen_system->startSystem();
             if (start_result.has_value()) {
-                DriverLog("[Warn] Massless Pen System failed to start with error [0x%X], attempting to force restart.\n", *start_result);
+                DRIVER_LOG_WARN(Backend, "Massless Pen System failed to start with error [0x%X], attempting to force restart.\n", *start_result);
                 auto restart_result = pen_system->stopSystem(true);
                 if (restart_result.has_value()) {
-                    DriverLog("[Error] Massless Pen System failed to stop with error [0x%X].\n", *restart_result);
+                    DRIVER_LOG_ERROR(Backend, "Massless Pen System failed to stop with error [0x%X].\n", *restart_result);
                     this->m_initSuccess = false;
                 }
                 else {
                     start_result = pen_system->startSystem(true);
                     if (start_result.has_value()) {
-                        DriverLog("[Error] Massless Pen System failed to start with error [0x%X].\n", *start_result);
+                        DRIVER_LOG_ERROR(Backend, "Massless Pen System failed to start with error [0x%X].\n", *start_result);
                         this->m_initSuccess = false;
                     }
                     else {
@@ -271,76 +229,73 @@ void ServerDriver::RunFrame()
 
             if (this->m_initSuccess) {
                 pen_system->setUnitScale(0.001);
-                DriverLog("[Info] Massless Pen System backend started successfully.\n");
+                DRIVER_LOG_INFO(Backend, "Massless Pen System backend started successfully.\n");
                 hasSetupBackend = true;
             }
         }
 
         if (hasSetupBackend) {
-
-            // If a new device is connected that is a higher priority tracking reference, clear the old one
-            //At the end of the count actually do the search (0 means don't count).
-            if (m_TrackingReferenceSearchCountdown == 1) {
-                DriverLog("Tracking reference search countdown finished, actually searching the list.\n");
-                auto indices = DriverAnalytics::firstPass(vr::VRServerDriverHost(), vr::VRProperties());
-                if (indices.size() > 0) {
-                    // New tracking reference that is different to our old one
-                    if ((this->m_trackingReferencePack.has_value() && this->m_trackingReferencePack->index != indices.at(0)) || !this->m_trackingReferencePack.has_value()) {
-                        this->setTrackingReference(std::nullopt);
-                    }
-                }
-            }
-                
             for (const auto& event : events) {
 
-                // If the application was changed
+                // If the application was changed, look up its name in the background (see below)
                 if (event.eventType == vr::EVREventType::VREvent_SceneApplicationChanged) {
-                    std::wstring processName = DriverAnalytics::getVRClientProcessName(event.data.process.pid).value_or(L"Unknown Process");
-
-                    std::stringstream s;
-                    const std::ctype<char>& ctfacet = std::use_facet<std::ctype<char>>(s.getloc());
-                    for (size_t i = 0; i < processName.size(); ++i)
-                        s << ctfacet.narrow(processName[i], 0);
-
-                    DriverLog("[Application Changed]: (%d) %s\n", event.data.process.pid, s.str().c_str());
-                    auto integrationKey = SettingsUtilities::getIntegrationKeyForApp(s.str()).value_or(SettingsUtilities::getDefaultIntegrationKey());
-
-                    std::stringstream key_str;
-                    for (auto v : integrationKey)
-                        key_str << "0x" << std::uppercase << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(v) << " ";
-                    
-                    if (auto err = pen_system->setIntegrationKey(integrationKey); err.has_value()) {
-                        DriverLog("Failed to change integration key with error [0x%X]\n", err.value());
-                    }
-                    else {
-                        DriverLog("Integration key changed: %s\n", key_str.str().c_str());
-                    }
+                    this->m_processNameResolver.request(event.data.process.pid);
                 }
 
-                //Start a count when we find the event
+                // Re-evaluate the tracking reference once newly activated devices have settled
                 if (event.eventType == vr::EVREventType::VREvent_TrackedDeviceActivated
                     || event.eventType == vr::EVREventType::VREvent_Input_TrackerActivated) {
-                    if (!this->m_doLookForever) {
-                        //Only restart the count, if we're not already counting
-                        //Start out with a 30 frame delay
-                        if (m_TrackingReferenceSearchCountdown == 0) {
-                            m_TrackingReferenceSearchCountdown = 300;
-                            DriverLog("Started tracking reference search countdown.\n");
-                        }
-                    }
+                    this->m_referenceSearch.onDeviceActivated(this->m_doRetryOnConnect);
                 }
 
-                // If a tracking reference was disconnected and we aren't quitting, clear the old one
+                // If the tracking reference was disconnected, wait for it to come back before searching for a new one
                 if (event.eventType == vr::EVREventType::VREvent_TrackedDeviceDeactivated) {
-                    if (!this->m_doLookForever && this->m_trackingReferencePack.has_value()) {
-                        auto pose = DriverAnalytics::getDevicePose(this->m_trackingReferencePack->index, vr::VRServerDriverHost());
+                    if (this->m_doRetryOnDisconnect && this->m_referenceSearch.getState() == TrackingReferenceSearch::State::Locked) {
+                        auto pose = DriverAnalytics::getDevicePose(this->m_trackingReferencePack->index, this->m_poseSnapshot);
                         if (!pose.has_value()) {
-                            this->m_didReferenceDisconnect = true;
-                            this->m_timeReferenceDisconnect = std::chrono::system_clock::now();
+                            DRIVER_LOG_INFO(Reference, "Tracking reference with serial [%s] was deactivated.\n", this->m_trackingReferencePack->device_serial.c_str());
+                            this->m_referenceSearch.onReferenceLost();
                         }
                     }
                 }
             }
+
+            // Switch the integration key once the new application's name has been resolved
+            if (auto application = this->m_processNameResolver.takeResult(); application.has_value()) {
+                std::wstring processName = application->name.value_or(L"Unknown Process");
+
+                std::stringstream s;
+                const std::ctype<char>& ctfacet = std::use_facet<std::ctype<char>>(s.getloc());
+                for (size_t i = 0; i < processName.size(); ++i)
+                    s << ctfacet.narrow(processName[i], 0);
+
+                DRIVER_LOG_INFO(Backend, "Application changed: (%lu) %s\n", application->pid, s.str().c_str());
+                this->m_currentApplication = s.str();
+                this->m_activeProfile = this->m_profileTable.find(this->m_currentApplication);
+                DRIVER_LOG_INFO(Pose, "Using pen profile [%s].\n", this->m_activeProfile->name.c_str());
+                auto integrationKey = this->m_integrationKeyTable.find(s.str()).value_or(SettingsUtilities::getDefaultIntegrationKey());
+
+                std::stringstream key_str;
+                for (auto v : integrationKey)
+                    key_str << "0x" << std::uppercase << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(v) << " ";
+
+                if (auto err = pen_system->setIntegrationKey(integrationKey); err.has_value()) {
+                    DRIVER_LOG_ERROR(Backend, "Failed to change integration key with error [0x%X]\n", err.value());
+                }
+                else {
+                    DRIVER_LOG_INFO(Backend, "Integration key changed: %s\n", key_str.str().c_str());
+                }
+            }
+        }
+
+        // Go active before anything is skipped this frame
+        if (hasSetupBackend && pen_system->isPenTracking())
+            this->m_powerController.onPenActivity();
+
+        // Where the pen tip is, for offset_observation requests (which can't use the pen system, see handleDebugRequest)
+        if (this->m_offsetRefiner != nullptr && hasSetupBackend && pen_system->isPenTracking()) {
+            MasslessInterface::Pose pen_pose = pen_system->getCurrentPose();
+            this->m_penPosition = Eigen::Vector3f(pen_pose.m_x, pen_pose.m_y, pen_pose.m_z);
         }
 
         // Wait until the pen is connected to poll for serial
@@ -350,18 +305,28 @@ void ServerDriver::RunFrame()
 
             // Initialise the pen controller
             if (serial.has_value()) {
-                this->m_hasAddedPen = this->tryAddDevice(std::make_unique<PenController>(this->m_settingsManager, this->m_masslessManager), "massless_pen_" + *serial, vr::ETrackedDeviceClass::TrackedDeviceClass_Controller);
+                auto pen = std::make_unique<PenController>(this->m_settingsManager, this->m_masslessManager);
+                IDriverDevice* pen_device = pen.get();
+                this->m_hasAddedPen = this->tryAddDevice(std::move(pen), "massless_pen_" + *serial, vr::ETrackedDeviceClass::TrackedDeviceClass_Controller);
+                if (this->m_hasAddedPen)
+                    this->m_penDevice = pen_device;
             }
         }
 
-        if (this->m_hasAddedPen) {
+        // Nothing needs a tracking reference while the pen is idle, so discovery and updates slow down to the work interval
+        if (this->m_hasAddedPen && this->m_powerController.isWorkDue()) {
             // Either find tracking reference, or update if vive tracker
+            ScopedTimer tracking_reference_timer(this->m_trackingReferenceTiming);
             this->updateTrackingReference(vr::VRServerDriverHost(), vr::VRProperties());
         }
     }
 
     for (auto&& device : this->m_devices)
         device.get()->update(events);
+
+    this->m_masslessManager->setPollInterval(this->m_powerController.getPollInterval());
+    this->publishDebugState();
+    this->updateControlChannel(power_mode);
 }
 
 bool ServerDriver::ShouldBlockStandbyMode()
@@ -371,10 +336,14 @@ bool ServerDriver::ShouldBlockStandbyMode()
 
 void ServerDriver::EnterStandby()
 {
+    this->m_powerController.enterStandby();
+    this->m_masslessManager->setPollInterval(this->m_powerController.getPollInterval());
 }
 
 void ServerDriver::LeaveStandby()
 {
+    this->m_powerController.leaveStandby();
+    this->m_masslessManager->setPollInterval(this->m_powerController.getPollInterval());
 }
 
 bool ServerDriver::tryAddDevice(std::unique_ptr<IDriverDevice> device, std::string serial, vr::ETrackedDeviceClass device_class, vr::IVRServerDriverHost* serverdriver_host)
@@ -396,9 +365,284 @@ std::optional<DriverAnalytics::TrackingReferencePack> ServerDriver::getTrackingR
     return this->m_trackingReferencePack;
 }
 
+std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> ServerDriver::getTrackingReferencePoseAt(std::chrono::system_clock::time_point time)
+{
+    if (this->m_referenceSearch.getState() != TrackingReferenceSearch::State::Locked || DriverAnalytics::isStaticReference(this->m_trackingReferencePack->type))
+        return std::nullopt;
+    return this->m_referenceHistory.sample(time);
+}
+
+std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> ServerDriver::getFusedPenPose(const MasslessInterface::Pose& pen_pose)
+{
+    if (this->m_referenceSearch.getState() != TrackingReferenceSearch::State::Locked)
+        return std::nullopt;
+    return this->m_referenceFusion.fuse(pen_pose);
+}
+
+void ServerDriver::handleDebugRequest(std::string_view command, std::string_view argument, DebugResponseWriter& writer, Span<const char* const> device_commands)
+{
+    this->m_debugState.read([&](const DebugState& state) {
+        writer.beginObject();
+        if (command == "tracking_reference") {
+            writer.field("found", state.tracking_reference.has_value());
+            if (state.tracking_reference.has_value()) {
+                const auto& pack = *state.tracking_reference;
+                writer.field("index", pack.index);
+                writer.field("serial", pack.device_serial);
+                writer.field("type", pack.type.getStringValue());
+                writer.key("position");
+                writer.beginArray();
+                writer.value(pack.global_pose.second.x());
+                writer.value(pack.global_pose.second.y());
+                writer.value(pack.global_pose.second.z());
+                writer.endArray();
+                writer.key("rotation");
+                writer.beginArray();
+                writer.value(pack.global_pose.first.w());
+                writer.value(pack.global_pose.first.x());
+                writer.value(pack.global_pose.first.y());
+                writer.value(pack.global_pose.first.z());
+                writer.endArray();
+                writer.key("offset_position");
+                writer.beginArray();
+                writer.value(pack.pose_offset.m_x);
+                writer.value(pack.pose_offset.m_y);
+                writer.value(pack.pose_offset.m_z);
+                writer.endArray();
+                writer.key("offset_rotation");
+                writer.beginArray();
+                writer.value(pack.pose_offset.m_qr);
+                writer.value(pack.pose_offset.m_qx);
+                writer.value(pack.pose_offset.m_qy);
+                writer.value(pack.pose_offset.m_qz);
+                writer.endArray();
+            }
+            writer.key("serial_hint");
+            if (state.serial_hint.has_value())
+                writer.value(*state.serial_hint);
+            else
+                writer.nullValue();
+            writer.field("look_forever", state.look_forever);
+            writer.field("search_state", TrackingReferenceSearch::getStateName(state.search_state));
+            writer.field("search_probes", state.search_probes);
+            writer.field("search_backoff_ms", static_cast<int64_t>(state.search_backoff.count()));
+            writer.field("next_probe_ms", static_cast<int64_t>(state.next_probe.count()));
+            writer.key("candidate");
+            if (state.candidate_serial.has_value())
+                writer.value(*state.candidate_serial);
+            else
+                writer.nullValue();
+            writer.field("directory_generation", state.directory_generation);
+            writer.field("directory_classifications", state.directory_classifications);
+            writer.key("candidates");
+            writer.beginArray();
+            for (auto index : state.candidates)
+                writer.value(index);
+            writer.endArray();
+            writer.key("health");
+            writer.beginObject();
+            writer.field("holding", state.health_holding);
+            writer.field("accepted", state.health.accepted);
+            writer.field("held", state.health.held);
+            writer.field("discontinuities", state.health.discontinuities);
+            writer.field("transients", state.health.transients);
+            writer.field("drifts", state.health.drifts);
+            writer.field("moves", state.health.moves);
+            writer.endObject();
+            writer.key("history");
+            writer.beginObject();
+            writer.field("samples", state.history_samples);
+            writer.field("interpolated", state.history.interpolated);
+            writer.field("extrapolated", state.history.extrapolated);
+            writer.field("out_of_range", state.history.out_of_range);
+            writer.endObject();
+            writer.key("candidate_scores");
+            writer.beginArray();
+            // One score per candidate, in the same order
+            for (std::size_t i = 0; i < state.candidates.size(); ++i) {
+                writer.beginObject();
+                writer.field("index", state.candidates[i]);
+                if (const auto& score = state.candidate_scores[i]; score.has_value()) {
+                    writer.field("score", score->score);
+                    writer.field("validity_rate", score->validity_rate);
+                    writer.field("jitter", score->jitter);
+                    writer.key("correlation");
+                    if (score->correlation.has_value())
+                        writer.value(*score->correlation);
+                    else
+                        writer.nullValue();
+                }
+                writer.endObject();
+            }
+            writer.endArray();
+            writer.field("fusion_composite_updates", state.fusion_composite_updates);
+            writer.key("fusion");
+            writer.beginArray();
+            for (const ReferenceFusion::Slot& slot : state.fusion) {
+                writer.beginObject();
+                writer.field("serial", slot.device_serial);
+                writer.field("weight", slot.weight);
+                writer.field("jitter", slot.jitter);
+                writer.field("rejected", slot.rejected);
+                writer.endObject();
+            }
+            writer.endArray();
+            writer.key("offset_refinement");
+            if (state.offset_refinement.has_value()) {
+                const OffsetRefiner::Metrics& refinement = *state.offset_refinement;
+                writer.beginObject();
+                writer.field("observations", refinement.observations);
+                writer.field("dropped", refinement.dropped);
+                writer.field("solves", refinement.solves);
+                writer.field("rejected", refinement.rejected);
+                writer.field("residual_mm", refinement.residual * 1000.0f);
+                writer.field("correction_mm", refinement.correction_distance * 1000.0f);
+                writer.field("correction_rad", refinement.correction_angle);
+                writer.endObject();
+            }
+            else {
+                writer.nullValue();
+            }
+        }
+        else if (command == "offset_observation") {
+            // The pen tip is on a known point of the tracking reference, given in the reference's frame. The pen position is the one published
+            // by the last frame: trying the pen system's lock from here would make the frame's own try fail, and the pen drop out for that frame.
+            // The refiner is only created in Init and queues observations under its own lock.
+            auto reference_point = DebugResponseWriter::parseVector3(argument);
+            if (this->m_offsetRefiner == nullptr)
+                writer.error("offset_refinement_disabled");
+            else if (!reference_point.has_value())
+                writer.error("expected_reference_point_xyz");
+            else if (state.search_state != TrackingReferenceSearch::State::Locked)
+                writer.error("no_tracking_reference");
+            else if (!state.pen_position.has_value())
+                writer.error("pen_not_tracking");
+            else {
+                const auto& point = *reference_point;
+                this->m_offsetRefiner->addObservation(*state.pen_position, Eigen::Vector3f(point[0], point[1], point[2]));
+                writer.field("queued", true);
+                writer.field("observations", this->m_offsetRefiner->getMetrics().observations);
+            }
+        }
+        else if (command == "settings") {
+            if (state.settings_available) {
+                for (const auto& [key, value] : state.settings) {
+                    writer.key(key);
+                    std::visit([&](const auto& setting_value) {
+                        using T = std::decay_t<decltype(setting_value)>;
+                        if constexpr (std::is_same_v<T, DriverSettings::invalid_setting_t>)
+                            writer.nullValue();
+                        else
+                            writer.value(setting_value);
+                    }, value);
+                }
+            }
+            else {
+                writer.error("settings_unavailable");
+            }
+        }
+        else if (command == "timings") {
+            writer.key("server_driver");
+            this->writeTimings(state, writer);
+        }
+        else {
+            writer.error("unknown_request");
+            writer.field("request", command);
+            writer.key("commands");
+            writer.beginArray();
+            for (const char* device_command : device_commands)
+                writer.value(device_command);
+            for (const char* known_command : { "tracking_reference", "settings", "timings", "offset_observation" })
+                writer.value(known_command);
+            writer.endArray();
+        }
+        writer.endObject();
+    });
+}
+
+void ServerDriver::writeTimings(DebugResponseWriter& writer) const
+{
+    this->m_debugState.read([&](const DebugState& state) { this->writeTimings(state, writer); });
+}
+
+void ServerDriver::writeTimings(const DebugState& state, DebugResponseWriter& writer) const
+{
+    writer.beginObject();
+    writer.field("run_frame_last_us", state.run_frame.last_us);
+    writer.field("run_frame_mean_us", state.run_frame.meanMicroseconds());
+    writer.field("run_frame_max_us", state.run_frame.max_us);
+    writer.field("run_frame_count", state.run_frame.count);
+    writer.field("tracking_reference_last_us", state.tracking_reference_timing.last_us);
+    writer.field("tracking_reference_mean_us", state.tracking_reference_timing.meanMicroseconds());
+    writer.field("tracking_reference_max_us", state.tracking_reference_timing.max_us);
+    writer.key("time_to_first_pose_ms");
+    if (state.time_to_first_pose.has_value())
+        writer.value(static_cast<int64_t>(state.time_to_first_pose->count()));
+    else
+        writer.nullValue();
+    writer.field("warm_start", state.warm_start);
+    writer.key("power");
+    writer.beginObject();
+    writer.field("mode", PowerController::getModeName(state.power_mode));
+    writer.field("poll_interval_ms", static_cast<int64_t>(this->m_masslessManager->getPollInterval().count()));
+    for (auto mode : { PowerController::Mode::Active, PowerController::Mode::Idle, PowerController::Mode::Standby }) {
+        const PowerController::ModeStats& stats = state.power_stats[static_cast<std::size_t>(mode)];
+        writer.key(PowerController::getModeName(mode));
+        writer.beginObject();
+        writer.field("entered", stats.entered);
+        writer.field("time_s", std::chrono::duration<double>(stats.time).count());
+        writer.field("frames", stats.frames.count);
+        writer.field("run_frame_mean_us", stats.frames.meanMicroseconds());
+        writer.field("cpu_percent", stats.cpuPercent());
+        writer.endObject();
+    }
+    writer.endObject();
+    writer.key("pose_trace");
+    if (state.pose_trace) {
+        writer.beginObject();
+        writer.field("path", state.pose_trace_path.u8string());
+        writer.field("recorded", state.pose_trace_recorded);
+        writer.field("dropped", state.pose_trace_dropped);
+        writer.endObject();
+    }
+    else {
+        writer.nullValue();
+    }
+    AsyncLogger::Stats log_stats = GetDriverLogStats();
+    writer.key("log");
+    writer.beginObject();
+    writer.field("written", log_stats.written);
+    writer.field("dropped", log_stats.dropped);
+    writer.field("suppressed", log_stats.suppressed);
+    writer.endObject();
+    IProcessWatcher::Metrics watcher_metrics = this->m_masslessManager->getProcessWatcherMetrics();
+    writer.key("pose_stream_published");
+    if (this->m_poseStream != nullptr)
+        writer.value(this->m_poseStream->getPublishedCount());
+    else
+        writer.nullValue();
+    writer.key("process_watcher");
+    writer.beginObject();
+    writer.field("backend", this->m_masslessManager->getProcessWatcherName());
+    writer.field("scans", watcher_metrics.scans.count);
+    writer.field("scan_mean_us", watcher_metrics.scans.meanMicroseconds());
+    writer.field("scan_max_us", watcher_metrics.scans.max_us);
+    writer.field("detection_latency_mean_us", watcher_metrics.detection_latency.meanMicroseconds());
+    writer.field("detection_latency_max_us", watcher_metrics.detection_latency.max_us);
+    writer.field("started", watcher_metrics.started);
+    writer.field("exited", watcher_metrics.exited);
+    writer.field("rescans", watcher_metrics.rescans);
+    writer.endObject();
+    writer.endObject();
+}
+
 ServerDriver::ServerDriver(std::shared_ptr<MasslessInterface::IPenSystem> pen_system)
 {
     this->m_masslessManager = std::make_shared<MasslessManager>(pen_system);
+    this->m_frameEvents.reserve(m_frameEventsReserve);
+    this->m_fusionReferences.reserve(ReferenceFusion::m_maxReferences);
+    this->m_scoringCandidates.reserve(vr::k_unMaxTrackedDeviceCount);
+    this->m_rankedCandidates.reserve(vr::k_unMaxTrackedDeviceCount);
 }
 
 const std::shared_ptr<ServerDriver> ServerDriver::create(std::shared_ptr<MasslessInterface::IPenSystem> pen_system)
@@ -412,113 +656,690 @@ void ServerDriver::updateTrackingReference(vr::IVRServerDriverHost* serverdriver
 {
     if (auto pen_system_lock = this->m_masslessManager->getPenSystem(); pen_system_lock.pen_system.has_value()) {
         auto pen_system = pen_system_lock.pen_system.value();
+        auto& search = this->m_referenceSearch;
+
+        if (search.getState() == TrackingReferenceSearch::State::Idle)
+            search.start();
 
-        // If the tracking reference has been disconnected for too long, reset it
-        if (this->m_didReferenceDisconnect && this->m_timeReferenceDisconnect + this->m_searchTimeout < std::chrono::system_clock::now()) {
-            this->m_didReferenceDisconnect = false;
-            if (!this->m_doLookForever) {
+        // Wait for a lost reference to come back (possibly at a new index), or give up on it
+        if (search.getState() == TrackingReferenceSearch::State::Lost) {
+            auto index = this->m_deviceDirectory.findIndex(this->m_trackingReferencePack->device_serial);
+            if (index.has_value() && this->m_poseSnapshot.getPose(*index).has_value()) {
+                this->m_trackingReferencePack->index = *index;
+                search.onReferenceRecovered();
+            }
+            else if (search.hasLostTimedOut()) {
+                DRIVER_LOG_INFO(Reference, "Tracking reference with serial [%s] did not come back, searching for a new one.\n", this->m_trackingReferencePack->device_serial.c_str());
                 this->setTrackingReference(std::nullopt);
+                search.restart();
             }
         }
 
-        // If we have already previously got a tracking reference pack
-        if (this->m_trackingReferencePack.has_value()) {
-            auto pose = DriverAnalytics::getDevicePose(this->m_trackingReferencePack->index, serverdriver_host);
-            if (pose.has_value() && !((this->m_trackingReferencePack->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT
-                || this->m_trackingReferencePack->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT)
-                && pose.value().second.isApprox(Eigen::Vector3f(0, 0, 0)))) {
-                this->m_trackingReferencePack->global_pose = *pose;
-                if (this->m_settingsManager->getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false))
-                    DriverLog("[Info] Tracking reference pose updated.\n");
+        if (search.getState() == TrackingReferenceSearch::State::Locked) {
+            // If a new device is connected that is a higher priority tracking reference, clear the old one
+            if (search.consumeReevaluation()) {
+                const auto& indices = this->m_deviceDirectory.getTrackingReferences();
+                if (!indices.empty() && this->m_trackingReferencePack->index != indices.front()) {
+                    DRIVER_LOG_INFO(Reference, "Higher priority tracking reference connected, searching again.\n");
+                    this->setTrackingReference(std::nullopt);
+                    search.restart();
+                }
             }
         }
-        else {
-            // Do we already know what we are looking for?
-            if (this->m_trackingReferenceSerialHint.has_value()) {
 
-                // Do we need to ignore our old suggestion and look for a new one?
-                if (!this->m_doLookForever && (this->m_timeDriverStart + this->m_searchTimeout) < std::chrono::system_clock::now()) {
-                    this->m_trackingReferenceSerialHint = std::nullopt;
-                    return;
+        // Update the locked reference's pose. Static references are checked for bumps first; trackers and controllers move legitimately.
+        if (search.getState() == TrackingReferenceSearch::State::Locked) {
+            auto pose = DriverAnalytics::getDevicePose(this->m_trackingReferencePack->index, this->m_poseSnapshot);
+            if (isUsableReferencePose(*this->m_trackingReferencePack, pose)) {
+                auto verdict = ReferenceHealthMonitor::Verdict::Accept;
+                if (DriverAnalytics::isStaticReference(this->m_trackingReferencePack->type))
+                    verdict = this->m_referenceHealth.observe(*pose);
+
+                if (verdict == ReferenceHealthMonitor::Verdict::Moved) {
+                    DRIVER_LOG_INFO(Reference, "Tracking reference with serial [%s] has moved, searching again.\n", this->m_trackingReferencePack->device_serial.c_str());
+                    this->setTrackingReference(std::nullopt);
+                    search.restart();
                 }
-
-                auto tracking_reference_pack = DriverAnalytics::secondPass(*this->m_trackingReferenceSerialHint, serverdriver_host, properties, pen_system);
-                if (tracking_reference_pack.has_value()) {
-                    DriverLog("[Info] Found forced tracking reference pose for device with serial [%s].\n", this->m_trackingReferenceSerialHint->c_str());
-                    this->setTrackingReference(tracking_reference_pack);
+                else if (verdict == ReferenceHealthMonitor::Verdict::Accept) {
+                    this->m_trackingReferencePack->global_pose = *pose;
+                    if (!DriverAnalytics::isStaticReference(this->m_trackingReferencePack->type))
+                        this->m_referenceHistory.push(std::chrono::system_clock::now(), *pose);
+                    DRIVER_LOG_DEBUG(Reference, "Tracking reference pose updated.\n");
                 }
             }
-            else {
-                // Else we dont know what we are looking for
-                auto indices = DriverAnalytics::firstPass(serverdriver_host, properties);
-                for (auto index : indices) {
-                    // Check if device is a rift S controller
-                    auto system_type = DriverAnalytics::getReferenceSystemType(index, properties);
-                    if (system_type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT
-                        || system_type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT) {
-
-                        // Check if our pen is left or right handed
-                        auto device_props = properties->TrackedDeviceToPropertyContainer(index);
-                        auto pen_handedness = Handedness(this->getSettingsManager()->getSettings().getValue<std::string>(DriverSettings::Handedness).value_or("invalid"));
-
-                        if (pen_handedness.value() == Handedness::LEFT) {
-                            // We need the left controller
-                            vr::ETrackedPropertyError err = vr::ETrackedPropertyError::TrackedProp_Success;
-                            auto controller_handedness = properties->GetInt32Property(device_props, vr::ETrackedDeviceProperty::Prop_ControllerRoleHint_Int32, &err);
-                            if (err != vr::ETrackedPropertyError::TrackedProp_Success)
-                                continue;
-                            if (controller_handedness == vr::ETrackedControllerRole::TrackedControllerRole_LeftHand) {
-                                auto tracking_reference_pack = DriverAnalytics::secondPass(index, serverdriver_host, properties, pen_system);
-                                if (tracking_reference_pack.has_value()) {
-                                    DriverLog("[Info] Found auto tracking reference of type %s.\n", tracking_reference_pack->type.getStringValue().c_str());
-                                    DriverLog("[Info] Found auto tracking reference pose for left Rift S controller with serial [%s].\n", tracking_reference_pack->device_serial.c_str());
-                                    this->setTrackingReference(tracking_reference_pack);
-                                    this->m_trackingReferenceSerialHint = tracking_reference_pack->device_serial;
-                                    break;
-                                }
-                            }
-                        }
-                        else if (pen_handedness.value() == Handedness::RIGHT) {
-                            // We need the right controller
-                            vr::ETrackedPropertyError err = vr::ETrackedPropertyError::TrackedProp_Success;
-                            auto controller_handedness = properties->GetInt32Property(device_props, vr::ETrackedDeviceProperty::Prop_ControllerRoleHint_Int32, &err);
-                            if (err != vr::ETrackedPropertyError::TrackedProp_Success)
-                                continue;
-                            if (controller_handedness == vr::ETrackedControllerRole::TrackedControllerRole_RightHand) {
-                                auto tracking_reference_pack = DriverAnalytics::secondPass(index, serverdriver_host, properties, pen_system);
-                                if (tracking_reference_pack.has_value()) {
-                                    DriverLog("[Info] Found auto tracking reference of type %s.\n", tracking_reference_pack->type.getStringValue().c_str());
-                                    DriverLog("[Info] Found auto tracking reference pose for right Rift S controller with serial [%s].\n", tracking_reference_pack->device_serial.c_str());
-                                    this->setTrackingReference(tracking_reference_pack);
-                                    this->m_trackingReferenceSerialHint = tracking_reference_pack->device_serial;
-                                    break;
-                                }
-                            }
-                        }
 
-                        // Otherwise we dont know the handedness of this controller, cant do anything
-                    }
-                    else { // otherwise do regular tracking reference logic
-                        auto tracking_reference_pack = DriverAnalytics::secondPass(index, serverdriver_host, properties, pen_system);
-                        if (tracking_reference_pack.has_value()) {
-                            DriverLog("[Info] Found auto tracking reference of type %s.\n", tracking_reference_pack->type.getStringValue().c_str());
-                            DriverLog("[Info] Found auto tracking reference pose for device with serial [%s].\n", tracking_reference_pack->device_serial.c_str());
-                            this->setTrackingReference(tracking_reference_pack);
-                            this->m_trackingReferenceSerialHint = tracking_reference_pack->device_serial;
-                            break;
-                        }
-                    }
+            // Ease on to the refined offset, if there is one
+            if (search.getState() == TrackingReferenceSearch::State::Locked && this->m_offsetRefiner != nullptr
+                && this->m_offsetRefiner->getDeviceSerial() == this->m_trackingReferencePack->device_serial)
+                this->m_trackingReferencePack->pose_offset = this->m_offsetRefiner->update();
+        }
+
+        // Lock on to the candidate once its pose has been valid for long enough
+        if (search.getState() == TrackingReferenceSearch::State::Validating) {
+            auto pose = DriverAnalytics::getDevicePose(this->m_candidatePack->index, this->m_poseSnapshot);
+            bool pose_valid = isUsableReferencePose(*this->m_candidatePack, pose);
+            if (pose_valid)
+                this->m_candidatePack->global_pose = *pose;
+
+            if (search.onCandidateValidated(pose_valid)) {
+                DRIVER_LOG_INFO(Reference, "Locked on to tracking reference of type %s with serial [%s].\n", this->m_candidatePack->type.getStringValue().c_str(), this->m_candidatePack->device_serial.c_str());
+                this->m_trackingReferenceSerialHint = this->m_candidatePack->device_serial;
+                this->m_referenceHealth.reset(this->m_candidatePack->global_pose);
+                this->m_referenceHistory.clear();
+                this->setTrackingReference(this->m_candidatePack);
+                this->saveWarmStart(*this->m_candidatePack);
+                this->m_candidatePack = std::nullopt;
+            }
+            else if (search.getState() == TrackingReferenceSearch::State::Searching) {
+                this->m_candidatePack = std::nullopt;
+                this->m_usingCachedOffset = false;
+            }
+        }
+
+        // A warm started reference uses the cached offset until the backend can give us the real one
+        if (search.getState() == TrackingReferenceSearch::State::Locked && this->m_usingCachedOffset) {
+            if (auto pose_offset = pen_system->getMasslessTrackerPoseOffset(this->m_trackingReferencePack->type); pose_offset.has_value()) {
+                if (*pose_offset != this->m_trackingReferencePack->pose_offset) {
+                    DRIVER_LOG_INFO(Reference, "Massless Tracker offset differs from the warm start cache, updating.\n");
+                    this->m_trackingReferencePack->pose_offset = *pose_offset;
+                    this->saveWarmStart(*this->m_trackingReferencePack);
                 }
+                if (this->m_offsetRefiner != nullptr)
+                    this->m_offsetRefiner->reset(*this->m_trackingReferencePack);
+                this->m_usingCachedOffset = false;
             }
         }
+
+        this->updateCandidateScores(pen_system);
+
+        // Probe for a candidate when the backoff allows
+        if (search.shouldProbe()) {
+            this->m_candidatePack = this->findWarmStartCandidate();
+            this->m_usingCachedOffset = this->m_warmStarted = this->m_candidatePack.has_value();
+            if (!this->m_candidatePack.has_value())
+                this->m_candidatePack = this->findTrackingReferenceCandidate(pen_system);
+            if (this->m_candidatePack.has_value())
+                search.onCandidateFound(this->m_usingCachedOffset);
+            else
+                search.onProbeFailed();
+        }
+
+        this->updateReferenceFusion();
+    }
+}
+
+std::optional<DriverAnalytics::TrackingReferencePack> ServerDriver::findTrackingReferenceCandidate(std::shared_ptr<MasslessInterface::IPenSystem> pen_system)
+{
+    // Do we already know what we are looking for?
+    if (this->m_trackingReferenceSerialHint.has_value()) {
+
+        // Do we need to ignore our old suggestion and look for a new one?
+        if (!this->m_doLookForever && this->m_referenceSearch.hasHintExpired()) {
+            DRIVER_LOG_INFO(Reference, "Tracking reference with serial [%s] not found, searching for any tracking reference.\n", this->m_trackingReferenceSerialHint->c_str());
+            this->m_trackingReferenceSerialHint = std::nullopt;
+        }
+        else {
+            auto tracking_reference_pack = DriverAnalytics::secondPass(*this->m_trackingReferenceSerialHint, this->m_deviceDirectory, this->m_poseSnapshot, pen_system);
+            if (tracking_reference_pack.has_value())
+                DRIVER_LOG_INFO(Reference, "Found forced tracking reference pose for device with serial [%s].\n", this->m_trackingReferenceSerialHint->c_str());
+            return tracking_reference_pack;
+        }
     }
 
+    // Else we dont know what we are looking for, so wait until every candidate has been watched for long enough and try the best first
+    const auto& indices = this->m_deviceDirectory.getTrackingReferences();
+    if (!this->m_candidateScorer.isReady(indices))
+        return std::nullopt;
+    this->m_candidateScorer.rank(indices, this->m_rankedCandidates);
+    for (auto index : this->m_rankedCandidates) {
+        // Check if device is a rift S controller
+        const TrackedDeviceDirectory::DeviceEntry* device_entry = this->m_deviceDirectory.getEntry(index);
+        auto system_type = device_entry->type;
+        if (system_type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT
+            || system_type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT) {
+
+            // Check if our pen is left or right handed, we need the controller in the other hand
+            auto pen_handedness = Handedness(this->getSettingsManager()->getSettings().getValue<std::string>(DriverSettings::Handedness).value_or("invalid"));
+            vr::ETrackedControllerRole wanted_role;
+            if (pen_handedness.value() == Handedness::LEFT)
+                wanted_role = vr::ETrackedControllerRole::TrackedControllerRole_LeftHand;
+            else if (pen_handedness.value() == Handedness::RIGHT)
+                wanted_role = vr::ETrackedControllerRole::TrackedControllerRole_RightHand;
+            else
+                continue;
+
+            // Otherwise we dont know the handedness of this controller, cant do anything
+            if (!device_entry->controller_role.has_value() || *device_entry->controller_role != wanted_role)
+                continue;
+
+            auto tracking_reference_pack = DriverAnalytics::secondPass(index, this->m_deviceDirectory, this->m_poseSnapshot, pen_system);
+            if (tracking_reference_pack.has_value()) {
+                DRIVER_LOG_INFO(Reference, "Found auto tracking reference of type %s.\n", tracking_reference_pack->type.getStringValue().c_str());
+                DRIVER_LOG_INFO(Reference, "Found auto tracking reference pose for %s Rift S controller with serial [%s].\n", wanted_role == vr::ETrackedControllerRole::TrackedControllerRole_LeftHand ? "left" : "right", tracking_reference_pack->device_serial.c_str());
+                return tracking_reference_pack;
+            }
+        }
+        else { // otherwise do regular tracking reference logic
+            auto tracking_reference_pack = DriverAnalytics::secondPass(index, this->m_deviceDirectory, this->m_poseSnapshot, pen_system);
+            if (tracking_reference_pack.has_value()) {
+                DRIVER_LOG_INFO(Reference, "Found auto tracking reference of type %s.\n", tracking_reference_pack->type.getStringValue().c_str());
+                DRIVER_LOG_INFO(Reference, "Found auto tracking reference pose for device with serial [%s].\n", tracking_reference_pack->device_serial.c_str());
+                return tracking_reference_pack;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<DriverAnalytics::TrackingReferencePack> ServerDriver::findWarmStartCandidate()
+{
+    if (!this->m_warmStart.has_value())
+        return std::nullopt;
+    if (this->m_trackingReferenceSerialHint != this->m_warmStart->device_serial) {
+        this->m_warmStart = std::nullopt;
+        return std::nullopt;
+    }
+
+    // Not reported yet, keep waiting for it until the serial hint expires
+    auto index = this->m_deviceDirectory.findIndex(this->m_warmStart->device_serial);
+    if (!index.has_value())
+        return std::nullopt;
+    const TrackedDeviceDirectory::DeviceEntry* entry = this->m_deviceDirectory.getEntry(*index);
+    auto pose = this->m_poseSnapshot.getPose(*index);
+    if (entry == nullptr || !entry->classified || !pose.has_value())
+        return std::nullopt;
+
+    WarmStartCache::Entry cached = std::move(*this->m_warmStart);
+    this->m_warmStart = std::nullopt;
+    if (!WarmStartCache::matches(cached, entry->serial, entry->type, *pose)) {
+        DRIVER_LOG_INFO(Reference, "Tracking reference with serial [%s] no longer matches the warm start cache, ignoring it.\n", cached.device_serial.c_str());
+        return std::nullopt;
+    }
+
+    DRIVER_LOG_INFO(Reference, "Found tracking reference with serial [%s] from the warm start cache.\n", cached.device_serial.c_str());
+    return DriverAnalytics::TrackingReferencePack(*index, entry->serial, entry->type, *pose, cached.pose_offset);
+}
+
+void ServerDriver::onValidPenPose()
+{
+    if (this->m_timeToFirstPose.has_value())
+        return;
+    this->m_timeToFirstPose = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->m_initTime);
+    DRIVER_LOG_INFO(Pose, "Time to first valid pen pose: %lld ms (%s start).\n", static_cast<long long>(this->m_timeToFirstPose->count()), this->m_warmStarted ? "warm" : "cold");
+}
+
+PowerController& ServerDriver::getPowerController()
+{
+    return this->m_powerController;
+}
+
+bool ServerDriver::isUsableReferencePose(const DriverAnalytics::TrackingReferencePack& pack, const std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>>& pose)
+{
+    if (!pose.has_value())
+        return false;
+    // Rift S/Quest controllers report a zero position while they aren't tracking
+    bool is_controller = pack.type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT
+        || pack.type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT;
+    return !(is_controller && pose->second.isApprox(Eigen::Vector3f(0, 0, 0)));
+}
+
+void ServerDriver::updateCandidateScores(std::shared_ptr<MasslessInterface::IPenSystem> pen_system)
+{
+    auto state = this->m_referenceSearch.getState();
+    if (state != TrackingReferenceSearch::State::Searching && state != TrackingReferenceSearch::State::Validating) {
+        this->m_candidateScorer.clear();
+        return;
+    }
+
+    std::optional<Eigen::Vector3f> pen_position;
+    if (pen_system->isSystemRunning() && pen_system->isPenTracking()) {
+        MasslessInterface::Pose pen_pose = pen_system->getCurrentPose();
+        pen_position = Eigen::Vector3f(pen_pose.m_x, pen_pose.m_y, pen_pose.m_z);
+    }
+
+    this->m_scoringCandidates.clear();
+    for (auto index : this->m_deviceDirectory.getTrackingReferences()) {
+        const TrackedDeviceDirectory::DeviceEntry* entry = this->m_deviceDirectory.getEntry(index);
+        bool is_controller = entry->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_RIGHT
+            || entry->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT;
+        this->m_scoringCandidates.push_back({ index, this->m_poseSnapshot.getPose(index), is_controller });
+    }
+    this->m_candidateScorer.update(pen_position, this->m_scoringCandidates);
+}
+
+void ServerDriver::updateReferenceFusion()
+{
+    if (!this->m_frameParameters.reference_fusion || this->m_referenceSearch.getState() != TrackingReferenceSearch::State::Locked || !ReferenceFusion::isFusable(this->m_trackingReferencePack->type)) {
+        this->m_referenceFusion.clear();
+        return;
+    }
+
+    // Offsets are per reference type, so only fuse references of the same type as the locked one
+    const DriverAnalytics::TrackingReferencePack& primary = *this->m_trackingReferencePack;
+    this->m_fusionReferences.clear();
+    for (auto index : this->m_deviceDirectory.getTrackingReferences()) {
+        if (index == primary.index)
+            continue;
+        const TrackedDeviceDirectory::DeviceEntry* entry = this->m_deviceDirectory.getEntry(index);
+        if (entry == nullptr || entry->type.getSystemType() != primary.type.getSystemType())
+            continue;
+        if (auto pose = this->m_poseSnapshot.getPose(index); pose.has_value())
+            this->m_fusionReferences.push_back({ index, entry->serial, *pose });
+    }
+    this->m_referenceFusion.update(primary, this->m_fusionReferences);
+}
+
+void ServerDriver::addGizmos()
+{
+    if (this->m_hasAddedGizmos)
+        return;
+    this->m_hasAddedGizmos = true;
+
+    // Setup update function for tracking reference pose gizmo
+    auto tracking_ref_gizmo_update_fn = [](DebugGizmo* thiz) {
+        vr::DriverPose_t out_pose = { 0 };
+        if (auto ref_pose = ServerDriver::instance()->getTrackingReference(); ref_pose.has_value()) {
+
+            // Set up some default values that should be in every pose
+            out_pose.deviceIsConnected = true;
+            out_pose.poseIsValid = true;
+            out_pose.result = vr::ETrackingResult::TrackingResult_Running_OK;
+            out_pose.willDriftInYaw = false;
+            out_pose.shouldApplyHeadModel = false;
+            out_pose.qDriverFromHeadRotation.w = out_pose.qWorldFromDriverRotation.w = out_pose.qRotation.w = 1.0;
+
+
+            // Tracking reference pose in steamvr space
+            const Eigen::Quaternionf& tracking_ref_steamvr_space_rotation = ref_pose->global_pose.first;
+            const Eigen::Vector3f& tracking_ref_steamvr_space_translation = ref_pose->global_pose.second;
+
+            out_pose.qRotation.w = tracking_ref_steamvr_space_rotation.w();
+            out_pose.qRotation.x = tracking_ref_steamvr_space_rotation.x();
+            out_pose.qRotation.y = tracking_ref_steamvr_space_rotation.y();
+            out_pose.qRotation.z = tracking_ref_steamvr_space_rotation.z();
+
+            out_pose.vecPosition[0] = tracking_ref_steamvr_space_translation.x();
+            out_pose.vecPosition[1] = tracking_ref_steamvr_space_translation.y();
+            out_pose.vecPosition[2] = tracking_ref_steamvr_space_translation.z();
+        }
+
+        thiz->m_currentGizmoPose = out_pose;
+        vr::VRServerDriverHost()->TrackedDevicePoseUpdated(thiz->m_deviceIndex, thiz->m_currentGizmoPose, sizeof(vr::DriverPose_t));
+    };
+
+    this->tryAddDevice(std::make_unique<DebugGizmo>(this->m_settingsManager, tracking_ref_gizmo_update_fn), "tracking_ref_gizmo", vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference);
+
+    // Setup update function for massless tracker pose gizmo (Copied straight out of PenController::makeOpenVRPose with a pen pose of (0,0,0)(1,0,0,0))
+    auto massless_tracker_gizmo_update_fn = [](DebugGizmo* thiz) {
+        vr::DriverPose_t out_pose = { 0 };
+        if (auto ref_pose = ServerDriver::instance()->getTrackingReference(); ref_pose.has_value()) {
+            // Set up some default values that should be in every pose
+            out_pose.deviceIsConnected = true;
+            out_pose.poseIsValid = true;
+            out_pose.result = vr::ETrackingResult::TrackingResult_Running_OK;
+            out_pose.willDriftInYaw = false;
+            out_pose.shouldApplyHeadModel = false;
+            out_pose.qDriverFromHeadRotation.w = out_pose.qWorldFromDriverRotation.w = out_pose.qRotation.w = 1.0;
+
+            /*
+                Things to note here:
+                1. The massless tracking space is defined as (looking toward the trackers) X left, Y down, Z toward you, Steamvr is defined as
+                   X right, Y up, Z toward you. When looking toward a lighthouse (and perhaps a rift camera also), X is left, Y is up, and z is away from you.
+                   (This is probably because the lighthouse model was made with z- pointing out the front of the glass, and it being spun to face you).
+                   To make these coordinate systems workable, we need to flip the massless coordinate system around the x axis by 180 degrees, so that now the massless
+                   tracker orientation is oriented with X left, Y up, and Z facing away from us (same orientation as the lighthouse)
+                2. The pen is defined as X out of the tip, Z up, Y right (looking down the tip), steamvr defines its controllers orientations
+                   as Z- out of the tip, Y up, and X to the left (looking down the controller).
+                3. The Massless API reports the offset (translation, and rotation to the described system above) from the tracking reference, to the Massless tracker's coord system.
+                   This is reported as a transformation in the Massless Tracker's frame of reference, to the origin point of the reference system. We then need to rotate this to
+                   match the orientation of the reference system.
+                To account for these, we need to apply the transformations as shown below
+            */
+            constexpr float pi = 3.1415926f;
+
+            // Tracking reference pose in steamvr space
+            Eigen::Quaternionf tracking_ref_steamvr_space_rotation = ref_pose->global_pose.first;
+            const Eigen::Vector3f& tracking_ref_steamvr_space_translation = ref_pose->global_pose.second;
+
+            // Massless tracker pose (offset) from tracking reference.
+            const MasslessInterface::Pose& tracker_pose = ref_pose->pose_offset;
+
+            // Rotation #1
+            Eigen::Vector3f tracker_local_x_axis = tracking_ref_steamvr_space_rotation * Eigen::Vector3f(1, 0, 0);
+            Eigen::Quaternionf tracker_coordinate_to_steamvr_coordinate;
+            if (ref_pose->type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER) {
+                tracker_coordinate_to_steamvr_coordinate = Eigen::AngleAxisf(pi / 2.0f, tracker_local_x_axis);
+            }
+            else {
+                tracker_coordinate_to_steamvr_coordinate = Eigen::AngleAxisf(pi, tracker_local_x_axis);
+            }
+            //
+
+            Eigen::Quaternionf tracker_ms_space_rotation = Eigen::Quaternion(tracker_pose.m_qr, tracker_pose.m_qx, tracker_pose.m_qy, tracker_pose.m_qz);
+            Eigen::Vector3f tracker_ms_space_translation = Eigen::Vector3f(tracker_pose.m_x, tracker_pose.m_y, tracker_pose.m_z);
+
+            //Eigen::Vector3f tracker_steamvr_space_translation = tracking_ref_steamvr_space_rotation * tracker_ms_space_translation;
+            //Eigen::Quaternionf tracker_steamvr_space_rotation = tracking_ref_steamvr_space_rotation * tracker_ms_space_rotation;
+
+            // Rotate the massless pen into the tracker's frame in the massless coordinate system, also translate it to the tracking reference's system.
+            Eigen::Vector3f pen_ms_space_translation = tracker_ms_space_rotation * Eigen::Vector3f(0, 0, 0) + tracker_ms_space_translation;
+            Eigen::Quaternionf pen_ms_space_rotation = tracker_ms_space_rotation * Eigen::Quaternionf(1, 0, 0, 0);
+
+            Eigen::Vector3f pen_steamvr_space_translation = tracking_ref_steamvr_space_rotation * pen_ms_space_translation;
+            Eigen::Quaternionf pen_steamvr_space_rotation = tracking_ref_steamvr_space_rotation * pen_ms_space_rotation;
+
+            // Rotation #2
+            Eigen::Vector3f local_x_axis = pen_steamvr_space_rotation * Eigen::Vector3f(1, 0, 0);
+            Eigen::Vector3f local_z_axis = pen_steamvr_space_rotation * Eigen::Vector3f(0, 0, 1);
+            pen_steamvr_space_rotation = tracker_coordinate_to_steamvr_coordinate * Eigen::AngleAxisf(-pi / 2, local_z_axis) * Eigen::AngleAxisf(pi / 2, local_x_axis) * pen_steamvr_space_rotation;
+            pen_steamvr_space_translation = tracker_coordinate_to_steamvr_coordinate * pen_steamvr_space_translation;
+            //
+            pen_steamvr_space_translation += tracking_ref_steamvr_space_translation;
+
+            out_pose.qRotation.w = pen_steamvr_space_rotation.w();
+            out_pose.qRotation.x = pen_steamvr_space_rotation.x();
+            out_pose.qRotation.y = pen_steamvr_space_rotation.y();
+            out_pose.qRotation.z = pen_steamvr_space_rotation.z();
+
+            out_pose.vecPosition[0] = pen_steamvr_space_translation.x();
+            out_pose.vecPosition[1] = pen_steamvr_space_translation.y();
+            out_pose.vecPosition[2] = pen_steamvr_space_translation.z();
+
+        }
+
+        thiz->m_currentGizmoPose = out_pose;
+        vr::VRServerDriverHost()->TrackedDevicePoseUpdated(thiz->m_deviceIndex, thiz->m_currentGizmoPose, sizeof(vr::DriverPose_t));
+    };
+
+    this->tryAddDevice(std::make_unique<DebugGizmo>(this->m_settingsManager, massless_tracker_gizmo_update_fn), "massless_tracker_gizmo", vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference);
+}
+
+void ServerDriver::loadIntegrationKeys()
+{
+    // Compiled once per load, bad entries are skipped rather than failing the whole setting
+    this->m_integrationKeyTable = IntegrationKeyTable();
+    if (auto integration_keys = this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::IntegrationKeys); integration_keys.has_value()) {
+        auto parsed = IntegrationKeyTable::parse(*integration_keys);
+        for (const auto& error : parsed.errors)
+            DRIVER_LOG_WARN(Settings, "Ignoring integration key: %s\n", error.c_str());
+        this->m_integrationKeyTable = IntegrationKeyTable(parsed.entries);
+        DRIVER_LOG_INFO(Settings, "Loaded %zu integration keys from settings.\n", this->m_integrationKeyTable.size());
+    }
+}
+
+void ServerDriver::loadProfiles()
+{
+    this->m_profileTable = PenProfileTable();
+    if (auto profiles = this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::ApplicationProfiles); profiles.has_value()) {
+        auto parsed = PenProfileTable::parse(*profiles);
+        for (const auto& error : parsed.errors)
+            DRIVER_LOG_WARN(Settings, "Ignoring application profile: %s\n", error.c_str());
+        this->m_profileTable = PenProfileTable(parsed.entries);
+        DRIVER_LOG_INFO(Settings, "Loaded %zu application profiles from settings.\n", this->m_profileTable.size());
+    }
+
+    // The application keeps running, so its profile is swapped straight away
+    this->m_activeProfile = this->m_profileTable.find(this->m_currentApplication);
+}
+
+void ServerDriver::applyLogLevels()
+{
+    LogLevel default_level = this->m_frameParameters.detailed_logging ? LogLevel::Debug : LogFilter::m_defaultLevel;
+    std::array<LogLevel, LogFilter::m_categoryCount> levels;
+    levels.fill(default_level);
+    if (auto log_levels = this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::LogLevels); log_levels.has_value()) {
+        auto parsed = LogFilter::parse(*log_levels);
+        for (const auto& error : parsed.errors)
+            DRIVER_LOG_WARN(Settings, "Ignoring log level: %s\n", error.c_str());
+        for (auto [category, level] : parsed.levels)
+            levels[static_cast<std::size_t>(category)] = level;
+    }
+
+    for (std::size_t category = 0; category < LogFilter::m_categoryCount; ++category)
+        LogFilter::setLevel(static_cast<LogCategory>(category), levels[category]);
+}
+
+void ServerDriver::updatePoseTrace()
+{
+    // Setting the same file again starts a new trace, the one in progress is closed first
+    auto path = this->m_settingsManager->getSettings().getValue<std::string>(DriverSettings::PoseTraceFile);
+    if (path.has_value() && !path->empty())
+        this->m_poseTraces->request(std::filesystem::u8path(*path));
+    else
+        this->m_poseTraces->request(std::nullopt);
+}
+
+void ServerDriver::onSettingsChanged(const std::vector<DriverSettings::Setting>& changed)
+{
+    const DriverSettings& settings = this->m_settingsManager->getSettings();
+    for (auto setting : changed) {
+        switch (setting) {
+        case DriverSettings::EnableDetailedLogging:
+        case DriverSettings::EnableReferenceFusion:
+            // Through the runtime parameters, which the frame picks up next
+            this->m_controlChannel->updateParameters([&settings](RuntimeParameters& parameters) {
+                parameters.detailed_logging = settings.getValue<bool>(DriverSettings::EnableDetailedLogging).value_or(false);
+                parameters.reference_fusion = settings.getValue<bool>(DriverSettings::EnableReferenceFusion).value_or(false);
+            });
+            break;
+        case DriverSettings::ForcedTrackingRefSerial: {
+            auto serial = settings.getValue<std::string>(DriverSettings::ForcedTrackingRefSerial);
+            this->m_doRetryOnConnect = !serial.has_value();
+            this->m_doRetryOnDisconnect = !serial.has_value();
+            this->selectTrackingReference(serial);
+            break;
+        }
+        case DriverSettings::AttachGizmo:
+            // SteamVR has no way to remove a device, so they stay until it restarts
+            if (settings.getValue<bool>(DriverSettings::AttachGizmo).value_or(false))
+                this->addGizmos();
+            else if (this->m_hasAddedGizmos)
+                DRIVER_LOG_INFO(Settings, "Gizmos will be removed when SteamVR restarts.\n");
+            break;
+        case DriverSettings::IntegrationKeys:
+            // Used from the next application change
+            this->loadIntegrationKeys();
+            break;
+        case DriverSettings::ApplicationProfiles:
+            this->loadProfiles();
+            break;
+        case DriverSettings::LogLevels:
+            this->applyLogLevels();
+            break;
+        case DriverSettings::PoseTraceFile:
+            this->updatePoseTrace();
+            break;
+        case DriverSettings::Handedness:
+            break;  // See PenController::onSettingsChanged
+        default:
+            DRIVER_LOG_INFO(Settings, "Setting [%s] changed, it takes effect when SteamVR restarts.\n", DriverSettings::getKeyString(setting).c_str());
+            break;
+        }
+    }
+
+    for (auto&& device : this->m_devices)
+        device->onSettingsChanged(changed);
+    DRIVER_LOG_INFO(Settings, "Reloaded settings, %zu changed.\n", changed.size());
+}
+
+void ServerDriver::updateRuntimeParameters()
+{
+    // A single atomic load when nothing has changed
+    uint64_t version = this->m_controlChannel->getParametersVersion();
+    if (version == this->m_frameParametersVersion)
+        return;
+    this->m_frameParametersVersion = version;
+    this->m_frameParameters = this->m_controlChannel->getParameters();
+
+    ReferenceFusion::Options fusion_options = this->m_referenceFusion.getOptions();
+    fusion_options.outlier_distance = this->m_frameParameters.fusion_outlier_distance;
+    fusion_options.jitter_smoothing = this->m_frameParameters.fusion_jitter_smoothing;
+    fusion_options.reenroll_frames = this->m_frameParameters.fusion_reenroll_frames;
+    this->m_referenceFusion.setOptions(fusion_options);
+    this->applyLogLevels();
+    DRIVER_LOG_INFO(General, "Runtime parameters changed (version %llu).\n", static_cast<unsigned long long>(version));
+}
+
+void ServerDriver::updateControlChannel(PowerController::Mode power_mode)
+{
+    this->m_controlChannel->runPending();
+
+    ControlTelemetry telemetry;
+    telemetry.frame = this->m_runFrameTiming.count + 1;  // This frame hasn't been recorded yet
+    telemetry.pen_added = this->m_penDevice != nullptr;
+    if (this->m_penDevice != nullptr) {
+        vr::DriverPose_t pose = this->m_penDevice->GetPose();
+        telemetry.pose_valid = pose.poseIsValid;
+        telemetry.tracking_result = static_cast<int32_t>(pose.result);
+        std::copy(std::begin(pose.vecPosition), std::end(pose.vecPosition), telemetry.position);
+        telemetry.rotation[0] = pose.qRotation.w;
+        telemetry.rotation[1] = pose.qRotation.x;
+        telemetry.rotation[2] = pose.qRotation.y;
+        telemetry.rotation[3] = pose.qRotation.z;
+    }
+    telemetry.reference_locked = this->m_referenceSearch.getState() == TrackingReferenceSearch::State::Locked;
+    telemetry.run_frame_mean_us = this->m_runFrameTiming.meanMicroseconds();
+    telemetry.power_mode = PowerController::getModeName(power_mode);
+    telemetry.ownership = MasslessManager::getOwnershipName(this->m_masslessManager->getOwnership());
+    this->m_controlChannel->publishTelemetry(telemetry);
+}
+
+void ServerDriver::publishDebugState()
+{
+    DebugState& state = this->m_debugState.getBack();
+    state.tracking_reference = this->m_trackingReferencePack;
+    state.serial_hint = this->m_trackingReferenceSerialHint;
+    state.look_forever = this->m_doLookForever;
+    state.search_state = this->m_referenceSearch.getState();
+    state.search_probes = this->m_referenceSearch.getProbeCount();
+    state.search_backoff = this->m_referenceSearch.getBackoff();
+    state.next_probe = this->m_referenceSearch.getTimeUntilProbe();
+    if (this->m_candidatePack.has_value())
+        state.candidate_serial = this->m_candidatePack->device_serial;
+    else
+        state.candidate_serial = std::nullopt;
+    state.directory_generation = this->m_deviceDirectory.getGeneration();
+    state.directory_classifications = this->m_deviceDirectory.getClassificationCount();
+    state.candidates = this->m_deviceDirectory.getTrackingReferences();
+    state.candidate_scores.resize(state.candidates.size());
+    for (std::size_t i = 0; i < state.candidates.size(); ++i)
+        state.candidate_scores[i] = this->m_candidateScorer.getScore(state.candidates[i]);
+    state.health_holding = this->m_referenceHealth.isHolding();
+    state.health = this->m_referenceHealth.getMetrics();
+    state.history_samples = this->m_referenceHistory.size();
+    state.history = this->m_referenceHistory.getMetrics();
+    state.fusion_composite_updates = this->m_referenceFusion.getCompositeUpdateCount();
+    Span<const ReferenceFusion::Slot> fusion_slots = this->m_referenceFusion.getSlots();
+    state.fusion.assign(fusion_slots.begin(), fusion_slots.end());
+    state.pen_position = this->m_penPosition;
+    if (this->m_offsetRefiner != nullptr)
+        state.offset_refinement = this->m_offsetRefiner->getMetrics();
+    else
+        state.offset_refinement = std::nullopt;
+
+    // Overwritten in place, so the strings in the settings keep their allocations from one frame to the next
+    state.settings_available = this->m_settingsManager != nullptr;
+    std::size_t setting_count = 0;
+    if (state.settings_available) {
+        const DriverSettings& settings = this->m_settingsManager->getSettings();
+        for (const auto& [setting, key] : DriverSettings::getKeys()) {
+            const DriverSettings::SettingValue* value = settings.findValue(setting);
+            if (value == nullptr)
+                continue;
+            if (setting_count == state.settings.size())
+                state.settings.emplace_back();
+            state.settings[setting_count].first = key;
+            state.settings[setting_count].second = *value;
+            ++setting_count;
+        }
+    }
+    state.settings.resize(setting_count);
+
+    state.run_frame = this->m_runFrameTiming;
+    state.tracking_reference_timing = this->m_trackingReferenceTiming;
+    state.time_to_first_pose = this->m_timeToFirstPose;
+    state.warm_start = this->m_warmStarted;
+    state.power_mode = this->m_powerController.getMode();
+    for (auto mode : { PowerController::Mode::Active, PowerController::Mode::Idle, PowerController::Mode::Standby })
+        state.power_stats[static_cast<std::size_t>(mode)] = this->m_powerController.getStats(mode);
+    PoseTraceRecorder* pose_trace = this->getPoseTrace();
+    state.pose_trace = pose_trace != nullptr;
+    if (pose_trace != nullptr) {
+        state.pose_trace_path = pose_trace->getPath();
+        state.pose_trace_recorded = pose_trace->getRecordedCount();
+        state.pose_trace_dropped = pose_trace->getDroppedCount();
+    }
+
+    // Skipped if a request is being answered, the next frame publishes instead
+    this->m_debugState.publish();
+}
+
+std::string ServerDriver::captureDebugRequest(std::string_view request)
+{
+    std::string buffer(m_captureBufferSize, '\0');
+    std::string null_terminated(request);
+    if (this->m_penDevice != nullptr) {
+        this->m_penDevice->DebugRequest(null_terminated.c_str(), buffer.data(), static_cast<uint32_t>(buffer.size()));
+    }
+    else {
+        // No pen yet, only the driver wide requests can be answered
+        DebugResponseWriter writer(buffer.data(), static_cast<uint32_t>(buffer.size()));
+        auto [command, argument] = DebugResponseWriter::splitRequest(null_terminated.c_str());
+        this->handleDebugRequest(command, argument, writer);
+        writer.finish();
+    }
+    buffer.resize(std::strlen(buffer.c_str()));
+    return buffer;
+}
+
+std::string ServerDriver::selectTrackingReference(const std::optional<std::string>& serial)
+{
+    this->m_trackingReferenceSerialHint = serial;
+    this->m_doLookForever = serial.has_value();
+    this->m_candidatePack = std::nullopt;
+    this->setTrackingReference(std::nullopt);
+    this->m_referenceFusion.clear();
+    this->m_referenceSearch.restart();
+    if (serial.has_value())
+        DRIVER_LOG_INFO(Reference, "Searching for tracking reference with serial [%s] (control request).\n", serial->c_str());
+    else
+        DRIVER_LOG_INFO(Reference, "Searching for a new tracking reference (control request).\n");
+    return "{\"searching\":true}";
+}
+
+PoseTraceRecorder* ServerDriver::getPoseTrace()
+{
+    return this->m_poseTraces != nullptr ? this->m_poseTraces->get() : nullptr;
+}
+
+const PenProfile& ServerDriver::getActiveProfile() const
+{
+    return *this->m_activeProfile;
+}
+
+std::optional<RuntimeParameters> ServerDriver::getRuntimeParameters() const
+{
+    if (this->m_controlChannel == nullptr)
+        return std::nullopt;
+    return this->m_frameParameters;
+}
+
+void ServerDriver::saveWarmStart(const DriverAnalytics::TrackingReferencePack& pack)
+{
+    if (this->m_warmStartPath.empty())
+        return;
+    this->m_warmStartWriter.schedule([path = this->m_warmStartPath, entry = WarmStartCache::fromPack(pack)]() {
+        if (!WarmStartCache::save(path, entry))
+            DRIVER_LOG_WARN(Reference, "Failed to write the warm start cache to %s\n", path.string().c_str());
+    });
 }
 
 void ServerDriver::setTrackingReference(std::optional<DriverAnalytics::TrackingReferencePack> new_tracking_reference_pack)
 {
     if (new_tracking_reference_pack.has_value()) {
         this->m_settingsManager->getSettings().setValue<std::string>(DriverSettings::AutoTrackingRefSerial, new_tracking_reference_pack->device_serial);
+        if (this->m_offsetRefiner != nullptr)
+            this->m_offsetRefiner->reset(*new_tracking_reference_pack);
     }
     else {
         this->m_settingsManager->getSettings().clearValue(DriverSettings::AutoTrackingRefSerial);
@@ -527,15 +1348,15 @@ void ServerDriver::setTrackingReference(std::optional<DriverAnalytics::TrackingR
     this->m_settingsManager->storeSettings();
 }
 
-std::vector<vr::VREvent_t> ServerDriver::processEvents(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties)
+EventSpan ServerDriver::processEvents(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties)
 {
-    // Process events
+    // Process events, reusing last frame's storage
     vr::VREvent_t event;
-    std::vector<vr::VREvent_t> events;
+    this->m_frameEvents.clear();
     while (serverdriver_host->PollNextEvent(&event, sizeof(event)))
     {
-        events.push_back(event);
+        this->m_frameEvents.push_back(event);
     }
 
-    return events;
+    return this->m_frameEvents;
 }
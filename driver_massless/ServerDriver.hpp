@@ -11,11 +11,14 @@
 #include <memory>
 #include <string>
 #include <cstdlib>
+#include <cstring>
 #include <optional>
 #include <array>
 #include <iostream>
 #include <locale>
 #include <sstream>
+#include <string_view>
+#include <vector>
 
 #include <Eigen/eigen>
 #include <openvr_driver.h>
@@ -29,9 +32,33 @@
 #include <SettingsManager.hpp>
 #include <SettingsUtilities.hpp>
 #include <IDriverDevice.hpp>
+#include <Span.hpp>
 #include <DriverAnalytics.hpp>
+#include <TrackedDeviceDirectory.hpp>
+#include <DevicePoseSnapshot.hpp>
+#include <TrackingReferenceSearch.hpp>
+#include <ReferenceFusion.hpp>
+#include <ReferenceCandidateScorer.hpp>
+#include <ReferenceHealthMonitor.hpp>
+#include <ReferencePoseHistory.hpp>
+#include <WarmStartCache.hpp>
+#include <OffsetRefiner.hpp>
+#include <DeferredWriter.hpp>
+#include <ProcessNameResolver.hpp>
+#include <IntegrationKeyTable.hpp>
+#include <PenProfileTable.hpp>
+#include <PoseTraceRecorder.hpp>
+#include <PoseTraceSwitcher.hpp>
+#include <PowerController.hpp>
+#include <PoseStreamWriter.hpp>
+#include <ControlChannel.hpp>
+#include <ControlServer.hpp>
+#include <FileWatcher.hpp>
+#include <DoubleBuffer.hpp>
 #include <Handedness.hpp>
 #include <MasslessManager.hpp>
+#include <DebugResponseWriter.hpp>
+#include <TimingStats.hpp>
 
 
 /// <summary>
@@ -113,8 +140,182 @@ public:
     /// <returns>Current tracking reference information, or nullopt if none is currently set</returns>
     std::optional<DriverAnalytics::TrackingReferencePack> getTrackingReference();
 
+    /// <summary>
+    /// Fuses the pen pose across every visible reference, when enable_reference_fusion is set
+    /// </summary>
+    /// <param name="pen_pose">Pose of the pen in the Massless coordinate space</param>
+    /// <returns>Pen pose in SteamVR space, or nullopt if fusion is disabled or there is no locked tracking reference</returns>
+    std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> getFusedPenPose(const MasslessInterface::Pose& pen_pose);
+
+    /// <summary>
+    /// Gets the pose of a moving tracking reference (Vive Tracker, Rift S/Quest controller) at the time a pen sample was captured
+    /// </summary>
+    /// <param name="time">Pen sample timestamp</param>
+    /// <returns>Time aligned reference pose, or nullopt if the reference is static, not locked, or the time is outside of the recorded history</returns>
+    std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>> getTrackingReferencePoseAt(std::chrono::system_clock::time_point time);
+
+    /// <summary>
+    /// Records that the pen produced a valid pose, the first one logs the time since Init
+    /// </summary>
+    void onValidPenPose();
+
+    /// <summary>
+    /// Gets the power controller, so devices can report pen activity and skip work while idle
+    /// </summary>
+    PowerController& getPowerController();
+
+    /// <summary>
+    /// Handles the driver wide debug requests "tracking_reference", "settings", "timings" and "offset_observation",
+    /// devices forward any request they do not handle themselves to here. Safe to call from any thread, responses are written from the state
+    /// published at the end of the last frame.
+    /// </summary>
+    /// <param name="command">Request command</param>
+    /// <param name="argument">Request argument, can be empty</param>
+    /// <param name="writer">Writer for the JSON response</param>
+    /// <param name="device_commands">Requests the forwarding device handles itself, listed alongside the driver wide ones for an unknown request</param>
+    void handleDebugRequest(std::string_view command, std::string_view argument, DebugResponseWriter& writer, Span<const char* const> device_commands = {});
+
+    /// <summary>
+    /// Writes the RunFrame timing statistics as a JSON object, from the state published at the end of the last frame
+    /// </summary>
+    /// <param name="writer">Writer for the JSON response</param>
+    void writeTimings(DebugResponseWriter& writer) const;
+
+    /// <summary>
+    /// Gets the runtime parameters (see ControlChannel) this frame is using
+    /// </summary>
+    /// <returns>The parameters, or nullopt before Init</returns>
+    std::optional<RuntimeParameters> getRuntimeParameters() const;
+
+    /// <summary>
+    /// Gets the profile (see PenProfileTable) for the scene application, devices read it each frame
+    /// </summary>
+    const PenProfile& getActiveProfile() const;
+
+    /// <summary>
+    /// Gets the pose trace being recorded (see the pose_trace_file setting), for devices to record each frame's pose
+    /// </summary>
+    /// <returns>The recorder, or nullptr when not tracing</returns>
+    PoseTraceRecorder* getPoseTrace();
+
 private:
 
+    /// <summary>
+    /// What the driver wide debug requests report on. vrserver makes debug requests from its own thread, so they are answered from this copy
+    /// of the frame thread's state rather than the state itself.
+    /// </summary>
+    struct DebugState {
+        std::optional<DriverAnalytics::TrackingReferencePack> tracking_reference;
+        std::optional<std::string> serial_hint;
+        bool look_forever = false;
+        TrackingReferenceSearch::State search_state = TrackingReferenceSearch::State::Idle;
+        uint32_t search_probes = 0;
+        std::chrono::milliseconds search_backoff{ 0 };
+        std::chrono::milliseconds next_probe{ 0 };
+        std::optional<std::string> candidate_serial;
+        uint64_t directory_generation = 0;
+        uint64_t directory_classifications = 0;
+        std::vector<vr::TrackedDeviceIndex_t> candidates;
+        std::vector<std::optional<ReferenceCandidateScorer::Score>> candidate_scores;
+        bool health_holding = false;
+        ReferenceHealthMonitor::Metrics health;
+        std::size_t history_samples = 0;
+        ReferencePoseHistory::Metrics history;
+        uint64_t fusion_composite_updates = 0;
+        std::vector<ReferenceFusion::Slot> fusion;
+        std::optional<OffsetRefiner::Metrics> offset_refinement;
+
+        /// <summary>
+        /// Pen tip position (Massless space) last frame, only kept with offset refinement on, nullopt while the pen isn't tracking
+        /// </summary>
+        std::optional<Eigen::Vector3f> pen_position;
+
+        /// <summary>
+        /// Every stored setting by key, empty before Init
+        /// </summary>
+        std::vector<std::pair<std::string_view, DriverSettings::SettingValue>> settings;
+        bool settings_available = false;
+
+        TimingStats run_frame;
+        TimingStats tracking_reference_timing;
+        std::optional<std::chrono::milliseconds> time_to_first_pose;
+        bool warm_start = false;
+        PowerController::Mode power_mode = PowerController::Mode::Active;
+        std::array<PowerController::ModeStats, 3> power_stats;
+        bool pose_trace = false;
+        std::filesystem::path pose_trace_path;
+        uint64_t pose_trace_recorded = 0;
+        uint64_t pose_trace_dropped = 0;
+    };
+
+    /// <summary>
+    /// Adds the tracking reference and Massless Tracker gizmos, once
+    /// </summary>
+    void addGizmos();
+
+    /// <summary>
+    /// Compiles the integration_keys setting into the integration key table
+    /// </summary>
+    void loadIntegrationKeys();
+
+    /// <summary>
+    /// Compiles the application_profiles setting into the profile table and picks the current application's profile
+    /// </summary>
+    void loadProfiles();
+
+    /// <summary>
+    /// Sets the level of each log category from the log_levels setting, defaulting to debug with detailed logging on and info otherwise
+    /// </summary>
+    void applyLogLevels();
+
+    /// <summary>
+    /// Asks for the pose trace to be started, restarted or stopped to match the pose_trace_file setting. The trace is opened and closed off the
+    /// frame thread, and swapped in at the start of a later frame.
+    /// </summary>
+    void updatePoseTrace();
+
+    /// <summary>
+    /// Applies settings changed by a reload of the settings file. Settings only read at startup are logged as needing a restart.
+    /// </summary>
+    /// <param name="changed">Settings whose values changed</param>
+    void onSettingsChanged(const std::vector<DriverSettings::Setting>& changed);
+
+    /// <summary>
+    /// Picks up runtime parameters changed through the control channel, once at the start of a frame
+    /// </summary>
+    void updateRuntimeParameters();
+
+    /// <summary>
+    /// Runs work posted by the control server and publishes this frame's telemetry for its feed
+    /// </summary>
+    /// <param name="power_mode">Power mode this frame ran in</param>
+    void updateControlChannel(PowerController::Mode power_mode);
+
+    /// <summary>
+    /// Copies the state the debug requests report on into m_debugState and publishes it, at the end of Init and of each frame.
+    /// Containers are assigned in place, so once their capacity has grown this doesn't allocate.
+    /// </summary>
+    void publishDebugState();
+
+    /// <summary>
+    /// Writes the RunFrame timing statistics from published state, for requests already reading it
+    /// </summary>
+    void writeTimings(const DebugState& state, DebugResponseWriter& writer) const;
+
+    /// <summary>
+    /// Runs a debug request for the control server's capture command, through the pen if it has been added
+    /// </summary>
+    /// <param name="request">Debug request, as for DebugRequest</param>
+    /// <returns>The JSON response</returns>
+    std::string captureDebugRequest(std::string_view request);
+
+    /// <summary>
+    /// Drops the tracking reference and searches again, for the control server's select_reference command
+    /// </summary>
+    /// <param name="serial">Serial to look for (forever), or nullopt to search automatically</param>
+    /// <returns>JSON result</returns>
+    std::string selectTrackingReference(const std::optional<std::string>& serial);
+
     /// <summary>
     /// Updates the internal tracking reference state
     /// </summary>
@@ -122,6 +323,45 @@ private:
     /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
     void updateTrackingReference(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties);
 
+    /// <summary>
+    /// Probes the connected devices for a tracking reference, preferring the serial hint until it expires
+    /// </summary>
+    /// <param name="pen_system">Pen system, used to get the Massless Tracker offset</param>
+    /// <returns>The candidate tracking reference, or nullopt if none could be found this probe</returns>
+    std::optional<DriverAnalytics::TrackingReferencePack> findTrackingReferenceCandidate(std::shared_ptr<MasslessInterface::IPenSystem> pen_system);
+
+    /// <summary>
+    /// Checks if the reference in the warm start cache is connected and still where it was, and if so builds a candidate from the cached offset.
+    /// The cache is only used for the first search after startup, and is dropped once the device reports a mismatching type or pose.
+    /// </summary>
+    /// <returns>The cached tracking reference with this frame's pose, or nullopt if there is no usable cache entry</returns>
+    std::optional<DriverAnalytics::TrackingReferencePack> findWarmStartCandidate();
+
+    /// <summary>
+    /// Checks if a tracking reference pose can be used (Rift S/Quest controllers report a zero position while not tracking)
+    /// </summary>
+    /// <param name="pack">Tracking reference the pose is for</param>
+    /// <param name="pose">Pose read this frame</param>
+    /// <returns>True if the pose is valid and usable</returns>
+    static bool isUsableReferencePose(const DriverAnalytics::TrackingReferencePack& pack, const std::optional<std::pair<Eigen::Quaternionf, Eigen::Vector3f>>& pose);
+
+    /// <summary>
+    /// Feeds the locked reference and every other visible reference of its type to the reference fusion, or clears it when fusion is off or not locked
+    /// </summary>
+    void updateReferenceFusion();
+
+    /// <summary>
+    /// Samples every connected tracking reference for the candidate scorer while searching, or clears it once locked
+    /// </summary>
+    /// <param name="pen_system">Pen system, used to correlate controller motion with the pen's</param>
+    void updateCandidateScores(std::shared_ptr<MasslessInterface::IPenSystem> pen_system);
+
+    /// <summary>
+    /// Schedules a write of the warm start cache on the background writer
+    /// </summary>
+    /// <param name="pack">Locked tracking reference</param>
+    void saveWarmStart(const DriverAnalytics::TrackingReferencePack& pack);
+
     /// <summary>
     /// Sets a new tracking reference and updates the auto tracking reference settings key
     /// <param name="new_tracking_reference_pack">The new tracking reference, can be nullopt to remove the tracking reference</param>
@@ -133,8 +373,8 @@ private:
     /// </summary>
     /// <param name="serverdriver_host">IVRServerDriverHost pointer (usually vr::VRServerDriverHost())</param>
     /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
-    /// <returns>List of events processed</returns>
-    std::vector<vr::VREvent_t> processEvents(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties);
+    /// <returns>View of the events processed, valid until the next call</returns>
+    EventSpan processEvents(vr::IVRServerDriverHost* serverdriver_host, vr::CVRPropertyHelpers* properties);
 
 	/// <summary>
 	/// Static instance to pass to the driver factory.
@@ -147,6 +387,16 @@ private:
 	/// </summary>
     std::vector<std::unique_ptr<IDriverDevice>> m_devices;
 
+    /// <summary>
+    /// Reusable storage for the events polled each frame, cleared (but not freed) every frame so steady state polling doesn't allocate
+    /// </summary>
+    std::vector<vr::VREvent_t> m_frameEvents;
+
+    /// <summary>
+    /// Number of events m_frameEvents is reserved for up front
+    /// </summary>
+    static constexpr std::size_t m_frameEventsReserve = 64;
+
     /// <summary>
     /// This driver's settings manager
     /// </summary>
@@ -157,11 +407,6 @@ private:
     /// </summary>
     std::shared_ptr<MasslessManager> m_masslessManager;
 
-    /// <summary>
-    /// Time point when the driver started
-    /// </summary>
-    std::chrono::time_point<std::chrono::system_clock> m_timeDriverStart;
-    
     /// <summary>
     /// Look for a new tracking reference when the previous one disconnects?
     /// </summary>
@@ -178,29 +423,187 @@ private:
     bool m_doLookForever = false;
 
     /// <summary>
-    /// Did a tracking reference disconnect?
+    /// Tracking reference discovery state and timers
     /// </summary>
-    bool m_didReferenceDisconnect = false;
+    TrackingReferenceSearch m_referenceSearch;
 
     /// <summary>
-    /// Time that the tracking reference disconnected
+    /// Serial number for the forced tracking reference
     /// </summary>
-    std::chrono::system_clock::time_point m_timeReferenceDisconnect;
+    std::optional<std::string> m_trackingReferenceSerialHint;
 
     /// <summary>
-    /// Timeout for looking for device with this->m_initialSerial serial
+    /// Information about the tracking reference
     /// </summary>
-    std::chrono::seconds m_searchTimeout{ 5 };
+    std::optional<DriverAnalytics::TrackingReferencePack> m_trackingReferencePack;
 
     /// <summary>
-    /// Serial number for the forced tracking reference
+    /// Tracking reference found by the last probe, waiting to be validated
     /// </summary>
-    std::optional<std::string> m_trackingReferenceSerialHint;
+    std::optional<DriverAnalytics::TrackingReferencePack> m_candidatePack;
 
     /// <summary>
-    /// Information about the tracking reference
+    /// Plausibility check of the locked reference's pose (static references only)
     /// </summary>
-    std::optional<DriverAnalytics::TrackingReferencePack> m_trackingReferencePack;
+    ReferenceHealthMonitor m_referenceHealth;
+
+    /// <summary>
+    /// Recent poses of a moving locked reference, so it can be evaluated at the pen sample's timestamp
+    /// </summary>
+    ReferencePoseHistory m_referenceHistory;
+
+    /// <summary>
+    /// Stability and motion scores of the tracking reference candidates, used to pick one when there is no serial hint
+    /// </summary>
+    ReferenceCandidateScorer m_candidateScorer;
+
+    /// <summary>
+    /// Candidates sampled this frame, kept to reuse the allocation
+    /// </summary>
+    std::vector<ReferenceCandidateScorer::Candidate> m_scoringCandidates;
+
+    /// <summary>
+    /// Candidates in score order for this probe, kept to reuse the allocation
+    /// </summary>
+    std::vector<vr::TrackedDeviceIndex_t> m_rankedCandidates;
+
+    /// <summary>
+    /// Cached classification of every tracked device, used to find tracking references without sweeping device properties
+    /// </summary>
+    TrackedDeviceDirectory m_deviceDirectory;
+
+    /// <summary>
+    /// Raw poses of every tracked device, captured once at the start of each frame
+    /// </summary>
+    DevicePoseSnapshot m_poseSnapshot;
+
+    /// <summary>
+    /// Pen pose fusion across every visible reference of the locked reference's type
+    /// </summary>
+    ReferenceFusion m_referenceFusion;
+
+    /// <summary>
+    /// Secondary references for fusion this frame, kept to reuse the allocation
+    /// </summary>
+    std::vector<ReferenceFusion::Reference> m_fusionReferences;
+
+    /// <summary>
+    /// Background refinement of the locked reference's Massless Tracker offset, only created when enable_offset_refinement is set
+    /// </summary>
+    std::unique_ptr<OffsetRefiner> m_offsetRefiner;
+
+    /// <summary>
+    /// Pen tip position (Massless space) this frame for offset_observation requests, only read while offset refinement is on
+    /// </summary>
+    std::optional<Eigen::Vector3f> m_penPosition;
+
+    /// <summary>
+    /// Shared memory stream of pen samples for other processes, only created when enable_pose_stream is set. Shared with the backend's callbacks.
+    /// </summary>
+    std::shared_ptr<PoseStreamWriter> m_poseStream;
+
+    /// <summary>
+    /// Runtime parameters and frame thread work shared with the control server
+    /// </summary>
+    std::shared_ptr<ControlChannel> m_controlChannel;
+
+    /// <summary>
+    /// Local control socket, only created when enable_control_socket is set
+    /// </summary>
+    std::unique_ptr<ControlServer> m_controlServer;
+
+    /// <summary>
+    /// Runtime parameters read at the start of this frame, and the version they were read at
+    /// </summary>
+    RuntimeParameters m_frameParameters;
+    uint64_t m_frameParametersVersion = 0;
+
+    /// <summary>
+    /// Watches driver_massless.json so edits are applied without restarting SteamVR
+    /// </summary>
+    std::unique_ptr<FileWatcher> m_settingsWatcher;
+
+    /// <summary>
+    /// Have the debug gizmos been added?
+    /// </summary>
+    bool m_hasAddedGizmos = false;
+
+    /// <summary>
+    /// Size of the response buffer for captured debug requests
+    /// </summary>
+    static constexpr std::size_t m_captureBufferSize = 64 * 1024;
+
+    /// <summary>
+    /// State for debug requests, written by the frame thread and read by whichever thread makes the request
+    /// </summary>
+    DoubleBuffer<DebugState> m_debugState;
+
+    /// <summary>
+    /// The pen once it has been added (owned by m_devices)
+    /// </summary>
+    IDriverDevice* m_penDevice = nullptr;
+
+    /// <summary>
+    /// Finds the name of the scene application off the frame thread, the integration key is switched once it is known
+    /// </summary>
+    ProcessNameResolver m_processNameResolver;
+
+    /// <summary>
+    /// Integration keys by application, the integration_keys setting over the built in keys
+    /// </summary>
+    IntegrationKeyTable m_integrationKeyTable;
+
+    /// <summary>
+    /// Profiles by application, and the one in use. Profiles are immutable, switching application only swaps the pointer.
+    /// </summary>
+    PenProfileTable m_profileTable;
+    std::shared_ptr<const PenProfile> m_activeProfile = m_profileTable.getDefault();
+    std::string m_currentApplication;
+
+    /// <summary>
+    /// Opens and closes the pose trace for pose_trace_file, and holds the one being recorded
+    /// </summary>
+    std::unique_ptr<PoseTraceSwitcher> m_poseTraces;
+
+    /// <summary>
+    /// Active, idle or standby, decides which per frame work can be deferred
+    /// </summary>
+    PowerController m_powerController;
+
+    /// <summary>
+    /// Path of the warm start cache, next to driver_massless.json
+    /// </summary>
+    std::filesystem::path m_warmStartPath;
+
+    /// <summary>
+    /// Writes the warm start cache off the frame thread
+    /// </summary>
+    DeferredWriter m_warmStartWriter{ std::chrono::milliseconds(500) };
+
+    /// <summary>
+    /// Reference loaded from the warm start cache, waiting for the device to report
+    /// </summary>
+    std::optional<WarmStartCache::Entry> m_warmStart;
+
+    /// <summary>
+    /// Is the locked reference still using the cached offset, rather than one from the backend?
+    /// </summary>
+    bool m_usingCachedOffset = false;
+
+    /// <summary>
+    /// Was the current reference locked from the warm start cache?
+    /// </summary>
+    bool m_warmStarted = false;
+
+    /// <summary>
+    /// Time Init was called
+    /// </summary>
+    std::chrono::steady_clock::time_point m_initTime;
+
+    /// <summary>
+    /// Time from Init to the first valid pen pose, or nullopt until then
+    /// </summary>
+    std::optional<std::chrono::milliseconds> m_timeToFirstPose;
 
     /// <summary>
     /// Has the pen been added yet?
@@ -213,7 +616,12 @@ private:
     bool m_initSuccess = false;
 
     /// <summary>
-    /// Temporary hacky fix for the Vive Tracker not appearing in the list when its "Tracker Attached" event fires.
+    /// Duration of each call to RunFrame
+    /// </summary>
+    TimingStats m_runFrameTiming;
+
+    /// <summary>
+    /// Duration of each call to updateTrackingReference
     /// </summary>
-    int m_TrackingReferenceSearchCountdown = 0;
+    TimingStats m_trackingReferenceTiming;
 };
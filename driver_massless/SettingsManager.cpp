@@ -8,15 +8,19 @@
  */
 
 #include "SettingsManager.hpp"
+#include <DriverLog.hpp>
+#include <DriverSettingsException.hpp>
 
-SettingsManager::SettingsManager(std::unique_ptr<IDriverSettingsLoader> settings_loader) :
-    m_driverSettingsLoader(std::move(settings_loader))
+SettingsManager::SettingsManager(std::unique_ptr<IDriverSettingsLoader> settings_loader, std::chrono::milliseconds store_delay) :
+    m_driverSettingsLoader(std::move(settings_loader)),
+    m_writer(store_delay)
 {
     m_driverSettings = m_driverSettingsLoader->readSettings();
 }
 
 SettingsManager::~SettingsManager()
 {
+    this->m_writer.flush();
     if(this->m_driverSettings.areAllValid())
         this->m_driverSettingsLoader->writeSettings(this->m_driverSettings);
 }
@@ -28,5 +32,92 @@ DriverSettings& SettingsManager::getSettings()
 
 void SettingsManager::storeSettings()
 {
-    m_driverSettingsLoader->writeSettings(m_driverSettings);
+    // Snapshot now, the frame thread carries on changing m_driverSettings while the write is pending. Only the settings the driver maintains
+    // are written from the snapshot: the rest are read back from the file when writing, so an edit saved while the write was pending is kept
+    // rather than replaced with the values from when it was scheduled (and then reloaded, undoing it).
+    this->m_writer.schedule([loader = this->m_driverSettingsLoader.get(), current = this->m_driverSettings]() {
+        DriverSettings settings = current;
+        try {
+            if (DriverSettings on_disk = loader->readSettings(); on_disk.areAllValid())
+                settings = std::move(on_disk);
+        }
+        catch (const DriverSettingsException&) {
+            // Missing or unreadable, write the settings in use
+        }
+        copyDriverMaintained(current, settings);
+        loader->writeSettings(settings);
+    });
+}
+
+void SettingsManager::flush()
+{
+    this->m_writer.flush();
+}
+
+const DeferredWriter& SettingsManager::getWriter() const
+{
+    return this->m_writer;
+}
+
+bool SettingsManager::prepareReload(IDriverSettingsLoader& loader)
+{
+    DriverSettings settings;
+    try {
+        settings = loader.readSettings();
+    }
+    catch (const DriverSettingsException& e) {
+        DRIVER_LOG_WARN(Settings, "Not reloading settings, unable to read them: %s\n", e.what());
+        return false;
+    }
+
+    if (!settings.areAllValid()) {
+        for (const auto& key : DriverSettings::getKeys()) {
+            if (!settings.isValid(key.first))
+                DRIVER_LOG_WARN(Settings, "Not reloading settings, setting [%s] is invalid\n", key.second.c_str());
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->m_reloadMutex);
+    this->m_pendingReload = std::move(settings);
+    this->m_hasPendingReload.store(true, std::memory_order_release);
+    return true;
+}
+
+std::vector<DriverSettings::Setting> SettingsManager::applyReload()
+{
+    if (!this->m_hasPendingReload.load(std::memory_order_acquire))
+        return {};
+
+    std::optional<DriverSettings> reloaded;
+    {
+        std::lock_guard<std::mutex> lock(this->m_reloadMutex);
+        reloaded.swap(this->m_pendingReload);
+        this->m_hasPendingReload = false;
+    }
+    if (!reloaded.has_value())
+        return {};
+
+    // The file may not have caught up with the reference locked since it was last written
+    copyDriverMaintained(this->m_driverSettings, *reloaded);
+
+    auto changed = this->m_driverSettings.getChangedKeys(*reloaded);
+    if (!changed.empty()) {
+        this->m_driverSettings = std::move(*reloaded);
+        ++this->m_reloads;
+    }
+    return changed;
+}
+
+void SettingsManager::copyDriverMaintained(const DriverSettings& from, DriverSettings& to)
+{
+    if (const DriverSettings::SettingValue* serial = from.findValue(DriverSettings::AutoTrackingRefSerial); serial != nullptr)
+        to.setValue<DriverSettings::SettingValue>(DriverSettings::AutoTrackingRefSerial, *serial);
+    else
+        to.clearValue(DriverSettings::AutoTrackingRefSerial);
+}
+
+uint64_t SettingsManager::getReloadCount() const
+{
+    return this->m_reloads;
 }
@@ -9,14 +9,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <variant>
+#include <vector>
 
 #include <IDriverSettingsLoader.hpp>
+#include <DeferredWriter.hpp>
 
 /// <summary>
 /// Class for managing access to the driver settings
-/// Construction will load the settings from the given settings loader, and destruction will save the settings
+/// Construction will load the settings from the given settings loader, and destruction will save the settings.
+/// Stores in between are written on a background thread, so they can be requested from the frame thread.
+/// The settings can be reloaded while running: another thread reads and validates them (prepareReload), and the frame thread swaps them in
+/// between frames (applyReload).
 /// </summary>
 class SettingsManager
 {
@@ -26,7 +35,8 @@ public:
     /// Will attempt to load settings on startup
     /// </summary>
     /// <param name="settings_loader">Settings loader to use to load and save driver settings</param>
-    SettingsManager(std::unique_ptr<IDriverSettingsLoader> settings_loader);
+    /// <param name="store_delay">How long storeSettings waits for further changes before writing</param>
+    SettingsManager(std::unique_ptr<IDriverSettingsLoader> settings_loader, std::chrono::milliseconds store_delay = std::chrono::milliseconds(500));
 
     ~SettingsManager();
 
@@ -36,10 +46,59 @@ public:
     /// <returns></returns>
     DriverSettings& getSettings();
 
+    /// <summary>
+    /// Schedules a write of the current settings on the background writer, a burst of stores is written once. Only the settings the driver
+    /// maintains (the auto tracking reference serial) are taken from memory, the rest are kept as they are in the file when it is written.
+    /// </summary>
     void storeSettings();
 
+    /// <summary>
+    /// Writes any stored settings now, and waits for the write to finish
+    /// </summary>
+    void flush();
+
+    /// <summary>
+    /// Gets the background writer, for its counters
+    /// </summary>
+    const DeferredWriter& getWriter() const;
+
+    /// <summary>
+    /// Reads the settings again for applyReload, from any thread (ie. a FileWatcher's). Settings that fail to load or validate are rejected and
+    /// the current ones are kept.
+    /// </summary>
+    /// <param name="loader">Loader to read with, not the one the settings are written with as that is in use on the writer thread</param>
+    /// <returns>True if the settings were read and are all valid</returns>
+    bool prepareReload(IDriverSettingsLoader& loader);
+
+    /// <summary>
+    /// Swaps in the settings from the last prepareReload, if there are any (frame thread only). Only checks an atomic when there are none.
+    /// The auto tracking reference serial is kept, it is maintained by the driver rather than the file.
+    /// </summary>
+    /// <returns>The settings whose values changed</returns>
+    std::vector<DriverSettings::Setting> applyReload();
+
+    /// <summary>
+    /// Gets the number of reloads that changed any settings
+    /// </summary>
+    uint64_t getReloadCount() const;
+
 private:
+    /// <summary>
+    /// Copies the settings the driver maintains, rather than the user, between two sets of settings
+    /// </summary>
+    static void copyDriverMaintained(const DriverSettings& from, DriverSettings& to);
+
     DriverSettings m_driverSettings;
     std::unique_ptr<IDriverSettingsLoader> m_driverSettingsLoader;
+
+    std::mutex m_reloadMutex;
+    std::optional<DriverSettings> m_pendingReload;
+    std::atomic<bool> m_hasPendingReload = false;
+    std::atomic<uint64_t> m_reloads = 0;
+
+    /// <summary>
+    /// Declared after the loader so it is stopped before the loader is destroyed
+    /// </summary>
+    DeferredWriter m_writer;
 };
 
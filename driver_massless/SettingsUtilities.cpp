@@ -10,23 +10,32 @@
 #include "SettingsUtilities.hpp"
 #include <MasslessOpenVRIntegrationUUIDs.h>
 #include <shlobj.h>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
 
 const std::array<uint8_t, SettingsUtilities::m_integrationKeyLen> SettingsUtilities::m_defaultIntegrationKey = M_INTEGRATION_OPENVRDEV;
 
-const std::vector<std::pair<std::string, std::array<uint8_t, SettingsUtilities::m_integrationKeyLen>>> SettingsUtilities::m_integrationKeys = {
-    {"steamtours", M_INTEGRATION_OPENVR_STEAMVRHOME},
-    {"tiltbrush", M_INTEGRATION_OPENVR_TILTBRUSH},
-    {"SculptrVR-Win64-Shipping", M_INTEGRATION_OPENVR_SCULPTVR},
-    {"Masterpiece_VR", M_INTEGRATION_OPENVR_MASTERPIECEVR},
-    {"Sketch-Win64-Shipping", M_INTEGRATION_OPENVR_SKETCHBOX},
-    {"GravitySketchVR", M_INTEGRATION_OPENVR_GRAVITYSKETCH}
-};
+const StringPatternTable<std::array<uint8_t, SettingsUtilities::m_integrationKeyLen>, 6> SettingsUtilities::m_integrationKeys(std::array<std::pair<StringPattern, std::array<uint8_t, SettingsUtilities::m_integrationKeyLen>>, 6>{ {
+    {StringPattern::compile("steamtours"), M_INTEGRATION_OPENVR_STEAMVRHOME},
+    {StringPattern::compile("tiltbrush"), M_INTEGRATION_OPENVR_TILTBRUSH},
+    {StringPattern::compile("SculptrVR-Win64-Shipping"), M_INTEGRATION_OPENVR_SCULPTVR},
+    {StringPattern::compile("Masterpiece_VR"), M_INTEGRATION_OPENVR_MASTERPIECEVR},
+    {StringPattern::compile("Sketch-Win64-Shipping"), M_INTEGRATION_OPENVR_SKETCHBOX},
+    {StringPattern::compile("GravitySketchVR"), M_INTEGRATION_OPENVR_GRAVITYSKETCH}
+} });
 
 
 std::array<uint8_t, SettingsUtilities::m_integrationKeyLen> SettingsUtilities::parseIntegrationKey(std::string string_value) {
-    // Check the string is the correct length
-    if (string_value.length() != m_integrationKeyLen) {
-        throw std::invalid_argument("String needs to be " + std::to_string(static_cast<int>(m_integrationKeyLen)) + " characters long (was " + std::to_string(string_value.length()) + ").");
+    // Allow the key to be written as a UUID, ie "{5A2B33..-....}"
+    string_value.erase(std::remove_if(string_value.begin(), string_value.end(), [](char c) { return c == '-' || c == '{' || c == '}'; }), string_value.end());
+
+    // Check the string is the correct length, two hex digits per byte
+    if (string_value.length() != 2 * m_integrationKeyLen) {
+        throw std::invalid_argument("String needs to be " + std::to_string(static_cast<int>(2 * m_integrationKeyLen)) + " hex digits long (was " + std::to_string(string_value.length()) + ").");
+    }
+    if (!std::all_of(string_value.begin(), string_value.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; })) {
+        throw std::invalid_argument("String can only contain hex digits.");
     }
 
     // Setup return
@@ -78,12 +87,32 @@ std::filesystem::path SettingsUtilities::getMasslessConfigPath()
     return file_path;
 }
 
-std::optional<std::array<uint8_t, SettingsUtilities::m_integrationKeyLen>> SettingsUtilities::getIntegrationKeyForApp(std::string exeName)
+bool SettingsUtilities::replaceFile(const std::filesystem::path& path, std::string_view contents)
 {
-    for (auto key : SettingsUtilities::m_integrationKeys) {
-        if (std::regex_search(exeName, std::regex(key.first, std::regex_constants::ECMAScript | std::regex_constants::icase))) {
-            return key.second;
-        }
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream temp_file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!temp_file.is_open())
+            return false;
+        temp_file.write(contents.data(), contents.size());
+        temp_file.flush();
+        if (!temp_file.good())
+            return false;
     }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::array<uint8_t, SettingsUtilities::m_integrationKeyLen>> SettingsUtilities::getIntegrationKeyForApp(std::string_view exeName)
+{
+    if (const auto* key = SettingsUtilities::m_integrationKeys.find(exeName))
+        return *key;
     return std::nullopt;
 }
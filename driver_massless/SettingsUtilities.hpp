@@ -9,8 +9,8 @@
 
 #pragma once
 
-#include <regex>
 #include <string>
+#include <string_view>
 #include <array>
 #include <filesystem>
 #include <fstream>
@@ -18,6 +18,7 @@
 
 #include <Handedness.hpp>
 #include <DriverSettingsException.hpp>
+#include <StringPattern.hpp>
 
 class SettingsUtilities {
 public:
@@ -29,8 +30,8 @@ public:
     /// <summary>
     /// Parses a raw string integration key into an array to be passed to the Massless C API
     /// </summary>
-    /// <param name="string_value">String representation of the integration key</param>
-    /// <exception cref="std::invalid_argument">When the input string is not the correct length (m_integrationKeyLen)</exception>
+    /// <param name="string_value">String representation of the integration key, two hex digits per byte, optionally with dashes and braces like a UUID</param>
+    /// <exception cref="std::invalid_argument">When the input string is not the correct length (2 * m_integrationKeyLen hex digits) or is not hex</exception>
     /// <returns>Parsed array ready to be passed to the Massless C API</returns>
     static std::array<uint8_t, m_integrationKeyLen> parseIntegrationKey(std::string string_value);
 
@@ -47,12 +48,21 @@ public:
     /// <returns></returns>
     static std::filesystem::path getMasslessConfigPath();
 
+    /// <summary>
+    /// Replaces a file's contents atomically, by writing a temporary file next to it and renaming it over the original,
+    /// so a crash mid-write leaves either the old or the new contents
+    /// </summary>
+    /// <param name="path">File to replace</param>
+    /// <param name="contents">New contents</param>
+    /// <returns>True if the file was replaced</returns>
+    static bool replaceFile(const std::filesystem::path& path, std::string_view contents);
+
     /// <summary>
     /// Gets the integration key for an application by its executable name
     /// </summary>
     /// <param name="exeName">Name of the exe file</param>
     /// <returns>The integration key for the application, or nullopt if the app doesn't have a key assigned</returns>
-    static std::optional<std::array<uint8_t, m_integrationKeyLen>> getIntegrationKeyForApp(std::string exeName);
+    static std::optional<std::array<uint8_t, m_integrationKeyLen>> getIntegrationKeyForApp(std::string_view exeName);
         
 private:
     // Prevent instantiation
@@ -63,5 +73,8 @@ private:
     /// </summary>
     static const std::array<uint8_t, m_integrationKeyLen> m_defaultIntegrationKey;
 
-    static const std::vector<std::pair<std::string,std::array<uint8_t, m_integrationKeyLen>>> m_integrationKeys;
+    /// <summary>
+    /// Integration keys for known applications, matched case-insensitively against the exe name
+    /// </summary>
+    static const StringPatternTable<std::array<uint8_t, m_integrationKeyLen>, 6> m_integrationKeys;
 };
\ No newline at end of file
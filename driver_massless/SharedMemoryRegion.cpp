@@ -0,0 +1,159 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "SharedMemoryRegion.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+namespace {
+    std::string platformName(const std::string& name)
+    {
+        // Per session, so no privileges are needed to create it
+        return "Local\\" + name;
+    }
+}
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::create(const std::string& name, std::size_t size)
+{
+    uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), platformName(name).c_str());
+    if (mapping == nullptr)
+        return nullptr;
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    // A mapping left open by a reader of a previous instance keeps its old contents
+    std::memset(data, 0, size);
+    std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion());
+    region->m_data = data;
+    region->m_size = size;
+    region->m_isOwner = true;
+    region->m_name = name;
+    region->m_mapping = mapping;
+    return region;
+}
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::open(const std::string& name)
+{
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, platformName(name).c_str());
+    if (mapping == nullptr)
+        return nullptr;
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (data == nullptr || VirtualQuery(data, &info, sizeof(info)) == 0) {
+        if (data != nullptr)
+            UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion());
+    region->m_data = data;
+    region->m_size = info.RegionSize;
+    region->m_name = name;
+    region->m_mapping = mapping;
+    return region;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    UnmapViewOfFile(this->m_data);
+    CloseHandle(this->m_mapping);
+}
+#else
+namespace {
+    std::string platformName(const std::string& name)
+    {
+        return "/" + name;
+    }
+}
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::create(const std::string& name, std::size_t size)
+{
+    int fd = shm_open(platformName(name).c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    // Truncating to zero first drops any stale contents
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, 0) == 0 && ftruncate(fd, static_cast<off_t>(size)) == 0)
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        shm_unlink(platformName(name).c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion());
+    region->m_data = data;
+    region->m_size = size;
+    region->m_isOwner = true;
+    region->m_name = name;
+    return region;
+}
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::open(const std::string& name)
+{
+    int fd = shm_open(platformName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion());
+    region->m_data = data;
+    region->m_size = static_cast<std::size_t>(info.st_size);
+    region->m_name = name;
+    return region;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    munmap(this->m_data, this->m_size);
+    if (this->m_isOwner)
+        shm_unlink(platformName(this->m_name).c_str());
+}
+#endif
+
+void* SharedMemoryRegion::data()
+{
+    return this->m_data;
+}
+
+const void* SharedMemoryRegion::data() const
+{
+    return this->m_data;
+}
+
+std::size_t SharedMemoryRegion::size() const
+{
+    return this->m_size;
+}
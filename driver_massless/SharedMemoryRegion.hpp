@@ -0,0 +1,55 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/// <summary>
+/// A named block of memory shared between processes: a file mapping on Windows, POSIX shared memory elsewhere.
+/// The creator maps it read/write and removes the name when destroyed, openers map it read only.
+/// </summary>
+class SharedMemoryRegion
+{
+public:
+    /// <summary>
+    /// Creates (or takes over a stale) region, zero filled
+    /// </summary>
+    /// <param name="name">Name of the region, without any platform prefix</param>
+    /// <param name="size">Size in bytes</param>
+    /// <returns>The region, or nullptr if it could not be created</returns>
+    static std::unique_ptr<SharedMemoryRegion> create(const std::string& name, std::size_t size);
+
+    /// <summary>
+    /// Opens an existing region read only
+    /// </summary>
+    /// <returns>The region, or nullptr if there is no region with that name</returns>
+    static std::unique_ptr<SharedMemoryRegion> open(const std::string& name);
+
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    void* data();
+    const void* data() const;
+    std::size_t size() const;
+
+private:
+    SharedMemoryRegion() = default;
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_isOwner = false;
+    std::string m_name;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,185 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "SnapshotProcessWatcher.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#endif
+
+SnapshotProcessWatcher::SnapshotProcessWatcher() :
+    SnapshotProcessWatcher(makePlatformSource())
+{}
+
+SnapshotProcessWatcher::SnapshotProcessWatcher(Source source) :
+    m_source(source)
+{}
+
+std::vector<IProcessWatcher::Event> SnapshotProcessWatcher::waitForEvents(std::chrono::milliseconds timeout)
+{
+    if (this->m_hasScanned) {
+        std::unique_lock<std::mutex> lock(this->m_mutex);
+        this->m_wake.wait_for(lock, timeout, [this]() { return this->m_interrupted; });
+        this->m_interrupted = false;
+    }
+    return this->scan();
+}
+
+void SnapshotProcessWatcher::interrupt()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_interrupted = true;
+    }
+    this->m_wake.notify_all();
+}
+
+bool SnapshotProcessWatcher::isEventDriven() const
+{
+    return false;
+}
+
+const char* SnapshotProcessWatcher::getBackendName() const
+{
+    return this->m_source.name;
+}
+
+IProcessWatcher::Metrics SnapshotProcessWatcher::getMetrics() const
+{
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    return this->m_metrics;
+}
+
+std::vector<IProcessWatcher::Event> SnapshotProcessWatcher::scan()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Event> events;
+
+    this->m_pids.clear();
+    if (!this->m_source.list_pids(this->m_pids))
+        return events;
+    this->m_hasScanned = true;
+
+    // Sorted so exits can be found with a binary search rather than another set
+    std::sort(this->m_pids.begin(), this->m_pids.end());
+    for (unsigned long pid : this->m_pids) {
+        if (this->m_known.count(pid) != 0)
+            continue;
+        // Gone between listing and naming, it will never be seen as running
+        auto name = this->m_source.get_name(pid);
+        if (!name.has_value())
+            continue;
+        this->m_known.insert(pid);
+        events.push_back({ Event::Type::Started, pid, std::move(*name) });
+    }
+
+    std::size_t started = events.size();
+    for (auto it = this->m_known.begin(); it != this->m_known.end();) {
+        if (!std::binary_search(this->m_pids.begin(), this->m_pids.end(), *it)) {
+            events.push_back({ Event::Type::Exited, *it, std::string() });
+            it = this->m_known.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    this->m_metrics.scans.record(std::chrono::steady_clock::now() - start);
+    this->m_metrics.started += started;
+    this->m_metrics.exited += events.size() - started;
+    return events;
+}
+
+#ifdef _WIN32
+SnapshotProcessWatcher::Source SnapshotProcessWatcher::makePlatformSource()
+{
+    // Names from the latest snapshot, narrowed only when asked for
+    auto names = std::make_shared<std::unordered_map<unsigned long, std::wstring>>();
+
+    Source source;
+    source.name = "toolhelp";
+    source.list_pids = [names](std::vector<unsigned long>& pids) -> bool {
+        HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+        if (snapshot == INVALID_HANDLE_VALUE)
+            return false;
+
+        PROCESSENTRY32 entry;
+        entry.dwSize = sizeof(PROCESSENTRY32);
+        names->clear();
+        if (Process32First(snapshot, &entry)) {
+            do {
+                pids.push_back(entry.th32ProcessID);
+                names->emplace(entry.th32ProcessID, entry.szExeFile);
+            } while (Process32Next(snapshot, &entry));
+        }
+        CloseHandle(snapshot);
+        return true;
+    };
+    source.get_name = [names](unsigned long pid) -> std::optional<std::string> {
+        auto found = names->find(pid);
+        if (found == names->end())
+            return std::nullopt;
+        std::string name;
+        name.reserve(found->second.size());
+        for (wchar_t c : found->second)
+            name.push_back(c < 0x80 ? static_cast<char>(c) : '?');
+        return name;
+    };
+    return source;
+}
+#else
+SnapshotProcessWatcher::Source SnapshotProcessWatcher::makePlatformSource()
+{
+    Source source;
+    source.name = "procfs";
+    source.list_pids = [](std::vector<unsigned long>& pids) -> bool {
+        DIR* proc = opendir("/proc");
+        if (proc == nullptr)
+            return false;
+        while (dirent* entry = readdir(proc)) {
+            char* end = nullptr;
+            unsigned long pid = std::strtoul(entry->d_name, &end, 10);
+            if (end != entry->d_name && *end == '\0')
+                pids.push_back(pid);
+        }
+        closedir(proc);
+        return true;
+    };
+    source.get_name = [](unsigned long pid) -> std::optional<std::string> {
+        std::string base = "/proc/" + std::to_string(pid);
+
+        // The executable's full name, falling back to the (15 character) command name for processes we can't inspect
+        char target[4096];
+        ssize_t length = readlink((base + "/exe").c_str(), target, sizeof(target) - 1);
+        if (length > 0) {
+            std::string path(target, static_cast<std::size_t>(length));
+            return path.substr(path.find_last_of('/') + 1);
+        }
+        std::ifstream comm(base + "/comm");
+        std::string name;
+        if (!std::getline(comm, name))
+            return std::nullopt;
+        return name;
+    };
+    return source;
+}
+#endif
@@ -0,0 +1,79 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <IProcessWatcher.hpp>
+
+/// <summary>
+/// Finds processes starting and exiting by diffing the list of running PIDs between scans. Names are only looked up for PIDs that are new since
+/// the last scan, so a scan where nothing changed costs one listing of PIDs and no per process work.
+/// </summary>
+class SnapshotProcessWatcher : public IProcessWatcher
+{
+public:
+    /// <summary>
+    /// Where the process list comes from
+    /// </summary>
+    struct Source {
+        /// <summary>
+        /// Fills the list with the PIDs of every running process, returns false if the list could not be taken
+        /// </summary>
+        std::function<bool(std::vector<unsigned long>&)> list_pids;
+
+        /// <summary>
+        /// Gets the executable name of a process from the latest list, nullopt if it has already gone
+        /// </summary>
+        std::function<std::optional<std::string>(unsigned long)> get_name;
+
+        const char* name;
+    };
+
+    /// <summary>
+    /// Scans the platform's process list: a Toolhelp snapshot on Windows, /proc on Linux
+    /// </summary>
+    SnapshotProcessWatcher();
+
+    explicit SnapshotProcessWatcher(Source source);
+
+    std::vector<Event> waitForEvents(std::chrono::milliseconds timeout) override;
+    void interrupt() override;
+    bool isEventDriven() const override;
+    const char* getBackendName() const override;
+    Metrics getMetrics() const override;
+
+    /// <summary>
+    /// Scans now, without waiting
+    /// </summary>
+    std::vector<Event> scan();
+
+    /// <summary>
+    /// Gets the source for the platform's process list
+    /// </summary>
+    static Source makePlatformSource();
+
+private:
+    Source m_source;
+
+    std::unordered_set<unsigned long> m_known;
+    std::vector<unsigned long> m_pids;
+    bool m_hasScanned = false;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_interrupted = false;
+    Metrics m_metrics;
+};
@@ -0,0 +1,53 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+/// <summary>
+/// Minimal non-owning view over a contiguous sequence (a subset of C++20's std::span, as this project is built as C++17)
+/// </summary>
+template<typename T>
+class Span
+{
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr Span() noexcept = default;
+
+    constexpr Span(T* data, std::size_t size) noexcept :
+        m_data(data),
+        m_size(size)
+    {}
+
+    /// <summary>
+    /// Views any contiguous container with data() and size() (ie. std::vector, std::array)
+    /// </summary>
+    template<typename Container, typename = std::enable_if_t<std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>>>
+    constexpr Span(Container& container) noexcept :
+        m_data(container.data()),
+        m_size(container.size())
+    {}
+
+    constexpr T* data() const noexcept { return this->m_data; }
+    constexpr std::size_t size() const noexcept { return this->m_size; }
+    constexpr bool empty() const noexcept { return this->m_size == 0; }
+
+    constexpr T& operator[](std::size_t index) const { return this->m_data[index]; }
+
+    constexpr iterator begin() const noexcept { return this->m_data; }
+    constexpr iterator end() const noexcept { return this->m_data + this->m_size; }
+
+private:
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+};
@@ -0,0 +1,88 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+/// <summary>
+/// A bounded queue between one producer thread and one consumer thread. Both ends are wait free: a push or pop is a copy and a couple of atomic
+/// loads and stores, and a push into a full queue fails straight away rather than waiting for the consumer.
+/// </summary>
+template<typename T>
+class SpscQueue
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Items are copied in and out of the ring");
+
+public:
+    /// <summary>
+    /// Creates the queue
+    /// </summary>
+    /// <param name="capacity">Items the queue holds, rounded up to a power of two</param>
+    explicit SpscQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        this->m_items = std::make_unique<T[]>(size);
+        this->m_mask = size - 1;
+    }
+
+    /// <summary>
+    /// Adds an item, from the producer thread only
+    /// </summary>
+    /// <returns>Whether there was room for it</returns>
+    bool tryPush(const T& item)
+    {
+        std::size_t tail = this->m_tail.load(std::memory_order_relaxed);
+        if (tail - this->m_cachedHead > this->m_mask) {
+            // Only look at the consumer's index when the cached one says we are full
+            this->m_cachedHead = this->m_head.load(std::memory_order_acquire);
+            if (tail - this->m_cachedHead > this->m_mask)
+                return false;
+        }
+        this->m_items[tail & this->m_mask] = item;
+        this->m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// <summary>
+    /// Takes the oldest item, from the consumer thread only
+    /// </summary>
+    std::optional<T> tryPop()
+    {
+        std::size_t head = this->m_head.load(std::memory_order_relaxed);
+        if (head == this->m_cachedTail) {
+            this->m_cachedTail = this->m_tail.load(std::memory_order_acquire);
+            if (head == this->m_cachedTail)
+                return std::nullopt;
+        }
+        T item = this->m_items[head & this->m_mask];
+        this->m_head.store(head + 1, std::memory_order_release);
+        return item;
+    }
+
+    std::size_t capacity() const
+    {
+        return this->m_mask + 1;
+    }
+
+private:
+    std::unique_ptr<T[]> m_items;
+    std::size_t m_mask;
+
+    // Each end's index and its cached copy of the other end's on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+    std::size_t m_cachedHead = 0;
+    alignas(64) std::atomic<std::size_t> m_head{ 0 };
+    std::size_t m_cachedTail = 0;
+};
@@ -0,0 +1,303 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+/// <summary>
+/// Case-insensitive pattern compiled at compile time, used in place of std::regex for matching device model numbers and process names.
+/// Supports the small subset of ECMAScript regex syntax the driver actually uses:
+///     ^           anchors the pattern to the start of the input (only valid as the first character)
+///     \d+         one or more digits
+///     \s*         zero or more whitespace characters
+///     (abc)       a literal group
+///     (abc)*      zero or more repetitions of a literal group
+///     \X          the literal character X
+/// Anything else is matched literally. search() has the same semantics as std::regex_search with std::regex_constants::icase (ASCII only).
+/// </summary>
+class StringPattern
+{
+public:
+    /// <summary>
+    /// Maximum number of tokens a pattern can compile to
+    /// </summary>
+    static constexpr std::size_t m_maxTokens = 8;
+
+    /// <summary>
+    /// Compiles a pattern. When used to initialise a constexpr variable, invalid patterns fail to compile.
+    /// </summary>
+    /// <param name="pattern">Pattern source, which must outlive the compiled pattern (ie. a string literal)</param>
+    /// <exception cref="std::invalid_argument">When the pattern uses unsupported syntax or has too many tokens</exception>
+    /// <returns>Compiled pattern</returns>
+    static constexpr StringPattern compile(std::string_view pattern)
+    {
+        StringPattern out;
+        std::size_t i = 0;
+        if (!pattern.empty() && pattern[0] == '^') {
+            out.m_anchored = true;
+            i = 1;
+        }
+
+        std::size_t literal_start = i;
+        auto flush_literal = [&](std::size_t end) {
+            if (end > literal_start)
+                out.push({ TokenKind::Literal, pattern.substr(literal_start, end - literal_start) });
+        };
+
+        while (i < pattern.size()) {
+            char c = pattern[i];
+            if (c == '\\') {
+                if (i + 1 >= pattern.size())
+                    throw std::invalid_argument("Trailing escape in pattern");
+                flush_literal(i);
+                char escaped = pattern[i + 1];
+                if (escaped == 'd') {
+                    if (i + 2 >= pattern.size() || pattern[i + 2] != '+')
+                        throw std::invalid_argument("\\d is only supported as \\d+");
+                    out.push({ TokenKind::Digits, {} });
+                    i += 3;
+                }
+                else if (escaped == 's') {
+                    if (i + 2 >= pattern.size() || pattern[i + 2] != '*')
+                        throw std::invalid_argument("\\s is only supported as \\s*");
+                    out.push({ TokenKind::Whitespace, {} });
+                    i += 3;
+                }
+                else {
+                    out.push({ TokenKind::Literal, pattern.substr(i + 1, 1) });
+                    i += 2;
+                }
+                literal_start = i;
+            }
+            else if (c == '(') {
+                flush_literal(i);
+                std::size_t close = pattern.find(')', i + 1);
+                if (close == std::string_view::npos)
+                    throw std::invalid_argument("Unterminated group in pattern");
+                std::string_view group = pattern.substr(i + 1, close - i - 1);
+                for (char g : group) {
+                    if (isSpecial(g))
+                        throw std::invalid_argument("Groups may only contain literal characters");
+                }
+                bool repeated = close + 1 < pattern.size() && pattern[close + 1] == '*';
+                if (group.empty())
+                    throw std::invalid_argument("Empty group in pattern");
+                out.push({ repeated ? TokenKind::RepeatedLiteral : TokenKind::Literal, group });
+                i = close + (repeated ? 2 : 1);
+                literal_start = i;
+            }
+            else if (isSpecial(c)) {
+                throw std::invalid_argument("Unsupported pattern syntax");
+            }
+            else {
+                ++i;
+            }
+        }
+        flush_literal(i);
+
+        // Precompute the prefilter: the shortest input that could match, and the first character a match has to start with
+        for (std::size_t t = 0; t < out.m_tokenCount; ++t) {
+            const Token& token = out.m_tokens[t];
+            if (token.kind == TokenKind::Literal)
+                out.m_minLength += token.text.size();
+            else if (token.kind == TokenKind::Digits)
+                out.m_minLength += 1;
+        }
+        if (out.m_tokenCount > 0 && out.m_tokens[0].kind == TokenKind::Literal)
+            out.m_firstChar = toLower(out.m_tokens[0].text[0]);
+        return out;
+    }
+
+    /// <summary>
+    /// Searches for the pattern anywhere in the input (or at its start, if anchored)
+    /// </summary>
+    /// <param name="input">String to search</param>
+    /// <returns>True if the pattern matches a part of the input</returns>
+    constexpr bool search(std::string_view input) const
+    {
+        if (input.size() < this->m_minLength)
+            return false;
+        if (this->m_anchored)
+            return this->matchFrom(0, input, 0);
+
+        std::size_t last_start = input.size() - this->m_minLength;
+        for (std::size_t start = 0; start <= last_start; ++start) {
+            if (this->m_firstChar != '\0' && toLower(input[start]) != this->m_firstChar)
+                continue;
+            if (this->matchFrom(0, input, start))
+                return true;
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Gets the length of the shortest input that could match
+    /// </summary>
+    constexpr std::size_t getMinLength() const { return this->m_minLength; }
+
+    /// <summary>
+    /// Gets the number of compiled tokens
+    /// </summary>
+    constexpr std::size_t getTokenCount() const { return this->m_tokenCount; }
+
+    static constexpr char toLower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    /// <summary>
+    /// Case-insensitive (ASCII) comparison of two strings of the same length
+    /// </summary>
+    static constexpr bool equalsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (toLower(a[i]) != toLower(b[i]))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    enum class TokenKind {
+        Literal,
+        Digits,
+        Whitespace,
+        RepeatedLiteral
+    };
+
+    struct Token {
+        TokenKind kind = TokenKind::Literal;
+        std::string_view text;
+    };
+
+    constexpr StringPattern() = default;
+
+    static constexpr bool isSpecial(char c)
+    {
+        switch (c) {
+        case '^': case '$': case '.': case '*': case '+': case '?':
+        case '(': case ')': case '[': case ']': case '{': case '}': case '|': case '\\':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    static constexpr bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    constexpr void push(Token token)
+    {
+        if (this->m_tokenCount >= m_maxTokens)
+            throw std::invalid_argument("Pattern has too many tokens");
+        this->m_tokens[this->m_tokenCount++] = token;
+    }
+
+    /// <summary>
+    /// Matches tokens [token, end) against the input starting at position, backtracking greedily like std::regex
+    /// </summary>
+    constexpr bool matchFrom(std::size_t token, std::string_view input, std::size_t position) const
+    {
+        if (token == this->m_tokenCount)
+            return true;
+
+        const Token& current = this->m_tokens[token];
+        switch (current.kind) {
+        case TokenKind::Literal:
+            if (input.size() - position < current.text.size() || !equalsIgnoreCase(input.substr(position, current.text.size()), current.text))
+                return false;
+            return this->matchFrom(token + 1, input, position + current.text.size());
+
+        case TokenKind::Digits:
+        case TokenKind::Whitespace: {
+            bool digits = current.kind == TokenKind::Digits;
+            std::size_t end = position;
+            while (end < input.size() && (digits ? isDigit(input[end]) : isWhitespace(input[end])))
+                ++end;
+            std::size_t minimum = position + (digits ? 1 : 0);
+            for (std::size_t i = end + 1; i-- > minimum;) {
+                if (this->matchFrom(token + 1, input, i))
+                    return true;
+            }
+            return false;
+        }
+
+        case TokenKind::RepeatedLiteral: {
+            std::size_t end = position;
+            while (input.size() - end >= current.text.size() && equalsIgnoreCase(input.substr(end, current.text.size()), current.text))
+                end += current.text.size();
+            for (std::size_t i = end; ; i -= current.text.size()) {
+                if (this->matchFrom(token + 1, input, i))
+                    return true;
+                if (i == position)
+                    return false;
+            }
+        }
+        }
+        return false;
+    }
+
+    std::array<Token, m_maxTokens> m_tokens{};
+    std::size_t m_tokenCount = 0;
+    std::size_t m_minLength = 0;
+    char m_firstChar = '\0';
+    bool m_anchored = false;
+};
+
+/// <summary>
+/// Compile time table of patterns and associated values, searched in order. The tables are small (six to eight entries), where each pattern's
+/// first-character prefilter beats indexing the entries by the characters in the input.
+/// </summary>
+template<typename Value, std::size_t N>
+class StringPatternTable
+{
+public:
+    using Entry = std::pair<StringPattern, Value>;
+
+    constexpr StringPatternTable(const std::array<Entry, N>& entries) :
+        m_entries(entries)
+    {
+        for (const auto& entry : entries) {
+            if (entry.first.getMinLength() < this->m_minLength)
+                this->m_minLength = entry.first.getMinLength();
+        }
+    }
+
+    /// <summary>
+    /// Finds the first entry whose pattern matches the input
+    /// </summary>
+    /// <param name="input">String to search</param>
+    /// <returns>Pointer to the value of the matching entry, or nullptr if nothing matched</returns>
+    constexpr const Value* find(std::string_view input) const
+    {
+        if (input.size() < this->m_minLength)
+            return nullptr;
+        for (const auto& entry : this->m_entries) {
+            if (entry.first.search(input))
+                return &entry.second;
+        }
+        return nullptr;
+    }
+
+    constexpr const std::array<Entry, N>& getEntries() const { return this->m_entries; }
+
+private:
+    std::array<Entry, N> m_entries;
+    std::size_t m_minLength = static_cast<std::size_t>(-1);
+};
@@ -0,0 +1,66 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+/// <summary>
+/// Running statistics for a repeatedly timed section of code (ie. RunFrame), in microseconds
+/// </summary>
+struct TimingStats
+{
+    /// <summary>
+    /// Records a new duration sample
+    /// </summary>
+    /// <param name="duration">Duration of the timed section</param>
+    void record(std::chrono::steady_clock::duration duration) {
+        this->last_us = std::chrono::duration<double, std::micro>(duration).count();
+        this->max_us = std::max(this->max_us, this->last_us);
+        this->total_us += this->last_us;
+        ++this->count;
+    }
+
+    /// <summary>
+    /// Gets the mean duration of all recorded samples
+    /// </summary>
+    /// <returns>Mean duration in microseconds, or 0 if there are no samples</returns>
+    double meanMicroseconds() const {
+        return this->count == 0 ? 0.0 : this->total_us / static_cast<double>(this->count);
+    }
+
+    double last_us = 0.0;
+    double max_us = 0.0;
+    double total_us = 0.0;
+    uint64_t count = 0;
+};
+
+/// <summary>
+/// Records the lifetime of this object into a TimingStats on destruction
+/// </summary>
+class ScopedTimer
+{
+public:
+    ScopedTimer(TimingStats& stats) :
+        m_stats(stats),
+        m_start(std::chrono::steady_clock::now())
+    {}
+
+    ~ScopedTimer() {
+        this->m_stats.record(std::chrono::steady_clock::now() - this->m_start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    TimingStats& m_stats;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,213 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "TrackedDeviceDirectory.hpp"
+#include <DriverAnalytics.hpp>
+
+#include <algorithm>
+
+using SystemType = MasslessInterface::TrackingSystemType::SystemType;
+
+TrackedDeviceDirectory::TrackedDeviceDirectory()
+{
+    this->m_trackingReferences.reserve(vr::k_unMaxTrackedDeviceCount);
+}
+
+void TrackedDeviceDirectory::processEvents(EventSpan events)
+{
+    for (const auto& event : events) {
+        switch (event.eventType) {
+        case vr::VREvent_TrackedDeviceActivated:
+        case vr::VREvent_TrackedDeviceDeactivated:
+        case vr::VREvent_TrackedDeviceUpdated:
+            this->invalidate(event.trackedDeviceIndex);
+            break;
+
+        case vr::VREvent_PropertyChanged:
+            // Only the properties we classify on are worth re-reading
+            switch (event.data.property.prop) {
+            case vr::Prop_ModelNumber_String:
+            case vr::Prop_RenderModelName_String:
+            case vr::Prop_SerialNumber_String:
+            case vr::Prop_ControllerRoleHint_Int32:
+                this->invalidate(event.trackedDeviceIndex);
+                break;
+            default:
+                break;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+void TrackedDeviceDirectory::refresh(const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties)
+{
+    bool changed = false;
+    for (vr::TrackedDeviceIndex_t index = 0; index < vr::k_unMaxTrackedDeviceCount; ++index) {
+        DeviceEntry& entry = this->m_entries[index];
+        bool connected = poses.isConnected(index);
+        if (entry.connected != connected) {
+            entry.connected = connected;
+            changed = true;
+        }
+        if (connected && !entry.classified && this->classify(index, properties))
+            changed = true;
+    }
+
+    if (changed)
+        this->rebuildIndices();
+}
+
+void TrackedDeviceDirectory::invalidateAll()
+{
+    for (vr::TrackedDeviceIndex_t index = 0; index < vr::k_unMaxTrackedDeviceCount; ++index)
+        this->invalidate(index);
+}
+
+void TrackedDeviceDirectory::invalidate(vr::TrackedDeviceIndex_t device_index)
+{
+    if (device_index >= vr::k_unMaxTrackedDeviceCount)
+        return;
+    DeviceEntry& entry = this->m_entries[device_index];
+    if (!entry.classified)
+        return;
+
+    auto it = this->m_serialToIndex.find(entry.serial);
+    if (it != this->m_serialToIndex.end() && it->second == device_index)
+        this->m_serialToIndex.erase(it);
+
+    bool connected = entry.connected;
+    entry = DeviceEntry();
+    entry.connected = connected;
+    this->rebuildIndices();
+}
+
+const TrackedDeviceDirectory::DeviceEntry* TrackedDeviceDirectory::getEntry(vr::TrackedDeviceIndex_t device_index) const
+{
+    if (device_index >= vr::k_unMaxTrackedDeviceCount)
+        return nullptr;
+    return &this->m_entries[device_index];
+}
+
+std::optional<vr::TrackedDeviceIndex_t> TrackedDeviceDirectory::findIndex(const std::string& device_serial) const
+{
+    auto it = this->m_serialToIndex.find(device_serial);
+    if (it == this->m_serialToIndex.end() || !this->m_entries[it->second].connected)
+        return std::nullopt;
+    return it->second;
+}
+
+uint64_t TrackedDeviceDirectory::getDevicesOfType(SystemType system_type) const
+{
+    auto type_index = static_cast<std::size_t>(system_type);
+    if (type_index >= this->m_typeMasks.size())
+        return 0;
+    return this->m_typeMasks[type_index];
+}
+
+const std::vector<vr::TrackedDeviceIndex_t>& TrackedDeviceDirectory::getTrackingReferences() const
+{
+    return this->m_trackingReferences;
+}
+
+uint64_t TrackedDeviceDirectory::getGeneration() const
+{
+    return this->m_generation;
+}
+
+uint64_t TrackedDeviceDirectory::getClassificationCount() const
+{
+    return this->m_classificationCount;
+}
+
+bool TrackedDeviceDirectory::classify(vr::TrackedDeviceIndex_t device_index, vr::CVRPropertyHelpers* properties)
+{
+    ++this->m_classificationCount;
+    vr::PropertyContainerHandle_t device_props = properties->TrackedDeviceToPropertyContainer(device_index);
+
+    // Without a serial we can't identify the device, so wait for its properties to be populated
+    vr::ETrackedPropertyError error = vr::ETrackedPropertyError::TrackedProp_Success;
+    std::string serial = properties->GetStringProperty(device_props, vr::Prop_SerialNumber_String, &error);
+    if (error != vr::ETrackedPropertyError::TrackedProp_Success)
+        return false;
+
+    DeviceEntry entry;
+    entry.classified = true;
+    entry.connected = this->m_entries[device_index].connected;
+    entry.serial = serial;
+
+    // Same matching order as DriverAnalytics::isTrackingReference and DriverAnalytics::getReferenceSystemType
+    std::string model_number = properties->GetStringProperty(device_props, vr::Prop_ModelNumber_String, &error);
+    if (error == vr::ETrackedPropertyError::TrackedProp_Success) {
+        if (auto system_type = DriverAnalytics::matchModelNumber(model_number); system_type.has_value()) {
+            entry.is_tracking_reference = true;
+            entry.type = *system_type;
+        }
+        else {
+            std::string render_model = properties->GetStringProperty(device_props, vr::Prop_RenderModelName_String, &error);
+            if (error == vr::ETrackedPropertyError::TrackedProp_Success && DriverAnalytics::matchesViveTrackerV1RenderModel(render_model))
+                entry.type = SystemType::VIVE_TRACKER;
+        }
+    }
+    else {
+        bool model_not_ready = error == vr::ETrackedPropertyError::TrackedProp_NotYetAvailable;
+        std::string render_model = properties->GetStringProperty(device_props, vr::Prop_RenderModelName_String, &error);
+        if (error == vr::ETrackedPropertyError::TrackedProp_Success) {
+            if (DriverAnalytics::matchesViveTrackerV1RenderModel(render_model)) {
+                entry.is_tracking_reference = true;
+                entry.type = SystemType::VIVE_TRACKER;
+            }
+        }
+        else if (model_not_ready) {
+            return false;
+        }
+    }
+
+    int32_t controller_role = properties->GetInt32Property(device_props, vr::Prop_ControllerRoleHint_Int32, &error);
+    if (error == vr::ETrackedPropertyError::TrackedProp_Success)
+        entry.controller_role = controller_role;
+
+    // A serial can only belong to one slot
+    if (auto it = this->m_serialToIndex.find(serial); it != this->m_serialToIndex.end() && it->second != device_index)
+        this->m_entries[it->second] = DeviceEntry();
+
+    this->m_entries[device_index] = entry;
+    this->m_serialToIndex[serial] = device_index;
+    return true;
+}
+
+void TrackedDeviceDirectory::rebuildIndices()
+{
+    this->m_typeMasks.fill(0);
+    this->m_trackingReferences.clear();
+
+    for (vr::TrackedDeviceIndex_t index = 0; index < vr::k_unMaxTrackedDeviceCount; ++index) {
+        const DeviceEntry& entry = this->m_entries[index];
+        if (!entry.classified || !entry.connected || !entry.is_tracking_reference)
+            continue;
+        auto type_index = static_cast<std::size_t>(entry.type.getSystemType());
+        if (type_index < this->m_typeMasks.size())
+            this->m_typeMasks[type_index] |= uint64_t(1) << index;
+        this->m_trackingReferences.push_back(index);
+    }
+
+    // Vive trackers first, matching DriverAnalytics::firstPass
+    std::stable_sort(this->m_trackingReferences.begin(), this->m_trackingReferences.end(),
+        [&](vr::TrackedDeviceIndex_t a, vr::TrackedDeviceIndex_t b) {
+            int priority_a = this->m_entries[a].type.getSystemType() == SystemType::VIVE_TRACKER ? 0 : 1;
+            int priority_b = this->m_entries[b].type.getSystemType() == SystemType::VIVE_TRACKER ? 0 : 1;
+            return priority_a < priority_b;
+        }
+    );
+
+    ++this->m_generation;
+}
@@ -0,0 +1,163 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <openvr_driver.h>
+
+#include <IUpdatable.hpp>
+#include <DevicePoseSnapshot.hpp>
+#include <TrackingSystemType.hpp>
+
+/// <summary>
+/// Cache of the tracked devices known to SteamVR and what kind of tracking reference (if any) each one is.
+/// Each device is classified once from its properties, and only reclassified after an activation, deactivation, or relevant property changed event for it.
+/// </summary>
+class TrackedDeviceDirectory
+{
+public:
+    /// <summary>
+    /// Cached information about a single tracked device slot
+    /// </summary>
+    struct DeviceEntry {
+        /// <summary>
+        /// Have this device's properties been read since it was last invalidated?
+        /// </summary>
+        bool classified = false;
+
+        /// <summary>
+        /// Was the device connected at the last refresh?
+        /// </summary>
+        bool connected = false;
+
+        /// <summary>
+        /// Is this a device we can use as a tracking reference (same rules as DriverAnalytics::isTrackingReference)?
+        /// </summary>
+        bool is_tracking_reference = false;
+
+        /// <summary>
+        /// Tracking system type (same rules as DriverAnalytics::getReferenceSystemType)
+        /// </summary>
+        MasslessInterface::TrackingSystemType type;
+
+        /// <summary>
+        /// Device serial
+        /// </summary>
+        std::string serial;
+
+        /// <summary>
+        /// Controller role hint, used to tell left and right Rift S/Quest controllers apart
+        /// </summary>
+        std::optional<int32_t> controller_role;
+    };
+
+    TrackedDeviceDirectory();
+
+    /// <summary>
+    /// Invalidates the entries of any devices that were activated, deactivated, or had an identifying property changed
+    /// </summary>
+    /// <param name="events">Events polled this frame</param>
+    void processEvents(EventSpan events);
+
+    /// <summary>
+    /// Updates the connection state of all devices, and classifies any connected devices that are not yet classified.
+    /// Devices whose properties are not available yet are retried on the next refresh.
+    /// </summary>
+    /// <param name="poses">Device poses captured this frame</param>
+    /// <param name="properties">CVRPropertyHelpers pointer (usually vr::VRProperties())</param>
+    void refresh(const DevicePoseSnapshot& poses, vr::CVRPropertyHelpers* properties);
+
+    /// <summary>
+    /// Marks every device as needing reclassification
+    /// </summary>
+    void invalidateAll();
+
+    /// <summary>
+    /// Marks a single device as needing reclassification
+    /// </summary>
+    /// <param name="device_index">device index</param>
+    void invalidate(vr::TrackedDeviceIndex_t device_index);
+
+    /// <summary>
+    /// Gets the cached entry for a device
+    /// </summary>
+    /// <param name="device_index">device index</param>
+    /// <returns>The entry, or nullptr if the index is out of range</returns>
+    const DeviceEntry* getEntry(vr::TrackedDeviceIndex_t device_index) const;
+
+    /// <summary>
+    /// Gets the index of a classified device by serial
+    /// </summary>
+    /// <param name="device_serial">device serial</param>
+    /// <returns>index of the device, or nullopt if no connected device has this serial</returns>
+    std::optional<vr::TrackedDeviceIndex_t> findIndex(const std::string& device_serial) const;
+
+    /// <summary>
+    /// Gets a bitmask of the connected tracking references of a system type (bit n set = device index n)
+    /// </summary>
+    /// <param name="system_type">Tracking system type</param>
+    /// <returns>Bitmask of device indices</returns>
+    uint64_t getDevicesOfType(MasslessInterface::TrackingSystemType::SystemType system_type) const;
+
+    /// <summary>
+    /// Gets the connected tracking references, sorted by priority (0 = highest), equivalent to DriverAnalytics::firstPass
+    /// </summary>
+    /// <returns>List of possible tracking references</returns>
+    const std::vector<vr::TrackedDeviceIndex_t>& getTrackingReferences() const;
+
+    /// <summary>
+    /// Gets a counter that is incremented whenever any entry changes
+    /// </summary>
+    /// <returns>Change counter</returns>
+    uint64_t getGeneration() const;
+
+    /// <summary>
+    /// Gets the number of property based classifications done so far (for diagnostics)
+    /// </summary>
+    /// <returns>Number of classifications</returns>
+    uint64_t getClassificationCount() const;
+
+private:
+    /// <summary>
+    /// Reads a device's properties and fills in its entry
+    /// </summary>
+    /// <returns>True if the device could be classified, false if its properties are not available yet</returns>
+    bool classify(vr::TrackedDeviceIndex_t device_index, vr::CVRPropertyHelpers* properties);
+
+    /// <summary>
+    /// Rebuilds the type masks and the sorted tracking reference list from the entries
+    /// </summary>
+    void rebuildIndices();
+
+    std::array<DeviceEntry, vr::k_unMaxTrackedDeviceCount> m_entries;
+
+    /// <summary>
+    /// Lookup from serial to device index, for classified devices
+    /// </summary>
+    std::unordered_map<std::string, vr::TrackedDeviceIndex_t> m_serialToIndex;
+
+    /// <summary>
+    /// Bitmask of connected tracking reference device indices for each system type
+    /// </summary>
+    std::array<uint64_t, static_cast<std::size_t>(MasslessInterface::TrackingSystemType::SystemType::OCULUS_RIFT_S_TOUCH_LEFT) + 1> m_typeMasks = { 0 };
+
+    /// <summary>
+    /// Connected tracking references, sorted by priority
+    /// </summary>
+    std::vector<vr::TrackedDeviceIndex_t> m_trackingReferences;
+
+    uint64_t m_generation = 0;
+    uint64_t m_classificationCount = 0;
+};
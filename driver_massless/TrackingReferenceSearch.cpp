@@ -0,0 +1,180 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "TrackingReferenceSearch.hpp"
+#include <DriverLog.hpp>
+
+#include <algorithm>
+
+TrackingReferenceSearch::TrackingReferenceSearch() :
+    TrackingReferenceSearch(Timings(), Clock::now)
+{}
+
+TrackingReferenceSearch::TrackingReferenceSearch(Timings timings, ClockFunction clock) :
+    m_timings(timings),
+    m_clock(clock),
+    m_backoff(timings.initial_backoff)
+{}
+
+void TrackingReferenceSearch::start()
+{
+    if (this->m_state != State::Idle)
+        return;
+    this->m_searchStart = this->m_clock();
+    this->restart();
+}
+
+void TrackingReferenceSearch::restart()
+{
+    this->m_nextProbe = this->m_clock();
+    this->m_backoff = this->m_timings.initial_backoff;
+    this->m_probeCount = 0;
+    this->m_reevaluatePending = false;
+    this->setState(State::Searching);
+}
+
+bool TrackingReferenceSearch::shouldProbe() const
+{
+    return this->m_state == State::Searching && this->m_clock() >= this->m_nextProbe;
+}
+
+void TrackingReferenceSearch::onProbeFailed()
+{
+    ++this->m_probeCount;
+    this->m_nextProbe = this->m_clock() + this->m_backoff;
+    this->m_backoff = std::min(this->m_backoff * 2, this->m_timings.max_backoff);
+}
+
+void TrackingReferenceSearch::onCandidateFound(bool trusted)
+{
+    if (this->m_state != State::Searching)
+        return;
+    ++this->m_probeCount;
+    this->m_candidateTrusted = trusted;
+    this->m_validationStart = this->m_clock();
+    this->setState(State::Validating);
+}
+
+bool TrackingReferenceSearch::onCandidateValidated(bool pose_valid)
+{
+    if (this->m_state != State::Validating)
+        return false;
+
+    if (!pose_valid) {
+        this->setState(State::Searching);
+        this->m_nextProbe = this->m_clock() + this->m_backoff;
+        this->m_backoff = std::min(this->m_backoff * 2, this->m_timings.max_backoff);
+        return false;
+    }
+
+    if (!this->m_candidateTrusted && this->m_clock() - this->m_validationStart < this->m_timings.validation_period)
+        return false;
+
+    this->setState(State::Locked);
+    return true;
+}
+
+void TrackingReferenceSearch::onDeviceActivated(bool reevaluate)
+{
+    switch (this->m_state) {
+    case State::Searching:
+        // Something new to look at, so don't wait out the backoff
+        this->m_backoff = this->m_timings.initial_backoff;
+        this->m_nextProbe = this->m_clock();
+        break;
+
+    case State::Locked:
+        // Only start the timer if one isn't already running, so a burst of activations is evaluated once
+        if (reevaluate && !this->m_reevaluatePending) {
+            this->m_reevaluatePending = true;
+            this->m_reevaluateTime = this->m_clock() + this->m_timings.settle_delay;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool TrackingReferenceSearch::consumeReevaluation()
+{
+    if (this->m_state != State::Locked || !this->m_reevaluatePending || this->m_clock() < this->m_reevaluateTime)
+        return false;
+    this->m_reevaluatePending = false;
+    return true;
+}
+
+void TrackingReferenceSearch::onReferenceLost()
+{
+    if (this->m_state != State::Locked)
+        return;
+    this->m_lostTime = this->m_clock();
+    this->setState(State::Lost);
+}
+
+void TrackingReferenceSearch::onReferenceRecovered()
+{
+    if (this->m_state != State::Lost)
+        return;
+    this->setState(State::Locked);
+}
+
+bool TrackingReferenceSearch::hasLostTimedOut() const
+{
+    return this->m_state == State::Lost && this->m_clock() - this->m_lostTime >= this->m_timings.lost_timeout;
+}
+
+bool TrackingReferenceSearch::hasHintExpired() const
+{
+    return this->m_state != State::Idle && this->m_clock() - this->m_searchStart >= this->m_timings.hint_timeout;
+}
+
+TrackingReferenceSearch::State TrackingReferenceSearch::getState() const
+{
+    return this->m_state;
+}
+
+uint32_t TrackingReferenceSearch::getProbeCount() const
+{
+    return this->m_probeCount;
+}
+
+std::chrono::milliseconds TrackingReferenceSearch::getBackoff() const
+{
+    return this->m_backoff;
+}
+
+std::chrono::milliseconds TrackingReferenceSearch::getTimeUntilProbe() const
+{
+    if (this->m_state != State::Searching)
+        return std::chrono::milliseconds(0);
+    auto remaining = this->m_nextProbe - this->m_clock();
+    if (remaining <= Clock::duration::zero())
+        return std::chrono::milliseconds(0);
+    return std::chrono::ceil<std::chrono::milliseconds>(remaining);
+}
+
+std::string TrackingReferenceSearch::getStateName(State state)
+{
+    switch (state) {
+    case State::Idle: return "idle";
+    case State::Searching: return "searching";
+    case State::Validating: return "validating";
+    case State::Locked: return "locked";
+    case State::Lost: return "lost";
+    default: return "unknown";
+    }
+}
+
+void TrackingReferenceSearch::setState(State state)
+{
+    if (state != this->m_state)
+        DRIVER_LOG_INFO(Reference, "Tracking reference search: %s -> %s.\n", getStateName(this->m_state).c_str(), getStateName(state).c_str());
+    this->m_state = state;
+}
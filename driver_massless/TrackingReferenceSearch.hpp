@@ -0,0 +1,185 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/// <summary>
+/// State machine for discovering and keeping hold of the tracking reference.
+///     Idle        -> Searching    when the pen is added (start)
+///     Searching   -> Validating   when a probe finds a candidate; failed probes are retried with exponential backoff
+///     Validating  -> Locked       when the candidate's pose has stayed valid for the validation period, or straight away for a trusted candidate
+///     Validating  -> Searching    when the candidate's pose goes invalid
+///     Locked      -> Lost         when the reference is deactivated
+///     Lost        -> Locked       when the reference comes back before the lost timeout
+///     Lost        -> Searching    when the lost timeout expires (restart)
+///     Locked      -> Searching    when a re-evaluation after a device activation prefers another device (restart)
+/// All timers are wall time from an injectable clock, so behaviour doesn't depend on the frame rate.
+/// This class only decides when things should happen; ServerDriver does the probing and owns the tracking reference itself.
+/// </summary>
+class TrackingReferenceSearch
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+
+    enum class State {
+        Idle,
+        Searching,
+        Validating,
+        Locked,
+        Lost
+    };
+
+    /// <summary>
+    /// Timer configuration
+    /// </summary>
+    struct Timings {
+        /// <summary>
+        /// Delay before the first retry after a failed probe
+        /// </summary>
+        std::chrono::milliseconds initial_backoff{ 50 };
+
+        /// <summary>
+        /// Maximum delay between probes
+        /// </summary>
+        std::chrono::milliseconds max_backoff{ 2000 };
+
+        /// <summary>
+        /// How long a candidate's pose has to stay valid before locking on to it
+        /// </summary>
+        std::chrono::milliseconds validation_period{ 100 };
+
+        /// <summary>
+        /// How long to wait after a device activates before re-evaluating the tracking reference (Vive Trackers are not classifiable as soon as they activate)
+        /// </summary>
+        std::chrono::milliseconds settle_delay{ 3000 };
+
+        /// <summary>
+        /// How long a lost reference has to come back before searching for a new one
+        /// </summary>
+        std::chrono::milliseconds lost_timeout{ 5000 };
+
+        /// <summary>
+        /// How long to look for the saved serial hint before searching for any reference
+        /// </summary>
+        std::chrono::milliseconds hint_timeout{ 5000 };
+    };
+
+    TrackingReferenceSearch();
+    TrackingReferenceSearch(Timings timings, ClockFunction clock);
+
+    /// <summary>
+    /// Starts searching (Idle -> Searching), with the first probe due immediately
+    /// </summary>
+    void start();
+
+    /// <summary>
+    /// Clears the current reference and searches again (any state -> Searching), with the backoff reset
+    /// </summary>
+    void restart();
+
+    /// <summary>
+    /// Is a probe for a candidate due this frame?
+    /// </summary>
+    /// <returns>True if Searching and the backoff has elapsed</returns>
+    bool shouldProbe() const;
+
+    /// <summary>
+    /// Records a failed probe and schedules the next one
+    /// </summary>
+    void onProbeFailed();
+
+    /// <summary>
+    /// Records that a probe found a candidate (Searching -> Validating)
+    /// </summary>
+    /// <param name="trusted">Skip the validation period, the candidate locks on its first valid pose (ie. it matched the warm start cache)</param>
+    void onCandidateFound(bool trusted = false);
+
+    /// <summary>
+    /// Reports the candidate's pose validity for this frame while Validating
+    /// </summary>
+    /// <param name="pose_valid">Is the candidate's pose valid?</param>
+    /// <returns>True if the candidate has now been locked on to</returns>
+    bool onCandidateValidated(bool pose_valid);
+
+    /// <summary>
+    /// Records a tracked device activation. Schedules a re-evaluation while Locked, and probes again straight away while Searching.
+    /// </summary>
+    /// <param name="reevaluate">Should a locked reference be re-evaluated (ie. the reference was not forced)?</param>
+    void onDeviceActivated(bool reevaluate);
+
+    /// <summary>
+    /// Is a re-evaluation of the locked reference due? Clears the pending re-evaluation.
+    /// </summary>
+    /// <returns>True if Locked and the settle delay since the last activation has elapsed</returns>
+    bool consumeReevaluation();
+
+    /// <summary>
+    /// Records that the locked reference was deactivated (Locked -> Lost)
+    /// </summary>
+    void onReferenceLost();
+
+    /// <summary>
+    /// Records that the lost reference came back (Lost -> Locked)
+    /// </summary>
+    void onReferenceRecovered();
+
+    /// <summary>
+    /// Has the reference been lost for longer than the lost timeout?
+    /// </summary>
+    bool hasLostTimedOut() const;
+
+    /// <summary>
+    /// Has the search been running for longer than the hint timeout?
+    /// </summary>
+    bool hasHintExpired() const;
+
+    State getState() const;
+
+    /// <summary>
+    /// Gets the number of probes done since the search was last (re)started
+    /// </summary>
+    uint32_t getProbeCount() const;
+
+    /// <summary>
+    /// Gets the delay that will be used after the next failed probe
+    /// </summary>
+    std::chrono::milliseconds getBackoff() const;
+
+    /// <summary>
+    /// Gets the time until the next probe is due (zero if due or not searching)
+    /// </summary>
+    std::chrono::milliseconds getTimeUntilProbe() const;
+
+    /// <summary>
+    /// Gets the name of a state, for logging
+    /// </summary>
+    static std::string getStateName(State state);
+
+private:
+    void setState(State state);
+
+    Timings m_timings;
+    ClockFunction m_clock;
+
+    State m_state = State::Idle;
+    Clock::time_point m_searchStart;
+    Clock::time_point m_nextProbe;
+    Clock::time_point m_validationStart;
+    Clock::time_point m_lostTime;
+    Clock::time_point m_reevaluateTime;
+    bool m_reevaluatePending = false;
+    bool m_candidateTrusted = false;
+    std::chrono::milliseconds m_backoff;
+    uint32_t m_probeCount = 0;
+};
@@ -126,7 +126,7 @@ std::vector<PROCESSENTRY32> VRProcessEnumerator::findVRClientProcesses()
     return vrProcesses;
 }
 
-bool VRProcessEnumerator::isProcessRunning(std::regex exeMatcher)
+bool VRProcessEnumerator::isProcessRunning(const StringPattern& exeMatcher)
 {
     auto process_list = GetProcessList();
     for (const auto& process : process_list) {
@@ -135,7 +135,7 @@ bool VRProcessEnumerator::isProcessRunning(std::regex exeMatcher)
         const std::ctype<char>& ctfacet = std::use_facet<std::ctype<char>>(s.getloc());
         for (size_t i = 0; i < exeName.size(); ++i)
             s << ctfacet.narrow(static_cast<char>(exeName[i]), 0);
-        if (std::regex_search(s.str(), exeMatcher))
+        if (exeMatcher.search(s.str()))
             return true;
     }
 
@@ -156,3 +156,18 @@ std::optional<std::wstring> VRProcessEnumerator::getVRClientProcessName(unsigned
 
     return std::nullopt;
 }
+
+std::optional<uint64_t> VRProcessEnumerator::getProcessStartTime(unsigned long pid)
+{
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (hProcess == NULL)
+        return std::nullopt;
+
+    FILETIME creation, exit, kernel, user;
+    BOOL success = GetProcessTimes(hProcess, &creation, &exit, &kernel, &user);
+    CloseHandle(hProcess);
+    if (!success)
+        return std::nullopt;
+
+    return (static_cast<uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+}
@@ -15,20 +15,27 @@
 #include <tlhelp32.h>
 #include <vector>
 #include <array>
-#include <regex>
 #include <cctype>
 #include <sstream>
 #include <DriverLog.hpp>
 #include <thread>
 #include <optional>
+#include <cstdint>
+
+#include <StringPattern.hpp>
 
 class VRProcessEnumerator
 {
 public:
     static std::vector<PROCESSENTRY32> findVRClientProcesses();
 
-    static bool isProcessRunning(std::regex exeMatcher);
+    static bool isProcessRunning(const StringPattern& exeMatcher);
     
     static std::optional<std::wstring> getVRClientProcessName(unsigned long pid);
+
+    /// <summary>
+    /// Gets when a process was created (as a FILETIME count), which together with its PID identifies it
+    /// </summary>
+    static std::optional<uint64_t> getProcessStartTime(unsigned long pid);
 };
 
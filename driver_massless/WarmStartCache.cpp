@@ -0,0 +1,166 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "WarmStartCache.hpp"
+#include <SettingsUtilities.hpp>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace {
+    uint32_t fnv1a(const uint8_t* data, std::size_t size) {
+        uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    void put(std::vector<uint8_t>& buffer, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    /// <summary>
+    /// Bounds checked reader over the loaded bytes
+    /// </summary>
+    class Reader {
+    public:
+        Reader(const std::vector<uint8_t>& buffer, std::size_t end) : m_buffer(buffer), m_end(end) {}
+
+        template<typename T>
+        bool get(T& value) {
+            if (this->m_position + sizeof(T) > this->m_end)
+                return false;
+            std::memcpy(&value, this->m_buffer.data() + this->m_position, sizeof(T));
+            this->m_position += sizeof(T);
+            return true;
+        }
+
+        bool get(std::string& value, std::size_t length) {
+            if (this->m_position + length > this->m_end)
+                return false;
+            value.assign(reinterpret_cast<const char*>(this->m_buffer.data() + this->m_position), length);
+            this->m_position += length;
+            return true;
+        }
+
+        bool atEnd() const {
+            return this->m_position == this->m_end;
+        }
+
+    private:
+        const std::vector<uint8_t>& m_buffer;
+        std::size_t m_end;
+        std::size_t m_position = 0;
+    };
+}
+
+std::filesystem::path WarmStartCache::getCachePath(const std::filesystem::path& config_path)
+{
+    return std::filesystem::path(config_path).replace_filename(m_fileName);
+}
+
+WarmStartCache::Entry WarmStartCache::fromPack(const DriverAnalytics::TrackingReferencePack& pack)
+{
+    return Entry{ pack.device_serial, pack.type, pack.pose_offset, pack.global_pose };
+}
+
+std::optional<WarmStartCache::Entry> WarmStartCache::read(std::istream& stream)
+{
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(uint32_t))
+        return std::nullopt;
+
+    std::size_t payload_size = buffer.size() - sizeof(uint32_t);
+    uint32_t checksum;
+    std::memcpy(&checksum, buffer.data() + payload_size, sizeof(checksum));
+    if (checksum != fnv1a(buffer.data(), payload_size))
+        return std::nullopt;
+
+    Reader reader(buffer, payload_size);
+    uint32_t magic;
+    uint16_t version;
+    uint16_t serial_length;
+    if (!reader.get(magic) || magic != m_magic || !reader.get(version) || version != m_version)
+        return std::nullopt;
+    if (!reader.get(serial_length) || serial_length == 0 || serial_length > m_maxSerialLength)
+        return std::nullopt;
+
+    Entry entry;
+    int32_t type;
+    std::array<float, 7> offset;
+    std::array<float, 7> pose;
+    if (!reader.get(entry.device_serial, serial_length) || !reader.get(type) || !reader.get(offset) || !reader.get(pose) || !reader.atEnd())
+        return std::nullopt;
+
+    entry.type = MasslessInterface::TrackingSystemType(static_cast<MasslessInterface::TrackingSystemType::SystemType>(type));
+    if (entry.type.getSystemType() == MasslessInterface::TrackingSystemType::SystemType::INVALID_SYSTEM)
+        return std::nullopt;
+    entry.pose_offset = MasslessInterface::Pose(offset[0], offset[1], offset[2], offset[3], offset[4], offset[5], offset[6]);
+    entry.global_pose = { Eigen::Quaternionf(pose[3], pose[4], pose[5], pose[6]).normalized(), Eigen::Vector3f(pose[0], pose[1], pose[2]) };
+    return entry;
+}
+
+bool WarmStartCache::write(std::ostream& stream, const Entry& entry)
+{
+    if (entry.device_serial.empty() || entry.device_serial.size() > m_maxSerialLength)
+        return false;
+
+    std::vector<uint8_t> buffer;
+    put(buffer, m_magic);
+    put(buffer, m_version);
+    put(buffer, static_cast<uint16_t>(entry.device_serial.size()));
+    buffer.insert(buffer.end(), entry.device_serial.begin(), entry.device_serial.end());
+    put(buffer, static_cast<int32_t>(entry.type.getSystemType()));
+    const auto& offset = entry.pose_offset;
+    put(buffer, std::array<float, 7>{ offset.m_x, offset.m_y, offset.m_z, offset.m_qr, offset.m_qx, offset.m_qy, offset.m_qz });
+    const auto& [rotation, position] = entry.global_pose;
+    put(buffer, std::array<float, 7>{ position.x(), position.y(), position.z(), rotation.w(), rotation.x(), rotation.y(), rotation.z() });
+    put(buffer, fnv1a(buffer.data(), buffer.size()));
+
+    stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    return stream.good();
+}
+
+std::optional<WarmStartCache::Entry> WarmStartCache::load(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return std::nullopt;
+    return read(file);
+}
+
+bool WarmStartCache::save(const std::filesystem::path& path, const Entry& entry)
+{
+    std::ostringstream stream;
+    return write(stream, entry) && SettingsUtilities::replaceFile(path, stream.str());
+}
+
+bool WarmStartCache::matches(const Entry& entry, const std::string& serial, const MasslessInterface::TrackingSystemType& type, const EigenPose& pose)
+{
+    return matches(entry, serial, type, pose, Options());
+}
+
+bool WarmStartCache::matches(const Entry& entry, const std::string& serial, const MasslessInterface::TrackingSystemType& type, const EigenPose& pose, Options options)
+{
+    if (serial != entry.device_serial || type.getSystemType() != entry.type.getSystemType())
+        return false;
+    if (!DriverAnalytics::isStaticReference(type))
+        return true;
+    return (pose.second - entry.global_pose.second).norm() <= options.max_distance
+        && pose.first.angularDistance(entry.global_pose.first) <= options.max_angle;
+}
@@ -0,0 +1,120 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <Eigen/eigen>
+
+#include <DriverAnalytics.hpp>
+#include <Pose.hpp>
+#include <TrackingSystemType.hpp>
+
+/// <summary>
+/// Compact binary cache of the last locked tracking reference (serial, system type, Massless Tracker offset and reference pose), stored next to
+/// driver_massless.json. On startup the cached reference is trusted as soon as the same device reports a matching pose, so the pen doesn't have to
+/// wait for the backend offset and the validation period before its first valid pose.
+/// </summary>
+/// <detail>
+/// Layout (little endian): magic, version, serial length, serial bytes, system type, offset (x, y, z, qr, qx, qy, qz),
+/// reference pose (x, y, z, qw, qx, qy, qz), then an FNV-1a checksum of everything before it.
+/// </detail>
+class WarmStartCache
+{
+public:
+    using EigenPose = std::pair<Eigen::Quaternionf, Eigen::Vector3f>;
+
+    static constexpr uint32_t m_magic = 0x5357534D; // "MSWS"
+    static constexpr uint16_t m_version = 1;
+
+    /// <summary>
+    /// Longest serial that will be read back, anything longer is treated as corruption
+    /// </summary>
+    static constexpr uint16_t m_maxSerialLength = 256;
+
+    /// <summary>
+    /// Name of the cache file, in the same folder as driver_massless.json
+    /// </summary>
+    static constexpr const char* m_fileName = "driver_massless.cache";
+
+    /// <summary>
+    /// How far a static reference may be from its cached pose and still be trusted
+    /// </summary>
+    struct Options {
+        float max_distance = 0.02f;
+        float max_angle = 0.035f;
+    };
+
+    /// <summary>
+    /// The cached tracking reference
+    /// </summary>
+    struct Entry {
+        std::string device_serial;
+        MasslessInterface::TrackingSystemType type;
+        MasslessInterface::Pose pose_offset;
+        EigenPose global_pose;
+    };
+
+    /// <summary>
+    /// Gets the cache path for a config file path
+    /// </summary>
+    /// <param name="config_path">Path to driver_massless.json</param>
+    /// <returns>Path to the cache file next to it</returns>
+    static std::filesystem::path getCachePath(const std::filesystem::path& config_path);
+
+    /// <summary>
+    /// Makes a cache entry from a locked tracking reference
+    /// </summary>
+    static Entry fromPack(const DriverAnalytics::TrackingReferencePack& pack);
+
+    /// <summary>
+    /// Reads a cache entry
+    /// </summary>
+    /// <returns>The entry, or nullopt if the data is truncated, from another version, or fails the checksum</returns>
+    static std::optional<Entry> read(std::istream& stream);
+
+    /// <summary>
+    /// Writes a cache entry
+    /// </summary>
+    /// <returns>True if the entry was written</returns>
+    static bool write(std::ostream& stream, const Entry& entry);
+
+    /// <summary>
+    /// Loads the cache file, a missing or invalid file is not an error
+    /// </summary>
+    static std::optional<Entry> load(const std::filesystem::path& path);
+
+    /// <summary>
+    /// Saves the cache file, replacing it atomically
+    /// </summary>
+    /// <returns>True if the file was written</returns>
+    static bool save(const std::filesystem::path& path, const Entry& entry);
+
+    /// <summary>
+    /// Checks whether a connected device is still the cached reference. Static references must also be close to their cached pose,
+    /// moving references (trackers and controllers) only need to be the same type.
+    /// </summary>
+    /// <param name="entry">Cached reference</param>
+    /// <param name="serial">Serial of the connected device</param>
+    /// <param name="type">Type of the connected device</param>
+    /// <param name="pose">Pose of the connected device this frame</param>
+    /// <param name="options">Pose tolerance</param>
+    /// <returns>True if the cached offset can be used for this device</returns>
+    static bool matches(const Entry& entry, const std::string& serial, const MasslessInterface::TrackingSystemType& type, const EigenPose& pose, Options options);
+    static bool matches(const Entry& entry, const std::string& serial, const MasslessInterface::TrackingSystemType& type, const EigenPose& pose);
+
+private:
+    // Prevent instantiation
+    WarmStartCache() = default;
+};
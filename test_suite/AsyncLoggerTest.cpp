@@ -0,0 +1,108 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <AsyncLogger.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+namespace {
+    struct LoggerFixture {
+        std::vector<std::string> lines;
+        AsyncLogger::Clock::time_point now = AsyncLogger::Clock::time_point() + std::chrono::hours(1);
+
+        std::unique_ptr<AsyncLogger> make(AsyncLogger::Options options) {
+            return std::make_unique<AsyncLogger>([this](const char* line) { this->lines.emplace_back(line); }, options, [this]() { return this->now; });
+        }
+    };
+}
+
+TEST(AsyncLoggerTest, QueuesFormattedLinesUntilFlushed) {
+    LoggerFixture fixture;
+    auto logger = fixture.make(AsyncLogger::Options());
+
+    std::string temporary = "serial";
+    EXPECT_TRUE(logger->log("[Info] %s %d\n", temporary.c_str(), 42));
+    temporary = "changed";
+    EXPECT_THAT(fixture.lines, IsEmpty());
+
+    logger->flush();
+    EXPECT_THAT(fixture.lines, ElementsAre("[Info] serial 42\n"));
+    EXPECT_EQ(logger->getStats().written, 1);
+}
+
+TEST(AsyncLoggerTest, DropsLinesWhenFullAndReportsThem) {
+    LoggerFixture fixture;
+    AsyncLogger::Options options;
+    options.capacity = 4;
+    options.repeat_limit = 0;
+    auto logger = fixture.make(options);
+
+    for (int i = 0; i < 6; ++i)
+        logger->log("line %d\n", i);
+    logger->flush();
+
+    EXPECT_THAT(fixture.lines, ElementsAre("line 0\n", "line 1\n", "line 2\n", "line 3\n", "[Warn] Dropped 2 log lines, the log queue was full.\n"));
+    EXPECT_EQ(logger->getStats().dropped, 2);
+
+    // Slots are reused once read
+    EXPECT_TRUE(logger->log("line %d\n", 6));
+    logger->flush();
+    EXPECT_EQ(fixture.lines.back(), "line 6\n");
+}
+
+TEST(AsyncLoggerTest, SuppressesRepeatsPerWindow) {
+    LoggerFixture fixture;
+    AsyncLogger::Options options;
+    options.repeat_limit = 2;
+    options.repeat_window = std::chrono::milliseconds(1000);
+    auto logger = fixture.make(options);
+
+    const char* repeated = "[Info] Battery %d\n";
+    for (int i = 0; i < 5; ++i)
+        logger->log(repeated, i);
+    logger->log("[Info] Other\n");
+    logger->flush();
+
+    EXPECT_THAT(fixture.lines, ElementsAre("[Info] Battery 0\n", "[Info] Battery 1\n", "[Info] Other\n", "[Warn] Suppressed 3 repeats of: [Info] Battery %d\n"));
+    EXPECT_EQ(logger->getStats().suppressed, 3);
+
+    // Allowed again in the next window
+    fixture.now += std::chrono::milliseconds(1000);
+    EXPECT_TRUE(logger->log(repeated, 5));
+}
+
+TEST(AsyncLoggerTest, BackgroundThreadWritesLinesFromManyThreads) {
+    LoggerFixture fixture;
+    AsyncLogger::Options options;
+    options.capacity = 4096;
+    options.repeat_limit = 0;
+    options.flush_interval = std::chrono::milliseconds(1);
+    auto logger = fixture.make(options);
+    logger->start();
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t)
+        writers.emplace_back([&logger, t]() {
+            for (int i = 0; i < 500; ++i)
+                logger->log("%d %d\n", t, i);
+        });
+    for (auto& writer : writers)
+        writer.join();
+    logger->stop();
+
+    // Big enough for every line even if the thread never ran
+    EXPECT_EQ(logger->getStats().written, 2000);
+    EXPECT_EQ(logger->getStats().dropped, 0);
+    EXPECT_EQ(fixture.lines.size(), 2000);
+}
@@ -0,0 +1,77 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ControlChannel.hpp>
+#include <SeqlockValue.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace testing;
+
+namespace {
+    struct WordPair {
+        uint64_t a;
+        uint64_t b;
+    };
+}
+
+TEST(SeqlockValue, ReadersNeverSeeATornValue) {
+    SeqlockValue<WordPair> value(WordPair{ 0, ~0ull });
+    std::atomic<bool> done = false;
+
+    std::thread writer([&]() {
+        for (uint64_t i = 1; i <= 200000; ++i)
+            value.store(WordPair{ i, ~i });
+        done = true;
+    });
+
+    uint64_t reads = 0;
+    uint64_t last = 0;
+    while (!done) {
+        WordPair loaded = value.load();
+        ASSERT_EQ(loaded.b, ~loaded.a);
+        ASSERT_GE(loaded.a, last);
+        last = loaded.a;
+        ++reads;
+    }
+    writer.join();
+
+    EXPECT_GT(reads, 0u);
+    EXPECT_EQ(value.load().a, 200000u);
+    EXPECT_EQ(value.getVersion(), 200000u);
+}
+
+TEST(ControlChannel, ParameterUpdatesBumpTheVersion) {
+    ControlChannel channel;
+    EXPECT_EQ(channel.getParametersVersion(), 0u);
+    EXPECT_FALSE(channel.getParameters().reference_fusion);
+
+    channel.updateParameters([](RuntimeParameters& parameters) { parameters.reference_fusion = true; });
+    channel.updateParameters([](RuntimeParameters& parameters) { parameters.fusion_reenroll_frames = 10; });
+
+    EXPECT_EQ(channel.getParametersVersion(), 2u);
+    EXPECT_TRUE(channel.getParameters().reference_fusion);
+    EXPECT_EQ(channel.getParameters().fusion_reenroll_frames, 10u);
+}
+
+TEST(ControlChannel, PostedWorkRunsOnlyWhenTheFrameThreadRunsIt) {
+    ControlChannel channel;
+    EXPECT_EQ(channel.runPending(), 0u);
+
+    auto first = channel.post([]() { return std::string("1"); });
+    auto second = channel.post([]() { return std::string("2"); });
+    EXPECT_EQ(first.wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+
+    EXPECT_EQ(channel.runPending(), 2u);
+    EXPECT_EQ(first.get(), "1");
+    EXPECT_EQ(second.get(), "2");
+    EXPECT_EQ(channel.runPending(), 0u);
+}
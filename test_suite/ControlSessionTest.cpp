@@ -0,0 +1,203 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ControlSession.hpp>
+#include <ControlServer.hpp>
+
+#include <json.hpp>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace testing;
+using json = nlohmann::json;
+
+namespace {
+    struct ControlSessionTest : public Test {
+        std::shared_ptr<ControlChannel> channel = std::make_shared<ControlChannel>();
+        std::chrono::steady_clock::time_point now;
+        ControlSession session{ channel, [this]() { return this->now; } };
+        std::vector<std::string> output;
+
+        json request(const std::string& line)
+        {
+            this->output.clear();
+            this->session.handleLine(line, this->output);
+            if (this->output.size() != 1)
+                return json();
+            return json::parse(this->output[0]);
+        }
+
+        std::vector<json> poll()
+        {
+            this->output.clear();
+            this->session.poll(this->output);
+            std::vector<json> parsed;
+            for (const auto& line : this->output)
+                parsed.push_back(json::parse(line));
+            return parsed;
+        }
+    };
+}
+
+TEST_F(ControlSessionTest, GetsEveryParameterOrOne) {
+    json all = request(R"({"cmd":"get","id":1})");
+    EXPECT_EQ(all["ok"], true);
+    EXPECT_EQ(all["id"], 1);
+    EXPECT_EQ(all["parameters"].size(), ControlSession::getParameterNames().size());
+    EXPECT_EQ(all["parameters"]["fusion_reenroll_frames"], 90);
+
+    json one = request(R"({"cmd":"get","name":"reference_fusion"})");
+    EXPECT_EQ(one["ok"], true);
+    EXPECT_EQ(one["value"], false);
+    EXPECT_FALSE(one.contains("id"));
+}
+
+TEST_F(ControlSessionTest, SetChangesTheSnapshot) {
+    json response = request(R"({"cmd":"set","name":"fusion_outlier_distance","value":0.02})");
+    EXPECT_EQ(response["ok"], true);
+    EXPECT_FLOAT_EQ(channel->getParameters().fusion_outlier_distance, 0.02f);
+    EXPECT_EQ(channel->getParametersVersion(), 1u);
+
+    EXPECT_EQ(request(R"({"cmd":"set","name":"detailed_logging","value":true})")["ok"], true);
+    EXPECT_TRUE(channel->getParameters().detailed_logging);
+}
+
+TEST_F(ControlSessionTest, RejectsBadRequestsWithoutChangingAnything) {
+    EXPECT_EQ(request("not json")["error"], "invalid_json");
+    EXPECT_EQ(request(R"({"id":2})")["error"], "missing_cmd");
+    EXPECT_EQ(request(R"({"cmd":"reboot"})")["error"], "unknown_cmd");
+    EXPECT_EQ(request(R"({"cmd":"set","name":"nope","value":1})")["error"], "unknown_parameter");
+    EXPECT_EQ(request(R"({"cmd":"set","name":"reference_fusion","value":1})")["error"], "invalid_value");
+    EXPECT_EQ(request(R"({"cmd":"set","name":"fusion_outlier_distance","value":5})")["error"], "invalid_value");
+    EXPECT_EQ(request(R"({"cmd":"set","name":"fusion_reenroll_frames","value":1.5})")["error"], "invalid_value");
+    EXPECT_EQ(request(R"({"cmd":"set","name":"fusion_reenroll_frames"})")["error"], "invalid_value");
+
+    // Writers still bump the version, but the values are untouched
+    RuntimeParameters defaults;
+    EXPECT_FLOAT_EQ(channel->getParameters().fusion_outlier_distance, defaults.fusion_outlier_distance);
+    EXPECT_EQ(channel->getParameters().fusion_reenroll_frames, defaults.fusion_reenroll_frames);
+    EXPECT_FALSE(channel->getParameters().reference_fusion);
+}
+
+TEST_F(ControlSessionTest, FeedIsDownsampledAndOnlySendsNewFrames) {
+    json response = request(R"({"cmd":"subscribe","rate_hz":1000})");
+    EXPECT_EQ(response["rate_hz"], ControlSession::m_maxFeedRateHz);
+    ASSERT_TRUE(session.getNextDeadline().has_value());
+
+    ControlTelemetry telemetry;
+    telemetry.frame = 1;
+    telemetry.position[0] = 0.5;
+    telemetry.power_mode = "active";
+    channel->publishTelemetry(telemetry);
+
+    auto samples = poll();
+    ASSERT_EQ(samples.size(), 1u);
+    EXPECT_EQ(samples[0]["feed"]["frame"], 1);
+    EXPECT_EQ(samples[0]["feed"]["position"][0], 0.5);
+    EXPECT_EQ(samples[0]["feed"]["power_mode"], "active");
+
+    // Not due yet, however many frames there have been
+    telemetry.frame = 5;
+    channel->publishTelemetry(telemetry);
+    now += std::chrono::milliseconds(5);
+    EXPECT_TRUE(poll().empty());
+
+    now += std::chrono::milliseconds(5);
+    samples = poll();
+    ASSERT_EQ(samples.size(), 1u);
+    EXPECT_EQ(samples[0]["feed"]["frame"], 5);
+
+    // Due, but the frame thread hasn't moved on
+    now += std::chrono::milliseconds(10);
+    EXPECT_TRUE(poll().empty());
+
+    request(R"({"cmd":"unsubscribe"})");
+    telemetry.frame = 6;
+    channel->publishTelemetry(telemetry);
+    now += std::chrono::milliseconds(10);
+    EXPECT_TRUE(poll().empty());
+    EXPECT_FALSE(session.getNextDeadline().has_value());
+}
+
+TEST_F(ControlSessionTest, CaptureRunsOnTheFrameThread) {
+    EXPECT_EQ(request(R"({"cmd":"capture","request":"stats"})")["error"], "unavailable");
+
+    std::string captured;
+    ControlChannel::Handlers handlers;
+    handlers.capture = [&](std::string_view debug_request) {
+        captured = debug_request;
+        return std::string(R"({"updates":3})");
+    };
+    channel->setHandlers(handlers);
+
+    output.clear();
+    session.handleLine(R"({"cmd":"capture","request":"stats","id":"c"})", output);
+    EXPECT_TRUE(output.empty());
+    EXPECT_TRUE(poll().empty());
+    EXPECT_TRUE(captured.empty());
+
+    EXPECT_EQ(channel->runPending(), 1u);
+    EXPECT_EQ(captured, "stats");
+    auto responses = poll();
+    ASSERT_EQ(responses.size(), 1u);
+    EXPECT_EQ(responses[0]["id"], "c");
+    EXPECT_EQ(responses[0]["capture"]["updates"], 3);
+}
+
+#ifdef __linux__
+TEST(ControlServer, AnswersOverTheSocket) {
+    auto channel = std::make_shared<ControlChannel>();
+    std::string address = "/tmp/massless_control_test_" + std::to_string(getpid()) + ".sock";
+    auto server = ControlServer::create(channel, address);
+    ASSERT_NE(server, nullptr);
+
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(client, 0);
+    sockaddr_un socket_address = {};
+    socket_address.sun_family = AF_UNIX;
+    std::strcpy(socket_address.sun_path, address.c_str());
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)), 0);
+
+    // Split across writes, and two requests in one
+    std::string first = R"({"cmd":"set","name":"reference_fus)";
+    std::string rest = "ion\",\"value\":true}\n{\"cmd\":\"get\",\"name\":\"reference_fusion\"}\n";
+    ASSERT_EQ(send(client, first.data(), first.size(), 0), static_cast<ssize_t>(first.size()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(send(client, rest.data(), rest.size(), 0), static_cast<ssize_t>(rest.size()));
+
+    std::string received;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::count(received.begin(), received.end(), '\n') < 2 && std::chrono::steady_clock::now() < deadline) {
+        pollfd readable = { client, POLLIN, 0 };
+        if (::poll(&readable, 1, 100) <= 0)
+            continue;
+        char buffer[1024];
+        ssize_t length = recv(client, buffer, sizeof(buffer), 0);
+        ASSERT_GT(length, 0);
+        received.append(buffer, static_cast<std::size_t>(length));
+    }
+    close(client);
+
+    auto newline = received.find('\n');
+    ASSERT_NE(newline, std::string::npos);
+    EXPECT_EQ(json::parse(received.substr(0, newline))["ok"], true);
+    EXPECT_EQ(json::parse(received.substr(newline + 1))["value"], true);
+    EXPECT_TRUE(channel->getParameters().reference_fusion);
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+
+    server.reset();
+    EXPECT_NE(access(address.c_str(), F_OK), 0);
+}
+#endif
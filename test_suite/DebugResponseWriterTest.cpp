@@ -0,0 +1,127 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <DebugResponseWriter.hpp>
+#include <json.hpp>
+
+using namespace testing;
+
+TEST(DebugResponseWriter, WritesNestedObjectsAndArrays) {
+    char buffer[256];
+    DebugResponseWriter writer(buffer, sizeof(buffer));
+    writer.beginObject();
+    writer.field("count", 3u);
+    writer.field("negative", -2);
+    writer.field("valid", true);
+    writer.field("name", "pen");
+    writer.key("position");
+    writer.beginArray();
+    writer.value(1.5f);
+    writer.value(2.0);
+    writer.nullValue();
+    writer.endArray();
+    writer.key("nested");
+    writer.beginObject();
+    writer.endObject();
+    writer.endObject();
+
+    ASSERT_TRUE(writer.finish());
+    ASSERT_STREQ(buffer, "{\"count\":3,\"negative\":-2,\"valid\":true,\"name\":\"pen\",\"position\":[1.5,2,null],\"nested\":{}}");
+}
+
+TEST(DebugResponseWriter, EscapesStrings) {
+    char buffer[128];
+    DebugResponseWriter writer(buffer, sizeof(buffer));
+    writer.beginObject();
+    writer.field("text", "a\"b\\c\n\x01");
+    writer.endObject();
+
+    ASSERT_TRUE(writer.finish());
+    auto parsed = nlohmann::json::parse(buffer);
+    ASSERT_EQ(parsed["text"].get<std::string>(), "a\"b\\c\n\x01");
+}
+
+TEST(DebugResponseWriter, NonFiniteNumbersAreNull) {
+    char buffer[64];
+    DebugResponseWriter writer(buffer, sizeof(buffer));
+    writer.beginArray();
+    writer.value(std::numeric_limits<double>::infinity());
+    writer.value(std::numeric_limits<float>::quiet_NaN());
+    writer.endArray();
+
+    ASSERT_TRUE(writer.finish());
+    ASSERT_STREQ(buffer, "[null,null]");
+}
+
+TEST(DebugResponseWriter, OverflowIsReplacedWithError) {
+    char buffer[48];
+    DebugResponseWriter writer(buffer, sizeof(buffer));
+    writer.beginArray();
+    for (int i = 0; i < 100; ++i)
+        writer.value(i);
+    writer.endArray();
+
+    ASSERT_TRUE(writer.hasOverflowed());
+    ASSERT_FALSE(writer.finish());
+    auto parsed = nlohmann::json::parse(buffer);
+    ASSERT_EQ(parsed["error"].get<std::string>(), "buffer_too_small");
+    ASSERT_EQ(parsed["required"].get<std::size_t>(), writer.requiredLength() + 1);
+}
+
+TEST(DebugResponseWriter, TinyBufferIsNullTerminated) {
+    char buffer[4] = { 'x', 'x', 'x', 'x' };
+    DebugResponseWriter writer(buffer, sizeof(buffer));
+    writer.beginObject();
+    writer.error("something long");
+    writer.endObject();
+
+    ASSERT_FALSE(writer.finish());
+    ASSERT_EQ(buffer[0], 0);
+}
+
+TEST(DebugResponseWriter, NullBufferIsSafe) {
+    DebugResponseWriter writer(nullptr, 0);
+    writer.beginObject();
+    writer.endObject();
+    ASSERT_FALSE(writer.finish());
+    ASSERT_EQ(writer.requiredLength(), 2);
+}
+
+TEST(DebugResponseWriter, SplitRequest) {
+    auto [command, argument] = DebugResponseWriter::splitRequest("  pose_history   10 ");
+    ASSERT_EQ(command, "pose_history");
+    ASSERT_EQ(argument, "10");
+
+    auto [single_command, no_argument] = DebugResponseWriter::splitRequest("stats");
+    ASSERT_EQ(single_command, "stats");
+    ASSERT_TRUE(no_argument.empty());
+
+    auto [null_command, null_argument] = DebugResponseWriter::splitRequest(nullptr);
+    ASSERT_TRUE(null_command.empty());
+    ASSERT_TRUE(null_argument.empty());
+}
+
+TEST(DebugResponseWriter, ParseUnsigned) {
+    ASSERT_EQ(DebugResponseWriter::parseUnsigned("42", 7), 42);
+    ASSERT_EQ(DebugResponseWriter::parseUnsigned("", 7), 7);
+    ASSERT_EQ(DebugResponseWriter::parseUnsigned("-1", 7), 7);
+    ASSERT_EQ(DebugResponseWriter::parseUnsigned("12a", 7), 7);
+    ASSERT_EQ(DebugResponseWriter::parseUnsigned("99999999999", 7), UINT32_MAX);
+}
+
+TEST(DebugResponseWriter, ParseVector3) {
+    auto parsed = DebugResponseWriter::parseVector3("0.5 -1 2e-2");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_THAT(*parsed, ElementsAre(0.5f, -1.0f, 0.02f));
+    EXPECT_EQ(DebugResponseWriter::parseVector3(""), std::nullopt);
+    EXPECT_EQ(DebugResponseWriter::parseVector3("1 2"), std::nullopt);
+    EXPECT_EQ(DebugResponseWriter::parseVector3("1 2 3 4"), std::nullopt);
+    EXPECT_EQ(DebugResponseWriter::parseVector3("1 x 3"), std::nullopt);
+}
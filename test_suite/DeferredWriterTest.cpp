@@ -0,0 +1,53 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <DeferredWriter.hpp>
+
+#include <atomic>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+TEST(DeferredWriterTest, CoalescesBursts) {
+    DeferredWriter writer(50ms);
+    std::atomic<int> last_written = 0;
+    for (int i = 1; i <= 10; ++i)
+        writer.schedule([&last_written, i]() { last_written = i; });
+    EXPECT_EQ(last_written, 0) << "Nothing is written straight away";
+
+    writer.flush();
+    EXPECT_EQ(last_written, 10) << "Only the latest state is written";
+    EXPECT_EQ(writer.getScheduledCount(), 10);
+    EXPECT_EQ(writer.getWriteCount(), 1);
+}
+
+TEST(DeferredWriterTest, WritesAfterDelay) {
+    DeferredWriter writer(10ms);
+    std::atomic<bool> written = false;
+    writer.schedule([&written]() { written = true; });
+    for (int i = 0; i < 1000 && !written; ++i)
+        std::this_thread::sleep_for(1ms);
+    EXPECT_TRUE(written);
+}
+
+TEST(DeferredWriterTest, DestructorRunsPendingWrite) {
+    std::atomic<bool> written = false;
+    {
+        DeferredWriter writer(1h);
+        writer.schedule([&written]() { written = true; });
+    }
+    EXPECT_TRUE(written);
+}
+
+TEST(DeferredWriterTest, FlushWithNothingPendingReturns) {
+    DeferredWriter writer(1h);
+    writer.flush();
+    EXPECT_EQ(writer.getWriteCount(), 0);
+}
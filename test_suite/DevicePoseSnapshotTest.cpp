@@ -0,0 +1,120 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <DevicePoseSnapshot.hpp>
+
+using namespace testing;
+
+namespace {
+    vr::TrackedDevicePose_t makeConnectedPose(float x, float y, float z) {
+        vr::TrackedDevicePose_t pose = { 0 };
+        pose.bDeviceIsConnected = true;
+        pose.bPoseIsValid = true;
+        pose.eTrackingResult = vr::ETrackingResult::TrackingResult_Running_OK;
+        pose.mDeviceToAbsoluteTracking.m[0][0] = pose.mDeviceToAbsoluteTracking.m[1][1] = pose.mDeviceToAbsoluteTracking.m[2][2] = 1;
+        pose.mDeviceToAbsoluteTracking.m[0][3] = x;
+        pose.mDeviceToAbsoluteTracking.m[1][3] = y;
+        pose.mDeviceToAbsoluteTracking.m[2][3] = z;
+        return pose;
+    }
+}
+
+class DevicePoseSnapshotTest : public Test {
+protected:
+    void SetUp() override {
+        ON_CALL(this->serverdriver_host, GetRawTrackedDevicePoses(_, _, _))
+            .WillByDefault(Invoke([this](float, vr::TrackedDevicePose_t* poses, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i)
+                    poses[i] = this->poses[i];
+            }));
+    }
+
+    std::array<vr::TrackedDevicePose_t, vr::k_unMaxTrackedDeviceCount> poses = { {0} };
+    NiceMock<MockVRServerDriverHost> serverdriver_host;
+};
+
+TEST_F(DevicePoseSnapshotTest, CapturesOncePerFrame) {
+    this->poses[3] = makeConnectedPose(1, 2, 3);
+    this->poses[9] = makeConnectedPose(4, 5, 6);
+
+    DevicePoseSnapshot snapshot;
+    EXPECT_CALL(this->serverdriver_host, GetRawTrackedDevicePoses(_, _, vr::k_unMaxTrackedDeviceCount)).Times(1);
+    snapshot.capture(&this->serverdriver_host);
+
+    // Every consumer reads from the same capture
+    for (int consumer = 0; consumer < 5; ++consumer) {
+        ASSERT_TRUE(snapshot.getPose(3).has_value());
+        ASSERT_TRUE(DriverAnalytics::getDevicePose(9, snapshot).has_value());
+        ASSERT_TRUE(snapshot.isConnected(3));
+        ASSERT_FALSE(snapshot.isConnected(4));
+    }
+    ASSERT_EQ(snapshot.getCaptureCount(), 1);
+}
+
+TEST_F(DevicePoseSnapshotTest, ConvertsLazilyAndOnlyRequestedIndices) {
+    for (vr::TrackedDeviceIndex_t index = 0; index < 10; ++index)
+        this->poses[index] = makeConnectedPose(static_cast<float>(index), 0, 0);
+
+    DevicePoseSnapshot snapshot;
+    snapshot.capture(&this->serverdriver_host);
+    ASSERT_EQ(snapshot.getConversionCount(), 0);
+
+    auto pose = snapshot.getPose(7);
+    ASSERT_TRUE(pose.has_value());
+    ASSERT_TRUE(pose->second.isApprox(Eigen::Vector3f(7, 0, 0)));
+    snapshot.getPose(7);
+    ASSERT_EQ(snapshot.getConversionCount(), 1) << "Repeated reads should use the cached conversion";
+
+    // Recapturing discards the cache, so moved devices are converted again
+    this->poses[7] = makeConnectedPose(0, 7, 0);
+    snapshot.capture(&this->serverdriver_host);
+    ASSERT_EQ(snapshot.getConversionCount(), 0);
+    ASSERT_TRUE(snapshot.getPose(7)->second.isApprox(Eigen::Vector3f(0, 7, 0)));
+}
+
+TEST_F(DevicePoseSnapshotTest, MatchesDriverAnalyticsConversion) {
+    vr::TrackedDevicePose_t pose = makeConnectedPose(0.5f, -1.0f, 2.0f);
+    pose.mDeviceToAbsoluteTracking.m[0][0] = 0.762660979240981f;
+    pose.mDeviceToAbsoluteTracking.m[1][0] = 0.237339020759019f;
+    pose.mDeviceToAbsoluteTracking.m[2][0] = 0.601679665576574f;
+    pose.mDeviceToAbsoluteTracking.m[0][1] = 0.237339020759019f;
+    pose.mDeviceToAbsoluteTracking.m[1][1] = 0.762660979240981f;
+    pose.mDeviceToAbsoluteTracking.m[2][1] = -0.601679665576574f;
+    pose.mDeviceToAbsoluteTracking.m[0][2] = -0.601679665576574f;
+    pose.mDeviceToAbsoluteTracking.m[1][2] = 0.601679665576574f;
+    pose.mDeviceToAbsoluteTracking.m[2][2] = 0.525321958481962f;
+    this->poses[20] = pose;
+
+    DevicePoseSnapshot snapshot;
+    snapshot.capture(&this->serverdriver_host);
+
+    auto expected = DriverAnalytics::hmdMatrixtoEigenPose(pose.mDeviceToAbsoluteTracking);
+    auto received = snapshot.getPose(20);
+    ASSERT_TRUE(received.has_value());
+    EXPECT_TRUE(received->first.isApprox(expected.first));
+    EXPECT_TRUE(received->second.isApprox(expected.second));
+    EXPECT_TRUE(DriverAnalytics::getDevicePose(20, &this->serverdriver_host)->second.isApprox(expected.second));
+}
+
+TEST_F(DevicePoseSnapshotTest, InvalidPosesAreNotReturned) {
+    this->poses[1] = makeConnectedPose(1, 1, 1);
+    this->poses[1].bPoseIsValid = false;
+    this->poses[2] = makeConnectedPose(2, 2, 2);
+    this->poses[2].bDeviceIsConnected = false;
+
+    DevicePoseSnapshot snapshot;
+    snapshot.capture(&this->serverdriver_host);
+
+    EXPECT_TRUE(snapshot.isConnected(1));
+    EXPECT_EQ(snapshot.getPose(1), std::nullopt);
+    EXPECT_EQ(snapshot.getPose(2), std::nullopt);
+    EXPECT_EQ(snapshot.getPose(vr::k_unMaxTrackedDeviceCount), std::nullopt);
+    EXPECT_FALSE(snapshot.isConnected(vr::k_unMaxTrackedDeviceCount));
+}
@@ -0,0 +1,53 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <DoubleBuffer.hpp>
+
+#include <thread>
+
+using namespace testing;
+
+TEST(DoubleBufferTest, ReadersSeeOnlyPublishedValues) {
+    DoubleBuffer<std::string> buffer;
+    auto read = [&buffer]() { return buffer.read([](const std::string& value) { return value; }); };
+    EXPECT_EQ(read(), "");
+
+    buffer.getBack() = "first";
+    EXPECT_EQ(read(), "");
+    EXPECT_TRUE(buffer.publish());
+    EXPECT_EQ(read(), "first");
+
+    // The back copy now holds the older value, which the writer overwrites
+    buffer.getBack() = "second";
+    EXPECT_TRUE(buffer.publish());
+    EXPECT_EQ(read(), "second");
+}
+
+TEST(DoubleBufferTest, PublishIsSkippedWhileReading) {
+    DoubleBuffer<int> buffer;
+    buffer.getBack() = 1;
+    ASSERT_TRUE(buffer.publish());
+
+    buffer.read([&buffer](const int& value) {
+        // The writer runs on another thread, and must not wait for the reader
+        bool published = true;
+        std::thread writer([&buffer, &published]() {
+            buffer.getBack() = 2;
+            published = buffer.publish();
+        });
+        writer.join();
+        EXPECT_FALSE(published);
+        EXPECT_EQ(value, 1);
+    });
+
+    // Published again once the reader is done
+    EXPECT_TRUE(buffer.publish());
+    EXPECT_EQ(buffer.read([](const int& value) { return value; }), 2);
+}
@@ -17,8 +17,15 @@ TEST(DriverSettingsTest, DefaultSetsValues) {
     EXPECT_EQ(settings.getValue<std::string>(DriverSettings::Handedness).value(), "right");
     EXPECT_EQ(settings.getValue<bool>(DriverSettings::AttachGizmo).value(), false);
     EXPECT_EQ(settings.getValue<bool>(DriverSettings::EnableDetailedLogging).value(), false);
+    EXPECT_EQ(settings.getValue<bool>(DriverSettings::EnableReferenceFusion).value(), false);
+    EXPECT_EQ(settings.getValue<bool>(DriverSettings::EnableOffsetRefinement).value(), false);
+    EXPECT_EQ(settings.getValue<bool>(DriverSettings::EnablePoseStream).value(), false);
+    EXPECT_EQ(settings.getValue<bool>(DriverSettings::EnableControlSocket).value(), false);
     EXPECT_EQ(settings.getValue<std::string>(DriverSettings::AutoTrackingRefSerial), std::nullopt);
     EXPECT_EQ(settings.getValue<std::string>(DriverSettings::ForcedTrackingRefSerial), std::nullopt);
+    EXPECT_EQ(settings.getValue<std::string>(DriverSettings::ApplicationProfiles), std::nullopt);
+    EXPECT_EQ(settings.getValue<std::string>(DriverSettings::LogLevels), std::nullopt);
+    EXPECT_EQ(settings.getValue<std::string>(DriverSettings::PoseTraceFile), std::nullopt);
 }
 
 TEST(DriverSettingsTest, BadValueTypeReturnsNullopt) {
@@ -59,4 +66,14 @@ TEST(DriverSettingsTest, ClearValueWorks) {
     EXPECT_TRUE(settings.getValue<DriverSettings::SettingValue>(DriverSettings::AttachGizmo).has_value());
     settings.clearValue(DriverSettings::AttachGizmo);
     EXPECT_FALSE(settings.getValue<DriverSettings::SettingValue>(DriverSettings::AttachGizmo).has_value());
-}
\ No newline at end of file
+}
+TEST(DriverSettingsTest, ChangedKeysIncludeSetAndClearedValues) {
+    DriverSettings settings = DriverSettings::make_default();
+    DriverSettings other = DriverSettings::make_default();
+    EXPECT_TRUE(settings.getChangedKeys(other).empty());
+
+    other.setValue<std::string>(DriverSettings::Handedness, "left");
+    other.setValue<std::string>(DriverSettings::ForcedTrackingRefSerial, "LHB-1234");
+    other.clearValue(DriverSettings::AttachGizmo);
+    EXPECT_THAT(settings.getChangedKeys(other), ElementsAre(DriverSettings::ForcedTrackingRefSerial, DriverSettings::Handedness, DriverSettings::AttachGizmo));
+}
@@ -0,0 +1,89 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include <IProcessWatcher.hpp>
+
+/// <summary>
+/// Process watcher that reports events pushed by a test, waking any waiter as they arrive
+/// </summary>
+class FakeProcessWatcher : public IProcessWatcher {
+public:
+    void start(unsigned long pid, std::string name)
+    {
+        this->push({ Event::Type::Started, pid, std::move(name) });
+    }
+
+    void exit(unsigned long pid)
+    {
+        this->push({ Event::Type::Exited, pid, std::string() });
+    }
+
+    /// <summary>
+    /// Reports that events were lost, followed by every running process
+    /// </summary>
+    void rescan(std::vector<std::pair<unsigned long, std::string>> running)
+    {
+        this->push({ Event::Type::Rescanned, 0, std::string() });
+        for (auto& [pid, name] : running)
+            this->push({ Event::Type::Started, pid, std::move(name) });
+    }
+
+    std::vector<Event> waitForEvents(std::chrono::milliseconds timeout) override
+    {
+        std::unique_lock<std::mutex> lock(this->m_mutex);
+        this->m_wake.wait_for(lock, timeout, [this]() { return this->m_interrupted || !this->m_events.empty(); });
+        this->m_interrupted = false;
+        ++this->m_waits;
+        std::vector<Event> events(this->m_events.begin(), this->m_events.end());
+        this->m_events.clear();
+        return events;
+    }
+
+    void interrupt() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->m_mutex);
+            this->m_interrupted = true;
+        }
+        this->m_wake.notify_all();
+    }
+
+    bool isEventDriven() const override { return true; }
+    const char* getBackendName() const override { return "fake"; }
+    Metrics getMetrics() const override { return Metrics(); }
+
+    std::size_t getWaitCount() const
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        return this->m_waits;
+    }
+
+private:
+    void push(Event event)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->m_mutex);
+            this->m_events.push_back(std::move(event));
+        }
+        this->m_wake.notify_all();
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Event> m_events;
+    bool m_interrupted = false;
+    std::size_t m_waits = 0;
+};
@@ -67,9 +67,17 @@ TEST(FileSettingsLoaderTest, ReadSettingsReadsAllSettings) {
     DriverSettings expected_settings;
     expected_settings.setValue<bool>(DriverSettings::AttachGizmo, true);
     expected_settings.setValue<bool>(DriverSettings::EnableDetailedLogging, true);
+    expected_settings.setValue<bool>(DriverSettings::EnableReferenceFusion, true);
+    expected_settings.setValue<bool>(DriverSettings::EnableOffsetRefinement, true);
+    expected_settings.setValue<bool>(DriverSettings::EnablePoseStream, true);
+    expected_settings.setValue<bool>(DriverSettings::EnableControlSocket, true);
     expected_settings.setValue<std::string>(DriverSettings::Handedness, "right");
     expected_settings.setValue<std::string>(DriverSettings::AutoTrackingRefSerial, "example_trackingref_serial");
     expected_settings.setValue<std::string>(DriverSettings::ForcedTrackingRefSerial, "forced_trackingref_serial");
+    expected_settings.setValue<std::string>(DriverSettings::IntegrationKeys, R"({"Blender.exe":"0123456789ABCDEF0123456789ABCDEF"})");
+    expected_settings.setValue<std::string>(DriverSettings::ApplicationProfiles, R"({"Blender.exe":{"smoothing":0.5}})");
+    expected_settings.setValue<std::string>(DriverSettings::LogLevels, R"({"pose":"debug"})");
+    expected_settings.setValue<std::string>(DriverSettings::PoseTraceFile, "pose.trace");
 
     // Write and read
     FileSettingsLoader settingsLoader(working_path);
@@ -79,12 +87,69 @@ TEST(FileSettingsLoaderTest, ReadSettingsReadsAllSettings) {
     // Check expected
     EXPECT_EQ(loaded_settings.getValue<bool>(DriverSettings::AttachGizmo).value(), expected_settings.getValue<bool>(DriverSettings::AttachGizmo).value());
     EXPECT_EQ(loaded_settings.getValue<bool>(DriverSettings::EnableDetailedLogging).value(), expected_settings.getValue<bool>(DriverSettings::EnableDetailedLogging).value());
+    EXPECT_EQ(loaded_settings.getValue<bool>(DriverSettings::EnableReferenceFusion).value(), expected_settings.getValue<bool>(DriverSettings::EnableReferenceFusion).value());
+    EXPECT_EQ(loaded_settings.getValue<bool>(DriverSettings::EnableOffsetRefinement).value(), expected_settings.getValue<bool>(DriverSettings::EnableOffsetRefinement).value());
+    EXPECT_EQ(loaded_settings.getValue<bool>(DriverSettings::EnablePoseStream).value(), expected_settings.getValue<bool>(DriverSettings::EnablePoseStream).value());
+    EXPECT_EQ(loaded_settings.getValue<bool>(DriverSettings::EnableControlSocket).value(), expected_settings.getValue<bool>(DriverSettings::EnableControlSocket).value());
     EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::Handedness).value(), expected_settings.getValue<std::string>(DriverSettings::Handedness).value());
     EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value(), expected_settings.getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value());
     EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::ForcedTrackingRefSerial).value(), expected_settings.getValue<std::string>(DriverSettings::ForcedTrackingRefSerial).value());
+    EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::IntegrationKeys).value(), expected_settings.getValue<std::string>(DriverSettings::IntegrationKeys).value());
+    EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::ApplicationProfiles).value(), expected_settings.getValue<std::string>(DriverSettings::ApplicationProfiles).value());
+    EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::LogLevels).value(), expected_settings.getValue<std::string>(DriverSettings::LogLevels).value());
+    EXPECT_EQ(loaded_settings.getValue<std::string>(DriverSettings::PoseTraceFile).value(), expected_settings.getValue<std::string>(DriverSettings::PoseTraceFile).value());
     
     std::filesystem::remove(working_path);
 }
+TEST(FileSettingsLoaderTest, IntegrationKeysMustBeAnObject) {
+    FileSettingsLoader object_loader(std::make_unique<std::istringstream>(R"({"integration_keys": {"Quill*": "0123456789ABCDEF0123456789ABCDEF"}})"), std::make_unique<std::ostringstream>());
+    EXPECT_EQ(object_loader.readSettings().getValue<std::string>(DriverSettings::IntegrationKeys), R"({"Quill*":"0123456789ABCDEF0123456789ABCDEF"})");
+
+    FileSettingsLoader string_loader(std::make_unique<std::istringstream>(R"({"integration_keys": "Quill*"})"), std::make_unique<std::ostringstream>());
+    EXPECT_FALSE(string_loader.readSettings().isValid(DriverSettings::IntegrationKeys));
+}
+TEST(FileSettingsLoaderTest, UnchangedSettingsAreNotWritten) {
+    auto write_stream = std::make_unique<std::ostringstream>();
+    std::ostringstream* written = write_stream.get();
+    FileSettingsLoader settingsLoader(std::make_unique<std::istringstream>("{}"), std::move(write_stream));
+
+    // Same as what was read
+    DriverSettings settings = settingsLoader.readSettings();
+    settingsLoader.writeSettings(settings);
+    EXPECT_TRUE(written->str().empty());
+
+    settings.setValue<std::string>(DriverSettings::AutoTrackingRefSerial, "example_trackingref_serial");
+    settingsLoader.writeSettings(settings);
+    std::string first_write = written->str();
+    EXPECT_FALSE(first_write.empty());
+
+    // Same as what was last written
+    written->str("");
+    settingsLoader.writeSettings(settings);
+    EXPECT_TRUE(written->str().empty());
+}
+
+TEST(FileSettingsLoaderTest, WritingReplacesTheFile) {
+    std::filesystem::path working_path = std::filesystem::current_path().string() + "//TEST_" + testing::UnitTest::GetInstance()->current_test_info()->name() + ".json";
+    std::filesystem::path temp_path = working_path;
+    temp_path += ".tmp";
+    if (std::filesystem::exists(working_path)) // Remove old file in case it already exists
+        std::filesystem::remove(working_path);
+
+    {
+        FileSettingsLoader settingsLoader(working_path);
+        DriverSettings settings = settingsLoader.readSettings();
+        settings.setValue<std::string>(DriverSettings::AutoTrackingRefSerial, "example_trackingref_serial");
+        settingsLoader.writeSettings(settings);
+        EXPECT_FALSE(std::filesystem::exists(temp_path)) << "Temporary file should have been renamed over the config";
+    }
+    {
+        FileSettingsLoader settingsLoader(working_path);
+        EXPECT_EQ(settingsLoader.readSettings().getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value(), "example_trackingref_serial");
+    }
+    std::filesystem::remove(working_path);
+}
+
 TEST(FileSettingsLoaderTest, ReadingBlankSettingsUsesDefaults) {
     
     FileSettingsLoader settingsLoader(std::make_unique<std::istringstream>("{}"), std::make_unique<std::ostringstream>());
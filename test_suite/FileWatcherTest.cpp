@@ -0,0 +1,96 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <FileWatcher.hpp>
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace {
+    // A directory of its own per test, so other tests' files don't show up as changes
+    struct FileWatcherTest : public Test {
+        std::filesystem::path directory;
+        std::filesystem::path path;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        int changes = 0;
+
+        void SetUp() override
+        {
+            this->directory = std::filesystem::temp_directory_path() / (std::string("FileWatcherTest_") + UnitTest::GetInstance()->current_test_info()->name()
+                + "_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+            std::filesystem::create_directories(this->directory);
+            this->path = this->directory / "driver_massless.json";
+            this->write(this->path, "{}");
+        }
+
+        void TearDown() override
+        {
+            std::error_code ignored;
+            std::filesystem::remove_all(this->directory, ignored);
+        }
+
+        void write(const std::filesystem::path& file, const std::string& contents)
+        {
+            std::ofstream(file, std::ios::trunc) << contents;
+        }
+
+        std::function<void()> onChange()
+        {
+            return [this]() {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                ++this->changes;
+                this->changed.notify_all();
+            };
+        }
+
+        bool waitForChanges(int count, std::chrono::milliseconds timeout = 5s)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            return this->changed.wait_for(lock, timeout, [&]() { return this->changes >= count; });
+        }
+    };
+}
+
+TEST_F(FileWatcherTest, ReportsABurstOfWritesOnce) {
+    FileWatcher watcher(path, onChange(), { 100ms, 20ms, false });
+
+    for (int i = 0; i < 5; ++i)
+        write(path, "{\"attach_gizmo\": " + std::string(i % 2 ? "true" : "false") + std::string(i, ' ') + "}");
+    ASSERT_TRUE(waitForChanges(1));
+
+    // Nothing more comes of the same burst
+    EXPECT_FALSE(waitForChanges(2, 300ms));
+    EXPECT_EQ(watcher.getChangeCount(), 1u);
+}
+
+TEST_F(FileWatcherTest, SeesTheFileReplacedByRename) {
+    FileWatcher watcher(path, onChange(), { 20ms, 20ms, false });
+    ASSERT_TRUE(SettingsUtilities::replaceFile(path, "{\"pen_handedness\": \"left\"}"));
+    EXPECT_TRUE(waitForChanges(1));
+}
+
+TEST_F(FileWatcherTest, IgnoresOtherFilesInTheDirectory) {
+    FileWatcher watcher(path, onChange(), { 20ms, 20ms, false });
+    write(directory / "warm_start.json", "{}");
+    EXPECT_FALSE(waitForChanges(1, 300ms));
+}
+
+TEST_F(FileWatcherTest, PollingSeesChanges) {
+    FileWatcher watcher(path, onChange(), { 20ms, 20ms, true });
+    EXPECT_STREQ(watcher.getBackendName(), "polling");
+    write(path, "{\"enable_detailed_logging\": true}");
+    EXPECT_TRUE(waitForChanges(1));
+}
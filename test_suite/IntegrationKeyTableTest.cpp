@@ -0,0 +1,95 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <IntegrationKeyTable.hpp>
+#include <MasslessOpenVRIntegrationUUIDs.h>
+
+using namespace testing;
+using MatchKind = IntegrationKeyTable::MatchKind;
+
+namespace {
+    IntegrationKeyTable::Key makeKey(uint8_t value) {
+        IntegrationKeyTable::Key key;
+        key.fill(value);
+        return key;
+    }
+}
+
+TEST(IntegrationKeyTableTest, ClassifiesPatterns) {
+    EXPECT_EQ(IntegrationKeyTable::classify("Blender.exe"), MatchKind::Exact);
+    EXPECT_EQ(IntegrationKeyTable::classify("Quill*"), MatchKind::Prefix);
+    EXPECT_EQ(IntegrationKeyTable::classify("*Sketch*.exe"), MatchKind::Glob);
+    EXPECT_EQ(IntegrationKeyTable::classify("Quill?*"), MatchKind::Glob);
+}
+
+TEST(IntegrationKeyTableTest, GlobMatchesWholeInputIgnoringCase) {
+    EXPECT_TRUE(IntegrationKeyTable::globMatch("*sketch*.exe", "GravitySketchVR.EXE"));
+    EXPECT_TRUE(IntegrationKeyTable::globMatch("app?.exe", "App1.exe"));
+    EXPECT_TRUE(IntegrationKeyTable::globMatch("*", ""));
+    EXPECT_FALSE(IntegrationKeyTable::globMatch("app?.exe", "App12.exe"));
+    EXPECT_FALSE(IntegrationKeyTable::globMatch("*sketch", "GravitySketchVR.exe"));
+}
+
+TEST(IntegrationKeyTableTest, UserEntriesMatchByPriority) {
+    IntegrationKeyTable table({
+        { "Quill*", makeKey(1) },
+        { "QuillTheater*", makeKey(2) },
+        { "QuillTheater.exe", makeKey(3) },
+        { "*Theater*", makeKey(4) },
+        { "Blender.exe", makeKey(5) }
+    });
+    EXPECT_EQ(table.size(), 5);
+
+    EXPECT_EQ(table.find("Quill.exe"), makeKey(1));
+    EXPECT_EQ(table.find("QuillTheaterBeta.exe"), makeKey(2)) << "Longest prefix wins";
+    EXPECT_EQ(table.find("quilltheater.exe"), makeKey(3)) << "Exact wins, ignoring case";
+    EXPECT_EQ(table.find("HomeTheater.exe"), makeKey(4));
+    EXPECT_EQ(table.find("BLENDER.EXE"), makeKey(5));
+    EXPECT_EQ(table.find("Blender"), std::nullopt);
+}
+
+TEST(IntegrationKeyTableTest, FallsBackToBuiltInKeys) {
+    IntegrationKeyTable table({ { "tiltbrush.exe", makeKey(1) } });
+    EXPECT_EQ(table.find("TiltBrush.exe"), makeKey(1)) << "User entries override built in keys";
+    EXPECT_EQ(table.find("steamtours.exe"), IntegrationKeyTable::Key(M_INTEGRATION_OPENVR_STEAMVRHOME));
+    EXPECT_EQ(IntegrationKeyTable().find("Masterpiece_VR.exe"), IntegrationKeyTable::Key(M_INTEGRATION_OPENVR_MASTERPIECEVR));
+}
+
+TEST(IntegrationKeyTableTest, CachesResultsPerExecutable) {
+    IntegrationKeyTable table({ { "Quill*", makeKey(1) } });
+    table.find("Quill.exe");
+    table.find("QUILL.exe");
+    table.find("Unknown.exe");
+    EXPECT_EQ(table.getCacheSize(), 2) << "Names are cached ignoring case, misses too";
+
+    for (std::size_t i = 0; i < IntegrationKeyTable::m_maxCached; ++i)
+        table.find("App" + std::to_string(i) + ".exe");
+    EXPECT_LE(table.getCacheSize(), IntegrationKeyTable::m_maxCached);
+    EXPECT_EQ(table.find("Quill.exe"), makeKey(1));
+}
+
+TEST(IntegrationKeyTableTest, ParsesSetting) {
+    auto result = IntegrationKeyTable::parse(R"({
+        "Blender.exe": "01010101010101010101010101010101",
+        "Quill*": "{02020202-0202-0202-0202-020202020202}",
+        "Short.exe": "0102",
+        "Number.exe": 5,
+        "Hex.exe": "0g010101010101010101010101010101"
+    })");
+    ASSERT_EQ(result.entries.size(), 2);
+    EXPECT_EQ(result.entries[0].pattern, "Blender.exe");
+    EXPECT_EQ(result.entries[0].key, makeKey(1));
+    EXPECT_EQ(result.entries[1].pattern, "Quill*");
+    EXPECT_EQ(result.entries[1].key, makeKey(2));
+    EXPECT_EQ(result.errors.size(), 3);
+
+    EXPECT_EQ(IntegrationKeyTable::parse("[]").errors.size(), 1);
+    EXPECT_EQ(IntegrationKeyTable::parse("{").errors.size(), 1);
+}
@@ -0,0 +1,108 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <DriverLog.hpp>
+#include <LogFilter.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace testing;
+
+namespace {
+    // The filter is global, put back what the test changed
+    struct ScopedLevels {
+        std::array<LogLevel, LogFilter::m_categoryCount> saved;
+        ScopedLevels() {
+            for (std::size_t i = 0; i < saved.size(); ++i)
+                saved[i] = LogFilter::getLevel(static_cast<LogCategory>(i));
+        }
+        ~ScopedLevels() {
+            for (std::size_t i = 0; i < saved.size(); ++i)
+                LogFilter::setLevel(static_cast<LogCategory>(i), saved[i]);
+        }
+    };
+
+    int evaluations = 0;
+    int countEvaluation() {
+        return ++evaluations;
+    }
+}
+
+TEST(LogFilterTest, LevelsArePerCategory) {
+    ScopedLevels scoped;
+    LogFilter::setLevel(LogCategory::Pose, LogLevel::Debug);
+    LogFilter::setLevel(LogCategory::Gesture, LogLevel::Off);
+
+    EXPECT_TRUE(LogFilter::isEnabled(LogCategory::Pose, LogLevel::Debug));
+    EXPECT_TRUE(LogFilter::isEnabled(LogCategory::Pose, LogLevel::Error));
+    EXPECT_FALSE(LogFilter::isEnabled(LogCategory::Pose, LogLevel::Trace));
+    EXPECT_FALSE(LogFilter::isEnabled(LogCategory::Gesture, LogLevel::Error));
+    EXPECT_FALSE(LogFilter::isEnabled(LogCategory::Reference, LogLevel::Debug));
+    EXPECT_TRUE(LogFilter::isEnabled(LogCategory::Reference, LogLevel::Info));
+    EXPECT_EQ(LogFilter::getLevel(LogCategory::Pose), LogLevel::Debug);
+    EXPECT_EQ(LogFilter::getLevel(LogCategory::Gesture), LogLevel::Off);
+    EXPECT_EQ(LogFilter::getLevel(LogCategory::Settings), LogFilter::m_defaultLevel);
+}
+
+TEST(LogFilterTest, ParsesLogLevelsSetting) {
+    auto parsed = LogFilter::parse(R"({"pose": "trace", "backend": "off", "gestures": "debug", "settings": "loud", "reference": 2})");
+
+    EXPECT_THAT(parsed.levels, ElementsAre(Pair(LogCategory::Backend, LogLevel::Off), Pair(LogCategory::Pose, LogLevel::Trace)));
+    EXPECT_EQ(parsed.errors.size(), 3);
+    EXPECT_THAT(LogFilter::parse("[]").errors, SizeIs(1));
+    EXPECT_STREQ(LogFilter::getCategoryName(LogCategory::Reference), "reference");
+    EXPECT_STREQ(LogFilter::getLevelName(LogLevel::Warn), "warn");
+}
+
+TEST(LogFilterTest, DisabledLinesDontEvaluateArguments) {
+    ScopedLevels scoped;
+    evaluations = 0;
+    LogFilter::setLevel(LogCategory::Gesture, LogLevel::Info);
+
+    DRIVER_LOG_DEBUG(Gesture, "%d\n", countEvaluation());
+    DRIVER_LOG_TRACE(Gesture, "%d\n", countEvaluation());
+    EXPECT_EQ(evaluations, 0);
+
+    DRIVER_LOG_INFO(Gesture, "%d\n", countEvaluation());
+    EXPECT_EQ(evaluations, 1);
+
+    // Below the compiled in level, never evaluated whatever the filter says
+    LogFilter::setLevel(LogCategory::Gesture, LogLevel::Trace);
+    DRIVER_LOG_TRACE(Gesture, "%d\n", countEvaluation());
+    EXPECT_EQ(evaluations, MASSLESS_LOG_MIN_LEVEL > 0 ? 1 : 2);
+}
+
+TEST(LogFilterTest, DISABLED_BenchmarkDisabledLogSites) {
+    ScopedLevels scoped;
+    LogFilter::setLevel(LogCategory::Pose, LogLevel::Info);
+    constexpr int iterations = 10000000;
+
+    // The same loop with and without a disabled log site whose arguments would be costly. Only meaningful in a release build, the check is
+    // only inlined to a load and a test when optimised.
+    volatile int sink = 0;
+    auto baseline_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        sink = sink + i;
+    auto baseline_time = std::chrono::steady_clock::now() - baseline_start;
+
+    std::string serial = "LHR-0123456789";
+    auto disabled_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink = sink + i;
+        DRIVER_LOG_DEBUG(Pose, "%s %d\n", (serial + std::to_string(i)).c_str(), i);
+    }
+    auto disabled_time = std::chrono::steady_clock::now() - disabled_start;
+
+    using ns = std::chrono::duration<double, std::nano>;
+    std::cout << "Baseline: " << ns(baseline_time).count() / iterations << "ns per iteration\n"
+        << "With a disabled log site: " << ns(disabled_time).count() / iterations << "ns per iteration\n";
+    EXPECT_LT(ns(disabled_time).count() / iterations, ns(baseline_time).count() / iterations + 1.0);
+}
@@ -0,0 +1,125 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include "FakeProcessWatcher.hpp"
+#include <MasslessManager.hpp>
+
+#include <condition_variable>
+#include <thread>
+
+using namespace testing;
+
+namespace {
+    bool waitForOwnership(const MasslessManager& manager, MasslessManager::Ownership ownership)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (manager.getOwnership() != ownership) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+TEST(MasslessManager, StopsThePenSystemWhileStudioRuns) {
+    std::shared_ptr<NiceMock<MockPenSystem>> pen_system = std::make_shared<NiceMock<MockPenSystem>>();
+    auto watcher = std::make_unique<FakeProcessWatcher>();
+    FakeProcessWatcher* fake = watcher.get();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int stops = 0;
+    int starts = 0;
+    ON_CALL(*pen_system, isSystemRunning()).WillByDefault(Return(true));
+    ON_CALL(*pen_system, stopSystem(_)).WillByDefault([&](bool) -> std::optional<MasslessInterface::IPenSystem::ErrorType> {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stops;
+        changed.notify_all();
+        return std::nullopt;
+    });
+    ON_CALL(*pen_system, startSystem(_)).WillByDefault([&](bool) -> std::optional<MasslessInterface::IPenSystem::ErrorType> {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++starts;
+        changed.notify_all();
+        return std::nullopt;
+    });
+
+    MasslessManager manager(pen_system, std::move(watcher));
+    manager.setPollInterval(std::chrono::seconds(10));
+    ASSERT_STREQ(manager.getProcessWatcherName(), "fake");
+
+    // Reported as soon as it starts, not after the (long) interval
+    fake->start(30, "MasslessStudio.exe");
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(changed.wait_for(lock, std::chrono::seconds(5), [&]() { return stops == 1; }));
+    lock.unlock();
+
+    fake->exit(30);
+    lock.lock();
+    ASSERT_TRUE(changed.wait_for(lock, std::chrono::seconds(5), [&]() { return starts == 1; }));
+}
+
+TEST(MasslessManager, PenSystemIsSuspendedWhileStudioOwnsIt) {
+    std::shared_ptr<NiceMock<MockPenSystem>> pen_system = std::make_shared<NiceMock<MockPenSystem>>();
+    auto watcher = std::make_unique<FakeProcessWatcher>();
+    FakeProcessWatcher* fake = watcher.get();
+    MasslessManager manager(pen_system, std::move(watcher));
+
+    {
+        auto lock = manager.getPenSystem();
+        ASSERT_TRUE(lock.pen_system.has_value());
+        ASSERT_TRUE(lock.lock.owns_lock());
+        ASSERT_EQ(lock.ownership, MasslessManager::Ownership::Driver);
+    }
+
+    fake->start(40, "Massless Studio.exe");
+    ASSERT_TRUE(waitForOwnership(manager, MasslessManager::Ownership::Studio));
+    {
+        // Refused without touching the lock, rather than by failing to take it
+        auto lock = manager.getPenSystem();
+        ASSERT_FALSE(lock.pen_system.has_value());
+        ASSERT_FALSE(lock.lock.owns_lock());
+        ASSERT_EQ(lock.ownership, MasslessManager::Ownership::Studio);
+    }
+    ASSERT_EQ(manager.getHandoffCount(), 1u);
+
+    fake->exit(40);
+    ASSERT_TRUE(waitForOwnership(manager, MasslessManager::Ownership::Driver));
+    ASSERT_TRUE(manager.getPenSystem().pen_system.has_value());
+}
+
+TEST(MasslessManager, HandoffWaitsForTheFrameInProgress) {
+    std::shared_ptr<NiceMock<MockPenSystem>> pen_system = std::make_shared<NiceMock<MockPenSystem>>();
+    auto watcher = std::make_unique<FakeProcessWatcher>();
+    FakeProcessWatcher* fake = watcher.get();
+    std::atomic<bool> stopped = false;
+    ON_CALL(*pen_system, isSystemRunning()).WillByDefault(Return(true));
+    ON_CALL(*pen_system, stopSystem(_)).WillByDefault([&](bool) -> std::optional<MasslessInterface::IPenSystem::ErrorType> {
+        stopped = true;
+        return std::nullopt;
+    });
+    MasslessManager manager(pen_system, std::move(watcher));
+
+    auto frame_lock = manager.getPenSystem();
+    ASSERT_TRUE(frame_lock.pen_system.has_value());
+
+    fake->start(50, "MasslessStudio.exe");
+    ASSERT_TRUE(waitForOwnership(manager, MasslessManager::Ownership::ReleasingToStudio));
+
+    // The rest of the frame no longer gets the pen system, but the one it has isn't stopped underneath it
+    ASSERT_FALSE(manager.getPenSystem().pen_system.has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(stopped);
+
+    frame_lock.lock.unlock();
+    ASSERT_TRUE(waitForOwnership(manager, MasslessManager::Ownership::Studio));
+    ASSERT_TRUE(stopped);
+}
@@ -21,6 +21,6 @@ public:
     MOCK_METHOD3(DebugRequest, void(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize));
     MOCK_METHOD0(GetPose, vr::DriverPose_t());
     MOCK_METHOD0(getIndex, vr::TrackedDeviceIndex_t(void));
-    MOCK_METHOD1(update, void(std::vector<vr::VREvent_t> events));
+    MOCK_METHOD1(update, void(EventSpan events));
 };
 
@@ -0,0 +1,158 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <OffsetRefiner.hpp>
+
+#include <thread>
+
+using namespace testing;
+using namespace std::chrono_literals;
+using SystemType = MasslessInterface::TrackingSystemType::SystemType;
+
+namespace {
+    constexpr float pi = 3.1415926f;
+
+    // Corners of a 4cm cube around the origin, like marked points on a controller
+    std::vector<Eigen::Vector3f> makePoints() {
+        std::vector<Eigen::Vector3f> points;
+        for (float x : { -0.02f, 0.02f })
+            for (float y : { -0.02f, 0.02f })
+                for (float z : { -0.02f, 0.02f })
+                    points.emplace_back(x, y, z);
+        return points;
+    }
+
+    OffsetRefiner::EigenPose makeOffset(float x, float angle) {
+        return { Eigen::Quaternionf(Eigen::AngleAxisf(angle, Eigen::Vector3f(1, 2, 3).normalized())), Eigen::Vector3f(x, 0.1f, 0.2f) };
+    }
+}
+
+class OffsetRefinerTest : public Test {
+protected:
+    OffsetRefinerTest() {
+        this->options.solve_interval = 1ms;
+    }
+
+    DriverAnalytics::TrackingReferencePack makeReference(const OffsetRefiner::EigenPose& offset) {
+        return DriverAnalytics::TrackingReferencePack(1, "LHR-TRACKER", MasslessInterface::TrackingSystemType(SystemType::VIVE_TRACKER), {}, OffsetRefiner::toPose(offset));
+    }
+
+    // Where the pen tip would be in Massless space when touching a point on the reference, if the true offset is as given
+    Eigen::Vector3f penPositionFor(const Eigen::Vector3f& reference_point, const OffsetRefiner::EigenPose& true_offset) {
+        Eigen::Vector3f flipped = Eigen::AngleAxisf(-pi / 2.0f, Eigen::Vector3f::UnitX()) * reference_point;
+        return true_offset.first.inverse() * (flipped - true_offset.second);
+    }
+
+    // The worker runs on real time, the smoothing on the fake clock
+    void waitForSolves(OffsetRefiner& refiner, uint64_t solves) {
+        for (int i = 0; i < 2000 && refiner.getMetrics().solves < solves; ++i)
+            std::this_thread::sleep_for(1ms);
+        ASSERT_GE(refiner.getMetrics().solves, solves);
+    }
+
+    OffsetRefiner::Options options;
+    OffsetRefiner::Clock::time_point now{};
+};
+
+TEST_F(OffsetRefinerTest, AccumulatorRecoversTransform) {
+    auto truth = makeOffset(0.05f, 0.3f);
+    OffsetRefiner::Accumulator accumulator;
+    for (const auto& point : makePoints())
+        accumulator.add(point, truth.first * point + truth.second);
+
+    auto solution = accumulator.solve(this->options);
+    ASSERT_TRUE(solution.has_value());
+    EXPECT_NEAR(solution->offset.first.angularDistance(truth.first), 0.0f, 1e-4f);
+    EXPECT_TRUE(solution->offset.second.isApprox(truth.second, 1e-4f));
+    EXPECT_NEAR(solution->residual, 0.0f, 1e-4f);
+}
+
+TEST_F(OffsetRefinerTest, AccumulatorReportsResidual) {
+    OffsetRefiner::Accumulator accumulator;
+    auto points = makePoints();
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        // 1mm of noise on every observation
+        Eigen::Vector3f noise = (i % 2 == 0 ? 0.001f : -0.001f) * Eigen::Vector3f::UnitZ();
+        accumulator.add(points[i], points[i] + noise);
+    }
+    auto solution = accumulator.solve(this->options);
+    ASSERT_TRUE(solution.has_value());
+    EXPECT_NEAR(solution->residual, 0.001f, 2e-4f);
+}
+
+TEST_F(OffsetRefinerTest, AccumulatorNeedsSpreadOutObservations) {
+    OffsetRefiner::Accumulator accumulator;
+    for (int i = 0; i < 3; ++i)
+        accumulator.add(Eigen::Vector3f(0.02f * i, 0, 0), Eigen::Vector3f(0.02f * i, 0, 0));
+    EXPECT_EQ(accumulator.solve(this->options), std::nullopt) << "Too few";
+
+    for (int i = 3; i < 10; ++i)
+        accumulator.add(Eigen::Vector3f(0.02f * i, 0, 0), Eigen::Vector3f(0.02f * i, 0, 0));
+    EXPECT_EQ(accumulator.solve(this->options), std::nullopt) << "All on a line";
+
+    accumulator.add(Eigen::Vector3f(0, 0.1f, 0), Eigen::Vector3f(0, 0.1f, 0));
+    accumulator.add(Eigen::Vector3f(0, -0.1f, 0), Eigen::Vector3f(0, -0.1f, 0));
+    EXPECT_TRUE(accumulator.solve(this->options).has_value());
+}
+
+TEST_F(OffsetRefinerTest, EasesOnToRefinedOffset) {
+    OffsetRefiner refiner(this->options, [this]() { return this->now; });
+    auto backend = makeOffset(0.0f, 0.0f);
+    auto truth = makeOffset(0.01f, 0.02f);
+    refiner.reset(this->makeReference(backend));
+    EXPECT_TRUE(refiner.update() == OffsetRefiner::toPose(backend)) << "Backend offset until there is a solution";
+
+    for (const auto& point : makePoints())
+        refiner.addObservation(this->penPositionFor(point, truth), point);
+    this->waitForSolves(refiner, 1);
+    EXPECT_EQ(refiner.getMetrics().rejected, 0);
+
+    // 1cm at 1cm/s takes a second, never stepping more than the rate allows
+    auto previous = OffsetRefiner::toEigen(refiner.update());
+    for (int frame = 0; frame < 100; ++frame) {
+        this->now += 11ms;
+        auto applied = OffsetRefiner::toEigen(refiner.update());
+        ASSERT_LE((applied.second - previous.second).norm(), this->options.max_translation_rate * 0.011f + 1e-6f);
+        previous = applied;
+    }
+    this->now += 1s;
+    auto applied = OffsetRefiner::toEigen(refiner.update());
+    EXPECT_TRUE(applied.second.isApprox(truth.second, 1e-3f));
+    EXPECT_NEAR(applied.first.angularDistance(truth.first), 0.0f, 1e-3f);
+}
+
+TEST_F(OffsetRefinerTest, RejectsLargeCorrections) {
+    OffsetRefiner refiner(this->options, [this]() { return this->now; });
+    auto backend = makeOffset(0.0f, 0.0f);
+    refiner.reset(this->makeReference(backend));
+
+    for (const auto& point : makePoints())
+        refiner.addObservation(this->penPositionFor(point, makeOffset(0.2f, 0.0f)), point);
+    this->waitForSolves(refiner, 1);
+    EXPECT_EQ(refiner.getMetrics().rejected, 1);
+
+    this->now += 10s;
+    EXPECT_TRUE(refiner.update() == OffsetRefiner::toPose(backend));
+}
+
+TEST_F(OffsetRefinerTest, NewReferenceDiscardsObservations) {
+    OffsetRefiner refiner(this->options, [this]() { return this->now; });
+    auto backend = makeOffset(0.0f, 0.0f);
+    refiner.reset(this->makeReference(backend));
+    refiner.addObservation(Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero());
+    EXPECT_EQ(refiner.getMetrics().observations, 1);
+
+    refiner.reset(this->makeReference(backend));
+    EXPECT_EQ(refiner.getMetrics().observations, 1) << "Same reference and offset keeps the observations";
+
+    refiner.reset(this->makeReference(makeOffset(0.01f, 0.0f)));
+    EXPECT_EQ(refiner.getMetrics().observations, 0);
+    EXPECT_TRUE(refiner.update() == OffsetRefiner::toPose(makeOffset(0.01f, 0.0f)));
+}
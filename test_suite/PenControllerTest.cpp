@@ -156,3 +156,39 @@ TEST(PenController, UpdatePenPosePostsToServerDriverHost) {
 
     controller.updatePenPose(test_pose, &host);
 }
+
+TEST(PenController, DebugRequestStatsIsJson) {
+    std::shared_ptr<SettingsManager> settings_manager = std::make_shared<SettingsManager>(std::make_unique<FileSettingsLoader>(std::make_unique<std::istringstream>("{}"), std::make_unique<std::ostringstream>()));
+    std::shared_ptr<NiceMock<MockPenSystem>> pen_system = std::make_shared<NiceMock<MockPenSystem>>();
+    std::shared_ptr<MasslessManager> massless_manager = std::make_shared<MasslessManager>(pen_system);
+
+    PenController controller(settings_manager, massless_manager);
+
+    char buffer[1024];
+    controller.DebugRequest("stats", buffer, sizeof(buffer));
+    auto stats = nlohmann::json::parse(buffer);
+    ASSERT_EQ(stats["updates"].get<uint64_t>(), 0);
+    ASSERT_EQ(stats["pose_valid"].get<bool>(), false);
+
+    controller.DebugRequest("pose_history 5", buffer, sizeof(buffer));
+    auto history = nlohmann::json::parse(buffer);
+    ASSERT_TRUE(history["poses"].is_array());
+    ASSERT_EQ(history["poses"].size(), 0);
+
+    controller.DebugRequest("queues", buffer, sizeof(buffer));
+    auto queues = nlohmann::json::parse(buffer);
+    ASSERT_EQ(queues["gesture_stack"].get<std::size_t>(), 0);
+}
+
+TEST(PenController, DebugRequestUnknownReturnsError) {
+    std::shared_ptr<SettingsManager> settings_manager = std::make_shared<SettingsManager>(std::make_unique<FileSettingsLoader>(std::make_unique<std::istringstream>("{}"), std::make_unique<std::ostringstream>()));
+    std::shared_ptr<NiceMock<MockPenSystem>> pen_system = std::make_shared<NiceMock<MockPenSystem>>();
+    std::shared_ptr<MasslessManager> massless_manager = std::make_shared<MasslessManager>(pen_system);
+
+    PenController controller(settings_manager, massless_manager);
+
+    char buffer[1024];
+    controller.DebugRequest("not_a_command", buffer, sizeof(buffer));
+    auto response = nlohmann::json::parse(buffer);
+    ASSERT_EQ(response["error"].get<std::string>(), "unknown_request");
+}
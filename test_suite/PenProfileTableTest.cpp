@@ -0,0 +1,66 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <PenProfileTable.hpp>
+
+using namespace testing;
+
+namespace {
+    PenProfileTable::Entry makeEntry(std::string pattern, float smoothing) {
+        PenProfileTable::Entry entry{ pattern, PenProfile() };
+        entry.profile.name = pattern;
+        entry.profile.smoothing = smoothing;
+        return entry;
+    }
+}
+
+TEST(PenProfileTableTest, ParsesProfilesWithDefaultsForMissingFields) {
+    auto parsed = PenProfileTable::parse(R"({"Blender.exe": {"smoothing": 0.5, "prediction_ms": 10}, "Quill*": {"haptic_scale": 2}})");
+
+    EXPECT_THAT(parsed.errors, IsEmpty());
+    ASSERT_EQ(parsed.entries.size(), 2);
+    PenProfileTable table(parsed.entries);
+    auto blender = table.find("Blender.exe");
+    EXPECT_EQ(blender->name, "Blender.exe");
+    EXPECT_FLOAT_EQ(blender->smoothing, 0.5f);
+    EXPECT_FLOAT_EQ(blender->prediction_ms, 10.0f);
+    EXPECT_FLOAT_EQ(blender->haptic_scale, 1.0f);
+    EXPECT_FLOAT_EQ(table.find("Quill.exe")->haptic_scale, 2.0f);
+    EXPECT_FLOAT_EQ(table.find("Quill.exe")->smoothing, 0.0f);
+}
+
+TEST(PenProfileTableTest, SkipsInvalidProfiles) {
+    auto parsed = PenProfileTable::parse(R"({"A.exe": {"smoothing": 2}, "B.exe": {"jitter": 1}, "C.exe": 5, "D.exe": {"max_pose_rate_hz": "90"}, "E.exe": {"haptic_scale": 0}})");
+
+    EXPECT_EQ(parsed.errors.size(), 4);
+    ASSERT_EQ(parsed.entries.size(), 1);
+    EXPECT_EQ(parsed.entries[0].pattern, "E.exe");
+    EXPECT_THAT(PenProfileTable::parse("[]").errors, SizeIs(1));
+    EXPECT_THAT(PenProfileTable::parse("{").errors, SizeIs(1));
+}
+
+TEST(PenProfileTableTest, MatchesByPriorityAndFallsBackToDefault) {
+    PenProfileTable table({ makeEntry("*.exe", 0.1f), makeEntry("Quill*", 0.2f), makeEntry("QuillTheater*", 0.3f), makeEntry("quill.exe", 0.4f) });
+
+    EXPECT_EQ(table.size(), 4);
+    EXPECT_FLOAT_EQ(table.find("Quill.exe")->smoothing, 0.4f);
+    EXPECT_FLOAT_EQ(table.find("QuillTheater.exe")->smoothing, 0.3f);
+    EXPECT_FLOAT_EQ(table.find("QuillBeta.exe")->smoothing, 0.2f);
+    EXPECT_FLOAT_EQ(table.find("Blender.exe")->smoothing, 0.1f);
+    EXPECT_EQ(table.find("blender"), table.getDefault());
+    EXPECT_EQ(table.getDefault()->name, "default");
+}
+
+TEST(PenProfileTableTest, FindReturnsTheSameBlock) {
+    PenProfileTable table({ makeEntry("Blender.exe", 0.5f) });
+
+    // Switching between applications only swaps pointers to the compiled profiles
+    EXPECT_EQ(table.find("Blender.exe"), table.find("BLENDER.EXE"));
+}
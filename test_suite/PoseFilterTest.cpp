@@ -0,0 +1,81 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <PoseFilter.hpp>
+
+using namespace testing;
+
+namespace {
+    vr::DriverPose_t makePose(double x) {
+        vr::DriverPose_t pose = {};
+        pose.vecPosition[0] = x;
+        pose.qRotation.w = 1.0;
+        return pose;
+    }
+
+    const std::chrono::system_clock::time_point start = std::chrono::system_clock::time_point() + std::chrono::hours(1);
+}
+
+TEST(PoseFilterTest, PassesThroughWhenDisabled) {
+    PoseFilter filter;
+    auto pose = makePose(1.0);
+    pose.qRotation.x = 0.5;
+
+    filter.apply(pose, start);
+    filter.apply(pose, start + std::chrono::milliseconds(10));
+
+    EXPECT_FALSE(filter.isEnabled());
+    EXPECT_DOUBLE_EQ(pose.vecPosition[0], 1.0);
+    EXPECT_DOUBLE_EQ(pose.qRotation.x, 0.5);
+}
+
+TEST(PoseFilterTest, SmoothsTowardsNewPoses) {
+    PoseFilter filter;
+    filter.configure(0.5f, 0.0f);
+
+    auto first = makePose(0.0);
+    filter.apply(first, start);
+    auto second = makePose(1.0);
+    filter.apply(second, start + std::chrono::milliseconds(10));
+
+    EXPECT_DOUBLE_EQ(first.vecPosition[0], 0.0);
+    EXPECT_DOUBLE_EQ(second.vecPosition[0], 0.5);
+    EXPECT_DOUBLE_EQ(second.vecVelocity[0], 0.0);
+}
+
+TEST(PoseFilterTest, PredictsFromVelocity) {
+    PoseFilter filter;
+    filter.configure(0.0f, 100.0f);
+
+    // Moving at 1 m/s
+    vr::DriverPose_t pose;
+    for (int i = 0; i <= 10; ++i) {
+        pose = makePose(i * 0.01);
+        filter.apply(pose, start + std::chrono::milliseconds(i * 10));
+    }
+
+    EXPECT_NEAR(pose.vecPosition[0], 0.2, 1e-6);
+}
+
+TEST(PoseFilterTest, RestartsAfterGapsAndResets) {
+    PoseFilter filter;
+    filter.configure(0.9f, 0.0f);
+
+    auto pose = makePose(0.0);
+    filter.apply(pose, start);
+    pose = makePose(1.0);
+    filter.apply(pose, start + PoseFilter::m_maxGap + std::chrono::milliseconds(1));
+    EXPECT_DOUBLE_EQ(pose.vecPosition[0], 1.0);
+
+    filter.reset();
+    pose = makePose(2.0);
+    filter.apply(pose, start + PoseFilter::m_maxGap + std::chrono::milliseconds(2));
+    EXPECT_DOUBLE_EQ(pose.vecPosition[0], 2.0);
+}
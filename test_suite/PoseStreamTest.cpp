@@ -0,0 +1,157 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <PoseStreamWriter.hpp>
+#include <PoseStreamReader.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+using namespace testing;
+
+namespace {
+    // Unique per test, so tests (and test runs) don't open each other's streams
+    std::string streamName()
+    {
+        return std::string("MasslessPoseStreamTest_") + testing::UnitTest::GetInstance()->current_test_info()->name() + "_"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+}
+
+TEST(PoseStream, ReaderSeesPosesStatesAndEvents) {
+    std::string name = streamName();
+    auto writer = PoseStreamWriter::create(name, 16);
+    ASSERT_NE(writer, nullptr);
+    auto reader = PoseStreamReader::open(name);
+    ASSERT_NE(reader, nullptr);
+
+    MasslessInterface::Pose pose(0.1f, 0.2f, 0.3f, 1.0f, 0.0f, 0.0f, 0.0f);
+    pose.m_gz = 4.0f;
+    MasslessInterface::PenState state(0.05f, 200);
+    state.m_surfaceFound = true;
+    writer->publishPose(pose);
+    writer->publishState(state);
+    writer->publishEvent(7);
+
+    std::vector<PoseStream::Record> records;
+    ASSERT_EQ(reader->read(records, 16), 3u);
+    ASSERT_EQ(records[0].type, PoseStream::RecordType::Pose);
+    EXPECT_FLOAT_EQ(records[0].position[1], 0.2f);
+    EXPECT_FLOAT_EQ(records[0].rotation[0], 1.0f);
+    EXPECT_FLOAT_EQ(records[0].gyro[2], 4.0f);
+    EXPECT_EQ(records[0].timestamp_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(pose.m_timestamp.time_since_epoch()).count());
+    ASSERT_EQ(records[1].type, PoseStream::RecordType::State);
+    EXPECT_EQ(records[1].capsense_value, 200);
+    EXPECT_EQ(records[1].surface_found, 1);
+    ASSERT_EQ(records[2].type, PoseStream::RecordType::Event);
+    EXPECT_EQ(records[2].event_type, 7u);
+
+    // Nothing new
+    ASSERT_EQ(reader->read(records, 16), 0u);
+    EXPECT_EQ(reader->getDroppedCount(), 0u);
+}
+
+TEST(PoseStream, ReaderStartsAtTheNewestRecord) {
+    std::string name = streamName();
+    auto writer = PoseStreamWriter::create(name, 16);
+    ASSERT_NE(writer, nullptr);
+    writer->publishEvent(1);
+
+    auto reader = PoseStreamReader::open(name);
+    ASSERT_NE(reader, nullptr);
+    writer->publishEvent(2);
+
+    std::vector<PoseStream::Record> records;
+    ASSERT_EQ(reader->read(records, 16), 1u);
+    EXPECT_EQ(records[0].event_type, 2u);
+    ASSERT_TRUE(reader->readLatest().has_value());
+    EXPECT_EQ(reader->readLatest()->event_type, 2u);
+}
+
+TEST(PoseStream, SlowReaderDropsOverwrittenRecords) {
+    std::string name = streamName();
+    auto writer = PoseStreamWriter::create(name, 8);
+    ASSERT_NE(writer, nullptr);
+    auto reader = PoseStreamReader::open(name);
+    ASSERT_NE(reader, nullptr);
+
+    for (uint16_t i = 0; i < 20; ++i)
+        writer->publishEvent(i);
+
+    std::vector<PoseStream::Record> records;
+    ASSERT_EQ(reader->read(records, 100), 8u);
+    EXPECT_EQ(records.front().event_type, 12u);
+    EXPECT_EQ(records.back().event_type, 19u);
+    EXPECT_EQ(reader->getDroppedCount(), 12u);
+}
+
+TEST(PoseStream, OpenFailsWithoutAStream) {
+    ASSERT_EQ(PoseStreamReader::open(streamName()), nullptr);
+
+    // Removed with the writer
+    std::string name = streamName();
+    PoseStreamWriter::create(name, 8);
+    ASSERT_EQ(PoseStreamReader::open(name), nullptr);
+}
+
+// Several readers following a writer, first at a pen-like rate then as fast as it can publish, run with --gtest_also_run_disabled_tests
+TEST(PoseStream, DISABLED_BenchmarkMultipleReaders) {
+    constexpr int reader_count = 4;
+
+    auto run = [](const std::string& name, uint64_t record_count, std::optional<double> rate_hz) {
+        auto writer = PoseStreamWriter::create(name, PoseStream::default_capacity);
+        ASSERT_NE(writer, nullptr);
+
+        std::atomic<bool> writing = true;
+        std::vector<uint64_t> read_counts(reader_count);
+        std::vector<uint64_t> dropped_counts(reader_count);
+        std::vector<std::thread> readers;
+        for (int i = 0; i < reader_count; ++i) {
+            readers.emplace_back([&, i]() {
+                auto reader = PoseStreamReader::open(name);
+                std::vector<PoseStream::Record> records;
+                records.reserve(PoseStream::default_capacity);
+                while (writing) {
+                    records.clear();
+                    read_counts[i] += reader->read(records, PoseStream::default_capacity);
+                }
+                records.clear();
+                read_counts[i] += reader->read(records, PoseStream::default_capacity);
+                dropped_counts[i] = reader->getDroppedCount();
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        MasslessInterface::Pose pose;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < record_count; ++i) {
+            if (rate_hz.has_value()) {
+                auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(i / *rate_hz));
+                while (std::chrono::steady_clock::now() < due) {}
+            }
+            writer->publishPose(pose);
+        }
+        auto write_time = std::chrono::steady_clock::now() - start;
+        writing = false;
+        for (auto& reader : readers)
+            reader.join();
+
+        double seconds = std::chrono::duration<double>(write_time).count();
+        std::cout << "Published " << record_count << " records in " << seconds * 1000.0 << "ms (" << record_count / seconds / 1000.0 << " kHz)\n";
+        for (int i = 0; i < reader_count; ++i) {
+            std::cout << "  Reader " << i << ": read " << read_counts[i] << ", dropped " << dropped_counts[i] << "\n";
+            EXPECT_EQ(read_counts[i] + dropped_counts[i], record_count);
+        }
+    };
+
+    run(streamName() + "_paced", 100000, 50000.0);
+    run(streamName() + "_unpaced", 2000000, std::nullopt);
+}
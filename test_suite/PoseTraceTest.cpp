@@ -0,0 +1,251 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <PoseTraceRecorder.hpp>
+#include <PoseTraceSwitcher.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+namespace {
+    std::filesystem::path tracePath()
+    {
+        return std::filesystem::temp_directory_path() / (std::string("MasslessPoseTraceTest_") + testing::UnitTest::GetInstance()->current_test_info()->name() + ".trace");
+    }
+
+    PoseTrace::Record makeRecord(int64_t sample_ns)
+    {
+        PoseTrace::Record record = {};
+        record.sample_ns = sample_ns;
+        record.submit_ns = sample_ns + 500000;
+        record.raw_position[0] = 0.1f;
+        record.filtered_rotation[0] = 1.0f;
+        record.flags = PoseTrace::Fused;
+        return record;
+    }
+
+    PoseTraceSwitcher::Factory smallTraces()
+    {
+        return [](const std::filesystem::path& path) {
+            PoseTraceRecorder::Options options;
+            options.capacity = 100;
+            return PoseTraceRecorder::create(path, options);
+        };
+    }
+
+    // Calls update as the frame thread would until the recorder in use changes
+    PoseTraceRecorder* updateUntilChanged(PoseTraceSwitcher& switcher, PoseTraceRecorder* previous)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        PoseTraceRecorder* current = switcher.update();
+        while (current == previous && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            current = switcher.update();
+        }
+        return current;
+    }
+}
+
+TEST(PoseTrace, RecordedPosesCanBeReadBack) {
+    auto path = tracePath();
+    PoseTraceRecorder::Options options;
+    options.capacity = 100;
+    {
+        auto recorder = PoseTraceRecorder::create(path, options);
+        ASSERT_NE(recorder, nullptr);
+        for (int i = 0; i < 10; ++i)
+            recorder->record(makeRecord(i * 1000000));
+    }
+
+    // Preallocated for the whole capacity
+    EXPECT_EQ(std::filesystem::file_size(path), PoseTrace::fileSize(100));
+
+    std::string error;
+    auto trace = PoseTrace::read(path, error);
+    ASSERT_TRUE(trace.has_value()) << error;
+    EXPECT_EQ(trace->capacity, 100);
+    ASSERT_EQ(trace->records.size(), 10);
+    EXPECT_EQ(trace->records[9].sample_ns, 9000000);
+    EXPECT_EQ(trace->records[9].submit_ns, 9500000);
+    EXPECT_FLOAT_EQ(trace->records[9].raw_position[0], 0.1f);
+    EXPECT_FLOAT_EQ(trace->records[9].filtered_rotation[0], 1.0f);
+    EXPECT_EQ(trace->records[9].flags, PoseTrace::Fused);
+    std::filesystem::remove(path);
+}
+
+TEST(PoseTrace, RecordsPastTheCapacityAreDropped) {
+    auto path = tracePath();
+    PoseTraceRecorder::Options options;
+    options.capacity = 4;
+    options.queue_size = 64;
+    {
+        auto recorder = PoseTraceRecorder::create(path, options);
+        ASSERT_NE(recorder, nullptr);
+        for (int i = 0; i < 6; ++i)
+            recorder->record(makeRecord(i));
+    }
+
+    std::string error;
+    auto trace = PoseTrace::read(path, error);
+    ASSERT_TRUE(trace.has_value()) << error;
+    EXPECT_EQ(trace->records.size(), 4);
+    EXPECT_EQ(trace->records[3].sample_ns, 3);
+    std::filesystem::remove(path);
+}
+
+TEST(PoseTrace, CountsRecordedAndDropped) {
+    auto path = tracePath();
+    PoseTraceRecorder::Options options;
+    options.capacity = 4;
+    options.queue_size = 64;
+    auto recorder = PoseTraceRecorder::create(path, options);
+    ASSERT_NE(recorder, nullptr);
+    for (int i = 0; i < 6; ++i)
+        recorder->record(makeRecord(i));
+
+    // Drained by the recorder thread
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (recorder->getRecordedCount() + recorder->getDroppedCount() < 6 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(recorder->getRecordedCount(), 4);
+    EXPECT_EQ(recorder->getDroppedCount(), 2);
+    recorder.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(PoseTrace, ReadRejectsOtherFiles) {
+    auto path = tracePath();
+    std::ofstream(path) << std::string(200, 'x');
+
+    std::string error;
+    EXPECT_FALSE(PoseTrace::read(path, error).has_value());
+    EXPECT_EQ(error, "Not a pose trace");
+    EXPECT_FALSE(PoseTrace::read(path.string() + ".missing", error).has_value());
+    std::filesystem::remove(path);
+}
+
+TEST(PoseTrace, DISABLED_BenchmarkRecordAt1kHz) {
+    auto path = tracePath();
+    PoseTraceRecorder::Options options;
+    options.capacity = 100000;
+    auto recorder = PoseTraceRecorder::create(path, options);
+    ASSERT_NE(recorder, nullptr);
+
+    // Ten seconds of records paced at 1 kHz, timing only the frame thread's side
+    constexpr int iterations = 10000;
+    std::chrono::nanoseconds total{ 0 }, worst{ 0 };
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        recorder->record(makeRecord(i));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        total += elapsed;
+        worst = std::max<std::chrono::nanoseconds>(worst, elapsed);
+        if (i % 10 == 9)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    recorder.reset();
+
+    std::cout << "record(): " << total.count() / iterations << "ns mean, " << worst.count() << "ns worst\n";
+    std::string error;
+    EXPECT_EQ(PoseTrace::read(path, error)->records.size(), iterations);
+    std::filesystem::remove(path);
+}
+
+TEST(PoseTraceSwitcher, StartsAndStopsTracesOffTheFrameThread) {
+    auto path = tracePath();
+    auto next_path = std::filesystem::path(path.string() + ".next");
+    {
+        PoseTraceSwitcher switcher(smallTraces());
+        EXPECT_EQ(switcher.update(), nullptr);
+
+        switcher.request(path);
+        PoseTraceRecorder* recorder = updateUntilChanged(switcher, nullptr);
+        ASSERT_NE(recorder, nullptr);
+        EXPECT_EQ(switcher.get(), recorder);
+        EXPECT_EQ(recorder->getPath(), path);
+        for (int i = 0; i < 10; ++i)
+            recorder->record(makeRecord(i));
+
+        switcher.request(std::nullopt);
+        EXPECT_EQ(updateUntilChanged(switcher, recorder), nullptr);
+        EXPECT_EQ(switcher.get(), nullptr);
+
+        // The next trace is only opened once the worker has closed the last one
+        switcher.request(next_path);
+        ASSERT_NE(updateUntilChanged(switcher, nullptr), nullptr);
+        std::string error;
+        auto trace = PoseTrace::read(path, error);
+        ASSERT_TRUE(trace.has_value()) << error;
+        EXPECT_EQ(trace->records.size(), 10);
+    }
+    std::filesystem::remove(path);
+    std::filesystem::remove(next_path);
+}
+
+TEST(PoseTraceSwitcher, RequestingTheSameFileStartsANewTrace) {
+    auto path = tracePath();
+    {
+        PoseTraceSwitcher switcher(smallTraces());
+        switcher.request(path);
+        PoseTraceRecorder* first = updateUntilChanged(switcher, nullptr);
+        ASSERT_NE(first, nullptr);
+        for (int i = 0; i < 10; ++i)
+            first->record(makeRecord(i));
+
+        // Stopped, then reopened once the first is closed
+        switcher.request(path);
+        EXPECT_EQ(updateUntilChanged(switcher, first), nullptr);
+        PoseTraceRecorder* second = updateUntilChanged(switcher, nullptr);
+        ASSERT_NE(second, nullptr);
+        second->record(makeRecord(100));
+    }
+
+    std::string error;
+    auto trace = PoseTrace::read(path, error);
+    ASSERT_TRUE(trace.has_value()) << error;
+    ASSERT_EQ(trace->records.size(), 1);
+    EXPECT_EQ(trace->records[0].sample_ns, 100);
+    std::filesystem::remove(path);
+}
+
+TEST(PoseTraceSwitcher, OnlyTheLatestRequestIsKept) {
+    auto base = tracePath().string();
+    auto latest = std::filesystem::path(base + "4");
+    std::vector<std::filesystem::path> opened;
+    std::mutex mutex;
+    {
+        PoseTraceSwitcher switcher([&](const std::filesystem::path& path) {
+            std::lock_guard<std::mutex> lock(mutex);
+            opened.push_back(path);
+            return smallTraces()(path);
+        });
+        for (int i = 0; i < 5; ++i)
+            switcher.request(base + std::to_string(i));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        PoseTraceRecorder* recorder = switcher.update();
+        while ((recorder == nullptr || recorder->getPath() != latest) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            recorder = switcher.update();
+        }
+        ASSERT_NE(recorder, nullptr);
+        EXPECT_EQ(recorder->getPath(), latest);
+    }
+
+    EXPECT_LE(opened.size(), 5);
+    EXPECT_EQ(opened.back(), latest);
+    for (auto& path : opened)
+        std::filesystem::remove(path);
+}
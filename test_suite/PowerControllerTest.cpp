@@ -0,0 +1,105 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <PowerController.hpp>
+
+using namespace testing;
+using namespace std::chrono_literals;
+using Mode = PowerController::Mode;
+
+class PowerControllerTest : public Test {
+protected:
+    PowerController makeController() {
+        return PowerController(this->options, [this]() { return this->now; });
+    }
+
+    // Runs frames at 90Hz for a duration, counting the frames deferred work was due
+    int runFrames(PowerController& power, std::chrono::milliseconds duration) {
+        int work_frames = 0;
+        for (auto end = this->now + duration; this->now < end; this->now += 11ms) {
+            power.update();
+            if (power.isWorkDue())
+                ++work_frames;
+        }
+        return work_frames;
+    }
+
+    PowerController::Options options;
+    PowerController::Clock::time_point now{};
+};
+
+TEST_F(PowerControllerTest, GoesIdleWithoutPenActivity) {
+    PowerController power = this->makeController();
+    EXPECT_EQ(power.update(), Mode::Active);
+
+    this->runFrames(power, 1s);
+    power.onPenActivity();
+    this->runFrames(power, 1900ms);
+    EXPECT_EQ(power.getMode(), Mode::Active);
+
+    this->runFrames(power, 200ms);
+    EXPECT_EQ(power.getMode(), Mode::Idle);
+    EXPECT_EQ(power.getPollInterval(), this->options.idle_poll_interval);
+}
+
+TEST_F(PowerControllerTest, IdleDefersWorkToTheInterval) {
+    PowerController power = this->makeController();
+    EXPECT_EQ(this->runFrames(power, 1s), 91) << "Every frame while active";
+
+    this->runFrames(power, this->options.idle_timeout);
+    ASSERT_EQ(power.getMode(), Mode::Idle);
+    EXPECT_NEAR(this->runFrames(power, 1s), 4, 1) << "Once per 250ms while idle";
+}
+
+TEST_F(PowerControllerTest, PenActivityResumesImmediately) {
+    PowerController power = this->makeController();
+    this->runFrames(power, 3s);
+    ASSERT_EQ(power.getMode(), Mode::Idle);
+
+    power.onPenActivity();
+    EXPECT_EQ(power.getMode(), Mode::Active);
+    EXPECT_TRUE(power.isWorkDue()) << "Work runs in the same frame";
+    EXPECT_EQ(power.getPollInterval(), this->options.active_poll_interval);
+}
+
+TEST_F(PowerControllerTest, StandbyUntilWokenOrUsed) {
+    PowerController power = this->makeController();
+    power.enterStandby();
+    EXPECT_EQ(power.getMode(), Mode::Standby);
+    EXPECT_EQ(this->runFrames(power, 3s), 3) << "Once per second in standby";
+    EXPECT_EQ(power.getMode(), Mode::Standby) << "The idle timeout doesn't leave standby";
+
+    power.leaveStandby();
+    EXPECT_EQ(power.getMode(), Mode::Idle) << "The pen hasn't been used for a while";
+
+    power.enterStandby();
+    power.onPenActivity();
+    EXPECT_EQ(power.getMode(), Mode::Active);
+    power.enterStandby();
+    power.leaveStandby();
+    EXPECT_EQ(power.getMode(), Mode::Active) << "The pen was just used";
+}
+
+TEST_F(PowerControllerTest, ReportsTimeAndCpuPerMode) {
+    PowerController power = this->makeController();
+    for (int frame = 0; frame < 100; ++frame) {
+        auto mode = power.update();
+        power.getFrameTiming(mode).record(1100us);
+        this->now += 11ms;
+    }
+    power.update();
+
+    const auto& active = power.getStats(Mode::Active);
+    EXPECT_EQ(active.frames.count, 100);
+    EXPECT_EQ(active.entered, 1);
+    EXPECT_EQ(active.time, 1100ms);
+    EXPECT_NEAR(active.cpuPercent(), 10.0, 1e-6);
+    EXPECT_EQ(power.getStats(Mode::Idle).cpuPercent(), 0.0);
+}
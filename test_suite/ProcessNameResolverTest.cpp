@@ -0,0 +1,169 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ProcessNameResolver.hpp>
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <thread>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+class ProcessNameResolverTest : public Test {
+protected:
+    std::unique_ptr<ProcessNameResolver> makeResolver(std::size_t capacity = 16) {
+        return std::make_unique<ProcessNameResolver>(capacity,
+            [this](unsigned long pid) -> std::optional<std::wstring> {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (auto found = this->names.find(pid); found != this->names.end())
+                    return found->second;
+                return std::nullopt;
+            },
+            [this](unsigned long pid) -> std::optional<uint64_t> {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (auto found = this->start_times.find(pid); found != this->start_times.end())
+                    return found->second;
+                return std::nullopt;
+            });
+    }
+
+    // The resolver runs on its own thread, so poll for the result like the frame loop does
+    std::optional<ProcessNameResolver::Result> waitForResult(ProcessNameResolver& resolver) {
+        for (int i = 0; i < 2000; ++i) {
+            if (auto result = resolver.takeResult(); result.has_value())
+                return result;
+            std::this_thread::sleep_for(1ms);
+        }
+        return std::nullopt;
+    }
+
+    void addProcess(unsigned long pid, uint64_t start_time, const std::wstring& name) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->names[pid] = name;
+        this->start_times[pid] = start_time;
+    }
+
+    std::mutex mutex;
+    std::map<unsigned long, std::wstring> names;
+    std::map<unsigned long, uint64_t> start_times;
+};
+
+TEST_F(ProcessNameResolverTest, ResolvesName) {
+    this->addProcess(42, 1000, L"Paint.exe");
+    auto resolver = this->makeResolver();
+    EXPECT_EQ(resolver->takeResult(), std::nullopt) << "Nothing requested";
+
+    resolver->request(42);
+    auto result = this->waitForResult(*resolver);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->pid, 42);
+    EXPECT_EQ(result->name, L"Paint.exe");
+    EXPECT_FALSE(result->cached);
+    EXPECT_EQ(resolver->takeResult(), std::nullopt) << "Results are only taken once";
+}
+
+TEST_F(ProcessNameResolverTest, CachedNameIsNotLookedUpAgain) {
+    this->addProcess(42, 1000, L"Paint.exe");
+    auto resolver = this->makeResolver();
+
+    resolver->request(42);
+    ASSERT_TRUE(this->waitForResult(*resolver).has_value());
+    resolver->request(42);
+    auto result = this->waitForResult(*resolver);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->name, L"Paint.exe");
+    EXPECT_TRUE(result->cached);
+    EXPECT_EQ(resolver->getLookupCount(), 1);
+}
+
+TEST_F(ProcessNameResolverTest, ReusedPidIsLookedUpAgain) {
+    this->addProcess(42, 1000, L"Paint.exe");
+    auto resolver = this->makeResolver();
+    resolver->request(42);
+    ASSERT_TRUE(this->waitForResult(*resolver).has_value());
+
+    this->addProcess(42, 2000, L"Sculpt.exe");
+    resolver->request(42);
+    auto result = this->waitForResult(*resolver);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->name, L"Sculpt.exe");
+    EXPECT_FALSE(result->cached);
+    EXPECT_EQ(resolver->getLookupCount(), 2);
+}
+
+TEST_F(ProcessNameResolverTest, MissesAndUnknownStartTimesAreNotCached) {
+    auto resolver = this->makeResolver();
+    resolver->request(7);
+    auto result = this->waitForResult(*resolver);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->name, std::nullopt);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->names[7] = L"Late.exe";
+    }
+    resolver->request(7);
+    result = this->waitForResult(*resolver);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->name, L"Late.exe");
+
+    resolver->request(7);
+    ASSERT_TRUE(this->waitForResult(*resolver).has_value());
+    EXPECT_EQ(resolver->getLookupCount(), 3) << "Without a start time the PID can't be trusted";
+}
+
+TEST_F(ProcessNameResolverTest, LeastRecentlyUsedIsEvicted) {
+    this->addProcess(1, 100, L"One.exe");
+    this->addProcess(2, 200, L"Two.exe");
+    this->addProcess(3, 300, L"Three.exe");
+    auto resolver = this->makeResolver(2);
+
+    for (unsigned long pid : { 1, 2, 1, 3 }) {
+        resolver->request(pid);
+        ASSERT_TRUE(this->waitForResult(*resolver).has_value());
+    }
+    EXPECT_EQ(resolver->getLookupCount(), 3) << "1 was a cache hit";
+
+    // 2 was least recently used when 3 came in
+    resolver->request(1);
+    ASSERT_TRUE(this->waitForResult(*resolver)->cached);
+    resolver->request(2);
+    ASSERT_FALSE(this->waitForResult(*resolver)->cached);
+}
+
+TEST_F(ProcessNameResolverTest, LatestRequestWins) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> started = 0;
+    ProcessNameResolver resolver(16,
+        [&](unsigned long pid) -> std::optional<std::wstring> {
+            ++started;
+            if (pid == 1)
+                released.wait();
+            return pid == 1 ? L"Slow.exe" : L"Fast.exe";
+        },
+        [](unsigned long) -> std::optional<uint64_t> { return std::nullopt; });
+
+    // The lookup of 1 is in progress when 2 is requested, so its result is dropped
+    resolver.request(1);
+    for (int i = 0; i < 2000 && started == 0; ++i)
+        std::this_thread::sleep_for(1ms);
+    ASSERT_EQ(started, 1);
+    resolver.request(2);
+    EXPECT_EQ(resolver.takeResult(), std::nullopt) << "Requesting never waits on a lookup";
+    release.set_value();
+
+    auto result = this->waitForResult(resolver);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->pid, 2);
+    EXPECT_EQ(result->name, L"Fast.exe");
+}
@@ -0,0 +1,92 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include "FakeProcessWatcher.hpp"
+#include <ProcessWatch.hpp>
+
+#include <thread>
+
+using namespace testing;
+
+namespace {
+    constexpr StringPattern studio_matcher = StringPattern::compile("^(Massless)*\\s*Studio");
+
+    ProcessWatch makeWatch(FakeProcessWatcher*& fake)
+    {
+        auto watcher = std::make_unique<FakeProcessWatcher>();
+        fake = watcher.get();
+        return ProcessWatch(studio_matcher, std::move(watcher));
+    }
+}
+
+TEST(ProcessWatch, RunningWhileAnyMatchingProcessIsAlive) {
+    FakeProcessWatcher* fake;
+    ProcessWatch watch = makeWatch(fake);
+    ASSERT_FALSE(watch.update(std::chrono::milliseconds(0)));
+
+    fake->start(10, "explorer.exe");
+    ASSERT_FALSE(watch.update(std::chrono::milliseconds(0)));
+    fake->start(11, "MasslessStudio.exe");
+    fake->start(12, "Studio.exe");
+    ASSERT_TRUE(watch.update(std::chrono::milliseconds(0)));
+
+    fake->exit(11);
+    fake->exit(10);
+    ASSERT_TRUE(watch.update(std::chrono::milliseconds(0)));
+    fake->exit(12);
+    ASSERT_FALSE(watch.update(std::chrono::milliseconds(0)));
+}
+
+TEST(ProcessWatch, ReusedPidIsMatchedAgain) {
+    FakeProcessWatcher* fake;
+    ProcessWatch watch = makeWatch(fake);
+
+    fake->start(20, "MasslessStudio.exe");
+    ASSERT_TRUE(watch.update(std::chrono::milliseconds(0)));
+
+    // The exit was missed and the PID is now something else
+    fake->start(20, "notepad.exe");
+    ASSERT_FALSE(watch.update(std::chrono::milliseconds(0)));
+}
+
+TEST(ProcessWatch, RescanAfterLostEventsRebuildsMatches) {
+    FakeProcessWatcher* fake;
+    ProcessWatch watch = makeWatch(fake);
+
+    fake->start(30, "MasslessStudio.exe");
+    fake->start(31, "explorer.exe");
+    ASSERT_TRUE(watch.update(std::chrono::milliseconds(0)));
+
+    // The socket overflowed while Studio exited, so its exit is never reported
+    fake->rescan({ { 31, "explorer.exe" } });
+    ASSERT_FALSE(watch.update(std::chrono::milliseconds(0)));
+
+    // And while it started again, so is only seen in the rescan
+    fake->rescan({ { 31, "explorer.exe" }, { 32, "Massless Studio.exe" } });
+    ASSERT_TRUE(watch.update(std::chrono::milliseconds(0)));
+
+    // Events after the rescan apply as usual
+    fake->exit(32);
+    ASSERT_FALSE(watch.update(std::chrono::milliseconds(0)));
+}
+
+TEST(ProcessWatch, InterruptEndsUpdateEarly) {
+    FakeProcessWatcher* fake;
+    ProcessWatch watch = makeWatch(fake);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread interrupter([&watch]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        watch.interrupt();
+    });
+    watch.update(std::chrono::seconds(10));
+    interrupter.join();
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
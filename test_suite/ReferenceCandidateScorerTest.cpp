@@ -0,0 +1,126 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ReferenceCandidateScorer.hpp>
+
+#include <cmath>
+
+using namespace testing;
+using Candidate = ReferenceCandidateScorer::Candidate;
+
+namespace {
+    std::optional<ReferenceCandidateScorer::EigenPose> makePose(float x, float y, float z) {
+        return ReferenceCandidateScorer::EigenPose(Eigen::Quaternionf::Identity(), Eigen::Vector3f(x, y, z));
+    }
+}
+
+class ReferenceCandidateScorerTest : public Test {
+protected:
+    ReferenceCandidateScorer::Options options;
+};
+
+TEST_F(ReferenceCandidateScorerTest, NotReadyUntilWindowCompletes) {
+    ReferenceCandidateScorer scorer(this->options);
+    std::vector<vr::TrackedDeviceIndex_t> indices = { 3 };
+    std::vector<Candidate> candidates = { { 3, makePose(1, 2, 3), false } };
+
+    for (uint32_t frame = 1; frame < this->options.window; ++frame) {
+        scorer.update(std::nullopt, candidates);
+        ASSERT_FALSE(scorer.isReady(indices)) << "frame " << frame;
+    }
+    scorer.update(std::nullopt, candidates);
+    ASSERT_TRUE(scorer.isReady(indices));
+
+    auto score = scorer.getScore(3);
+    ASSERT_TRUE(score.has_value());
+    EXPECT_EQ(score->samples, this->options.window);
+    EXPECT_FLOAT_EQ(score->validity_rate, 1.0f);
+    EXPECT_FLOAT_EQ(score->jitter, 0.0f);
+    EXPECT_FLOAT_EQ(score->score, 1.0f);
+
+    scorer.clear();
+    EXPECT_FALSE(scorer.isReady(indices));
+}
+
+TEST_F(ReferenceCandidateScorerTest, StableAndValidReferencesRankFirst) {
+    ReferenceCandidateScorer scorer(this->options);
+    std::vector<Candidate> candidates(3);
+    for (uint32_t frame = 0; frame < this->options.window; ++frame) {
+        float wobble = (frame % 2 == 0) ? 0.002f : -0.002f;
+        candidates[0] = { 1, makePose(wobble, 0, 0), false };                           // Jitters by 2mm
+        candidates[1] = { 2, frame % 4 == 0 ? std::nullopt : makePose(1, 0, 0), false }; // Invalid a quarter of the time
+        candidates[2] = { 5, makePose(2, 0, 0), false };                                // Perfectly still
+        scorer.update(std::nullopt, candidates);
+    }
+
+    EXPECT_NEAR(scorer.getScore(2)->validity_rate, 0.75f, 0.02f);
+    EXPECT_GT(scorer.getScore(1)->jitter, 1e-6f);
+
+    std::vector<vr::TrackedDeviceIndex_t> indices = { 1, 2, 5 };
+    std::vector<vr::TrackedDeviceIndex_t> ranked;
+    scorer.rank(indices, ranked);
+    EXPECT_THAT(ranked, ElementsAre(5, 2, 1));
+}
+
+TEST_F(ReferenceCandidateScorerTest, EqualScoresKeepPriorityOrder) {
+    ReferenceCandidateScorer scorer(this->options);
+    std::vector<Candidate> candidates = { { 4, makePose(0, 0, 0), false }, { 7, makePose(1, 1, 1), false } };
+    for (uint32_t frame = 0; frame < this->options.window; ++frame)
+        scorer.update(std::nullopt, candidates);
+
+    std::vector<vr::TrackedDeviceIndex_t> ranked;
+    std::vector<vr::TrackedDeviceIndex_t> indices = { 7, 4 };
+    scorer.rank(indices, ranked);
+    EXPECT_THAT(ranked, ElementsAre(7, 4));
+    indices = { 4, 7 };
+    scorer.rank(indices, ranked);
+    EXPECT_THAT(ranked, ElementsAre(4, 7));
+}
+
+TEST_F(ReferenceCandidateScorerTest, ControllerMovingWithPenRanksFirst) {
+    ReferenceCandidateScorer scorer(this->options);
+    std::vector<Candidate> candidates(2);
+    float mounted_x = 0;
+    float other_x = 0;
+    float pen_x = 0;
+    for (uint32_t frame = 0; frame < this->options.window; ++frame) {
+        // The mounted controller moves in step with the pen, the other one moves to its own rhythm
+        float speed = 0.001f + 0.004f * std::abs(std::sin(frame * 0.3f));
+        mounted_x += speed;
+        pen_x += speed * 0.8f;
+        other_x += 0.001f + 0.004f * std::abs(std::cos(frame * 0.7f));
+        candidates[0] = { 8, makePose(other_x, 1, 0), true };
+        candidates[1] = { 9, makePose(mounted_x, 1, 0), true };
+        scorer.update(Eigen::Vector3f(pen_x, 0, 0), candidates);
+    }
+
+    auto mounted = scorer.getScore(9);
+    auto other = scorer.getScore(8);
+    ASSERT_TRUE(mounted->correlation.has_value());
+    EXPECT_NEAR(*mounted->correlation, 1.0f, 1e-3f);
+    EXPECT_LT(other->score, mounted->score);
+
+    std::vector<vr::TrackedDeviceIndex_t> indices = { 8, 9 };
+    std::vector<vr::TrackedDeviceIndex_t> ranked;
+    scorer.rank(indices, ranked);
+    EXPECT_THAT(ranked, ElementsAre(9, 8));
+}
+
+TEST_F(ReferenceCandidateScorerTest, ControllerWithoutPenMotionIsNeutral) {
+    ReferenceCandidateScorer scorer(this->options);
+    std::vector<Candidate> candidates = { { 2, makePose(0, 0, 0), true } };
+    for (uint32_t frame = 0; frame < this->options.window; ++frame)
+        scorer.update(std::nullopt, candidates);
+
+    auto score = scorer.getScore(2);
+    ASSERT_TRUE(score.has_value());
+    EXPECT_FALSE(score->correlation.has_value());
+    EXPECT_FLOAT_EQ(score->score, this->options.unknown_correlation_factor);
+}
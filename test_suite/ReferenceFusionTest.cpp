@@ -0,0 +1,151 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ReferenceFusion.hpp>
+
+using namespace testing;
+using SystemType = MasslessInterface::TrackingSystemType::SystemType;
+
+namespace {
+    ReferenceFusion::EigenPose makeReferencePose(float angle, const Eigen::Vector3f& axis, const Eigen::Vector3f& position) {
+        return { Eigen::Quaternionf(Eigen::AngleAxisf(angle, axis.normalized())), position };
+    }
+
+    DriverAnalytics::TrackingReferencePack makePack(SystemType type, const ReferenceFusion::EigenPose& global_pose) {
+        MasslessInterface::Pose offset(0.1f, -0.2f, 0.3f, 0.9238795f, 0.0f, 0.3826834f, 0.0f);
+        return DriverAnalytics::TrackingReferencePack(0, "LHB-PRIMARY", type, global_pose, offset);
+    }
+
+    Eigen::Vector3f toPosition(const vr::DriverPose_t& pose) {
+        return Eigen::Vector3f(static_cast<float>(pose.vecPosition[0]), static_cast<float>(pose.vecPosition[1]), static_cast<float>(pose.vecPosition[2]));
+    }
+
+    Eigen::Quaternionf toRotation(const vr::DriverPose_t& pose) {
+        return Eigen::Quaternionf(static_cast<float>(pose.qRotation.w), static_cast<float>(pose.qRotation.x), static_cast<float>(pose.qRotation.y), static_cast<float>(pose.qRotation.z));
+    }
+}
+
+class ReferenceFusionTest : public Test {
+protected:
+    // Enrols two secondaries with the primary, then returns the references to update with
+    std::vector<ReferenceFusion::Reference> enrolSecondaries(ReferenceFusion& fusion) {
+        std::vector<ReferenceFusion::Reference> secondaries = {
+            { 1, "LHB-SECOND", makeReferencePose(1.2f, Eigen::Vector3f(0, 1, 0), Eigen::Vector3f(-2, 2, 1)) },
+            { 2, "LHB-THIRD", makeReferencePose(-0.7f, Eigen::Vector3f(1, 1, 0), Eigen::Vector3f(1, 2.5f, -3)) }
+        };
+        fusion.update(this->primary, secondaries);
+        return secondaries;
+    }
+
+    DriverAnalytics::TrackingReferencePack primary = makePack(SystemType::VIVE_BASESTATION_V2, makeReferencePose(0.4f, Eigen::Vector3f(1, 2, 3), Eigen::Vector3f(2, 2, 2)));
+    MasslessInterface::Pose pen_pose = MasslessInterface::Pose(0.05f, 0.1f, 0.6f, 0.8660254f, 0.5f, 0.0f, 0.0f);
+};
+
+TEST_F(ReferenceFusionTest, CompositeMatchesMakeOpenVRPose) {
+    for (auto type : { SystemType::VIVE_BASESTATION_V2, SystemType::VIVE_TRACKER, SystemType::OCULUS_SENSOR }) {
+        auto pack = makePack(type, this->primary.global_pose);
+        vr::DriverPose_t expected = PenController::makeOpenVRPose(this->pen_pose, pack.pose_offset, pack.global_pose, pack.type);
+        auto received = ReferenceFusion::applyCompositeTransform(ReferenceFusion::makeCompositeTransform(pack), this->pen_pose);
+
+        EXPECT_TRUE(received.second.isApprox(toPosition(expected), 1e-4f)) << pack.type.getStringValue();
+        EXPECT_NEAR(std::abs(received.first.dot(toRotation(expected))), 1.0f, 1e-4f) << pack.type.getStringValue();
+    }
+}
+
+TEST_F(ReferenceFusionTest, StillReferencesAgreeWithPrimary) {
+    ReferenceFusion fusion;
+    this->enrolSecondaries(fusion);
+    ASSERT_EQ(fusion.getSlots().size(), 3);
+
+    auto expected = ReferenceFusion::applyCompositeTransform(ReferenceFusion::makeCompositeTransform(this->primary), this->pen_pose);
+    auto received = fusion.fuse(this->pen_pose);
+    ASSERT_TRUE(received.has_value());
+    EXPECT_TRUE(received->second.isApprox(expected.second, 1e-4f));
+    EXPECT_NEAR(std::abs(received->first.dot(expected.first)), 1.0f, 1e-4f);
+    for (const auto& slot : fusion.getSlots())
+        EXPECT_FALSE(slot.rejected) << slot.device_serial;
+}
+
+TEST_F(ReferenceFusionTest, BumpedReferenceIsRejected) {
+    ReferenceFusion fusion;
+    auto secondaries = this->enrolSecondaries(fusion);
+    auto expected = fusion.fuse(this->pen_pose);
+
+    // Knock the primary 20cm, the pen should stay where the other two see it
+    this->primary.global_pose.second += Eigen::Vector3f(0.2f, 0, 0);
+    fusion.update(this->primary, secondaries);
+    auto received = fusion.fuse(this->pen_pose);
+
+    ASSERT_TRUE(received.has_value());
+    EXPECT_TRUE(fusion.getSlots()[0].rejected);
+    EXPECT_EQ(fusion.getSlots()[0].weight, 0);
+    EXPECT_TRUE(received->second.isApprox(expected->second, 1e-4f));
+}
+
+TEST_F(ReferenceFusionTest, NoisyReferenceGetsLessWeight) {
+    ReferenceFusion fusion;
+    auto secondaries = this->enrolSecondaries(fusion);
+
+    // Wobble the second reference by a millimeter each frame, small enough to not be an outlier
+    for (int frame = 0; frame < 20; ++frame) {
+        secondaries[0].global_pose.second.x() += (frame % 2 == 0) ? 0.001f : -0.001f;
+        fusion.update(this->primary, secondaries);
+        fusion.fuse(this->pen_pose);
+    }
+
+    auto slots = fusion.getSlots();
+    EXPECT_FALSE(slots[1].rejected);
+    EXPECT_LT(slots[1].weight, slots[0].weight);
+    EXPECT_LT(slots[1].weight, slots[2].weight);
+    EXPECT_NEAR(slots[0].weight + slots[1].weight + slots[2].weight, 1.0f, 1e-4f);
+}
+
+TEST_F(ReferenceFusionTest, CompositesOnlyRebuiltWhenReferencesMove) {
+    ReferenceFusion fusion;
+    auto secondaries = this->enrolSecondaries(fusion);
+    auto updates = fusion.getCompositeUpdateCount();
+
+    for (int frame = 0; frame < 100; ++frame) {
+        fusion.update(this->primary, secondaries);
+        fusion.fuse(this->pen_pose);
+    }
+    EXPECT_EQ(fusion.getCompositeUpdateCount(), updates);
+
+    secondaries[1].global_pose.second.y() += 0.001f;
+    fusion.update(this->primary, secondaries);
+    EXPECT_EQ(fusion.getCompositeUpdateCount(), updates + 1);
+}
+
+TEST_F(ReferenceFusionTest, ReferencesAreCappedAndDropped) {
+    ReferenceFusion fusion;
+    std::vector<ReferenceFusion::Reference> secondaries;
+    for (vr::TrackedDeviceIndex_t index = 1; index <= 6; ++index)
+        secondaries.push_back({ index, "LHB-" + std::to_string(index), makeReferencePose(0.1f * index, Eigen::Vector3f(0, 1, 0), Eigen::Vector3f(static_cast<float>(index), 2, 0)) });
+
+    fusion.update(this->primary, secondaries);
+    ASSERT_EQ(fusion.getSlots().size(), ReferenceFusion::m_maxReferences);
+    EXPECT_EQ(fusion.getSlots()[0].device_serial, this->primary.device_serial);
+
+    // References that are no longer visible are dropped, the primary is always kept
+    fusion.update(this->primary, Span<const ReferenceFusion::Reference>());
+    ASSERT_EQ(fusion.getSlots().size(), 1);
+    EXPECT_EQ(fusion.getSlots()[0].device_serial, this->primary.device_serial);
+
+    fusion.clear();
+    EXPECT_EQ(fusion.fuse(this->pen_pose), std::nullopt);
+}
+
+TEST_F(ReferenceFusionTest, OnlyStaticReferencesAreFusable) {
+    EXPECT_TRUE(ReferenceFusion::isFusable(SystemType::VIVE_BASESTATION_V1));
+    EXPECT_TRUE(ReferenceFusion::isFusable(SystemType::VIVE_BASESTATION_V2));
+    EXPECT_TRUE(ReferenceFusion::isFusable(SystemType::OCULUS_SENSOR));
+    EXPECT_FALSE(ReferenceFusion::isFusable(SystemType::VIVE_TRACKER));
+    EXPECT_FALSE(ReferenceFusion::isFusable(SystemType::OCULUS_RIFT_S_TOUCH_LEFT));
+}
@@ -0,0 +1,121 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ReferenceHealthMonitor.hpp>
+
+using namespace testing;
+using namespace std::chrono_literals;
+using Verdict = ReferenceHealthMonitor::Verdict;
+
+namespace {
+    ReferenceHealthMonitor::EigenPose makePose(float x, float y, float z, float yaw = 0) {
+        return { Eigen::Quaternionf(Eigen::AngleAxisf(yaw, Eigen::Vector3f::UnitY())), Eigen::Vector3f(x, y, z) };
+    }
+}
+
+class ReferenceHealthMonitorTest : public Test {
+protected:
+    ReferenceHealthMonitor makeMonitor() {
+        ReferenceHealthMonitor monitor(this->options, [this]() { return this->now; });
+        monitor.reset(makePose(1, 2, 3));
+        return monitor;
+    }
+
+    // One frame at 90Hz
+    void tick() {
+        this->now += 11ms;
+    }
+
+    ReferenceHealthMonitor::Options options;
+    ReferenceHealthMonitor::Clock::time_point now{};
+};
+
+TEST_F(ReferenceHealthMonitorTest, AcceptsSmallNoise) {
+    auto monitor = this->makeMonitor();
+    for (int frame = 0; frame < 100; ++frame) {
+        this->tick();
+        float noise = (frame % 2 == 0) ? 0.0005f : -0.0005f;
+        ASSERT_EQ(monitor.observe(makePose(1 + noise, 2, 3)), Verdict::Accept) << "frame " << frame;
+    }
+    EXPECT_EQ(monitor.getMetrics().accepted, 100);
+    EXPECT_EQ(monitor.getMetrics().discontinuities, 0);
+}
+
+TEST_F(ReferenceHealthMonitorTest, HoldsThroughTransient) {
+    auto monitor = this->makeMonitor();
+    this->tick();
+    ASSERT_EQ(monitor.observe(makePose(1.1f, 2, 3)), Verdict::Hold);
+    EXPECT_TRUE(monitor.isHolding());
+    EXPECT_TRUE(monitor.getLastGoodPose().second.isApprox(Eigen::Vector3f(1, 2, 3)));
+
+    this->tick();
+    ASSERT_EQ(monitor.observe(makePose(1.2f, 2, 3)), Verdict::Hold);
+    this->tick();
+    ASSERT_EQ(monitor.observe(makePose(1, 2, 3)), Verdict::Accept);
+    EXPECT_FALSE(monitor.isHolding());
+
+    const auto& metrics = monitor.getMetrics();
+    EXPECT_EQ(metrics.discontinuities, 1);
+    EXPECT_EQ(metrics.transients, 1);
+    EXPECT_EQ(metrics.held, 2);
+    EXPECT_EQ(metrics.moves, 0);
+}
+
+TEST_F(ReferenceHealthMonitorTest, RotationJumpIsADiscontinuity) {
+    auto monitor = this->makeMonitor();
+    this->tick();
+    EXPECT_EQ(monitor.observe(makePose(1, 2, 3, 0.1f)), Verdict::Hold);
+}
+
+TEST_F(ReferenceHealthMonitorTest, ReportsMoveOnceSettled) {
+    auto monitor = this->makeMonitor();
+    this->tick();
+    ASSERT_EQ(monitor.observe(makePose(1.3f, 2, 3)), Verdict::Hold);
+
+    auto bumped = this->now;
+    Verdict verdict = Verdict::Hold;
+    while (verdict == Verdict::Hold) {
+        this->tick();
+        verdict = monitor.observe(makePose(1.3f, 2, 3));
+    }
+    EXPECT_EQ(verdict, Verdict::Moved);
+    EXPECT_GE(this->now - bumped, this->options.settle_period);
+    EXPECT_LT(this->now - bumped, this->options.settle_period + 11ms);
+    EXPECT_EQ(monitor.getMetrics().moves, 1);
+}
+
+TEST_F(ReferenceHealthMonitorTest, ReportsMoveWhenJumpingForTooLong) {
+    auto monitor = this->makeMonitor();
+    auto start = this->now;
+    Verdict verdict = Verdict::Hold;
+    for (int frame = 0; verdict == Verdict::Hold; ++frame) {
+        this->tick();
+        // Never settles: alternates between two far apart poses
+        verdict = monitor.observe(makePose(frame % 2 == 0 ? 1.5f : 1.8f, 2, 3));
+    }
+    EXPECT_EQ(verdict, Verdict::Moved);
+    EXPECT_GE(this->now - start, this->options.hold_timeout);
+}
+
+TEST_F(ReferenceHealthMonitorTest, DetectsSlowDrift) {
+    auto monitor = this->makeMonitor();
+    // 1mm per frame never trips the jump check, but wanders off in the end
+    Verdict verdict = Verdict::Accept;
+    int frames = 0;
+    while (verdict == Verdict::Accept && frames < 1000) {
+        this->tick();
+        ++frames;
+        verdict = monitor.observe(makePose(1 + 0.001f * frames, 2, 3));
+    }
+    EXPECT_EQ(verdict, Verdict::Moved);
+    EXPECT_EQ(monitor.getMetrics().drifts, 1);
+    EXPECT_EQ(monitor.getMetrics().discontinuities, 0);
+    EXPECT_GT(frames, 20);
+}
@@ -0,0 +1,93 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <ReferencePoseHistory.hpp>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr float pi = 3.1415926f;
+
+    ReferencePoseHistory::EigenPose makePose(float x, float yaw) {
+        return { Eigen::Quaternionf(Eigen::AngleAxisf(yaw, Eigen::Vector3f::UnitY())), Eigen::Vector3f(x, 0, 0) };
+    }
+}
+
+class ReferencePoseHistoryTest : public Test {
+protected:
+    // A reference moving at 1m/s and turning at 1 rad/s, sampled every 10ms
+    void fill(ReferencePoseHistory& history, int samples) {
+        for (int i = 0; i < samples; ++i)
+            history.push(this->start + i * 10ms, makePose(0.01f * i, 0.01f * i));
+    }
+
+    ReferencePoseHistory::Clock::time_point start = ReferencePoseHistory::Clock::time_point(1000s);
+};
+
+TEST_F(ReferencePoseHistoryTest, InterpolatesBetweenSamples) {
+    ReferencePoseHistory history;
+    this->fill(history, 10);
+
+    auto pose = history.sample(this->start + 45ms);
+    ASSERT_TRUE(pose.has_value());
+    EXPECT_NEAR(pose->second.x(), 0.045f, 1e-5f);
+    EXPECT_NEAR(pose->first.angularDistance(makePose(0, 0.045f).first), 0.0f, 1e-4f);
+
+    // Exactly on a sample
+    pose = history.sample(this->start + 30ms);
+    EXPECT_NEAR(pose->second.x(), 0.03f, 1e-5f);
+    EXPECT_EQ(history.getMetrics().interpolated, 2);
+}
+
+TEST_F(ReferencePoseHistoryTest, ExtrapolatesAFewMillisecondsAhead) {
+    ReferencePoseHistory history;
+    this->fill(history, 10);
+
+    auto pose = history.sample(this->start + 95ms);
+    ASSERT_TRUE(pose.has_value());
+    EXPECT_NEAR(pose->second.x(), 0.095f, 1e-5f);
+    EXPECT_NEAR(pose->first.angularDistance(makePose(0, 0.095f).first), 0.0f, 1e-4f);
+
+    // Prediction is clamped to max_extrapolation
+    pose = history.sample(this->start + 90ms + 1s);
+    EXPECT_NEAR(pose->second.x(), 0.09f + 0.02f, 1e-5f);
+    EXPECT_EQ(history.getMetrics().extrapolated, 2);
+}
+
+TEST_F(ReferencePoseHistoryTest, TooOldIsNotAligned) {
+    ReferencePoseHistory history;
+    EXPECT_EQ(history.sample(this->start), std::nullopt) << "Empty history";
+
+    this->fill(history, 40);
+    ASSERT_EQ(history.size(), ReferencePoseHistory::m_capacity);
+    EXPECT_EQ(history.sample(this->start), std::nullopt) << "A pen timestamp this far back is probably on another clock";
+    EXPECT_EQ(history.getMetrics().out_of_range, 1);
+    EXPECT_TRUE(history.sample(this->start + 300ms).has_value());
+}
+
+TEST_F(ReferencePoseHistoryTest, IgnoresOutOfOrderSamples) {
+    ReferencePoseHistory history;
+    history.push(this->start + 10ms, makePose(1, 0));
+    history.push(this->start + 10ms, makePose(2, 0));
+    history.push(this->start, makePose(3, 0));
+    EXPECT_EQ(history.size(), 1);
+    EXPECT_NEAR(history.sample(this->start + 10ms)->second.x(), 1.0f, 1e-6f);
+
+    history.clear();
+    EXPECT_EQ(history.size(), 0);
+}
+
+TEST_F(ReferencePoseHistoryTest, InterpolationTakesShortestRotation) {
+    auto from = makePose(0, pi - 0.1f);
+    auto to = makePose(0, -pi + 0.1f);
+    auto middle = ReferencePoseHistory::interpolate(from, to, 0.5f);
+    EXPECT_NEAR(middle.first.angularDistance(makePose(0, pi).first), 0.0f, 1e-4f);
+}
@@ -45,3 +45,43 @@ TEST(ServerDriverTest, TryAddDevice) {
     // Expect to have failed
     EXPECT_EQ(server_driver.tryAddDevice(std::move(controller), controllername, vr::ETrackedDeviceClass::TrackedDeviceClass_Controller, &host), false);
 }
+
+TEST(ServerDriverTest, UnknownDebugRequestListsOnlyServedCommands) {
+    ServerDriver server_driver(std::make_shared<NiceMock<MockPenSystem>>());
+    auto request = [&](const char* command, Span<const char* const> device_commands) {
+        char buffer[1024];
+        DebugResponseWriter writer(buffer, sizeof(buffer));
+        server_driver.handleDebugRequest(command, "", writer, device_commands);
+        writer.finish();
+        return nlohmann::json::parse(buffer);
+    };
+
+    // Without a device in front, the pen's requests are not served so must not be offered
+    auto response = request("stats", {});
+    ASSERT_EQ(response["error"].get<std::string>(), "unknown_request");
+    auto commands = response["commands"].get<std::vector<std::string>>();
+    EXPECT_THAT(commands, Not(Contains("stats")));
+    EXPECT_THAT(commands, Contains("tracking_reference"));
+
+    std::array<const char*, 1> device_commands = { "stats" };
+    response = request("not_a_command", device_commands);
+    EXPECT_THAT(response["commands"].get<std::vector<std::string>>(), Contains("stats"));
+}
+
+TEST(ServerDriverTest, DebugRequestsAreAnsweredBeforeAnyFrame) {
+    ServerDriver server_driver(std::make_shared<NiceMock<MockPenSystem>>());
+    auto request = [&](const char* command) {
+        char buffer[4096];
+        DebugResponseWriter writer(buffer, sizeof(buffer));
+        server_driver.handleDebugRequest(command, "", writer);
+        writer.finish();
+        return nlohmann::json::parse(buffer);
+    };
+
+    // Answered straight away from the state published so far, rather than waiting for a frame that may never run
+    auto response = request("tracking_reference");
+    EXPECT_FALSE(response["found"].get<bool>());
+    EXPECT_EQ(response["search_state"].get<std::string>(), TrackingReferenceSearch::getStateName(TrackingReferenceSearch::State::Idle));
+    EXPECT_EQ(request("settings")["error"].get<std::string>(), "settings_unavailable");
+    EXPECT_EQ(request("timings")["server_driver"]["run_frame_count"].get<uint64_t>(), 0);
+}
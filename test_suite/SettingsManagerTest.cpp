@@ -9,7 +9,38 @@
 
 #include "Testing.hpp"
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+
 using namespace testing;
+using namespace std::chrono_literals;
+
+namespace {
+    // Counts writes rather than storing them anywhere
+    class CountingSettingsLoader : public IDriverSettingsLoader {
+    public:
+        CountingSettingsLoader(std::atomic<int>& writes) : m_writes(writes) {}
+        DriverSettings readSettings() override { return DriverSettings::make_default(); }
+        void writeSettings(DriverSettings settings) override { ++this->m_writes; this->m_lastWritten = settings; }
+        DriverSettings m_lastWritten;
+    private:
+        std::atomic<int>& m_writes;
+    };
+
+    // Keeps the settings in place of a file, which the test can edit as a user would
+    class InMemorySettingsLoader : public IDriverSettingsLoader {
+    public:
+        DriverSettings readSettings() override { std::lock_guard<std::mutex> lock(this->m_mutex); return this->m_file; }
+        void writeSettings(DriverSettings settings) override { std::lock_guard<std::mutex> lock(this->m_mutex); this->m_file = settings; }
+
+        void edit(const std::function<void(DriverSettings&)>& change) { std::lock_guard<std::mutex> lock(this->m_mutex); change(this->m_file); }
+
+    private:
+        std::mutex m_mutex;
+        DriverSettings m_file = DriverSettings::make_default();
+    };
+}
 
 TEST(SettingsManager, ConstructorLoadsSettings) {
     SettingsManager settingsManager(std::make_unique<FileSettingsLoader>(std::make_unique<std::istringstream>("{}"), std::make_unique<std::ostringstream>()));
@@ -35,4 +66,74 @@ TEST(SettingsManager, DestructorSavesSettings) {
     }
     // Remove working file
     std::filesystem::remove(working_path);
-}
\ No newline at end of file
+}
+TEST(SettingsManager, StoreSettingsWritesInBackground) {
+    std::atomic<int> writes = 0;
+    auto loader = std::make_unique<CountingSettingsLoader>(writes);
+    CountingSettingsLoader* loader_ptr = loader.get();
+    SettingsManager settingsManager(std::move(loader), 1h);
+
+    for (const char* serial : { "first", "second", "third" }) {
+        settingsManager.getSettings().setValue<std::string>(DriverSettings::AutoTrackingRefSerial, serial);
+        settingsManager.storeSettings();
+    }
+    EXPECT_EQ(writes, 0) << "storeSettings should not write on the calling thread";
+
+    settingsManager.flush();
+    EXPECT_EQ(writes, 1);
+    EXPECT_EQ(loader_ptr->m_lastWritten.getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value(), "third");
+}
+
+TEST(SettingsManager, PendingStoreKeepsEditsSavedMeanwhile) {
+    auto loader = std::make_unique<InMemorySettingsLoader>();
+    InMemorySettingsLoader* file = loader.get();
+    SettingsManager settingsManager(std::move(loader), 1h);
+
+    settingsManager.getSettings().setValue<std::string>(DriverSettings::AutoTrackingRefSerial, "locked");
+    settingsManager.storeSettings();
+
+    // Saved by the user while the store was waiting to be written
+    file->edit([](DriverSettings& settings) { settings.setValue<std::string>(DriverSettings::Handedness, "left"); });
+    settingsManager.flush();
+
+    DriverSettings written = file->readSettings();
+    EXPECT_EQ(written.getValue<std::string>(DriverSettings::Handedness).value(), "left");
+    EXPECT_EQ(written.getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value(), "locked");
+
+    // So reloading the file applies the edit rather than undoing it
+    ASSERT_TRUE(settingsManager.prepareReload(*file));
+    EXPECT_THAT(settingsManager.applyReload(), ElementsAre(DriverSettings::Handedness));
+    EXPECT_EQ(settingsManager.getSettings().getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value(), "locked");
+}
+
+TEST(SettingsManager, ReloadIsAppliedByTheFrameThread) {
+    SettingsManager settingsManager(std::make_unique<FileSettingsLoader>(std::make_unique<std::istringstream>("{}"), std::make_unique<std::ostringstream>()));
+    settingsManager.getSettings().setValue<std::string>(DriverSettings::AutoTrackingRefSerial, "locked_since_the_file_was_written");
+    EXPECT_TRUE(settingsManager.applyReload().empty());
+
+    FileSettingsLoader edited(std::make_unique<std::istringstream>(R"({"pen_handedness": "left", "enable_detailed_logging": true})"), std::make_unique<std::ostringstream>());
+    ASSERT_TRUE(settingsManager.prepareReload(edited));
+    EXPECT_EQ(settingsManager.getSettings().getValue<std::string>(DriverSettings::Handedness).value(), "right");
+
+    EXPECT_THAT(settingsManager.applyReload(), ElementsAre(DriverSettings::Handedness, DriverSettings::EnableDetailedLogging));
+    EXPECT_EQ(settingsManager.getSettings().getValue<std::string>(DriverSettings::Handedness).value(), "left");
+    EXPECT_TRUE(settingsManager.getSettings().getValue<bool>(DriverSettings::EnableDetailedLogging).value());
+    EXPECT_EQ(settingsManager.getSettings().getValue<std::string>(DriverSettings::AutoTrackingRefSerial).value(), "locked_since_the_file_was_written");
+    EXPECT_EQ(settingsManager.getReloadCount(), 1u);
+
+    // Only applied once
+    EXPECT_TRUE(settingsManager.applyReload().empty());
+}
+
+TEST(SettingsManager, InvalidReloadKeepsTheCurrentSettings) {
+    SettingsManager settingsManager(std::make_unique<FileSettingsLoader>(std::make_unique<std::istringstream>("{}"), std::make_unique<std::ostringstream>()));
+
+    FileSettingsLoader half_saved(std::make_unique<std::istringstream>(R"({"pen_handedness": )"), std::make_unique<std::ostringstream>());
+    EXPECT_FALSE(settingsManager.prepareReload(half_saved));
+    FileSettingsLoader wrong_type(std::make_unique<std::istringstream>(R"({"pen_handedness": "left", "attach_gizmo": "yes"})"), std::make_unique<std::ostringstream>());
+    EXPECT_FALSE(settingsManager.prepareReload(wrong_type));
+
+    EXPECT_TRUE(settingsManager.applyReload().empty());
+    EXPECT_EQ(settingsManager.getSettings(), DriverSettings::make_default());
+    EXPECT_EQ(settingsManager.getReloadCount(), 0u);
+}
@@ -44,4 +44,12 @@ TEST(SettingsUtilitiesTest, IntegrationKeysMatchToCorrectExeName) {
     EXPECT_TRUE(home_key.has_value());
     EXPECT_THAT(*home_key, ElementsAreArray(asIK(M_INTEGRATION_OPENVR_STEAMVRHOME)));
 
-}
\ No newline at end of file
+}
+TEST(SettingsUtilitiesTest, ParseIntegrationKeyReadsHexAndUUIDs) {
+    std::array<uint8_t, SettingsUtilities::m_integrationKeyLen> expected{ 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+    EXPECT_THAT(SettingsUtilities::parseIntegrationKey("0123456789ABCDEF0123456789abcdef"), ElementsAreArray(expected));
+    EXPECT_THAT(SettingsUtilities::parseIntegrationKey("{01234567-89AB-CDEF-0123-456789ABCDEF}"), ElementsAreArray(expected));
+
+    EXPECT_THROW(SettingsUtilities::parseIntegrationKey("0123456789ABCDEF"), std::invalid_argument);
+    EXPECT_THROW(SettingsUtilities::parseIntegrationKey("0123456789ABCDEF0123456789ABCDEX"), std::invalid_argument);
+}
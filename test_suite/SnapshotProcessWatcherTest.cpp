@@ -0,0 +1,136 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <SnapshotProcessWatcher.hpp>
+#include <ProcessWatch.hpp>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace testing;
+
+namespace {
+    struct FakeProcesses {
+        std::map<unsigned long, std::string> running;
+        std::vector<unsigned long> named;
+
+        SnapshotProcessWatcher::Source source()
+        {
+            SnapshotProcessWatcher::Source source;
+            source.name = "fake";
+            source.list_pids = [this](std::vector<unsigned long>& pids) {
+                for (const auto& [pid, name] : this->running)
+                    pids.push_back(pid);
+                return true;
+            };
+            source.get_name = [this](unsigned long pid) -> std::optional<std::string> {
+                this->named.push_back(pid);
+                auto found = this->running.find(pid);
+                if (found == this->running.end())
+                    return std::nullopt;
+                return found->second;
+            };
+            return source;
+        }
+    };
+
+    std::set<std::pair<unsigned long, bool>> summarise(const std::vector<IProcessWatcher::Event>& events)
+    {
+        std::set<std::pair<unsigned long, bool>> out;
+        for (const auto& event : events)
+            out.insert({ event.pid, event.type == IProcessWatcher::Event::Type::Started });
+        return out;
+    }
+}
+
+TEST(SnapshotProcessWatcher, FirstScanReportsEverythingRunning) {
+    FakeProcesses processes;
+    processes.running = { { 4, "System" }, { 100, "explorer.exe" } };
+    SnapshotProcessWatcher watcher(processes.source());
+
+    auto events = watcher.waitForEvents(std::chrono::seconds(10));
+    ASSERT_EQ(events.size(), 2u);
+    ASSERT_EQ(events[1].name, "explorer.exe");
+    ASSERT_EQ(summarise(events), (std::set<std::pair<unsigned long, bool>>{ { 4, true }, { 100, true } }));
+}
+
+TEST(SnapshotProcessWatcher, OnlyNamesNewProcesses) {
+    FakeProcesses processes;
+    processes.running = { { 4, "System" }, { 100, "explorer.exe" } };
+    SnapshotProcessWatcher watcher(processes.source());
+    watcher.scan();
+    processes.named.clear();
+
+    ASSERT_TRUE(watcher.scan().empty());
+    ASSERT_TRUE(processes.named.empty());
+
+    processes.running.erase(100);
+    processes.running[200] = "MasslessStudio.exe";
+    auto events = watcher.scan();
+    ASSERT_EQ(summarise(events), (std::set<std::pair<unsigned long, bool>>{ { 100, false }, { 200, true } }));
+    ASSERT_EQ(processes.named, std::vector<unsigned long>{ 200 });
+
+    auto metrics = watcher.getMetrics();
+    ASSERT_EQ(metrics.scans.count, 3u);
+    ASSERT_EQ(metrics.started, 3u);
+    ASSERT_EQ(metrics.exited, 1u);
+}
+
+TEST(SnapshotProcessWatcher, InterruptEndsWaitEarly) {
+    FakeProcesses processes;
+    SnapshotProcessWatcher watcher(processes.source());
+    watcher.waitForEvents(std::chrono::milliseconds(0));
+
+    watcher.interrupt();
+    auto start = std::chrono::steady_clock::now();
+    watcher.waitForEvents(std::chrono::seconds(10));
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+#ifdef __linux__
+TEST(SnapshotProcessWatcher, PlatformWatcherSeesChildStartAndExit) {
+    auto watcher = ProcessWatch::createPlatformWatcher();
+    watcher->waitForEvents(std::chrono::milliseconds(0));
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        execl("/bin/sleep", "sleep", "30", static_cast<char*>(nullptr));
+        _exit(1);
+    }
+
+    auto waitFor = [&watcher](unsigned long pid, IProcessWatcher::Event::Type type) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            auto events = watcher->waitForEvents(std::chrono::milliseconds(20));
+            if (std::any_of(events.begin(), events.end(), [&](const auto& event) { return event.pid == pid && event.type == type; }))
+                return true;
+        }
+        return false;
+    };
+    bool started = waitFor(static_cast<unsigned long>(child), IProcessWatcher::Event::Type::Started);
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    ASSERT_TRUE(started) << watcher->getBackendName();
+    ASSERT_TRUE(waitFor(static_cast<unsigned long>(child), IProcessWatcher::Event::Type::Exited)) << watcher->getBackendName();
+
+    auto metrics = watcher->getMetrics();
+    RecordProperty("backend", watcher->getBackendName());
+    RecordProperty("scan_mean_us", static_cast<int>(metrics.scans.meanMicroseconds()));
+    ASSERT_GE(metrics.exited, 1u);
+}
+#endif
@@ -0,0 +1,41 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <Span.hpp>
+
+using namespace testing;
+
+TEST(Span, DefaultIsEmpty) {
+    Span<const int> span;
+    ASSERT_TRUE(span.empty());
+    ASSERT_EQ(span.size(), 0);
+    ASSERT_EQ(span.begin(), span.end());
+}
+
+TEST(Span, ViewsVectorWithoutCopying) {
+    std::vector<int> values = { 1, 2, 3 };
+    Span<const int> span = values;
+    ASSERT_EQ(span.size(), 3);
+    ASSERT_EQ(span.data(), values.data());
+    ASSERT_EQ(span[2], 3);
+
+    int sum = 0;
+    for (int value : span)
+        sum += value;
+    ASSERT_EQ(sum, 6);
+}
+
+TEST(Span, EventSpanViewsEvents) {
+    std::vector<vr::VREvent_t> events(2);
+    events[1].eventType = vr::VREvent_Input_HapticVibration;
+    EventSpan span = events;
+    ASSERT_EQ(span.size(), 2);
+    ASSERT_EQ(span[1].eventType, vr::VREvent_Input_HapticVibration);
+}
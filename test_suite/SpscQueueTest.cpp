@@ -0,0 +1,50 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <SpscQueue.hpp>
+
+#include <thread>
+
+using namespace testing;
+
+TEST(SpscQueueTest, PopsInOrderAndRejectsWhenFull) {
+    SpscQueue<int> queue(3);
+    EXPECT_EQ(queue.capacity(), 4);
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(queue.tryPush(i));
+    EXPECT_FALSE(queue.tryPush(4));
+
+    EXPECT_EQ(queue.tryPop(), 0);
+    EXPECT_TRUE(queue.tryPush(4));
+    for (int i = 1; i < 5; ++i)
+        EXPECT_EQ(queue.tryPop(), i);
+    EXPECT_EQ(queue.tryPop(), std::nullopt);
+}
+
+TEST(SpscQueueTest, PassesEveryItemBetweenThreads) {
+    SpscQueue<uint64_t> queue(64);
+    constexpr uint64_t count = 100000;
+
+    std::thread producer([&queue]() {
+        for (uint64_t i = 0; i < count; ++i) {
+            while (!queue.tryPush(i))
+                std::this_thread::yield();
+        }
+    });
+    uint64_t expected = 0;
+    while (expected < count) {
+        if (auto item = queue.tryPop(); item.has_value()) {
+            ASSERT_EQ(*item, expected);
+            ++expected;
+        }
+    }
+    producer.join();
+}
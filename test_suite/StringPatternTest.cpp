@@ -0,0 +1,139 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <StringPattern.hpp>
+
+#include <chrono>
+#include <regex>
+
+using namespace testing;
+
+namespace {
+    // The patterns previously matched with std::regex
+    const std::vector<const char*> patterns = {
+        "HTC V2-XD/XE",
+        "Valve SR Imp",
+        "VIVE Tracker Pro MV",
+        "Oculus Rift CV1 \\(Camera\\d+\\)",
+        "Oculus Rift S \\((Right) Controller\\)",
+        "Oculus Rift S \\((Left) Controller\\)",
+        "Oculus Quest \\((Right) Controller\\)",
+        "Oculus Quest \\((Left) Controller\\)",
+        "\\{htc\\}vr_tracker_vive_1_0",
+        "steamtours",
+        "tiltbrush",
+        "SculptrVR-Win64-Shipping",
+        "^(Massless)*\\s*Studio"
+    };
+
+    const std::vector<std::string> inputs = {
+        "", "HTC V2-XD/XE", "htc v2-xd/xe", "HTC V2-XD/X", "Valve SR Imp", "VALVE SR IMP 2", "VIVE Tracker Pro MV", "Vive Tracker",
+        "Oculus Rift CV1 (Camera0)", "Oculus Rift CV1 (Camera12)", "oculus rift cv1 (camera)", "Oculus Rift CV1 (Camera1a)",
+        "Oculus Rift S (Right Controller)", "Oculus Rift S (Left Controller)", "oculus rift s (left controller) v2", "Oculus Rift S (Right) Controller",
+        "Oculus Quest (Right Controller)", "Oculus Quest (Left Controller)", "Oculus Quest2 (Left Controller)",
+        "{htc}vr_tracker_vive_1_0", "{HTC}VR_TRACKER_VIVE_1_0", "htc vr_tracker_vive_1_0",
+        "steamtours.exe", "SteamTours.exe", "TiltBrush.exe", "tilt_brush.exe", "SculptrVR-Win64-Shipping.exe", "SculptrVR.exe",
+        "Studio.exe", "MasslessStudio.exe", "Massless Studio.exe", "MasslessMassless  Studio.exe", "massless\tstudio", "Massless_Studio.exe",
+        "NotMasslessStudio.exe", " Studio.exe", "Masslesss Studio.exe"
+    };
+}
+
+TEST(StringPatternTest, MatchesStdRegex) {
+    for (const char* pattern : patterns) {
+        std::regex regex(pattern, std::regex_constants::ECMAScript | std::regex_constants::icase);
+        StringPattern compiled = StringPattern::compile(pattern);
+        for (const auto& input : inputs) {
+            EXPECT_EQ(compiled.search(input), std::regex_search(input, regex)) << "pattern: " << pattern << ", input: " << input;
+        }
+    }
+}
+
+TEST(StringPatternTest, CompilesAtCompileTime) {
+    constexpr StringPattern camera = StringPattern::compile("Oculus Rift CV1 \\(Camera\\d+\\)");
+    static_assert(camera.getTokenCount() == 5, "Literal, (, Camera, digits, )");
+    static_assert(camera.getMinLength() == 25, "Shortest match is Oculus Rift CV1 (Camera0)");
+    static_assert(camera.search("oculus rift cv1 (camera3)"));
+    static_assert(!camera.search("Oculus Rift CV1 (Camera)"));
+
+    constexpr StringPattern studio = StringPattern::compile("^(Massless)*\\s*Studio");
+    static_assert(studio.search("Massless Studio.exe"));
+    static_assert(!studio.search("Not Massless Studio.exe"));
+}
+
+TEST(StringPatternTest, RejectsUnsupportedSyntax) {
+    EXPECT_THROW(StringPattern::compile("a.b"), std::invalid_argument);
+    EXPECT_THROW(StringPattern::compile("a\\d"), std::invalid_argument);
+    EXPECT_THROW(StringPattern::compile("(a"), std::invalid_argument);
+    EXPECT_THROW(StringPattern::compile("(a|b)"), std::invalid_argument);
+    EXPECT_THROW(StringPattern::compile("a\\"), std::invalid_argument);
+}
+
+TEST(StringPatternTest, TableFindsFirstMatch) {
+    constexpr StringPatternTable<int, 3> table(std::array<std::pair<StringPattern, int>, 3>{ {
+        { StringPattern::compile("Tracker"), 1 },
+        { StringPattern::compile("Vive"), 2 },
+        { StringPattern::compile("Camera\\d+"), 3 }
+    } });
+    ASSERT_NE(table.find("VIVE Tracker"), nullptr);
+    EXPECT_EQ(*table.find("VIVE Tracker"), 1);
+    ASSERT_NE(table.find("vive"), nullptr);
+    EXPECT_EQ(*table.find("vive"), 2);
+    ASSERT_NE(table.find("camera7"), nullptr);
+    EXPECT_EQ(*table.find("camera7"), 3);
+    EXPECT_EQ(table.find("camera"), nullptr);
+    EXPECT_EQ(table.find(""), nullptr);
+}
+
+// Benchmark of the previous std::regex path against StringPattern, run with --gtest_also_run_disabled_tests
+TEST(StringPatternTest, DISABLED_BenchmarkAgainstRegex) {
+    constexpr int iterations = 200;
+    std::size_t regex_matches = 0;
+    std::size_t pattern_matches = 0;
+
+    // The regex path compiled each integration key regex per lookup, so do the same here
+    auto regex_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto& input : inputs) {
+            for (const char* pattern : patterns)
+                regex_matches += std::regex_search(input, std::regex(pattern, std::regex_constants::ECMAScript | std::regex_constants::icase));
+        }
+    }
+    auto regex_time = std::chrono::steady_clock::now() - regex_start;
+
+    std::vector<std::regex> precompiled;
+    for (const char* pattern : patterns)
+        precompiled.emplace_back(pattern, std::regex_constants::ECMAScript | std::regex_constants::icase);
+    auto precompiled_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto& input : inputs) {
+            for (const auto& regex : precompiled)
+                regex_matches += std::regex_search(input, regex);
+        }
+    }
+    auto precompiled_time = std::chrono::steady_clock::now() - precompiled_start;
+
+    std::vector<StringPattern> compiled;
+    for (const char* pattern : patterns)
+        compiled.push_back(StringPattern::compile(pattern));
+    auto pattern_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 2 * iterations; ++i) {
+        for (const auto& input : inputs) {
+            for (const auto& pattern : compiled)
+                pattern_matches += pattern.search(input);
+        }
+    }
+    auto pattern_time = std::chrono::steady_clock::now() - pattern_start;
+
+    using us = std::chrono::microseconds;
+    std::cout << "std::regex (constructed per search): " << std::chrono::duration_cast<us>(regex_time).count() << "us\n"
+        << "std::regex (precompiled): " << std::chrono::duration_cast<us>(precompiled_time).count() << "us\n"
+        << "StringPattern: " << std::chrono::duration_cast<us>(pattern_time).count() / 2 << "us\n";
+    EXPECT_EQ(regex_matches, pattern_matches);
+}
@@ -0,0 +1,176 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <TrackedDeviceDirectory.hpp>
+
+using namespace testing;
+
+namespace {
+    /// <summary>
+    /// Fake device properties, keyed by property container (device index + 100)
+    /// </summary>
+    struct FakeDevice {
+        std::string serial;
+        std::string model_number;
+        vr::ETrackedPropertyError error = vr::TrackedProp_Success;
+    };
+
+    vr::ETrackedPropertyError readFakeProperty(const std::map<vr::PropertyContainerHandle_t, FakeDevice>& devices, vr::PropertyContainerHandle_t container, vr::PropertyRead_t* read) {
+        auto it = devices.find(container);
+        if (it == devices.end() || it->second.error != vr::TrackedProp_Success) {
+            read->eError = it == devices.end() ? vr::TrackedProp_UnknownProperty : it->second.error;
+            return read->eError;
+        }
+        std::string value;
+        if (read->prop == vr::Prop_SerialNumber_String)
+            value = it->second.serial;
+        else if (read->prop == vr::Prop_ModelNumber_String)
+            value = it->second.model_number;
+        else {
+            read->eError = vr::TrackedProp_UnknownProperty;
+            return read->eError;
+        }
+        std::memset(read->pvBuffer, 0, read->unBufferSize);
+        std::strncpy(static_cast<char*>(read->pvBuffer), value.c_str(), read->unBufferSize - 1);
+        read->unRequiredBufferSize = static_cast<uint32_t>(value.size() + 1);
+        read->unTag = vr::k_unStringPropertyTag;
+        read->eError = vr::TrackedProp_Success;
+        return read->eError;
+    }
+
+    vr::VREvent_t makeEvent(vr::EVREventType type, vr::TrackedDeviceIndex_t index) {
+        vr::VREvent_t event = { 0 };
+        event.eventType = type;
+        event.trackedDeviceIndex = index;
+        return event;
+    }
+}
+
+class TrackedDeviceDirectoryTest : public Test {
+protected:
+    void SetUp() override {
+        ON_CALL(this->properties, TrackedDeviceToPropertyContainer(_))
+            .WillByDefault(Invoke([](vr::TrackedDeviceIndex_t index) { return static_cast<vr::PropertyContainerHandle_t>(index) + 100; }));
+        ON_CALL(this->properties, ReadPropertyBatch(_, _, _))
+            .WillByDefault(Invoke([this](vr::PropertyContainerHandle_t container, vr::PropertyRead_t* batch, uint32_t) {
+                return readFakeProperty(this->devices, container, batch);
+            }));
+        ON_CALL(this->serverdriver_host, GetRawTrackedDevicePoses(_, _, _))
+            .WillByDefault(Invoke([this](float, vr::TrackedDevicePose_t* poses, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i)
+                    poses[i] = this->poses[i];
+            }));
+    }
+
+    void refresh(TrackedDeviceDirectory& directory) {
+        this->snapshot.capture(&this->serverdriver_host);
+        directory.refresh(this->snapshot, &this->helper);
+    }
+
+    void connect(vr::TrackedDeviceIndex_t index, std::string serial, std::string model_number) {
+        this->devices[index + 100] = { serial, model_number };
+        this->poses[index].bDeviceIsConnected = true;
+        this->poses[index].bPoseIsValid = true;
+    }
+
+    std::map<vr::PropertyContainerHandle_t, FakeDevice> devices;
+    std::array<vr::TrackedDevicePose_t, vr::k_unMaxTrackedDeviceCount> poses = { {0} };
+    NiceMock<MockVRProperties> properties;
+    NiceMock<MockVRServerDriverHost> serverdriver_host;
+    vr::CVRPropertyHelpers helper{ &properties };
+    DevicePoseSnapshot snapshot;
+};
+
+TEST_F(TrackedDeviceDirectoryTest, ClassifiesEachDeviceOnce) {
+    this->connect(3, "LHB-1234", "Valve SR Imp");
+    this->connect(5, "HMD-1", "Index");
+
+    TrackedDeviceDirectory directory;
+    this->refresh(directory);
+    uint64_t classifications = directory.getClassificationCount();
+    ASSERT_EQ(classifications, 2);
+
+    for (int frame = 0; frame < 10; ++frame)
+        this->refresh(directory);
+    ASSERT_EQ(directory.getClassificationCount(), classifications) << "Refreshing without events should not read properties again";
+
+    ASSERT_THAT(directory.getTrackingReferences(), ElementsAre(3));
+    ASSERT_EQ(directory.findIndex("LHB-1234"), std::optional<vr::TrackedDeviceIndex_t>(3));
+    ASSERT_EQ(directory.findIndex("HMD-1"), std::optional<vr::TrackedDeviceIndex_t>(5));
+    ASSERT_EQ(directory.findIndex("unknown"), std::nullopt);
+    ASSERT_EQ(directory.getDevicesOfType(MasslessInterface::TrackingSystemType::SystemType::VIVE_BASESTATION_V2), uint64_t(1) << 3);
+    ASSERT_EQ(directory.getEntry(5)->is_tracking_reference, false);
+}
+
+TEST_F(TrackedDeviceDirectoryTest, ViveTrackersArePrioritised) {
+    this->connect(1, "LHB-1", "HTC V2-XD/XE");
+    this->connect(2, "LHR-2", "VIVE Tracker Pro MV");
+    this->connect(4, "LHB-2", "HTC V2-XD/XE");
+
+    TrackedDeviceDirectory directory;
+    this->refresh(directory);
+
+    ASSERT_THAT(directory.getTrackingReferences(), ElementsAre(2, 1, 4));
+    ASSERT_THAT(DriverAnalytics::firstPass(directory), ElementsAre(2, 1, 4));
+}
+
+TEST_F(TrackedDeviceDirectoryTest, EventsInvalidateOnlyAffectedDevices) {
+    this->connect(1, "LHB-1", "HTC V2-XD/XE");
+    this->connect(2, "LHR-2", "Index");
+
+    TrackedDeviceDirectory directory;
+    this->refresh(directory);
+    ASSERT_EQ(directory.getClassificationCount(), 2);
+
+    // Device 2 was re-activated as a tracker
+    this->devices[102].model_number = "VIVE Tracker Pro MV";
+    std::vector<vr::VREvent_t> events = { makeEvent(vr::VREvent_TrackedDeviceActivated, 2) };
+    directory.processEvents(events);
+    this->refresh(directory);
+
+    ASSERT_EQ(directory.getClassificationCount(), 3);
+    ASSERT_THAT(directory.getTrackingReferences(), ElementsAre(2, 1));
+
+    // Unrelated property changes are ignored
+    vr::VREvent_t property_event = makeEvent(vr::VREvent_PropertyChanged, 1);
+    property_event.data.property.prop = vr::Prop_DeviceBatteryPercentage_Float;
+    events = { property_event };
+    directory.processEvents(events);
+    this->refresh(directory);
+    ASSERT_EQ(directory.getClassificationCount(), 3);
+}
+
+TEST_F(TrackedDeviceDirectoryTest, RetriesUntilPropertiesAreAvailable) {
+    this->connect(7, "LHR-7", "VIVE Tracker Pro MV");
+    this->devices[107].error = vr::TrackedProp_NotYetAvailable;
+
+    TrackedDeviceDirectory directory;
+    this->refresh(directory);
+    ASSERT_TRUE(directory.getTrackingReferences().empty());
+    ASSERT_FALSE(directory.getEntry(7)->classified);
+
+    this->devices[107].error = vr::TrackedProp_Success;
+    this->refresh(directory);
+    ASSERT_THAT(directory.getTrackingReferences(), ElementsAre(7));
+    ASSERT_EQ(directory.getEntry(7)->type.getSystemType(), MasslessInterface::TrackingSystemType::SystemType::VIVE_TRACKER);
+}
+
+TEST_F(TrackedDeviceDirectoryTest, DisconnectedDevicesAreNotCandidates) {
+    this->connect(1, "LHB-1", "HTC V2-XD/XE");
+
+    TrackedDeviceDirectory directory;
+    this->refresh(directory);
+    ASSERT_THAT(directory.getTrackingReferences(), ElementsAre(1));
+
+    this->poses[1].bDeviceIsConnected = false;
+    this->refresh(directory);
+    ASSERT_TRUE(directory.getTrackingReferences().empty());
+    ASSERT_EQ(directory.findIndex("LHB-1"), std::nullopt);
+}
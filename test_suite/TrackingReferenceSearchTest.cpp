@@ -0,0 +1,162 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <TrackingReferenceSearch.hpp>
+
+using namespace testing;
+using namespace std::chrono_literals;
+using State = TrackingReferenceSearch::State;
+
+class TrackingReferenceSearchTest : public Test {
+protected:
+    TrackingReferenceSearch makeSearch() {
+        return TrackingReferenceSearch(this->timings, [this]() { return this->now; });
+    }
+
+    TrackingReferenceSearch::Timings timings;
+    TrackingReferenceSearch::Clock::time_point now{};
+};
+
+TEST_F(TrackingReferenceSearchTest, ProbesWithExponentialBackoff) {
+    auto search = this->makeSearch();
+    ASSERT_EQ(search.getState(), State::Idle);
+    ASSERT_FALSE(search.shouldProbe());
+
+    search.start();
+    ASSERT_EQ(search.getState(), State::Searching);
+    ASSERT_TRUE(search.shouldProbe()) << "First probe should happen straight away";
+
+    // Failed probes are spaced 50, 100, 200, 400... ms apart regardless of how many frames run in between
+    std::vector<std::chrono::milliseconds> gaps;
+    auto last_probe = this->now;
+    search.onProbeFailed();
+    while (gaps.size() < 7) {
+        this->now += 1ms;
+        if (search.shouldProbe()) {
+            gaps.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(this->now - last_probe));
+            last_probe = this->now;
+            search.onProbeFailed();
+        }
+    }
+    EXPECT_THAT(gaps, ElementsAre(50ms, 100ms, 200ms, 400ms, 800ms, 1600ms, 2000ms));
+    EXPECT_EQ(search.getProbeCount(), 8);
+}
+
+TEST_F(TrackingReferenceSearchTest, LocksAfterValidationPeriod) {
+    auto search = this->makeSearch();
+    search.start();
+    search.onCandidateFound();
+    ASSERT_EQ(search.getState(), State::Validating);
+    ASSERT_FALSE(search.shouldProbe());
+
+    EXPECT_FALSE(search.onCandidateValidated(true));
+    this->now += 50ms;
+    EXPECT_FALSE(search.onCandidateValidated(true));
+    this->now += 50ms;
+    EXPECT_TRUE(search.onCandidateValidated(true));
+    EXPECT_EQ(search.getState(), State::Locked);
+}
+
+TEST_F(TrackingReferenceSearchTest, TrustedCandidateLocksOnFirstValidPose) {
+    auto search = this->makeSearch();
+    search.start();
+    search.onCandidateFound(true);
+    EXPECT_FALSE(search.onCandidateValidated(false)) << "An invalid pose still fails a trusted candidate";
+    EXPECT_EQ(search.getState(), State::Searching);
+
+    this->now += this->timings.initial_backoff;
+    search.onCandidateFound(true);
+    EXPECT_TRUE(search.onCandidateValidated(true));
+    EXPECT_EQ(search.getState(), State::Locked);
+
+    // Trust doesn't carry over to the next search
+    search.restart();
+    search.onCandidateFound();
+    EXPECT_FALSE(search.onCandidateValidated(true));
+}
+
+TEST_F(TrackingReferenceSearchTest, InvalidCandidateReturnsToSearching) {
+    auto search = this->makeSearch();
+    search.start();
+    search.onCandidateFound();
+    EXPECT_FALSE(search.onCandidateValidated(false));
+    EXPECT_EQ(search.getState(), State::Searching);
+    EXPECT_FALSE(search.shouldProbe()) << "Retry should wait for the backoff";
+    this->now += this->timings.initial_backoff;
+    EXPECT_TRUE(search.shouldProbe());
+}
+
+TEST_F(TrackingReferenceSearchTest, ActivationResetsBackoffWhileSearching) {
+    auto search = this->makeSearch();
+    search.start();
+    for (int i = 0; i < 5; ++i)
+        search.onProbeFailed();
+    ASSERT_FALSE(search.shouldProbe());
+
+    search.onDeviceActivated(true);
+    EXPECT_TRUE(search.shouldProbe());
+    EXPECT_EQ(search.getBackoff(), this->timings.initial_backoff);
+}
+
+TEST_F(TrackingReferenceSearchTest, ActivationReevaluatesLockedReferenceAfterSettling) {
+    auto search = this->makeSearch();
+    search.start();
+    search.onCandidateFound();
+    this->now += this->timings.validation_period;
+    ASSERT_TRUE(search.onCandidateValidated(true));
+
+    // Forced references are never re-evaluated
+    search.onDeviceActivated(false);
+    this->now += this->timings.settle_delay;
+    EXPECT_FALSE(search.consumeReevaluation());
+
+    // A burst of activations is only evaluated once, settle_delay after the first
+    search.onDeviceActivated(true);
+    this->now += 1000ms;
+    search.onDeviceActivated(true);
+    EXPECT_FALSE(search.consumeReevaluation());
+    this->now += this->timings.settle_delay - 1000ms;
+    EXPECT_TRUE(search.consumeReevaluation());
+    EXPECT_FALSE(search.consumeReevaluation());
+    EXPECT_EQ(search.getState(), State::Locked);
+}
+
+TEST_F(TrackingReferenceSearchTest, LostReferenceRecoversOrTimesOut) {
+    auto search = this->makeSearch();
+    search.start();
+    search.onCandidateFound();
+    this->now += this->timings.validation_period;
+    ASSERT_TRUE(search.onCandidateValidated(true));
+
+    search.onReferenceLost();
+    ASSERT_EQ(search.getState(), State::Lost);
+    this->now += 1000ms;
+    EXPECT_FALSE(search.hasLostTimedOut());
+    search.onReferenceRecovered();
+    ASSERT_EQ(search.getState(), State::Locked);
+
+    search.onReferenceLost();
+    this->now += this->timings.lost_timeout;
+    EXPECT_TRUE(search.hasLostTimedOut());
+    search.restart();
+    EXPECT_EQ(search.getState(), State::Searching);
+    EXPECT_TRUE(search.shouldProbe());
+}
+
+TEST_F(TrackingReferenceSearchTest, HintExpiresRelativeToStart) {
+    auto search = this->makeSearch();
+    this->now += 10s;
+    EXPECT_FALSE(search.hasHintExpired()) << "Hint timer only runs once searching";
+    search.start();
+    this->now += this->timings.hint_timeout - 1ms;
+    EXPECT_FALSE(search.hasHintExpired());
+    this->now += 1ms;
+    EXPECT_TRUE(search.hasHintExpired());
+}
@@ -0,0 +1,98 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+#include "Testing.hpp"
+#include <WarmStartCache.hpp>
+
+#include <sstream>
+
+using namespace testing;
+using SystemType = MasslessInterface::TrackingSystemType::SystemType;
+
+namespace {
+    WarmStartCache::Entry makeEntry(SystemType type = SystemType::VIVE_BASESTATION_V2) {
+        return {
+            "LHB-12345678",
+            MasslessInterface::TrackingSystemType(type),
+            MasslessInterface::Pose(0.1f, 0.2f, 0.3f, 0.5f, 0.5f, 0.5f, 0.5f),
+            { Eigen::Quaternionf(Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitY())), Eigen::Vector3f(1, 2, 3) }
+        };
+    }
+
+    std::string serialise(const WarmStartCache::Entry& entry) {
+        std::stringstream stream;
+        EXPECT_TRUE(WarmStartCache::write(stream, entry));
+        return stream.str();
+    }
+
+    std::optional<WarmStartCache::Entry> deserialise(const std::string& data) {
+        std::stringstream stream(data);
+        return WarmStartCache::read(stream);
+    }
+}
+
+TEST(WarmStartCacheTest, RoundTrips) {
+    auto entry = makeEntry();
+    auto data = serialise(entry);
+    EXPECT_EQ(data.size(), 4 + 2 + 2 + entry.device_serial.size() + 4 + 7 * 4 + 7 * 4 + 4);
+
+    auto loaded = deserialise(data);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->device_serial, entry.device_serial);
+    EXPECT_EQ(loaded->type.getSystemType(), SystemType::VIVE_BASESTATION_V2);
+    EXPECT_TRUE(loaded->pose_offset == entry.pose_offset);
+    EXPECT_TRUE(loaded->global_pose.first.isApprox(entry.global_pose.first));
+    EXPECT_TRUE(loaded->global_pose.second.isApprox(entry.global_pose.second));
+}
+
+TEST(WarmStartCacheTest, RejectsCorruptData) {
+    auto data = serialise(makeEntry());
+
+    EXPECT_EQ(deserialise(""), std::nullopt);
+    EXPECT_EQ(deserialise(data.substr(0, data.size() - 1)), std::nullopt) << "Truncated";
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        auto flipped = data;
+        flipped[i] ^= 0x10;
+        EXPECT_EQ(deserialise(flipped), std::nullopt) << "Byte " << i << " flipped";
+    }
+}
+
+TEST(WarmStartCacheTest, RejectsEmptySerial) {
+    auto entry = makeEntry();
+    entry.device_serial.clear();
+    std::stringstream stream;
+    EXPECT_FALSE(WarmStartCache::write(stream, entry));
+}
+
+TEST(WarmStartCacheTest, CachePathIsNextToConfig) {
+    std::filesystem::path config = std::filesystem::path("Massless") / "driver_massless.json";
+    EXPECT_EQ(WarmStartCache::getCachePath(config), std::filesystem::path("Massless") / "driver_massless.cache");
+}
+
+TEST(WarmStartCacheTest, StaticReferenceMustNotHaveMoved) {
+    auto entry = makeEntry();
+    auto pose = entry.global_pose;
+    EXPECT_TRUE(WarmStartCache::matches(entry, entry.device_serial, entry.type, pose));
+    EXPECT_FALSE(WarmStartCache::matches(entry, "LHB-87654321", entry.type, pose));
+    EXPECT_FALSE(WarmStartCache::matches(entry, entry.device_serial, MasslessInterface::TrackingSystemType(SystemType::VIVE_BASESTATION_V1), pose));
+
+    pose.second.x() += 0.05f;
+    EXPECT_FALSE(WarmStartCache::matches(entry, entry.device_serial, entry.type, pose)) << "Base station was moved while SteamVR was off";
+
+    pose = entry.global_pose;
+    pose.first = pose.first * Eigen::Quaternionf(Eigen::AngleAxisf(0.1f, Eigen::Vector3f::UnitX()));
+    EXPECT_FALSE(WarmStartCache::matches(entry, entry.device_serial, entry.type, pose));
+}
+
+TEST(WarmStartCacheTest, MovingReferenceOnlyNeedsToMatchType) {
+    auto entry = makeEntry(SystemType::VIVE_TRACKER);
+    auto pose = entry.global_pose;
+    pose.second.x() += 1.0f;
+    EXPECT_TRUE(WarmStartCache::matches(entry, entry.device_serial, entry.type, pose));
+}
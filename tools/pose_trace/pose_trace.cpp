@@ -0,0 +1,207 @@
+/* Copyright (C) 2020 Massless Corp. - All Rights Reserved
+ * Author: Jacob Hilton.
+ * You may use, distribute and modify this code under the
+ * terms of the BSD 3-Clause "New" or "Revised" License.
+ *
+ * You should have received a copy of this license with
+ * this file. If not, please email support@massless.io
+ */
+
+// Reads pose trace files recorded by the driver (see the pose_trace_file setting and driver_massless/PoseTrace.hpp).
+//
+// Build on Linux from the repository root with:
+//   g++ -std=c++17 -O2 -Idriver_massless tools/pose_trace/pose_trace.cpp driver_massless/PoseTrace.cpp -o pose_trace
+//
+// Usage:
+//   pose_trace info <trace>               Summary of the trace
+//   pose_trace csv <trace>                Every record as CSV on stdout, one column per field
+//   pose_trace columns <trace> <dir>      One raw little endian file per column in <dir>, plus schema.csv listing each column's file, type
+//                                         and length, for loading with numpy.fromfile or converting to Parquet
+
+#include <PoseTrace.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    enum class ColumnType { Int64, Float32, UInt32 };
+
+    struct Column {
+        std::string name;
+        ColumnType type;
+        std::size_t offset;
+    };
+
+    std::vector<Column> makeColumns()
+    {
+        using PoseTrace::Record;
+        std::vector<Column> columns = {
+            { "sample_ns", ColumnType::Int64, offsetof(Record, sample_ns) },
+            { "submit_ns", ColumnType::Int64, offsetof(Record, submit_ns) },
+        };
+        struct Stage { const char* name; std::size_t position; std::size_t rotation; };
+        const Stage stages[] = {
+            { "raw", offsetof(Record, raw_position), offsetof(Record, raw_rotation) },
+            { "reference", offsetof(Record, reference_position), offsetof(Record, reference_rotation) },
+            { "transformed", offsetof(Record, transformed_position), offsetof(Record, transformed_rotation) },
+            { "filtered", offsetof(Record, filtered_position), offsetof(Record, filtered_rotation) },
+        };
+        for (const auto& stage : stages) {
+            for (int i = 0; i < 3; ++i)
+                columns.push_back({ std::string(stage.name) + "_p" + "xyz"[i], ColumnType::Float32, stage.position + i * sizeof(float) });
+            for (int i = 0; i < 4; ++i)
+                columns.push_back({ std::string(stage.name) + "_q" + "wxyz"[i], ColumnType::Float32, stage.rotation + i * sizeof(float) });
+        }
+        columns.push_back({ "flags", ColumnType::UInt32, offsetof(Record, flags) });
+        return columns;
+    }
+
+    const char* getTypeName(ColumnType type)
+    {
+        switch (type) {
+        case ColumnType::Int64:
+            return "int64";
+        case ColumnType::Float32:
+            return "float32";
+        default:
+            return "uint32";
+        }
+    }
+
+    std::size_t getTypeSize(ColumnType type)
+    {
+        return type == ColumnType::Int64 ? 8 : 4;
+    }
+
+    void printValue(const PoseTrace::Record& record, const Column& column)
+    {
+        const char* field = reinterpret_cast<const char*>(&record) + column.offset;
+        if (column.type == ColumnType::Int64) {
+            int64_t value;
+            std::memcpy(&value, field, sizeof(value));
+            std::printf("%lld", static_cast<long long>(value));
+        }
+        else if (column.type == ColumnType::Float32) {
+            float value;
+            std::memcpy(&value, field, sizeof(value));
+            std::printf("%.9g", value);
+        }
+        else {
+            uint32_t value;
+            std::memcpy(&value, field, sizeof(value));
+            std::printf("%u", value);
+        }
+    }
+
+    int info(const PoseTrace::Contents& trace)
+    {
+        std::printf("records: %zu of %llu\n", trace.records.size(), static_cast<unsigned long long>(trace.capacity));
+        std::printf("start_ns: %lld\n", static_cast<long long>(trace.start_ns));
+        if (trace.records.empty())
+            return 0;
+
+        double duration_s = (trace.records.back().sample_ns - trace.records.front().sample_ns) / 1e9;
+        std::printf("duration_s: %.3f\n", duration_s);
+        if (duration_s > 0)
+            std::printf("rate_hz: %.1f\n", (trace.records.size() - 1) / duration_s);
+
+        // Time from the SDK sample to SteamVR, for records that were submitted
+        std::vector<int64_t> latencies;
+        std::size_t fused = 0;
+        for (const auto& record : trace.records) {
+            if (record.submit_ns != 0)
+                latencies.push_back(record.submit_ns - record.sample_ns);
+            if (record.flags & PoseTrace::Fused)
+                ++fused;
+        }
+        std::printf("submitted: %zu\nfused: %zu\n", latencies.size(), fused);
+        if (!latencies.empty()) {
+            std::sort(latencies.begin(), latencies.end());
+            auto percentile = [&latencies](double p) { return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))] / 1000.0; };
+            std::printf("sample_to_submit_us: p50 %.1f, p99 %.1f, max %.1f\n", percentile(0.5), percentile(0.99), percentile(1.0));
+        }
+        return 0;
+    }
+
+    int csv(const PoseTrace::Contents& trace)
+    {
+        auto columns = makeColumns();
+        for (std::size_t i = 0; i < columns.size(); ++i)
+            std::printf("%s%s", i == 0 ? "" : ",", columns[i].name.c_str());
+        std::printf("\n");
+        for (const auto& record : trace.records) {
+            for (std::size_t i = 0; i < columns.size(); ++i) {
+                if (i != 0)
+                    std::printf(",");
+                printValue(record, columns[i]);
+            }
+            std::printf("\n");
+        }
+        return 0;
+    }
+
+    int columns(const PoseTrace::Contents& trace, const std::filesystem::path& directory)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        std::ofstream schema(directory / "schema.csv");
+        if (!schema) {
+            std::fprintf(stderr, "Unable to write to %s\n", directory.string().c_str());
+            return 1;
+        }
+        schema << "column,file,type,length\n";
+
+        std::vector<char> buffer;
+        for (const auto& column : makeColumns()) {
+            std::size_t size = getTypeSize(column.type);
+            buffer.resize(trace.records.size() * size);
+            for (std::size_t i = 0; i < trace.records.size(); ++i)
+                std::memcpy(buffer.data() + i * size, reinterpret_cast<const char*>(&trace.records[i]) + column.offset, size);
+
+            std::string file_name = column.name + ".bin";
+            std::ofstream file(directory / file_name, std::ios::binary);
+            if (!file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+                std::fprintf(stderr, "Unable to write %s\n", file_name.c_str());
+                return 1;
+            }
+            schema << column.name << "," << file_name << "," << getTypeName(column.type) << "," << trace.records.size() << "\n";
+        }
+        return 0;
+    }
+
+    int usage()
+    {
+        std::fprintf(stderr, "Usage: pose_trace info <trace>\n       pose_trace csv <trace>\n       pose_trace columns <trace> <dir>\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+        return usage();
+    std::string command = argv[1];
+    if (command != "info" && command != "csv" && command != "columns")
+        return usage();
+    if (command == "columns" && argc < 4)
+        return usage();
+
+    std::string error;
+    auto trace = PoseTrace::read(argv[2], error);
+    if (!trace.has_value()) {
+        std::fprintf(stderr, "%s: %s\n", argv[2], error.c_str());
+        return 1;
+    }
+
+    if (command == "info")
+        return info(*trace);
+    if (command == "csv")
+        return csv(*trace);
+    return columns(*trace, argv[3]);
+}